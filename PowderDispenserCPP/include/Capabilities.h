@@ -0,0 +1,66 @@
+#ifndef CAPABILITIES_H
+#define CAPABILITIES_H
+
+#include <Arduino.h>
+
+/**
+ * Command bits of the `<Caps>` bitmap. Append-only: a command keeps its bit in every firmware, so
+ * hosts decode the bitmap of any version. Bits 0 to 10 are the commands of protocol version 1
+ * (firmware that does not answer `<Caps>`).
+ */
+enum CommandBit : uint8_t {
+    CMD_DISPENSE = 0,
+    CMD_DISPENSER_ON = 1,
+    CMD_DISPENSER_OFF = 2,
+    CMD_SCALE_ON = 3,
+    CMD_SCALE_OFF = 4,
+    CMD_TARE = 5,
+    CMD_MEAS = 6,
+    CMD_ADC = 7,
+    CMD_MIX = 8,
+    CMD_DRAIN = 9,
+    CMD_PUMP = 10,
+    CMD_STATUS = 11,
+    CMD_ABORT = 12,
+    CMD_STATS = 13,
+    CMD_MEM = 14,
+    CMD_TRACE = 15,
+    CMD_PROF_START = 16,
+    CMD_PROF_STOP = 17,
+    CMD_PROF_DUMP = 18,
+    CMD_PREDICT = 19,
+    CMD_DISPENSE_MASS = 20,
+    CMD_AUGER_CAL = 21,
+    CMD_SCALE_IDLE = 22,
+    CMD_AFE_CAL = 23,
+    CMD_BATCH_START = 24,
+    CMD_BATCH_END = 25,
+    CMD_RESUME = 26,
+    CMD_REFILL = 27,
+    CMD_FLOW = 28,
+    CMD_HOPPER = 29,
+    CMD_DOSE = 30,
+    CMD_DOSE_PARAM = 31,
+    CMD_STREAM = 32,
+    CMD_CFG_LOAD = 33,
+    CMD_CFG = 34,
+    CMD_CAPS = 35,
+    CMD_IDLE = 36,
+    CMD_DOSE_QUEUE = 37,
+    CMD_AUTO_DOSE = 38,
+    CMD_COUNT
+};
+
+/**
+ * Protocol capabilities, reported by the immediate command `<Caps>` so a host can pick the
+ * fastest mode a device supports instead of the slowest common one.
+ */
+class Capabilities {
+public:
+    static bool supports(CommandBit command);
+    static void send(uint16_t sampleRate);
+
+    static const uint8_t protocolVersion;
+};
+
+#endif // CAPABILITIES_H
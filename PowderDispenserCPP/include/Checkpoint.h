@@ -0,0 +1,45 @@
+#ifndef CHECKPOINT_H
+#define CHECKPOINT_H
+
+#include <Arduino.h>
+#include <EEPROM.h>
+#include "DispenserControls.h"
+
+/**
+ * Batch progress saved to EEPROM so a batch survives a board reset.
+ */
+struct CheckpointRecord {
+    uint16_t sequence;                           // Increments with every save; the newest valid record is current.
+    uint16_t batchId;                            // Host-chosen batch identifier; 0 when no batch is active.
+    uint16_t step;                               // Recipe steps completed in the batch.
+    int32_t zeroOffset;                          // Scale tare baseline.
+    float mass[DispenserControls::numChannels];  // Cumulative dispensed grams per auger channel.
+    uint8_t crc;                                 // CRC-8 of the fields above; rejects torn writes.
+};
+
+class Checkpoint {
+public:
+    static void load();
+    static void begin(uint16_t batchId, int32_t zeroOffset);
+    static void addDose(uint8_t channel, float grams);
+    static void completeStep(int32_t zeroOffset);
+    static void save(int32_t zeroOffset);
+    static void end();
+    static void send();
+
+    static bool isActive() { return record.batchId != 0; }
+    static const CheckpointRecord& current() { return record; }
+
+    static const int LOC_CHECKPOINT;
+    static constexpr uint8_t numSlots = 16;
+    static constexpr uint8_t slotBytes = 32;
+
+private:
+    static uint8_t crc8(const uint8_t* data, uint8_t length);
+    static bool readSlot(uint8_t slot, CheckpointRecord& out);
+
+    static CheckpointRecord record;
+    static uint8_t slot;
+};
+
+#endif // CHECKPOINT_H
@@ -1,11 +1,13 @@
-<<<<<<< HEAD
 #ifndef COMMS_H
 #define COMMS_H
 
 #include "Utils.h"
+#include "MemoryArena.h"
+#include "RingBuffer.h"
 #include "ScaleControls.h"
 #include "MixerControls.h"
 #include "DispenserControls.h"
+#include "DoseController.h"
 
 class Comms {
 private:
@@ -13,70 +15,48 @@ private:
     ScaleControls& scaleControls;
     MixerControls& mixerControls;
     DispenserControls& dispenserControls;
+    DoseController& doseController;
 
-    static const byte buffSize = 128;
-    static char inputBuffer[buffSize];
+    static const byte buffSize = ARENA_RX_BYTES;
+    char* rxFrame;      // Frame being received; immediate commands are parsed in place.
+    char* inputBuffer;  // Queued command being run.
     const char startMarker = '<';
     const char endMarker = '>';
     byte bytesRecvd = 0;
     bool readInProgress = false;
     bool newDataFromPC = false;
 
-    char messageFromPC[buffSize] = {0};
+    char* messageFromPC;
 
-    static unsigned long prevReplyToPCmillis;
-    static unsigned long replyToPCinterval;
-    
-    void parseData();
-    void replyToPC();
-
-public:
-    Comms(Utils& utils, ScaleControls& scaleControls, MixerControls& mixerControls, DispenserControls& dispenserControls);
-
-    void getDataFromPC();
-    static inline void updateCurMillis(unsigned long millis) { curMillis = millis; }
-
-private:
-    static unsigned long curMillis;
-};
-
-#endif // COMMS_H
-=======
-#ifndef COMMS_H
-#define COMMS_H
-
-#include "Utils.h"
-#include "ScaleControls.h"
-#include "MixerControls.h"
-#include "DispenserControls.h"
-
-class Comms {
-private:
-    Utils& utils;
-    ScaleControls& scaleControls;
-    MixerControls& mixerControls;
-    DispenserControls& dispenserControls;
-
-    static const byte buffSize = 128;
-    static char inputBuffer[buffSize];
-    const char startMarker = '<';
-    const char endMarker = '>';
-    byte bytesRecvd = 0;
-    bool readInProgress = false;
-    bool newDataFromPC = false;
-
-    char messageFromPC[buffSize] = {0};
+    RingBuffer<char, ARENA_PENDING_BYTES>* pending;  // Null-separated actuation frames waiting to run.
+    uint8_t pendingFrames = 0;
+    bool busy = false;  // An actuation command is running.
 
     static unsigned long prevReplyToPCmillis;
     static unsigned long replyToPCinterval;
     
     void parseData();
     void replyToPC();
+    void predictCommand();
+
+    void dispatchFrame();
+    static bool isImmediate(const char* command);
+    static bool isRecipeStep(const char* message);
+    void handleImmediate();
+    bool queueFrame();
+    void runQueued();
+    void runPending();
+    void recordRecipeStep();
+    void sendStatus();
+    void sendAutoDose();
 
 public:
-    Comms(Utils& utils, ScaleControls& scaleControls, MixerControls& mixerControls, DispenserControls& dispenserControls);
+    Comms(Utils& utils, ScaleControls& scaleControls, MixerControls& mixerControls, DispenserControls& dispenserControls,
+          DoseController& doseController);
 
     void getDataFromPC();
+    void runAutoDose();
+    bool isBusy() const { return busy; }
     static inline void updateCurMillis(unsigned long millis) { curMillis = millis; }
 
 private:
@@ -84,4 +64,3 @@ private:
 };
 
 #endif // COMMS_H
->>>>>>> c5e728c45412297ccfbd7313ba623480bfd3dee3
@@ -0,0 +1,63 @@
+#ifndef DEVICECONFIG_H
+#define DEVICECONFIG_H
+
+#include <Arduino.h>
+#include <EEPROM.h>
+
+/**
+ * Sections of a configuration image. Multi-byte values are little-endian, floats are IEEE-754
+ * single precision and names are unterminated ASCII filling the rest of the section.
+ */
+enum ConfigSection : uint8_t {
+    CFG_SCALE = 1,       // sampleRate u16, gain u8, ldoVoltage u8, filter u8, singlePointCal u8, numMeas u8, numReadings u8.
+    CFG_LOAD_CELL = 2,   // capacityGrams u16, slope f32, intercept f32, active u8 (one section per load cell).
+    CFG_AUGER = 3,       // channel u8 (0xFF: none), gramsPerStep f32, name (one section per auger and powder).
+    CFG_PUMP = 4,        // pin u8 (0xFF: I2C), a f32, b f32, name (seconds = a * volume + b).
+    CFG_CONSTANTS = 5,   // mixTime f32, drainTime f32, dispenseDir i8, allowNegative u8, decimal u8.
+    CFG_DEFAULTS = 6,    // avgReadingSamples u16, avgWeightSamples u16, timeoutMs u16, reps u8, samples u8, calMode u8.
+    CFG_WEIGHT = 7,      // grams f32 (one section per calibration weight).
+};
+
+struct ScaleSettings {
+    uint16_t sampleRate;
+    uint8_t gain;
+    uint8_t ldoVoltage;
+};
+
+/**
+ * Device configuration compiled on the host from `config.json` (`devconfig.py`) and flashed with
+ * `<CfgLoad>` into its own EEPROM region.
+ *
+ * Image layout: a 12-byte header (magic "PDCF", format version u8, section count u8, payload
+ * bytes u16, payload CRC-16/CCITT u16, revision u16), then the payload: sections of
+ * `tag u8, length u8, data`. Unknown tags are skipped, so a newer host can add sections without
+ * breaking older firmware; the format version only changes for incompatible layouts.
+ */
+class DeviceConfig {
+public:
+    static bool load();
+    static bool receive(uint16_t length, uint16_t imageCrc);
+    static void send();
+
+    static bool isValid() { return valid; }
+    static void getScale(ScaleSettings& settings);
+    static bool getLoadCell(float& slope, float& intercept);
+    static bool getAugerCal(uint8_t channel, float& gramsPerStep);
+
+    static const int LOC_DEVICE_CONFIG;
+    static constexpr uint16_t maxBytes = 384;
+    static constexpr uint8_t headerBytes = 12;
+    static constexpr uint8_t formatVersion = 1;
+
+private:
+    static uint16_t crc16(uint16_t crc, uint8_t byte);
+    static uint16_t readU16(int address);
+    static bool nextSection(int& address, uint8_t& tag, uint8_t& length);
+
+    static bool valid;
+    static uint16_t payloadBytes;
+    static uint16_t revision;
+    static uint8_t sectionCount;
+};
+
+#endif // DEVICECONFIG_H
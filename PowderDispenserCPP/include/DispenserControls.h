@@ -1,4 +1,3 @@
-<<<<<<< HEAD
 #ifndef DISPENSERCONTROLS_H
 #define DISPENSERCONTROLS_H
 
@@ -14,43 +13,25 @@ public:
     void disableDispenser();
     bool isDispenserEnabled();
     void changeDir(int dir);
-    void dispense(int steps, int dir);
+    void dispense(long steps, int dir, uint8_t channel = 0);
+    long dispenseMass(float grams, uint8_t channel);
+    long massToSteps(float grams, uint8_t channel);
+    bool setAugerCal(uint8_t channel, float gramsPerStep);
+    float getAugerCal(uint8_t channel);
+    void loadAugerCal();
 
     static int dispenseDir;
     static bool dispenserEnabled;
     static const float dispenserCalFactor;
 
-private:
-    Utils& utils;
-    PRODRIVER Dispenser;
-};
-
-=======
-#ifndef DISPENSERCONTROLS_H
-#define DISPENSERCONTROLS_H
-
-#include "Utils.h"
-#include <SparkFun_ProDriver_TC78H670FTG_Arduino_Library.h>
-
-class DispenserControls {
-public:
-    DispenserControls(Utils& utils);
-
-    void setupDispenser(int resVar);
-    void enableDispenser();
-    void disableDispenser();
-    bool isDispenserEnabled();
-    void changeDir(int dir);
-    void dispense(int steps, int dir);
-
-    static int dispenseDir;
-    static bool dispenserEnabled;
-    static const float dispenserCalFactor;
+    static constexpr uint8_t numChannels = 4;
+    static const int LOC_AUGER_CAL;
+    static const unsigned long serviceChunkMs;
 
 private:
     Utils& utils;
     PRODRIVER Dispenser;
+    float augerCal[numChannels];  // Grams per microstep for each auger channel.
 };
 
->>>>>>> c5e728c45412297ccfbd7313ba623480bfd3dee3
 #endif // DISPENSERCONTROLS_H
\ No newline at end of file
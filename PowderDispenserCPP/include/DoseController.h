@@ -0,0 +1,82 @@
+#ifndef DOSECONTROLLER_H
+#define DOSECONTROLLER_H
+
+#include "Utils.h"
+#include "ScaleControls.h"
+#include "DispenserControls.h"
+#include "RingBuffer.h"
+#include "MemoryArena.h"
+
+/**
+ * Tunable parameters of the closed-loop dose.
+ *
+ * The dose starts with one open-loop move of `initialFraction` of the target, then runs three
+ * phases of bursts. Phase `i` repeats bursts of at least `phaseSteps[i]` steps, weighing after
+ * each one, until the measured mass reaches `phaseFraction[i]` of the target. A burst far from
+ * the phase target covers `approachFraction` of the remaining gap instead.
+ */
+struct DoseParams {
+    float initialFraction = 0.50;
+    float phaseFraction[3] = {0.80, 0.97, 0.99};
+    uint16_t phaseSteps[3] = {400, 20, 5};
+    uint16_t settleMs = 1000;      // Wait after each move before weighing.
+    uint8_t measSamples = 100;     // Conversions averaged per weighing.
+    uint16_t maxBursts = 500;      // Gives up after this many bursts (e.g. a jammed auger).
+    float approachFraction = 0.50; // Share of the gap to the phase target a burst may cover.
+};
+
+struct DoseResult {
+    float grams;           // Mass measured at the end of the dose.
+    uint16_t bursts;       // Bursts after the initial move.
+    unsigned long ms;      // Duration of the dose.
+    bool completed;        // Reached the last phase fraction (not aborted, no burst limit).
+};
+
+/**
+ * A dose waiting for the next vessel (`<DoseQueue>`).
+ */
+struct QueuedDose {
+    float grams;
+    uint8_t channel;
+};
+
+/**
+ * On-device closed-loop dosing (`<Dose,grams,channel>`).
+ *
+ * Runs the sequence the host's `dispense_powder_seq()` used to drive over serial, so a dose needs
+ * one command and no serial round trip per burst.
+ */
+class DoseController {
+public:
+    DoseController(Utils& utils, ScaleControls& scaleControls, DispenserControls& dispenserControls);
+
+    DoseResult dose(float grams, uint8_t channel);
+    const DoseParams& getParams() const { return params; }
+    bool setParams(const DoseParams& newParams);
+    void loadParams();
+    void sendParams();
+
+    bool queueDose(float grams, uint8_t channel) { return queue->push({grams, channel}); }
+    bool nextQueued(QueuedDose& next) { return queue->pop(next); }
+    uint8_t queuedDoses() const { return queue->count(); }
+    void clearQueue() { queue->clear(); }
+
+    static constexpr uint8_t queueSize = ARENA_DOSE_QUEUE;
+
+    static const unsigned long scaleReadyTimeoutMs;
+    static const int LOC_DOSE_PARAMS;
+
+private:
+    static bool isValid(const DoseParams& candidate);
+    float weigh();
+    bool settleAndWeigh(float& grams);
+
+    Utils& utils;
+    ScaleControls& scaleControls;
+    DispenserControls& dispenserControls;
+    DoseParams params;
+    float startWeight;  // Scale reading when the dose started; doses are measured relative to it.
+    RingBuffer<QueuedDose, queueSize>* queue;  // Doses started one per placed vessel (`Comms::runAutoDose()`).
+};
+
+#endif // DOSECONTROLLER_H
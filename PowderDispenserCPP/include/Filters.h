@@ -0,0 +1,103 @@
+#ifndef FILTERS_H
+#define FILTERS_H
+
+#include <stdint.h>
+
+/**
+ * Scale reading filters.
+ *
+ * Every filter offers two entry points:
+ * - `filter(x)`: filters a single reading and returns the filtered value.
+ * - `process(block, n)`: filters `n` raw conversions in one tight, inlined loop and returns the
+ *   sum of the filtered values, so callers can average whole blocks without a call per sample.
+ * Both paths produce identical results for the same input sequence.
+ */
+
+// Pass-through filter (FilterType NONE).
+struct NoFilter {
+    inline float filter(float reading) { return reading; }
+
+    inline float process(const int32_t* block, uint8_t n) {
+        float sum = 0;
+        for (uint8_t i = 0; i < n; i++) {
+            sum += block[i];
+        }
+        return sum;
+    }
+};
+
+// Exponentially weighted moving average (FilterType EWMA). The first reading seeds the output.
+struct EwmaFilter {
+    float alpha;
+    float output;
+    bool hasOutput;
+
+    explicit EwmaFilter(float alpha) : alpha(alpha), output(0), hasOutput(false) {}
+
+    inline float filter(float reading) {
+        output = hasOutput ? alpha * (reading - output) + output : reading;
+        hasOutput = true;
+        return output;
+    }
+
+    inline float process(const int32_t* block, uint8_t n) {
+        float sum = 0;
+        for (uint8_t i = 0; i < n; i++) {
+            sum += filter(block[i]);
+        }
+        return sum;
+    }
+
+    void reset() { hasOutput = false; }
+};
+
+// Simple moving average over a caller-provided window (FilterType SMA).
+struct SmaFilter {
+    float* values;
+    uint8_t size;
+    uint8_t index;
+    uint8_t count;
+    float sum;
+
+    SmaFilter(float* values, uint8_t size) : values(values), size(size), index(0), count(0), sum(0) {}
+
+    inline float filter(float reading) {
+        sum -= values[index];  // Subtract the oldest value from the sum.
+        values[index] = reading;  // Add the new value to the buffer.
+        sum += reading;  // Add the new value to the sum.
+        index = (index + 1) % size;  // Update the buffer index.
+        if (count < size) count++;
+        return sum / count;  // Compute the average.
+    }
+
+    inline float process(const int32_t* block, uint8_t n) {
+        float total = 0;
+        for (uint8_t i = 0; i < n; i++) {
+            total += filter(block[i]);
+        }
+        return total;
+    }
+};
+
+// First-order low-pass filter (FilterType LPF).
+struct LpfFilter {
+    float alpha;
+    float state;
+
+    LpfFilter(float alpha, float initial) : alpha(alpha), state(initial) {}
+
+    inline float filter(float reading) {
+        state = alpha * reading + (1.0f - alpha) * state;
+        return state;
+    }
+
+    inline float process(const int32_t* block, uint8_t n) {
+        float sum = 0;
+        for (uint8_t i = 0; i < n; i++) {
+            sum += filter(block[i]);
+        }
+        return sum;
+    }
+};
+
+#endif // FILTERS_H
@@ -0,0 +1,63 @@
+#ifndef HOPPERESTIMATOR_H
+#define HOPPERESTIMATOR_H
+
+#include <Arduino.h>
+#include "MemoryArena.h"
+
+struct HopperState {
+    float freshGps;           // Mean grams per step of the first moves after a refill.
+    float freshPos;           // Mean step position (since refill) of those moves.
+    float recentGps;          // Exponentially weighted grams per step of the latest moves.
+    float recentPos;          // Exponentially weighted step position of the latest moves.
+    uint32_t stepsSinceRefill;
+    float fillGrams;          // Mass loaded at the last refill; 0 if unknown.
+    float dispensedGrams;     // Mass dispensed since the refill (measured where reported).
+    float warnGrams;          // Remaining mass that raises the refill warning.
+    uint8_t freshCount;       // Moves averaged into `freshGps` (up to `freshSamples`).
+    bool warned;              // Refill warning already sent since the last refill.
+};
+
+/**
+ * Hopper level and flow-degradation estimator.
+ *
+ * Flow per step drops as a hopper empties. For every auger channel the estimator tracks the steps
+ * moved since the last refill and the grams per step of moves whose dispensed mass is measured,
+ * comparing the latest flow with the flow of a freshly filled hopper. The linear trend between the
+ * two predicts where the flow falls to `emptyFlowRatio` of fresh, which gives the remaining powder
+ * and the motor time to empty. The refill mass, when known, bounds the estimate. `<HopperLow ...>`
+ * is sent once per refill, as soon as the flow or the remaining mass crosses its warning threshold.
+ *
+ * The state lives in RAM only, so a reset starts every channel as freshly refilled with an unknown
+ * mass; send `<Refill>` again after a reset. It is not persisted: the four channel states do not fit
+ * the free EEPROM between the checkpoint ring, the dose parameters and the configuration image, and
+ * saving after every burst (about 20 per dose) would wear the 100k-cycle cells out within about
+ * 5000 doses.
+ */
+class HopperEstimator {
+public:
+    static void recordMove(uint8_t channel, long steps, float estimatedGrams);
+    static bool observe(uint8_t channel, float grams);
+    static void refill(uint8_t channel, float grams, float warnGrams);
+    static float remainingGrams(uint8_t channel);
+    static long stepsToEmpty(uint8_t channel);
+    static void send(uint8_t channel);
+
+    static constexpr uint8_t numChannels = ARENA_HOPPER_CHANNELS;
+    static constexpr uint8_t freshSamples = 3;       // Measured moves averaged as the fresh flow.
+    static constexpr long minObserveSteps = 100;     // Shorter moves are too small to weigh reliably.
+    static constexpr float recentWeight = 0.3;       // Weight of the newest flow observation.
+    static constexpr float warnFlowRatio = 0.85;     // Flow (relative to fresh) that raises the warning.
+    static constexpr float emptyFlowRatio = 0.6;     // Flow (relative to fresh) treated as empty.
+    static constexpr float minTrendDrop = 0.05;      // Flow drop (relative to fresh) before the trend is trusted.
+    static constexpr float defaultWarnFraction = 0.1;  // Default warning mass as a fraction of the refill.
+
+private:
+    static void checkWarning(uint8_t channel);
+
+    static HopperState* hoppers;
+    static uint8_t lastChannel;    // Channel of the last move, awaiting its measured mass.
+    static long lastSteps;         // Steps of that move; 0 once observed.
+    static float lastEstimate;     // Mass credited for that move from the auger calibration.
+};
+
+#endif // HOPPERESTIMATOR_H
@@ -0,0 +1,34 @@
+#ifndef IDLESLEEP_H
+#define IDLESLEEP_H
+
+#include <Arduino.h>
+
+/**
+ * Idle policy of the main loop and of `Utils::wait()`.
+ *
+ * Instead of spinning on `Serial.available()`, the CPU enters AVR idle sleep after each pass and
+ * wakes on the next interrupt: USART receive, the Timer0 millisecond tick (so a pass runs at least
+ * every 1.024 ms), TWI or the profiler timer. The clock to the core stops while asleep, which
+ * takes digital switching noise and self-heating away from the NAU7802. The scale's data-ready
+ * line is not wired on this board; the millisecond tick bounds the extra sample latency instead.
+ *
+ * The busy loop stays the default until the gain has been measured on the board: `<Idle,1>` turns
+ * sleeping on, `<Idle>` reports the policy and the time spent asleep, and
+ * `FastPowderDispenseController.compare_idle_sleep()` compares noise and settle time of the two.
+ * Sleeping is a no-op off AVR (the native simulator).
+ */
+class IdleSleep {
+public:
+    static void enter();
+    static void setEnabled(bool enable);
+    static bool isEnabled() { return enabled; }
+    static void send();
+
+private:
+    static bool enabled;
+    static uint32_t sleeps;         // Sleeps since the last report.
+    static uint32_t asleepUs;       // Time asleep since the last report.
+    static uint32_t windowStartUs;  // Start of the reporting window.
+};
+
+#endif // IDLESLEEP_H
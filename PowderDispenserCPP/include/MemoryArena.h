@@ -0,0 +1,131 @@
+#ifndef MEMORYARENA_H
+#define MEMORYARENA_H
+
+#include <Arduino.h>
+#include <new>
+
+/**
+ * Build profiles selecting the SRAM budget of every arena region.
+ * Select one with `-D MEMORY_PROFILE=<n>` in `platformio.ini`; the standard profile is the default.
+ */
+#define MEMORY_PROFILE_STANDARD 1  // Interactive use: longer sample blocks, fewer queued doses.
+#define MEMORY_PROFILE_BATCH    2  // Batch production: shorter commands, room for queued doses.
+
+#ifndef MEMORY_PROFILE
+#define MEMORY_PROFILE MEMORY_PROFILE_STANDARD
+#endif
+
+#if MEMORY_PROFILE == MEMORY_PROFILE_BATCH
+#define ARENA_RX_BYTES        96   // Command receive buffer and queued command buffer (one each).
+#define ARENA_TX_BYTES        96   // Copy of the last command echoed in replies.
+#define ARENA_PENDING_BYTES   64   // Actuation commands received while another one runs (power of two).
+#define ARENA_SAMPLE_BLOCK    16   // Samples per acquisition block (two blocks are allocated).
+#define ARENA_SMA_WINDOW      10   // SMA filter window.
+#define ARENA_TRACE_EVENTS    8    // Trace ring slots (power of two).
+#define ARENA_DOSE_QUEUE      8    // Slots for doses queued for vessel placement (power of two).
+#define ARENA_COMMAND_STATS   4    // Commands tracked for peak stack depth.
+#define ARENA_TWI_QUEUE       8    // I2C transactions queued or awaiting their callback (power of two).
+#elif MEMORY_PROFILE == MEMORY_PROFILE_STANDARD
+// Sized to leave the stack about 350 B of the 2 KB SRAM next to the arena (914 B), the other
+// globals and the serial and I2C buffers; check `minFree` in `<Stats>` when growing a region.
+#define ARENA_RX_BYTES        96
+#define ARENA_TX_BYTES        96
+#define ARENA_PENDING_BYTES   64
+#define ARENA_SAMPLE_BLOCK    20
+#define ARENA_SMA_WINDOW      10
+#define ARENA_TRACE_EVENTS    8
+#define ARENA_DOSE_QUEUE      4
+#define ARENA_COMMAND_STATS   4
+#define ARENA_TWI_QUEUE       8
+#else
+#error "Unknown MEMORY_PROFILE."
+#endif
+
+// Sampling profiler histogram, only reserved when the profiler is built in.
+#if defined(ENABLE_PROFILER)
+#define ARENA_PROFILE_BUCKETS 128
+#else
+#define ARENA_PROFILE_BUCKETS 0
+#endif
+
+#define ARENA_TRACE_EVENT_BYTES  12  // Budget per trace event (checked against `sizeof(TraceEvent)`).
+#define ARENA_DOSE_ENTRY_BYTES   8   // Budget per queued dose.
+#define ARENA_COMMAND_STAT_BYTES 12  // Budget per tracked command (checked against `sizeof(CommandStackStat)`).
+#define ARENA_HOPPER_ENTRY_BYTES 36  // Budget per hopper estimator channel (checked against `sizeof(HopperState)`).
+#define ARENA_HOPPER_CHANNELS    4   // Auger channels with a hopper estimate.
+
+/**
+ * Single, compile-time-sized static arena for every sizeable buffer in the firmware.
+ *
+ * Modules take their buffers from here with the typed `allocate<T>()` sub-allocator instead of
+ * declaring their own statics, so the whole SRAM budget is fixed at build time and reported by
+ * `report()`. Allocations are permanent; there is no free, so the arena never fragments and
+ * never grows into the stack.
+ */
+class MemoryArena {
+public:
+    /**
+     * Allocates and default-constructs `count` objects of type `T`.
+     *
+     * Parameters:
+     * - `count` (uint16_t): Number of objects.
+     * - `name` (const char*): Region name shown in the layout report, stored in flash (`PROGMEM`).
+     *
+     * Returns:
+     * - Pointer to the first object, or `nullptr` if the arena is exhausted (flagged in the report).
+     */
+    template <typename T>
+    static T* allocate(uint16_t count, const char* name) {
+        uint16_t start = (used + alignof(T) - 1) & ~(uint16_t)(alignof(T) - 1);
+        uint16_t bytes = sizeof(T) * count;
+        if (start + bytes > arenaBytes || regionCount >= maxRegions) {
+            overflow = true;
+            return nullptr;
+        }
+        regions[regionCount++] = {name, start, bytes};
+        used = start + bytes;
+
+        T* objects = reinterpret_cast<T*>(storage + start);
+        for (uint16_t i = 0; i < count; i++) {
+            new (objects + i) T();
+        }
+        return objects;
+    }
+
+    static void report();
+    static uint16_t bytesUsed() { return used; }
+    static uint16_t bytesFree() { return arenaBytes - used; }
+    static bool hasOverflowed() { return overflow; }
+
+    static constexpr uint8_t maxRegions = 14;  // 12 regions with the profiler built in, plus headroom.
+    static constexpr uint8_t alignSlack = alignof(uint64_t) - 1;  // Zero on AVR.
+
+    // Sum of all region budgets for the selected profile.
+    static constexpr uint16_t arenaBytes =
+        2 * ARENA_RX_BYTES + ARENA_TX_BYTES
+        + ARENA_PENDING_BYTES + 2
+        + 2 * ARENA_SAMPLE_BLOCK * sizeof(int32_t)
+        + ARENA_SMA_WINDOW * sizeof(float)
+        + ARENA_TRACE_EVENTS * ARENA_TRACE_EVENT_BYTES + 2
+        + ARENA_DOSE_QUEUE * ARENA_DOSE_ENTRY_BYTES + 2
+        + ARENA_COMMAND_STATS * ARENA_COMMAND_STAT_BYTES
+        + ARENA_HOPPER_CHANNELS * ARENA_HOPPER_ENTRY_BYTES
+        + ARENA_PROFILE_BUCKETS * sizeof(uint16_t)
+        + 2 * (ARENA_TWI_QUEUE * sizeof(void*) + 2)
+        + maxRegions * alignSlack;
+
+private:
+    struct Region {
+        const char* name;  // In flash.
+        uint16_t offset;
+        uint16_t bytes;
+    };
+
+    alignas(uint64_t) static uint8_t storage[arenaBytes];
+    static uint16_t used;
+    static bool overflow;
+    static Region regions[maxRegions];
+    static uint8_t regionCount;
+};
+
+#endif // MEMORYARENA_H
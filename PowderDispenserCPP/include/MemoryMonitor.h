@@ -0,0 +1,41 @@
+#ifndef MEMORYMONITOR_H
+#define MEMORYMONITOR_H
+
+#include <Arduino.h>
+#include "MemoryArena.h"
+
+struct CommandStackStat {
+    char name[10];   // Command token, truncated to fit.
+    uint16_t peak;   // Deepest stack use seen while the command ran, in bytes.
+};
+
+/**
+ * Free-memory and stack high-water monitoring.
+ *
+ * The free RAM between the heap and the stack is painted with a canary byte at boot. The lowest
+ * address whose canary was overwritten gives the stack high-water mark. Around every command the
+ * region below the current stack pointer is repainted, so the peak stack depth of each command
+ * can be measured on its own. On non-AVR builds every figure reads as zero.
+ */
+class MemoryMonitor {
+public:
+    static void beginCommand();
+    static void endCommand(const char* command);
+    static void sendStats();
+
+    static uint16_t freeMemory();
+    static uint16_t stackPeak();
+    static uint16_t minFreeMemory();
+
+    static constexpr uint8_t canary = 0xC5;
+    static constexpr uint8_t maxCommands = ARENA_COMMAND_STATS;
+
+private:
+    static uint16_t scanStackPeak();
+
+    static uint16_t peakStack;
+    static CommandStackStat* commands;
+    static uint8_t commandCount;
+};
+
+#endif // MEMORYMONITOR_H
@@ -2,6 +2,7 @@
 #define MIXERCONTROLS_H
 
 #include "Utils.h"
+#include "TwiEngine.h"
 #include <SparkFun_Qwiic_Relay.h>
 
 // Define relay addresses
@@ -23,9 +24,16 @@ public:
     void runPump(uint8_t pin, float runTime);
 
 private:
+    void switchRelay(Qwiic_Relay &relay, bool on);
+    static void onRelaySwitched(TwiTransaction& transaction);
+
     Utils& utils;
     Qwiic_Relay relay_mixer;
     Qwiic_Relay relay_drain;
+
+    // Relay commands on the TWI engine, one per relay (mixer, drain).
+    TwiTransaction relayCommands[2];
+    uint8_t relayCommandBytes[2];
 };
 
 #endif // MIXERCONTROLS_H
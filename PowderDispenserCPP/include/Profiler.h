@@ -0,0 +1,30 @@
+#ifndef PROFILER_H
+#define PROFILER_H
+
+#include <Arduino.h>
+#include "MemoryArena.h"
+
+/**
+ * Statistical sampling profiler.
+ *
+ * Built in only with `-D ENABLE_PROFILER` (see the `sparkfun_redboard_profile` environment).
+ * Timer2 interrupts the firmware at `sampleRateHz`; each tick records the interrupted return
+ * address into a histogram of `buckets` counters. Each counter covers `1 << shift` bytes of flash
+ * starting at `base`, so a coarse pass over the whole image can be followed by a zoomed pass over
+ * a hot region. Samples outside the window are counted in `other`.
+ *
+ * Time spent inside other interrupt handlers is not sampled (AVR interrupts do not nest).
+ * `PowderDispenserController/profiler.py` symbolizes a dump against the firmware ELF.
+ */
+class Profiler {
+public:
+    static void start(uint8_t shift, uint16_t base);
+    static void stop();
+    static void dump();
+
+    static constexpr uint8_t buckets = ARENA_PROFILE_BUCKETS;
+    static constexpr uint16_t sampleRateHz = 1000;
+    static constexpr uint8_t defaultShift = 8;  // 256-byte buckets cover the 32 KB flash.
+};
+
+#endif // PROFILER_H
@@ -0,0 +1,95 @@
+#ifndef RINGBUFFER_H
+#define RINGBUFFER_H
+
+#include <stdint.h>
+
+/**
+ * Lock-free single-producer/single-consumer ring buffer.
+ *
+ * One context (e.g. an ISR) pushes, another (e.g. `loop()`) pops. Head and tail are 8-bit,
+ * so every index read and write is a single atomic load/store on the 8-bit AVR and no
+ * `cli()`/`sei()` critical section is needed. Each index is written by exactly one side.
+ *
+ * Template parameters:
+ * - `T`: Element type (copied in and out).
+ * - `N`: Capacity slot count; must be a power of two no larger than 128. One slot is kept
+ *   free to tell "full" from "empty", so at most `N - 1` elements are queued.
+ */
+template <typename T, uint8_t N>
+class RingBuffer {
+    static_assert(N >= 2 && N <= 128 && (N & (N - 1)) == 0, "RingBuffer size must be a power of two (2..128).");
+
+public:
+    RingBuffer() : head(0), tail(0) {}
+
+    /**
+     * Queues one element. Producer side only.
+     *
+     * Returns:
+     * - `true` on success, `false` if the buffer is full (the element is dropped).
+     */
+    bool push(const T& item) {
+        uint8_t h = head;
+        uint8_t next = (h + 1) & mask;
+        if (next == tail) {
+            return false;
+        }
+        buffer[h] = item;
+        barrier();  // Publish the element before the index that makes it visible.
+        head = next;
+        return true;
+    }
+
+    /**
+     * Dequeues the oldest element. Consumer side only.
+     *
+     * Returns:
+     * - `true` if an element was copied into `item`, `false` if the buffer is empty.
+     */
+    bool pop(T& item) {
+        uint8_t t = tail;
+        if (t == head) {
+            return false;
+        }
+        item = buffer[t];
+        barrier();  // Finish reading the slot before handing it back to the producer.
+        tail = (t + 1) & mask;
+        return true;
+    }
+
+    /**
+     * Copies the oldest element without dequeuing it. Consumer side only.
+     *
+     * Lets the consumer keep a slot (e.g. a block index) claimed while it works on it and
+     * release it with `pop()` afterwards.
+     */
+    bool peek(T& item) const {
+        uint8_t t = tail;
+        if (t == head) {
+            return false;
+        }
+        item = buffer[t];
+        return true;
+    }
+
+    /**
+     * Drops every queued element. Consumer side only.
+     */
+    void clear() { tail = head; }
+
+    bool isEmpty() const { return head == tail; }
+    bool isFull() const { return ((head + 1) & mask) == tail; }
+    uint8_t count() const { return (uint8_t)(head - tail) & mask; }
+    static constexpr uint8_t capacity() { return N - 1; }
+
+private:
+    static constexpr uint8_t mask = N - 1;
+
+    static inline void barrier() { __asm__ __volatile__("" ::: "memory"); }
+
+    T buffer[N];
+    volatile uint8_t head;  // Next slot to write; owned by the producer.
+    volatile uint8_t tail;  // Next slot to read; owned by the consumer.
+};
+
+#endif // RINGBUFFER_H
@@ -1,10 +1,12 @@
-<<<<<<< HEAD
 #ifndef SCALECONTROLS_H
 #define SCALECONTROLS_H
 
 #include "Utils.h"
+#include "RingBuffer.h"
+#include "Filters.h"
+#include "MemoryArena.h"
+#include "TwiEngine.h"
 #include <SparkFun_Qwiic_Scale_NAU7802_Arduino_Library.h>
-#include <Ewma.h>
 
 enum FilterType {
     NONE,
@@ -13,58 +15,18 @@ enum FilterType {
     LPF
 };
 
-class ScaleControls {
-public:
-    ScaleControls(Utils& utils);
-
-    void setupScale(int sampleRate = 320, int gain = 128, int ldoVoltage = 3);
-    void scaleOn();
-    void scaleOff();
-    float getReading(uint8_t avgReadingSamples = 100, FilterType filterType = EWMA, unsigned long timeout_ms = 1000);
-    float convertToWeight(float reading);
-    void sendWeight(uint8_t avgReadingSamples = 100, FilterType filterType = EWMA, unsigned long timeout_ms = 1000);
-    void sendRaw(uint8_t avgReadingSamples = 100, FilterType filterType = EWMA, unsigned long timeout_ms = 1000);
-    static FilterType getFilterTypeFromString(const char* filterTypeStr);
-    void calculateCalParams(float manual_slope, float manual_intercept);
-    float applyFilter(float reading, FilterType filterType = EWMA);
-    void tareScale();
-
-    static constexpr bool allowNegative = true;
-    static constexpr uint8_t numReadings = 10;
-    static const uint8_t numMeas;
-    static const float MANUAL_SLOPE;
-    static const float MANUAL_INTERCEPT;
-    static const float lpfAlpha;
-    static float smaFilterValues[numReadings];
-
-    static const int LOC_CALIBRATION_FACTOR;
-    static const int LOC_ZERO_OFFSET;
-    static const int LOC_CH1_OFFSET;
-
-private:
-    Utils& utils;
-    NAU7802 Scale;
-    Ewma ewmaFilter;
-
-    float lpfFilterValue;
-    bool settingsDetected;
-    bool scaleRunning;
+enum PlacementState {
+    PLACEMENT_OFF,       // Detection disarmed.
+    PLACEMENT_EMPTY,     // Tracking the empty-scale baseline, waiting for a step.
+    PLACEMENT_SETTLING,  // Weight stepped up, waiting for it to hold still.
+    PLACEMENT_PLACED     // Vessel detected, not yet taken.
 };
 
-#endif // SCALECONTROLS_H
-=======
-#ifndef SCALECONTROLS_H
-#define SCALECONTROLS_H
-
-#include "Utils.h"
-#include <SparkFun_Qwiic_Scale_NAU7802_Arduino_Library.h>
-#include <Ewma.h>
-
-enum FilterType {
-    NONE,
-    EWMA,
-    SMA,
-    LPF
+enum ScaleState {
+    SCALE_OFF,       // Analog and digital sections powered down.
+    SCALE_STANDBY,   // Front end biased, conversions stopped.
+    SCALE_SETTLING,  // Conversions running, waiting for the first stable sample.
+    SCALE_READY      // Conversions running and settled.
 };
 
 class ScaleControls {
@@ -74,36 +36,127 @@ public:
     void setupScale(int sampleRate = 320, int gain = 128, int ldoVoltage = 3);
     void scaleOn();
     void scaleOff();
+    void powerDownScale();
+    void update(unsigned long now, bool systemIdle = true);
+    void setIdlePowerDown(unsigned long idleMs);
+    void setAfeCalInterval(unsigned long intervalMs);
+    bool isAfeCalibrating() const { return afeCalibrating; }
+    unsigned long predictReadyMs();
+    bool pollSample();
+    void setStream(uint8_t every, bool raw = false);
+    void armPlacement(float stepGrams, unsigned long stableMs);
+    void disarmPlacement() { placementState = PLACEMENT_OFF; }
+    void pausePlacement();
+    void resumePlacement();
+    bool takePlacement(float& vesselGrams);
+    PlacementState getPlacementState() const { return placementState; }
+    float getPlacementStep() const { return placementStepGrams; }
+    unsigned long getPlacementStableMs() const { return placementStableMs; }
+    ScaleState getScaleState() const { return scaleState; }
+    uint16_t getSampleRate() const { return sampleRate; }
+    bool isScaleReady() const { return scaleState == SCALE_READY; }
     float getReading(uint8_t avgReadingSamples = 100, FilterType filterType = EWMA, unsigned long timeout_ms = 1000);
+    bool lastReadingTimedOut() const { return readingTimedOut; }
     float convertToWeight(float reading);
     void sendWeight(uint8_t avgReadingSamples = 100, FilterType filterType = EWMA, unsigned long timeout_ms = 1000);
     void sendRaw(uint8_t avgReadingSamples = 100, FilterType filterType = EWMA, unsigned long timeout_ms = 1000);
     static FilterType getFilterTypeFromString(const char* filterTypeStr);
     void calculateCalParams(float manual_slope, float manual_intercept);
     float applyFilter(float reading, FilterType filterType = EWMA);
+    float processBlock(const int32_t* block, uint8_t n, FilterType filterType = EWMA);
     void tareScale();
+    int32_t getZeroOffset() { return Scale.getZeroOffset(); }
+    void setZeroOffset(int32_t zeroOffset) { Scale.setZeroOffset(zeroOffset); }
 
     static constexpr bool allowNegative = true;
-    static constexpr uint8_t numReadings = 10;
+    static constexpr uint8_t numReadings = ARENA_SMA_WINDOW;
     static const uint8_t numMeas;
     static const float MANUAL_SLOPE;
     static const float MANUAL_INTERCEPT;
     static const float lpfAlpha;
-    static float smaFilterValues[numReadings];
+    static const uint8_t settleSamples;
+    static const unsigned long powerUpSettleMs;
+    static const unsigned long defaultIdlePowerDownMs;
+    static const unsigned long tareSettleTimeoutMs;
+    static const unsigned long defaultAfeCalIntervalMs;
+    static const unsigned long afeCalTimeoutMs;
+    static constexpr uint8_t sampleBlockSize = ARENA_SAMPLE_BLOCK;
+    static constexpr uint8_t placementWindow = 16;  // Conversions per placement detection window.
+    static const float placementNoiseGrams;
+    static const float defaultPlacementStepGrams;
+    static const unsigned long defaultPlacementStableMs;
 
     static const int LOC_CALIBRATION_FACTOR;
     static const int LOC_ZERO_OFFSET;
     static const int LOC_CH1_OFFSET;
 
 private:
+    void startAfeCal(unsigned long now);
+    void finishAfeCal(unsigned long now);
+    void waitForAfeCal();
+    void streamSample(int32_t raw);
+    bool takeConversion(int32_t& raw);
+    void trackPlacement(int32_t raw);
+    static void onConversionRead(TwiTransaction& transaction);
+
     Utils& utils;
     NAU7802 Scale;
-    Ewma ewmaFilter;
+    EwmaFilter ewmaFilter;
+    SmaFilter smaFilter;
+    LpfFilter lpfFilter;
+
+    // Double-buffered acquisition: one block fills while the other is filtered.
+    int32_t* sampleBlocks;              // Two consecutive blocks of `sampleBlockSize` samples.
+    RingBuffer<uint8_t, 2> fullBlocks;  // Index of the block waiting to be filtered (at most one).
+    uint8_t fillBlock;                  // Block currently being filled by the acquisition side.
+    uint8_t fillCount;                  // Samples already written into `fillBlock`.
+    volatile bool restartBlocks;        // Set by the consumer to discard the partially filled block.
+    bool readingTimedOut;               // The last `getReading()` averaged fewer samples than requested.
 
-    float lpfFilterValue;
     bool settingsDetected;
     bool scaleRunning;
+
+    ScaleState scaleState;
+    bool notifyReady;
+    uint8_t settleCount;
+    unsigned long stateSince;
+    unsigned long settleMs;
+    unsigned long idlePowerDownMs;
+
+    // Background AFE recalibration.
+    bool afeCalibrating;
+    unsigned long afeCalSince;
+    unsigned long lastAfeCal;
+    unsigned long afeCalIntervalMs;
+
+    uint16_t sampleRate;  // Conversions per second set by `setupScale()`.
+
+    // Conversion reads on the TWI engine: PU_CTRL until the cycle-ready bit is set, then ADCO.
+    TwiTransaction conversionRead;
+    uint8_t conversionRegister;  // Register the running read starts at.
+    uint8_t conversionBytes[3];  // ADCO_B2..B0, most significant first.
+    int32_t pendingRaw;          // Conversion read but not yet taken.
+    bool hasPending;
+
+    // Vessel placement detection (<AutoDose>), on window means in ADC counts.
+    PlacementState placementState;
+    bool placementPaused;             // A command is moving the weight; conversions are ignored.
+    float placementStepGrams;         // Rise that counts as a vessel.
+    unsigned long placementStableMs;  // How long the raised weight must hold still.
+    bool placementHasBaseline;
+    int32_t placementBaseline;        // Empty-scale mean.
+    int32_t placementLastMean;        // Mean of the previous window.
+    int32_t placementMin;             // Extremes and sum of the window being collected.
+    int32_t placementMax;
+    int32_t placementSum;
+    uint8_t placementCount;
+    unsigned long placementSince;     // Start of the current still period while settling.
+    float placementVesselGrams;       // Mass of the detected vessel.
+
+    // Weight telemetry (<Stream>).
+    uint8_t streamEvery;  // Send every Nth conversion; 0 when not streaming.
+    uint8_t streamCount;
+    bool streamRaw;       // Send ADC counts instead of grams.
 };
 
 #endif // SCALECONTROLS_H
->>>>>>> c5e728c45412297ccfbd7313ba623480bfd3dee3
@@ -0,0 +1,42 @@
+#ifndef TIMINGMODEL_H
+#define TIMINGMODEL_H
+
+#include <Arduino.h>
+
+/**
+ * Learned timing model for duration predictions.
+ *
+ * Tracks exponentially weighted averages of the dispenser step period, the relay/pump switching
+ * overhead and the scale settle time, as observed on the device. `<Predict,...>` uses them to
+ * estimate how long a command will take; the prediction is armed, and once the predicted command
+ * completes the device reports `<Actual kind:K ms:A predicted:P>`.
+ */
+class TimingModel {
+public:
+    static void observeMove(long steps, unsigned long elapsedUs);
+    static void observeRelay(float requestedS, unsigned long elapsedMs);
+    static void observeSettle(unsigned long elapsedMs);
+
+    static unsigned long predictMove(long steps);
+    static unsigned long predictRelay(float requestedS);
+    static unsigned long predictSettle();
+    static uint16_t stepsWithin(unsigned long ms);
+
+    static void arm(const char* command, unsigned long predictedMs);
+    static void completeCommand(const char* command, unsigned long elapsedMs);
+    static void sendPrediction(const char* command, unsigned long predictedMs, bool armReport);
+
+    static constexpr float learnRate = 0.2;       // Weight of the newest observation.
+    static constexpr long minLearnSteps = 100;    // Shorter moves are dominated by command overhead.
+
+private:
+    static float usPerStep;        // Dispenser time per microstep.
+    static float moveOverheadMs;   // Fixed cost per move (driver commands).
+    static float relayOverheadMs;  // Relay/pump time beyond the requested duration.
+    static float settleMs;         // Scale wake-to-ready time.
+
+    static char armedCommand[14];  // Command whose completion is reported, empty if none.
+    static unsigned long armedPredictionMs;
+};
+
+#endif // TIMINGMODEL_H
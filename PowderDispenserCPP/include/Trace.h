@@ -0,0 +1,33 @@
+#ifndef TRACE_H
+#define TRACE_H
+
+#include <Arduino.h>
+#include "RingBuffer.h"
+#include "MemoryArena.h"
+
+enum TraceEventType : uint8_t {
+    TRACE_COMMAND,          // A command frame was dispatched (value: frame length).
+    TRACE_STEP,             // A dispenser move completed (value: signed step count).
+    TRACE_SCALE_READY,      // The scale reported its first stable sample (value: settle time in ms).
+    TRACE_AFE_CAL,          // A background AFE recalibration finished (value: duration in ms, -1 on failure).
+    TRACE_VESSEL            // A vessel was placed on the armed scale (value: its mass in mg).
+};
+
+struct TraceEvent {
+    uint32_t time;       // Timestamp in milliseconds.
+    uint8_t type;        // One of `TraceEventType`.
+    int32_t value;       // Event specific payload.
+};
+
+class Trace {
+public:
+    static void record(uint8_t type, int32_t value);
+    static void dump();
+
+    static constexpr uint8_t traceSize = ARENA_TRACE_EVENTS;
+
+private:
+    static RingBuffer<TraceEvent, traceSize>* events;
+};
+
+#endif // TRACE_H
@@ -0,0 +1,75 @@
+#ifndef TWIENGINE_H
+#define TWIENGINE_H
+
+#include <Arduino.h>
+#include "RingBuffer.h"
+#include "MemoryArena.h"
+
+enum TwiStatus : uint8_t {
+    TWI_IDLE,       // Never submitted, or completed and handed back.
+    TWI_PENDING,    // Queued or on the bus.
+    TWI_OK,
+    TWI_NACK,       // The device did not acknowledge its address or a byte.
+    TWI_BUS_ERROR   // Arbitration lost, bus error or timeout.
+};
+
+struct TwiTransaction;
+typedef void (*TwiCallback)(TwiTransaction& transaction);
+
+/**
+ * One I2C transfer: `writeLength` bytes, then (after a repeated start) `readLength` bytes.
+ * Owned by the caller and left untouched until it completes; buffers must stay valid as long.
+ */
+struct TwiTransaction {
+    uint8_t address = 0;
+    const uint8_t* writeData = nullptr;
+    uint8_t writeLength = 0;
+    uint8_t* readData = nullptr;
+    uint8_t readLength = 0;
+    TwiCallback done = nullptr;    // Run by `TwiEngine::poll()`, never from the interrupt.
+    void* context = nullptr;       // Free for the callback.
+    volatile TwiStatus status = TWI_IDLE;
+
+    bool isBusy() const { return status == TWI_PENDING; }
+};
+
+/**
+ * Interrupt-driven I2C master with a transaction queue.
+ *
+ * `submit()` returns at once; the TWI interrupt walks each transaction through start, address,
+ * data and stop, so bus time overlaps with filtering and step generation instead of blocking
+ * the CPU. Completion callbacks run from `poll()` in the main context (the main loop and
+ * `Utils::wait()` call it), so they may submit follow-up transactions and print.
+ *
+ * On AVR the engine owns the TWI hardware and its interrupt; the project's `Wire` library
+ * (`lib/TwiWire`) runs the vendor drivers' blocking calls through it. In the native simulator the
+ * transfers go to the simulated bus (`sim::twiTransfer()`).
+ */
+class TwiEngine {
+public:
+    static void begin(uint32_t frequency = 400000);
+    static bool submit(TwiTransaction& transaction);
+    static void poll();
+    static TwiStatus wait(TwiTransaction& transaction);
+    static bool isIdle() { return !busy; }
+
+    static constexpr uint8_t queueSize = ARENA_TWI_QUEUE;
+    static constexpr uint16_t timeoutMs = 25;  // A transfer still running after this is aborted.
+
+    // Bus back end: the transaction on the bus and its completion.
+    static TwiTransaction* volatile current;
+    static void complete(TwiStatus status);
+
+private:
+    static void startNext();
+
+    struct Queues {
+        RingBuffer<TwiTransaction*, queueSize> submitted;  // Main context pushes, the bus pops.
+        RingBuffer<TwiTransaction*, queueSize> finished;   // The bus pushes, `poll()` pops.
+    };
+    static Queues* queues;
+    static volatile bool busy;
+    static unsigned long startedMs;
+};
+
+#endif // TWIENGINE_H
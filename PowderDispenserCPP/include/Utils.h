@@ -1,4 +1,3 @@
-<<<<<<< HEAD
 #ifndef UTILS_H
 #define UTILS_H
 
@@ -13,31 +12,23 @@ class Utils {
         void clearEEPROM();
 
         static int getDecimal() { return DECIMAL; }
+        static unsigned long getBaudRate() { return BAUD_RATE; }
 
-    private:
-        static const int DECIMAL = 4;
-};
-
-#endif // UTILS_H
-=======
-#ifndef UTILS_H
-#define UTILS_H
+        static void setBackgroundTask(void (*task)()) { backgroundTask = task; }
+        static void runBackgroundTask();
+        static bool wait(unsigned long ms);
 
-#include <Arduino.h>
-#include <Wire.h>
-#include <EEPROM.h>
-
-class Utils {
-    public:
-        Utils();
-        void setupArduino();
-        void clearEEPROM();
-
-        static int getDecimal() { return DECIMAL; }
+        static void requestAbort() { abortRequested = true; }
+        static void clearAbort() { abortRequested = false; }
+        static bool isAbortRequested() { return abortRequested; }
 
     private:
         static const int DECIMAL = 4;
+        static const unsigned long BAUD_RATE = 115200;
+
+        static void (*backgroundTask)();
+        static bool inBackgroundTask;
+        static volatile bool abortRequested;
 };
 
 #endif // UTILS_H
->>>>>>> c5e728c45412297ccfbd7313ba623480bfd3dee3
@@ -0,0 +1,131 @@
+#include "Arduino.h"
+
+HardwareSerial Serial;
+
+namespace sim {
+uint8_t pumpPin = 12;
+}
+
+static uint8_t pinLevels[32];
+
+/**
+ * Returns simulated milliseconds, charging the CPU time of the read (see `sim::poll()`).
+ */
+unsigned long millis() {
+    sim::poll();
+    return (unsigned long)(sim::nowUs() / 1000);
+}
+
+/**
+ * Returns simulated microseconds, charging the CPU time of the read (see `sim::poll()`).
+ */
+unsigned long micros() {
+    sim::poll();
+    return (unsigned long)sim::nowUs();
+}
+
+/**
+ * Skips simulated time forward at once.
+ */
+void delay(unsigned long ms) {
+    sim::advance((uint64_t)ms * 1000);
+}
+
+void delayMicroseconds(unsigned int us) {
+    sim::advance(us);
+}
+
+void pinMode(uint8_t pin, uint8_t mode) {
+    (void)pin;
+    (void)mode;
+}
+
+void digitalWrite(uint8_t pin, uint8_t value) {
+    sim::activity();
+    if (pin < sizeof(pinLevels)) {
+        pinLevels[pin] = value;
+    }
+    if (pin == sim::pumpPin) {
+        sim::world().pumpOn = value == HIGH;
+    }
+}
+
+int digitalRead(uint8_t pin) {
+    return pin < sizeof(pinLevels) ? pinLevels[pin] : LOW;
+}
+
+size_t Print::write(const char* text) {
+    size_t n = 0;
+    while (*text) {
+        n += write((uint8_t)*text++);
+    }
+    return n;
+}
+
+size_t Print::print(const char* text) {
+    return write(text);
+}
+
+size_t Print::print(char c) {
+    return write((uint8_t)c);
+}
+
+size_t Print::print(long value, int base) {
+    if (base == DEC) {
+        char buffer[24];
+        snprintf(buffer, sizeof(buffer), "%ld", value);
+        return write(buffer);
+    }
+    return print((unsigned long)value, base);
+}
+
+size_t Print::print(unsigned long value, int base) {
+    char buffer[72];
+    snprintf(buffer, sizeof(buffer), base == HEX ? "%lX" : "%lu", value);
+    return write(buffer);
+}
+
+size_t Print::print(double value, int digits) {
+    char buffer[48];
+    snprintf(buffer, sizeof(buffer), "%.*f", digits, value);
+    return write(buffer);
+}
+
+size_t Print::println() {
+    return write("\r\n");
+}
+
+int HardwareSerial::available() {
+    uint64_t now = sim::nowUs();
+    if (now - lastPollUs > maxGapUs) {
+        maxGapUs = now - lastPollUs;
+    }
+    lastPollUs = now;
+    return (int)(rx.size() - rxPos);
+}
+
+int HardwareSerial::read() {
+    if (rxPos >= rx.size()) {
+        return -1;
+    }
+    sim::activity();
+    return (uint8_t)rx[rxPos++];
+}
+
+/**
+ * Queues bytes as if the PC had sent them.
+ */
+void HardwareSerial::inject(const std::string& data) {
+    rx.erase(0, rxPos);
+    rxPos = 0;
+    rx += data;
+}
+
+/**
+ * Returns and clears everything the firmware printed since the last call.
+ */
+std::string HardwareSerial::takeOutput() {
+    std::string output;
+    output.swap(tx);
+    return output;
+}
@@ -0,0 +1,118 @@
+#ifndef ARDUINO_H
+#define ARDUINO_H
+
+/**
+ * Arduino core for the native simulator.
+ *
+ * Provides the subset of the Arduino API the firmware uses, backed by the virtual clock
+ * (`SimClock.h`) and the simulated world (`SimWorld.h`). `Serial` keeps what the firmware prints
+ * and replays frames injected by a test.
+ */
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <stdio.h>
+#include <algorithm>
+#include <string>
+
+#include "SimClock.h"
+#include "SimWorld.h"
+
+typedef uint8_t byte;
+typedef bool boolean;
+
+#define HIGH 0x1
+#define LOW 0x0
+#define INPUT 0x0
+#define OUTPUT 0x1
+#define INPUT_PULLUP 0x2
+#define DEC 10
+#define HEX 16
+#define PROGMEM
+
+// Flash strings are ordinary strings on the host, but F() keeps its own
+// pointer type so code that mixes the two fails here as it would on AVR.
+class __FlashStringHelper;
+#define F(string_literal) (reinterpret_cast<const __FlashStringHelper*>(string_literal))
+#define PSTR(string_literal) (string_literal)
+#define strcmp_P strcmp
+#define strncmp_P strncmp
+#define strcpy_P strcpy
+
+using std::min;
+using std::max;
+
+template <typename T>
+T constrain(T value, T low, T high) { return value < low ? low : (value > high ? high : value); }
+
+unsigned long millis();
+unsigned long micros();
+void delay(unsigned long ms);
+void delayMicroseconds(unsigned int us);
+
+// Single-threaded: simulated devices only act between firmware statements, as scheduled events.
+inline void noInterrupts() {}
+inline void interrupts() {}
+
+void pinMode(uint8_t pin, uint8_t mode);
+void digitalWrite(uint8_t pin, uint8_t value);
+int digitalRead(uint8_t pin);
+
+class Print {
+public:
+    virtual ~Print() {}
+    virtual size_t write(uint8_t c) = 0;
+    size_t write(const char* text);
+
+    size_t print(const char* text);
+    size_t print(const __FlashStringHelper* text) { return print(reinterpret_cast<const char*>(text)); }
+    size_t print(char c);
+    size_t print(int value, int base = DEC) { return print((long)value, base); }
+    size_t print(unsigned int value, int base = DEC) { return print((unsigned long)value, base); }
+    size_t print(long value, int base = DEC);
+    size_t print(unsigned long value, int base = DEC);
+    size_t print(double value, int digits = 2);
+
+    size_t println();
+    template <typename T>
+    size_t println(T value) { size_t n = print(value); return n + println(); }
+    template <typename T>
+    size_t println(T value, int format) { size_t n = print(value, format); return n + println(); }
+};
+
+class HardwareSerial : public Print {
+public:
+    void begin(unsigned long baud) { (void)baud; }
+    int available();
+    int read();
+    int peek() { return rxPos < rx.size() ? (uint8_t)rx[rxPos] : -1; }
+    void flush() {}
+    size_t write(uint8_t c) override { sim::activity(); tx.push_back((char)c); return 1; }
+    using Print::write;
+
+    void inject(const std::string& data);
+    std::string takeOutput();
+
+    // Longest gap between two polls of `available()` since `resetPollGap()`: the worst-case
+    // latency before the firmware notices an incoming frame.
+    uint64_t maxPollGapUs() const { return maxGapUs; }
+    void resetPollGap() { maxGapUs = 0; lastPollUs = sim::nowUs(); }
+
+private:
+    uint64_t lastPollUs = 0;
+    uint64_t maxGapUs = 0;
+    std::string rx;
+    size_t rxPos = 0;
+    std::string tx;
+};
+
+extern HardwareSerial Serial;
+
+namespace sim {
+extern uint8_t pumpPin;  // Pin whose level is mirrored into `World::pumpOn`.
+}
+
+#endif // ARDUINO_H
@@ -0,0 +1,5 @@
+#include "Wire.h"
+#include "EEPROM.h"
+
+TwoWire Wire;
+EEPROMClass EEPROM;
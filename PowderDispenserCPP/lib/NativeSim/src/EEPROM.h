@@ -0,0 +1,49 @@
+#ifndef EEPROM_H
+#define EEPROM_H
+
+#include "Arduino.h"
+
+/**
+ * EEPROM of the native simulator: 1 KB like the ATmega328P, erased to 0xFF, with a write counter
+ * per cell so tests can check wear leveling.
+ */
+class EEPROMClass {
+public:
+    static constexpr uint16_t size = 1024;
+
+    EEPROMClass() { erase(); }
+
+    uint8_t read(int address) const { return cells[address]; }
+    void write(int address, uint8_t value) { cells[address] = value; writes[address]++; }
+    void update(int address, uint8_t value) { if (cells[address] != value) write(address, value); }
+    uint16_t length() const { return size; }
+
+    template <typename T>
+    T& get(int address, T& value) const {
+        memcpy(&value, cells + address, sizeof(T));
+        return value;
+    }
+
+    template <typename T>
+    const T& put(int address, const T& value) {
+        const uint8_t* bytes = reinterpret_cast<const uint8_t*>(&value);
+        for (size_t i = 0; i < sizeof(T); i++) {
+            update(address + i, bytes[i]);
+        }
+        return value;
+    }
+
+    void erase() {
+        memset(cells, 0xFF, sizeof(cells));
+        memset(writes, 0, sizeof(writes));
+    }
+    uint32_t writeCount(int address) const { return writes[address]; }
+
+private:
+    uint8_t cells[size];
+    uint32_t writes[size];
+};
+
+extern EEPROMClass EEPROM;
+
+#endif // EEPROM_H
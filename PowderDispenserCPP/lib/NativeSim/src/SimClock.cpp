@@ -0,0 +1,118 @@
+#include "SimClock.h"
+
+#include <queue>
+#include <vector>
+
+namespace sim {
+
+uint32_t callCostUs = 20;     // Roughly one pass of a short polling loop on the 16 MHz AVR.
+uint32_t i2cTransferUs = 200; // A short register transfer at 100 kHz.
+uint32_t idleQuantumUs = 1000;
+
+namespace {
+
+struct Scheduled {
+    uint64_t time;
+    uint64_t order;  // Keeps events scheduled for the same time in FIFO order.
+    Event event;
+
+    bool operator>(const Scheduled& other) const {
+        return time != other.time ? time > other.time : order > other.order;
+    }
+};
+
+uint64_t now = 0;
+uint64_t nextOrder = 0;
+bool dispatching = false;
+bool active = true;       // I/O happened since the last clock poll.
+uint64_t idleCostUs = 0;  // Cost of the next idle poll.
+std::priority_queue<Scheduled, std::vector<Scheduled>, std::greater<Scheduled>> events;
+
+}  // namespace
+
+/**
+ * Returns the current simulated time in microseconds.
+ */
+uint64_t nowUs() {
+    return now;
+}
+
+/**
+ * Moves simulated time forward, firing every event that falls due on the way in time order.
+ *
+ * Parameters:
+ * - `us` (uint64_t): Time to advance in microseconds.
+ *
+ * Behavior:
+ * - Events may schedule further events; those fire too if they fall within the window.
+ * - Calls made from inside an event (e.g. an event reading `millis()`) do not advance time.
+ */
+void advance(uint64_t us) {
+    if (dispatching) {
+        return;
+    }
+    uint64_t target = now + us;
+    dispatching = true;
+    while (!events.empty() && events.top().time <= target) {
+        Scheduled next = events.top();
+        events.pop();
+        now = next.time;
+        active = true;
+        next.event();
+    }
+    dispatching = false;
+    now = target;
+}
+
+/**
+ * Charges the CPU time of one clock read (`millis()`/`micros()`).
+ *
+ * Behavior:
+ * - After I/O, a read costs `callCostUs`.
+ * - Consecutive reads with no I/O in between double their cost up to `idleQuantumUs`, but never
+ *   jump past the next scheduled event.
+ */
+void poll() {
+    if (active || idleQuantumUs == 0) {
+        active = false;
+        idleCostUs = callCostUs;
+    } else if (idleCostUs < idleQuantumUs) {
+        idleCostUs = idleCostUs * 2 < idleQuantumUs ? idleCostUs * 2 : idleQuantumUs;
+    }
+    uint64_t cost = idleCostUs;
+    if (!events.empty() && events.top().time > now && events.top().time - now < cost) {
+        cost = events.top().time - now;
+    }
+    advance(cost > callCostUs ? cost : callCostUs);
+}
+
+/**
+ * Marks I/O by the firmware (serial traffic, device access, pin writes), ending an idle streak.
+ */
+void activity() {
+    active = true;
+}
+
+/**
+ * Schedules an event.
+ *
+ * Parameters:
+ * - `delayUs` (uint64_t): Time from now until the event fires, in microseconds.
+ * - `event` (Event): Callback run when simulated time reaches it.
+ */
+void schedule(uint64_t delayUs, Event event) {
+    events.push({now + delayUs, nextOrder++, event});
+}
+
+/**
+ * Drops all pending events and rewinds the clock to zero. Only for a fresh simulation; firmware
+ * objects that remember timestamps must be rebuilt afterwards.
+ */
+void reset() {
+    events = decltype(events)();
+    now = 0;
+    nextOrder = 0;
+    active = true;
+}
+
+}  // namespace sim
@@ -0,0 +1,37 @@
+#ifndef SIMCLOCK_H
+#define SIMCLOCK_H
+
+#include <stdint.h>
+#include <functional>
+
+/**
+ * Virtual clock and event scheduler of the native simulator.
+ *
+ * Simulated time only moves when the firmware spends it: `delay()` jumps ahead at once, every
+ * `millis()`/`micros()` call costs `callCostUs` of simulated CPU time (so polling loops make
+ * progress), and the fake devices charge their bus and motion time. Device activity (scale
+ * conversions, powder landing on the scale, calibration completion) is scheduled as events that
+ * fire in time order as the clock passes them, so hours of operation run in host milliseconds.
+ *
+ * A loop that only polls the clock, with no I/O in between, is fast-forwarded: each further idle
+ * poll costs twice the previous one, up to `idleQuantumUs` and never past the next event, so a
+ * busy wait overshoots its deadline by at most one quantum.
+ */
+namespace sim {
+
+typedef std::function<void()> Event;
+
+uint64_t nowUs();
+void advance(uint64_t us);
+void poll();
+void activity();
+void schedule(uint64_t delayUs, Event event);
+void reset();
+
+extern uint32_t callCostUs;      // Simulated CPU time charged per `millis()`/`micros()` call.
+extern uint32_t i2cTransferUs;   // Simulated time of one I2C register transfer.
+extern uint32_t idleQuantumUs;   // Largest step of an idle polling loop; 0 disables fast-forwarding.
+
+}  // namespace sim
+
+#endif // SIMCLOCK_H
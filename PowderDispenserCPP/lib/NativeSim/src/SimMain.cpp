@@ -0,0 +1,132 @@
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <string.h>
+
+#include "Arduino.h"
+
+/**
+ * Entry point of `pio run -e native`: the firmware on a simulated board, driven over stdin.
+ *
+ * Linked only when no other `main()` exists (the library is an archive and nothing else in this
+ * file is referenced), so `pio test` keeps the test runner's `main()`.
+ *
+ * Every stdin line is one of:
+ * - `<Frame>`: sent to the firmware as if the PC had sent it.
+ * - `!until TEXT [ms]`: runs `loop()` until the firmware prints TEXT; prints `!timeout` after
+ *   `ms` (default 60000) of simulated time.
+ * - `!run ms`: runs `loop()` for `ms` of simulated time.
+ * - `!seed N`: restores the default world with random seed N.
+ * - `!set NAME VALUE`: sets a `sim::World` parameter (see `setWorld()`).
+ * - `!mass`: prints `!mass G`, the true mass on the scale.
+ * - `!time`: prints `!time MS`, the simulated time.
+ * - `!quit`: exits.
+ * Firmware output is copied to stdout as it is printed.
+ */
+
+void setup();
+void loop();
+
+static std::string output;  // Firmware output not yet matched by `!until`.
+
+static void runLoop() {
+    loop();
+    std::string printed = Serial.takeOutput();
+    std::cout << printed;
+    output += printed;
+}
+
+static void runUntil(const std::string& text, unsigned long timeoutMs) {
+    unsigned long start = millis();
+    size_t found;
+    while ((found = output.find(text)) == std::string::npos) {
+        if (millis() - start >= timeoutMs) {
+            std::cout << "!timeout" << std::endl;
+            output.clear();
+            return;
+        }
+        runLoop();
+    }
+    output.erase(0, found + text.size());
+    std::cout.flush();
+}
+
+/**
+ * Sets a world parameter by name.
+ *
+ * Returns:
+ * - `false` for an unknown name.
+ */
+static bool setWorld(const std::string& name, double value) {
+    sim::World& world = sim::world();
+    if (name == "gramsPerStep") world.gramsPerStep = value;
+    else if (name == "flowNoise") world.flowNoise = value;
+    else if (name == "scaleNoiseG") world.scaleNoiseG = value;
+    else if (name == "vibrationNoiseG") world.vibrationNoiseG = value;
+    else if (name == "massOnScaleG") world.massOnScaleG = value;
+    else if (name == "stepPeriodUs") world.stepPeriodUs = value;
+    else if (name == "moveOverheadUs") world.moveOverheadUs = value;
+    else if (name == "fallDelayUs") world.fallDelayUs = value;
+    else if (name == "jamAfterSteps") world.jamAfterSteps = value;
+    else if (name == "jamSteps") world.jamSteps = value;
+    else if (name == "mixerOn") world.mixerOn = value != 0;
+    else return false;
+    return true;
+}
+
+int main() {
+    std::cout.precision(9);
+    setup();
+    runLoop();
+
+    std::string line;
+    while (std::getline(std::cin, line)) {
+        if (!line.empty() && line.back() == '\r') {
+            line.pop_back();
+        }
+        if (line.empty()) {
+            continue;
+        }
+        if (line[0] == '<') {
+            Serial.inject(line);
+            continue;
+        }
+
+        std::istringstream args(line);
+        std::string command;
+        args >> command;
+        if (command == "!until") {
+            std::string text;
+            unsigned long timeoutMs = 60000;
+            args >> text >> timeoutMs;
+            runUntil(text, timeoutMs);
+        } else if (command == "!run") {
+            unsigned long ms = 0;
+            args >> ms;
+            unsigned long start = millis();
+            while (millis() - start < ms) {
+                runLoop();
+            }
+        } else if (command == "!seed") {
+            uint32_t seed = 1;
+            args >> seed;
+            sim::resetWorld(seed);
+        } else if (command == "!set") {
+            std::string name;
+            double value = 0;
+            args >> name >> value;
+            if (!setWorld(name, value)) {
+                std::cout << "!unknown " << name << std::endl;
+            }
+        } else if (command == "!mass") {
+            std::cout << "!mass " << sim::world().massOnScaleG << std::endl;
+        } else if (command == "!time") {
+            std::cout << "!time " << millis() << std::endl;
+        } else if (command == "!quit") {
+            break;
+        } else {
+            std::cout << "!unknown " << command << std::endl;
+        }
+    }
+    return 0;
+}
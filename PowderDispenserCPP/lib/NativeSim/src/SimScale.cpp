@@ -0,0 +1,180 @@
+#include "SparkFun_Qwiic_Scale_NAU7802_Arduino_Library.h"
+
+/**
+ * Charges the bus time of one register transfer.
+ */
+bool NAU7802::transfer() {
+    sim::activity();
+    sim::advance(sim::i2cTransferUs);
+    return true;
+}
+
+bool NAU7802::begin(TwoWire& wirePort, bool initialize) {
+    (void)wirePort;
+    sim::attachTwiDevice(address, [this](const uint8_t* write, uint8_t writeLength, uint8_t* read, uint8_t readLength) {
+        return onBus(write, writeLength, read, readLength);
+    });
+    reset();
+    if (initialize) {
+        powerUp();
+        setSampleRate(NAU7802_SPS_80);
+        calibrateAFE();
+    }
+    return true;
+}
+
+/**
+ * Starts a new conversion cycle if the chip is converting; conversions of the old cycle are dropped.
+ */
+void NAU7802::restartConversions() {
+    generation++;
+    dataReady = false;
+    if (converting()) {
+        scheduleConversion(generation);
+    }
+}
+
+/**
+ * Schedules the next conversion of a cycle. Each conversion latches the current load and
+ * schedules the one after it until the cycle is stopped.
+ */
+void NAU7802::scheduleConversion(uint32_t cycle) {
+    sim::schedule(periodUs(), [this, cycle]() {
+        if (cycle != generation || !converting()) {
+            return;
+        }
+        latched = sim::world().scaleCounts();
+        dataReady = true;
+        scheduleConversion(cycle);
+    });
+}
+
+bool NAU7802::available() {
+    transfer();
+    return dataReady;
+}
+
+int32_t NAU7802::getReading() {
+    transfer();
+    dataReady = false;
+    return latched;
+}
+
+/**
+ * Register access over the simulated bus: the first written byte selects the register. Only the
+ * registers the firmware's asynchronous sampling reads are modelled.
+ */
+bool NAU7802::onBus(const uint8_t* write, uint8_t writeLength, uint8_t* read, uint8_t readLength) {
+    if (writeLength == 0 || readLength == 0) {
+        return true;
+    }
+    if (write[0] == NAU7802_PU_CTRL) {
+        read[0] = (powered ? (1 << NAU7802_PU_CTRL_PUD) | (1 << NAU7802_PU_CTRL_PUA) | (1 << NAU7802_PU_CTRL_PUR) : 0)
+                  | (dataReady ? (1 << NAU7802_PU_CTRL_CR) : 0);
+    } else if (write[0] == NAU7802_ADCO_B2 && readLength == 3) {
+        read[0] = (uint8_t)(latched >> 16);
+        read[1] = (uint8_t)(latched >> 8);
+        read[2] = (uint8_t)latched;
+        dataReady = false;
+    } else {
+        memset(read, 0, readLength);
+    }
+    return true;
+}
+
+bool NAU7802::setSampleRate(uint8_t rate) {
+    switch (rate) {
+        case NAU7802_SPS_10:  samplesPerSecond = 10; break;
+        case NAU7802_SPS_20:  samplesPerSecond = 20; break;
+        case NAU7802_SPS_40:  samplesPerSecond = 40; break;
+        case NAU7802_SPS_80:  samplesPerSecond = 80; break;
+        case NAU7802_SPS_320: samplesPerSecond = 320; break;
+        default:              return false;
+    }
+    restartConversions();
+    return transfer();
+}
+
+/**
+ * Runs an AFE calibration to completion (blocking, like the library).
+ */
+bool NAU7802::calibrateAFE() {
+    beginCalibrateAFE();
+    return waitForCalibrateAFE(1000);
+}
+
+void NAU7802::beginCalibrateAFE() {
+    transfer();
+    calStatus = NAU7802_CAL_IN_PROGRESS;
+    uint32_t cycle = ++generation;  // Conversions stop while the front end calibrates.
+    dataReady = false;
+    sim::schedule((uint64_t)afeCalConversions * periodUs(), [this, cycle]() {
+        calStatus = powered ? NAU7802_CAL_SUCCESS : NAU7802_CAL_FAILURE;
+        if (cycle == generation) {
+            restartConversions();
+        }
+    });
+}
+
+bool NAU7802::waitForCalibrateAFE(uint32_t timeoutMs) {
+    uint64_t start = sim::nowUs();
+    while (calAFEStatus() == NAU7802_CAL_IN_PROGRESS) {
+        if (timeoutMs > 0 && sim::nowUs() - start > (uint64_t)timeoutMs * 1000) {
+            return false;
+        }
+    }
+    return calStatus == NAU7802_CAL_SUCCESS;
+}
+
+NAU7802_Cal_Status NAU7802::calAFEStatus() {
+    transfer();
+    return calStatus;
+}
+
+bool NAU7802::reset() {
+    powered = false;
+    conversionsOn = false;
+    calStatus = NAU7802_CAL_SUCCESS;
+    restartConversions();
+    return transfer();
+}
+
+bool NAU7802::powerUp() {
+    powered = true;
+    conversionsOn = true;
+    restartConversions();
+    return transfer();
+}
+
+bool NAU7802::powerDown() {
+    powered = false;
+    conversionsOn = false;
+    restartConversions();
+    return transfer();
+}
+
+bool NAU7802::setBit(uint8_t bit, uint8_t registerAddress) {
+    if (registerAddress == NAU7802_PU_CTRL && bit == NAU7802_PU_CTRL_CS && !conversionsOn) {
+        conversionsOn = true;
+        restartConversions();
+    }
+    transfer();
+    return transfer();  // Read-modify-write.
+}
+
+bool NAU7802::clearBit(uint8_t bit, uint8_t registerAddress) {
+    if (registerAddress == NAU7802_PU_CTRL && bit == NAU7802_PU_CTRL_CS && conversionsOn) {
+        conversionsOn = false;
+        restartConversions();
+    }
+    transfer();
+    return transfer();  // Read-modify-write.
+}
+
+bool NAU7802::getBit(uint8_t bit, uint8_t registerAddress) {
+    transfer();
+    if (registerAddress == NAU7802_PU_CTRL && bit == NAU7802_PU_CTRL_CS) {
+        return conversionsOn;
+    }
+    return false;
+}
@@ -0,0 +1,12 @@
+#include "SparkFun_ProDriver_TC78H670FTG_Arduino_Library.h"
+
+bool PRODRIVER::stepSerial(uint16_t steps, bool direction, uint8_t clockDelay) {
+    (void)clockDelay;
+    sim::World& world = sim::world();
+    sim::activity();
+    sim::advance((uint64_t)steps * world.stepPeriodUs + world.moveOverheadUs);  // The driver blocks until done.
+    if (world.stepperEnabled && direction == dispenseDirection) {
+        world.dispense(steps);
+    }
+    return true;
+}
@@ -0,0 +1,37 @@
+#include "Wire.h"
+#include <map>
+
+namespace sim {
+
+static std::map<uint8_t, TwiDevice>& devices() {
+    static std::map<uint8_t, TwiDevice> attached;  // Function-local: devices attach during static init.
+    return attached;
+}
+
+static const uint8_t statusOk = 2;    // `TWI_OK` of the firmware's `TwiStatus`.
+static const uint8_t statusNack = 3;  // `TWI_NACK`.
+
+/**
+ * Connects a device handler at a 7-bit address, replacing any handler already there.
+ */
+void attachTwiDevice(uint8_t address, TwiDevice device) {
+    devices()[address] = device;
+}
+
+/**
+ * Runs one bus transaction without blocking, as the interrupt-driven TWI engine does on hardware.
+ *
+ * Behavior:
+ * - The device sees the transfer at once, but `done` runs as an event `i2cTransferUs` later, so
+ *   the firmware keeps executing for the bus time instead of being charged it.
+ * - An address without a device is not acknowledged.
+ */
+void twiTransfer(uint8_t address, const uint8_t* write, uint8_t writeLength, uint8_t* read,
+                 uint8_t readLength, std::function<void(uint8_t status)> done) {
+    activity();
+    auto device = devices().find(address);
+    bool acknowledged = device != devices().end() && device->second(write, writeLength, read, readLength);
+    schedule(i2cTransferUs, [done, acknowledged]() { done(acknowledged ? statusOk : statusNack); });
+}
+
+}  // namespace sim
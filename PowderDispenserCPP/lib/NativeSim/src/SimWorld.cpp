@@ -0,0 +1,71 @@
+#include "SimWorld.h"
+#include "SimClock.h"
+
+namespace sim {
+
+/**
+ * Returns the simulated world shared by all fake devices.
+ */
+World& world() {
+    static World instance;
+    return instance;
+}
+
+/**
+ * Restores the default world with a new random seed.
+ */
+void resetWorld(uint32_t seed) {
+    world() = World();
+    world().rng.seed(seed);
+}
+
+/**
+ * Draws a normally distributed value with mean 0.
+ */
+float World::normal(float sigma) {
+    if (sigma <= 0) {
+        return 0;
+    }
+    std::normal_distribution<float> distribution(0, sigma);
+    return distribution(rng);
+}
+
+/**
+ * Converts the current load into the raw counts of one conversion, including noise.
+ */
+int32_t World::scaleCounts() {
+    float grams = massOnScaleG + normal(scaleNoiseG) + (mixerOn ? normal(vibrationNoiseG) : 0);
+    return (int32_t)((grams - interceptG) / slopeGPerCount);
+}
+
+/**
+ * Moves powder for one driver command and schedules its arrival on the scale.
+ * Steps inside the jam window move no powder.
+ *
+ * Parameters:
+ * - `steps` (long): Steps moved in the dispensing direction.
+ *
+ * Returns:
+ * - The mass that will land on the scale after `fallDelayUs`.
+ */
+float World::dispense(long steps) {
+    long flowingSteps = steps;
+    if (jamAfterSteps > 0) {
+        // Remove the part of this move that falls inside the jam window.
+        uint64_t jamEnd = jamAfterSteps + jamSteps;
+        uint64_t overlapStart = totalSteps > jamAfterSteps ? totalSteps : jamAfterSteps;
+        uint64_t overlapEnd = totalSteps + steps < jamEnd ? totalSteps + steps : jamEnd;
+        if (overlapEnd > overlapStart) {
+            flowingSteps -= (long)(overlapEnd - overlapStart);
+        }
+    }
+    float grams = flowingSteps * gramsPerStep * (1 + normal(flowNoise));
+    if (grams < 0) {
+        grams = 0;
+    }
+    totalSteps += steps;
+    schedule(fallDelayUs, [grams]() { world().massOnScaleG += grams; });
+    return grams;
+}
+
+}  // namespace sim
@@ -0,0 +1,52 @@
+#ifndef SIMWORLD_H
+#define SIMWORLD_H
+
+#include <stdint.h>
+#include <random>
+
+/**
+ * Physical model behind the simulated devices.
+ *
+ * Tracks the powder on the scale, the auger flow and the state of the mixer, drain and pump, and
+ * turns them into the raw counts the fake NAU7802 reports. Every parameter can be changed between
+ * or during a simulation; `reset()` restores the defaults.
+ */
+namespace sim {
+
+struct World {
+    // Scale: raw counts = (grams - interceptG) / slopeGPerCount, matching the default calibration.
+    float slopeGPerCount = 3.06828559218341e-05;
+    float interceptG = -12.9400964147;
+    float scaleNoiseG = 0.002;       // Standard deviation of the conversion noise.
+    float vibrationNoiseG = 0.05;    // Extra noise while the mixer runs.
+    float massOnScaleG = 0;          // Powder (and vessel) on the scale.
+
+    // Auger and stepper.
+    float gramsPerStep = 2.1130909090909088e-05;
+    float flowNoise = 0.05;          // Relative standard deviation of the flow of one driver command.
+    uint32_t stepPeriodUs = 500;     // Time per microstep.
+    uint32_t moveOverheadUs = 2000;  // Time per driver command.
+    uint32_t fallDelayUs = 200000;   // Time for dispensed powder to land on the scale.
+    uint64_t jamAfterSteps = 0;      // The auger jams (no flow) once this many steps were moved; 0 never.
+    uint32_t jamSteps = 0;           // Steps the jam lasts before the powder flows again.
+    bool stepperEnabled = false;
+    uint64_t totalSteps = 0;         // Steps moved in the dispensing direction.
+
+    // Relays and pump.
+    bool mixerOn = false;
+    bool drainOn = false;
+    bool pumpOn = false;
+
+    std::mt19937 rng{12345};
+
+    float normal(float sigma);
+    int32_t scaleCounts();
+    float dispense(long steps);
+};
+
+World& world();
+void resetWorld(uint32_t seed = 12345);
+
+}  // namespace sim
+
+#endif // SIMWORLD_H
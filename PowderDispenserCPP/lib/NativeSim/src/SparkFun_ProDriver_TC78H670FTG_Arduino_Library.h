@@ -0,0 +1,42 @@
+#ifndef SIM_PRODRIVER_H
+#define SIM_PRODRIVER_H
+
+#include "Arduino.h"
+
+#define PRODRIVER_MODE_SERIAL 1
+#define PRODRIVER_MODE_CLOCK_IN 0
+
+#define PRODRIVER_STEP_RESOLUTION_VARIABLE_1_2 1
+#define PRODRIVER_STEP_RESOLUTION_VARIABLE_1_4 2
+#define PRODRIVER_STEP_RESOLUTION_VARIABLE_1_8 3
+#define PRODRIVER_STEP_RESOLUTION_VARIABLE_1_16 4
+#define PRODRIVER_STEP_RESOLUTION_VARIABLE_1_32 5
+#define PRODRIVER_STEP_RESOLUTION_VARIABLE_1_64 6
+#define PRODRIVER_STEP_RESOLUTION_VARIABLE_1_128 7
+
+struct PRODRIVER_SETTINGS {
+    uint8_t controlMode = PRODRIVER_MODE_SERIAL;
+    uint8_t stepResolutionMode = PRODRIVER_STEP_RESOLUTION_VARIABLE_1_128;
+};
+
+/**
+ * Simulated ProDriver stepper driver.
+ *
+ * `stepSerial()` blocks for `steps * stepPeriodUs + moveOverheadUs` of simulated time, like the
+ * real driver, and moves powder through `sim::world().dispense()` when stepping in the dispensing
+ * direction (`dispenseDirection`) while enabled.
+ */
+class PRODRIVER {
+public:
+    PRODRIVER_SETTINGS settings;
+
+    bool begin() { return true; }
+    bool stepSerial(uint16_t steps = 1, bool direction = 0, uint8_t clockDelay = 1);
+    bool enable() { sim::world().stepperEnabled = true; return true; }
+    bool disable() { sim::world().stepperEnabled = false; return true; }
+    bool setCurrentLimit(uint16_t limit) { (void)limit; return true; }
+
+    static constexpr bool dispenseDirection = 1;
+};
+
+#endif // SIM_PRODRIVER_H
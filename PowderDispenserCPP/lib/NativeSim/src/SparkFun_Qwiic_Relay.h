@@ -0,0 +1,46 @@
+#ifndef SIM_QWIIC_RELAY_H
+#define SIM_QWIIC_RELAY_H
+
+#include "Arduino.h"
+#include "Wire.h"
+
+/**
+ * Simulated Qwiic single relay. The relays at the firmware's mixer (0x19) and drain (0x18)
+ * addresses drive `World::mixerOn` and `World::drainOn`; every command charges one I2C transfer.
+ * On the simulated bus a relay takes the single command byte of the real board (0x01 on, 0x00 off).
+ */
+class Qwiic_Relay {
+public:
+    explicit Qwiic_Relay(uint8_t address) : address(address) {
+        sim::attachTwiDevice(address, [this](const uint8_t* write, uint8_t writeLength, uint8_t* read, uint8_t readLength) {
+            if (writeLength > 0) applyState(write[0] == 0x01);
+            if (readLength > 0) read[0] = state;
+            return true;
+        });
+    }
+
+    bool begin(TwoWire& wirePort = Wire) { (void)wirePort; sim::activity(); sim::advance(sim::i2cTransferUs); return true; }
+    void turnRelayOn() { setState(true); }
+    void turnRelayOff() { setState(false); }
+    uint8_t getState() { sim::activity(); sim::advance(sim::i2cTransferUs); return state; }
+
+    static constexpr uint8_t mixerAddress = 0x19;
+    static constexpr uint8_t drainAddress = 0x18;
+
+private:
+    void setState(bool on) {
+        sim::activity(); sim::advance(sim::i2cTransferUs);
+        applyState(on);
+    }
+
+    void applyState(bool on) {
+        state = on;
+        if (address == mixerAddress) sim::world().mixerOn = on;
+        if (address == drainAddress) sim::world().drainOn = on;
+    }
+
+    uint8_t address;
+    bool state = false;
+};
+
+#endif // SIM_QWIIC_RELAY_H
@@ -0,0 +1,84 @@
+#ifndef SIM_NAU7802_H
+#define SIM_NAU7802_H
+
+#include "Arduino.h"
+#include "Wire.h"
+
+// Register and constant names of the SparkFun NAU7802 library used by the firmware.
+enum { NAU7802_PU_CTRL = 0x00, NAU7802_CTRL1, NAU7802_CTRL2, NAU7802_ADCO_B2 = 0x12 };
+enum {
+    NAU7802_PU_CTRL_RR = 0, NAU7802_PU_CTRL_PUD, NAU7802_PU_CTRL_PUA, NAU7802_PU_CTRL_PUR,
+    NAU7802_PU_CTRL_CS, NAU7802_PU_CTRL_CR, NAU7802_PU_CTRL_OSCS, NAU7802_PU_CTRL_AVDDS
+};
+enum { NAU7802_SPS_10 = 0, NAU7802_SPS_20, NAU7802_SPS_40, NAU7802_SPS_80, NAU7802_SPS_320 = 7 };
+enum {
+    NAU7802_GAIN_1 = 0, NAU7802_GAIN_2, NAU7802_GAIN_4, NAU7802_GAIN_8,
+    NAU7802_GAIN_16, NAU7802_GAIN_32, NAU7802_GAIN_64, NAU7802_GAIN_128
+};
+enum {
+    NAU7802_LDO_4V5 = 0, NAU7802_LDO_4V2, NAU7802_LDO_3V9, NAU7802_LDO_3V6,
+    NAU7802_LDO_3V3, NAU7802_LDO_3V0, NAU7802_LDO_2V7, NAU7802_LDO_2V4
+};
+typedef enum { NAU7802_CAL_SUCCESS = 0, NAU7802_CAL_IN_PROGRESS = 1, NAU7802_CAL_FAILURE = 2 } NAU7802_Cal_Status;
+
+/**
+ * Simulated NAU7802 load-cell ADC.
+ *
+ * While powered with the conversion bit set, a conversion of `sim::world().scaleCounts()` is
+ * latched at the configured sample rate as a scheduled event. Every register access charges
+ * `sim::i2cTransferUs`. AFE calibration completes `afeCalConversions` conversion periods after it
+ * is started. `begin()` also attaches the chip to the simulated bus at `address`, where reads of
+ * `PU_CTRL` report the cycle-ready bit and a 3-byte read of `ADCO_B2` returns the conversion.
+ */
+class NAU7802 {
+public:
+    bool begin(TwoWire& wirePort = Wire, bool initialize = true);
+    bool isConnected() { return true; }
+    bool available();
+    int32_t getReading();
+
+    void setZeroOffset(int32_t offset) { zeroOffset = offset; }
+    int32_t getZeroOffset() { return zeroOffset; }
+    void setCalibrationFactor(float factor) { calibrationFactor = factor; }
+    float getCalibrationFactor() { return calibrationFactor; }
+
+    bool setGain(uint8_t gain) { (void)gain; return transfer(); }
+    bool setLDO(uint8_t ldo) { (void)ldo; return transfer(); }
+    bool setSampleRate(uint8_t rate);
+    bool setChannel(uint8_t channel) { (void)channel; return transfer(); }
+
+    bool calibrateAFE();
+    void beginCalibrateAFE();
+    bool waitForCalibrateAFE(uint32_t timeoutMs = 0);
+    NAU7802_Cal_Status calAFEStatus();
+
+    bool reset();
+    bool powerUp();
+    bool powerDown();
+    bool setBit(uint8_t bit, uint8_t registerAddress);
+    bool clearBit(uint8_t bit, uint8_t registerAddress);
+    bool getBit(uint8_t bit, uint8_t registerAddress);
+
+    static constexpr uint8_t afeCalConversions = 4;
+    static constexpr uint8_t address = 0x2A;
+
+private:
+    bool transfer();
+    bool onBus(const uint8_t* write, uint8_t writeLength, uint8_t* read, uint8_t readLength);
+    bool converting() const { return powered && conversionsOn; }
+    void restartConversions();
+    void scheduleConversion(uint32_t cycle);
+    uint32_t periodUs() const { return 1000000UL / samplesPerSecond; }
+
+    bool powered = false;
+    bool conversionsOn = false;
+    bool dataReady = false;
+    int32_t latched = 0;
+    uint32_t generation = 0;  // Invalidates the scheduled conversion chain of a stopped cycle.
+    uint16_t samplesPerSecond = 10;
+    NAU7802_Cal_Status calStatus = NAU7802_CAL_SUCCESS;
+    int32_t zeroOffset = 0;
+    float calibrationFactor = 1;
+};
+
+#endif // SIM_NAU7802_H
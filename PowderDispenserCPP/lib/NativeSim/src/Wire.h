@@ -0,0 +1,33 @@
+#ifndef WIRE_H
+#define WIRE_H
+
+#include "Arduino.h"
+#include <functional>
+
+/**
+ * I2C bus of the native simulator. The fake devices' blocking driver calls talk to the simulated
+ * world directly; `TwoWire` only exists so firmware and device headers compile unchanged.
+ */
+class TwoWire {
+public:
+    void begin() {}
+    void setClock(uint32_t frequency) { (void)frequency; }
+};
+
+extern TwoWire Wire;
+
+namespace sim {
+
+/**
+ * Register-level handler of a simulated bus device: receives the written bytes and fills the
+ * bytes read back after the repeated start. Returns `false` to not acknowledge.
+ */
+typedef std::function<bool(const uint8_t* write, uint8_t writeLength, uint8_t* read, uint8_t readLength)> TwiDevice;
+
+void attachTwiDevice(uint8_t address, TwiDevice device);
+void twiTransfer(uint8_t address, const uint8_t* write, uint8_t writeLength, uint8_t* read,
+                 uint8_t readLength, std::function<void(uint8_t status)> done);
+
+}  // namespace sim
+
+#endif // WIRE_H
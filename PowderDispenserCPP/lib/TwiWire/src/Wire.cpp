@@ -0,0 +1,104 @@
+#include "Wire.h"
+#include "TwiEngine.h"
+
+TwoWire Wire;
+
+/**
+ * Enables the TWI hardware at the engine's default 400 kHz.
+ */
+void TwoWire::begin() {
+    TwiEngine::begin();
+}
+
+/**
+ * Sets the SCL clock in Hz.
+ */
+void TwoWire::setClock(uint32_t frequency) {
+    TwiEngine::begin(frequency);
+}
+
+/**
+ * Starts collecting the bytes of a write to `address`.
+ */
+void TwoWire::beginTransmission(uint8_t address) {
+    txAddress = address;
+    txLength = 0;
+    txHeld = false;
+}
+
+size_t TwoWire::write(uint8_t data) {
+    if (txLength >= bufferLength) {
+        setWriteError();
+        return 0;
+    }
+    txBuffer[txLength++] = data;
+    return 1;
+}
+
+size_t TwoWire::write(const uint8_t* data, size_t quantity) {
+    for (size_t i = 0; i < quantity; i++) {
+        if (!write(data[i])) {
+            return i;
+        }
+    }
+    return quantity;
+}
+
+/**
+ * Sends the collected bytes.
+ *
+ * Parameters:
+ * - `sendStop` (uint8_t): `false` holds the bytes for the next `requestFrom()` to the same
+ *   address, which sends them in front of its read.
+ *
+ * Returns:
+ * - 0 on success, 2 if the device did not acknowledge, 4 on a bus error or timeout (the core
+ *   Wire's codes).
+ */
+uint8_t TwoWire::endTransmission(uint8_t sendStop) {
+    if (!sendStop) {
+        txHeld = true;
+        return 0;
+    }
+    TwiTransaction transaction;
+    transaction.address = txAddress;
+    transaction.writeData = txBuffer;
+    transaction.writeLength = txLength;
+    while (!TwiEngine::submit(transaction)) {
+        TwiEngine::poll();  // Queue full: let finished transactions drain.
+    }
+    TwiStatus status = TwiEngine::wait(transaction);
+    txLength = 0;
+    return status == TWI_OK ? 0 : status == TWI_NACK ? 2 : 4;
+}
+
+/**
+ * Reads `quantity` bytes from `address` into the receive buffer, after the bytes held by
+ * `endTransmission(false)` if any.
+ *
+ * Returns:
+ * - The number of bytes read (0 on failure).
+ */
+uint8_t TwoWire::requestFrom(uint8_t address, uint8_t quantity, uint8_t sendStop) {
+    (void)sendStop;  // Every transaction ends with a stop.
+    if (quantity > bufferLength) {
+        quantity = bufferLength;
+    }
+    TwiTransaction transaction;
+    transaction.address = address;
+    if (txHeld && txAddress == address) {
+        transaction.writeData = txBuffer;
+        transaction.writeLength = txLength;
+    }
+    transaction.readData = rxBuffer;
+    transaction.readLength = quantity;
+    while (!TwiEngine::submit(transaction)) {
+        TwiEngine::poll();
+    }
+    TwiStatus status = TwiEngine::wait(transaction);
+    txHeld = false;
+    txLength = 0;
+    rxIndex = 0;
+    rxLength = status == TWI_OK ? quantity : 0;
+    return rxLength;
+}
@@ -0,0 +1,57 @@
+#ifndef TWIWIRE_H
+#define TWIWIRE_H
+
+#include <Arduino.h>
+#include <Stream.h>
+
+/**
+ * Master-only `TwoWire` on top of `TwiEngine`.
+ *
+ * The core's Wire library owns the TWI interrupt, which the engine needs for its transaction
+ * queue, so this replacement takes its place (PlatformIO prefers project libraries over framework
+ * ones of the same name). The vendor drivers keep their blocking calls: each `endTransmission()`
+ * or `requestFrom()` submits one transaction and waits for it, running the completion callbacks
+ * of other transactions meanwhile. `endTransmission(false)` holds the written bytes so the next
+ * `requestFrom()` sends them in the same transaction, before a repeated start.
+ */
+class TwoWire : public Stream {
+public:
+    void begin();
+    void end() {}
+    void setClock(uint32_t frequency);
+
+    void beginTransmission(uint8_t address);
+    void beginTransmission(int address) { beginTransmission((uint8_t)address); }
+    uint8_t endTransmission(uint8_t sendStop);
+    uint8_t endTransmission() { return endTransmission(true); }
+
+    uint8_t requestFrom(uint8_t address, uint8_t quantity, uint8_t sendStop = true);
+    uint8_t requestFrom(int address, int quantity) { return requestFrom((uint8_t)address, (uint8_t)quantity); }
+    uint8_t requestFrom(int address, int quantity, int sendStop) {
+        return requestFrom((uint8_t)address, (uint8_t)quantity, (uint8_t)sendStop);
+    }
+
+    size_t write(uint8_t data) override;
+    size_t write(const uint8_t* data, size_t quantity) override;
+    int available() override { return rxLength - rxIndex; }
+    int read() override { return rxIndex < rxLength ? rxBuffer[rxIndex++] : -1; }
+    int peek() override { return rxIndex < rxLength ? rxBuffer[rxIndex] : -1; }
+    void flush() override {}
+
+    using Print::write;
+
+    static constexpr uint8_t bufferLength = 32;  // Same as the core's Wire.
+
+private:
+    uint8_t txAddress = 0;
+    uint8_t txBuffer[bufferLength];
+    uint8_t txLength = 0;
+    bool txHeld = false;  // Bytes of an `endTransmission(false)` waiting for the read.
+    uint8_t rxBuffer[bufferLength];
+    uint8_t rxIndex = 0;
+    uint8_t rxLength = 0;
+};
+
+extern TwoWire Wire;
+
+#endif // TWIWIRE_H
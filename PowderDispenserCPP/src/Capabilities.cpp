@@ -0,0 +1,72 @@
+#include "Capabilities.h"
+#include "MemoryArena.h"
+#include "Utils.h"
+
+#ifndef SERIAL_RX_BUFFER_SIZE
+#define SERIAL_RX_BUFFER_SIZE 64  // Arduino AVR core default.
+#endif
+
+const uint8_t Capabilities::protocolVersion = 2;  // 1: firmware without `<Caps>`.
+
+static const uint8_t streamFrameBytes = 26;  // A typical `<S t:MS g:G>` sample with its line end.
+
+/**
+ * Tells whether this build handles a command.
+ *
+ * Returns:
+ * - `false` for the profiler commands unless the profiler is built in (they are answered but do
+ *   nothing otherwise), and for bits newer than this firmware.
+ */
+bool Capabilities::supports(CommandBit command) {
+#if !(defined(ENABLE_PROFILER) && defined(__AVR__))
+    if (command == CMD_PROF_START || command == CMD_PROF_STOP || command == CMD_PROF_DUMP) {
+        return false;
+    }
+#endif
+    return command < CMD_COUNT;
+}
+
+/**
+ * Sends the capabilities.
+ *
+ * Parameters:
+ * - `sampleRate` (uint16_t): The scale's configured conversion rate.
+ *
+ * Format: `<Caps proto:P cmds:HEX fmt:F,... rx:B queue:B serial:B baud:N sps:N stream:N filters:F,...>`
+ * - `cmds`: `CommandBit` bitmap, most significant digit first.
+ * - `fmt`: frame formats: `ascii` (framed commands and replies), `stream` (`<S t:MS g:G>`),
+ *   `raw` (`<S t:MS r:COUNTS>`) and `image` (raw bytes after `<CfgLoad>`).
+ * - `rx`: longest command frame; `queue`: bytes of actuation commands held while one runs;
+ *   `serial`: receive FIFO, the most raw bytes a host may send ahead.
+ * - `sps`: scale conversions per second; `stream`: most samples per second the link carries.
+ */
+void Capabilities::send(uint16_t sampleRate) {
+    unsigned long linkRate = Utils::getBaudRate() / 10 / streamFrameBytes;
+
+    Serial.print(F("<Caps proto:"));
+    Serial.print(protocolVersion);
+    Serial.print(F(" cmds:"));
+    for (int8_t digit = (CMD_COUNT + 3) / 4 - 1; digit >= 0; digit--) {
+        uint8_t nibble = 0;
+        for (uint8_t bit = 0; bit < 4; bit++) {
+            uint8_t command = digit * 4 + bit;
+            if (command < CMD_COUNT && supports((CommandBit)command)) {
+                nibble |= 1 << bit;
+            }
+        }
+        Serial.print(nibble, HEX);
+    }
+    Serial.print(F(" fmt:ascii,stream,raw,image rx:"));
+    Serial.print(ARENA_RX_BYTES - 1);  // One byte holds the terminator.
+    Serial.print(F(" queue:"));
+    Serial.print(ARENA_PENDING_BYTES);
+    Serial.print(F(" serial:"));
+    Serial.print(SERIAL_RX_BUFFER_SIZE);
+    Serial.print(F(" baud:"));
+    Serial.print(Utils::getBaudRate());
+    Serial.print(F(" sps:"));
+    Serial.print(sampleRate);
+    Serial.print(F(" stream:"));
+    Serial.print(sampleRate < linkRate ? sampleRate : linkRate);
+    Serial.println(F(" filters:NONE,EWMA,SMA,LPF>"));
+}
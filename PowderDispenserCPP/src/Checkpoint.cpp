@@ -0,0 +1,162 @@
+#include "Checkpoint.h"
+#include <stddef.h>
+
+static_assert(sizeof(CheckpointRecord) <= Checkpoint::slotBytes, "CheckpointRecord exceeds its EEPROM slot.");
+
+const int Checkpoint::LOC_CHECKPOINT = 64;  // EEPROM location of the checkpoint ring (`numSlots * slotBytes` bytes).
+
+CheckpointRecord Checkpoint::record = {};  // Current batch progress.
+uint8_t Checkpoint::slot = numSlots - 1;    // Slot holding `record`; the next save goes to the following one.
+
+/**
+ * Computes a CRC-8 (polynomial 0x07) over a byte range.
+ */
+uint8_t Checkpoint::crc8(const uint8_t* data, uint8_t length) {
+    uint8_t crc = 0;
+    for (uint8_t i = 0; i < length; i++) {
+        crc ^= data[i];
+        for (uint8_t bit = 0; bit < 8; bit++) {
+            crc = (crc & 0x80) ? (crc << 1) ^ 0x07 : crc << 1;
+        }
+    }
+    return crc;
+}
+
+/**
+ * Reads one slot of the checkpoint ring.
+ *
+ * Returns:
+ * - `true` if the slot holds a record with a valid CRC.
+ */
+bool Checkpoint::readSlot(uint8_t slot, CheckpointRecord& out) {
+    EEPROM.get(LOC_CHECKPOINT + slot * slotBytes, out);
+    return out.crc == crc8(reinterpret_cast<const uint8_t*>(&out), offsetof(CheckpointRecord, crc));
+}
+
+/**
+ * Restores the newest valid checkpoint from EEPROM. Called once at startup.
+ *
+ * Behavior:
+ * - Scans every slot and keeps the record with the highest sequence number (wrap-around safe,
+ *   since all slots are within `numSlots` saves of each other).
+ * - A slot torn by a reset during its write fails the CRC and is skipped, so the previous save
+ *   is used instead.
+ * - With no valid record (new or cleared EEPROM), no batch is active.
+ */
+void Checkpoint::load() {
+    bool found = false;
+    CheckpointRecord candidate;
+    for (uint8_t i = 0; i < numSlots; i++) {
+        if (!readSlot(i, candidate)) {
+            continue;
+        }
+        if (!found || (int16_t)(candidate.sequence - record.sequence) > 0) {
+            record = candidate;
+            slot = i;
+            found = true;
+        }
+    }
+    if (!found) {
+        record = {};
+        slot = numSlots - 1;
+    }
+}
+
+/**
+ * Starts tracking a new batch and saves its first checkpoint.
+ *
+ * Parameters:
+ * - `batchId` (uint16_t): Host-chosen identifier (non-zero), reported back by `<Resume>`.
+ * - `zeroOffset` (int32_t): Current scale tare baseline.
+ */
+void Checkpoint::begin(uint16_t batchId, int32_t zeroOffset) {
+    uint16_t sequence = record.sequence;
+    record = {};
+    record.sequence = sequence;
+    record.batchId = batchId;
+    save(zeroOffset);
+}
+
+/**
+ * Adds a completed dose to the cumulative mass of its channel. Saved with the next checkpoint.
+ *
+ * Parameters:
+ * - `channel` (uint8_t): Auger channel.
+ * - `grams` (float): Dispensed mass.
+ */
+void Checkpoint::addDose(uint8_t channel, float grams) {
+    if (isActive() && channel < DispenserControls::numChannels) {
+        record.mass[channel] += grams;
+    }
+}
+
+/**
+ * Counts a completed recipe step and saves the checkpoint.
+ *
+ * Parameters:
+ * - `zeroOffset` (int32_t): Current scale tare baseline.
+ */
+void Checkpoint::completeStep(int32_t zeroOffset) {
+    if (!isActive()) {
+        return;
+    }
+    record.step++;
+    save(zeroOffset);
+}
+
+/**
+ * Saves the current batch progress into the next slot of the wear-leveled ring.
+ *
+ * Parameters:
+ * - `zeroOffset` (int32_t): Current scale tare baseline.
+ *
+ * Behavior:
+ * - Each save goes to the slot after the previous one, spreading writes over `numSlots` slots.
+ *   `EEPROM.put()` only rewrites bytes that changed.
+ * - The previous slot stays intact until the new one is complete, so a reset mid-write loses at
+ *   most the save in progress.
+ */
+void Checkpoint::save(int32_t zeroOffset) {
+    record.sequence++;
+    record.zeroOffset = zeroOffset;
+    record.crc = crc8(reinterpret_cast<const uint8_t*>(&record), offsetof(CheckpointRecord, crc));
+    slot = (slot + 1) % numSlots;
+    EEPROM.put(LOC_CHECKPOINT + slot * slotBytes, record);
+}
+
+/**
+ * Ends the batch. The saved record is marked inactive, so `<Resume>` finds nothing to continue.
+ */
+void Checkpoint::end() {
+    if (!isActive()) {
+        return;
+    }
+    record.batchId = 0;
+    save(record.zeroOffset);
+}
+
+/**
+ * Sends the current checkpoint to the PC.
+ *
+ * Format: `<Resume batch:B step:S zero:Z mass:m0,m1,...>`, or `<Resume none>` without an active batch.
+ */
+void Checkpoint::send() {
+    if (!isActive()) {
+        Serial.println(F("<Resume none>"));
+        return;
+    }
+    Serial.print(F("<Resume batch:"));
+    Serial.print(record.batchId);
+    Serial.print(F(" step:"));
+    Serial.print(record.step);
+    Serial.print(F(" zero:"));
+    Serial.print(record.zeroOffset);
+    Serial.print(F(" mass:"));
+    for (uint8_t ch = 0; ch < DispenserControls::numChannels; ch++) {
+        if (ch > 0) {
+            Serial.print(F(","));
+        }
+        Serial.print(record.mass[ch], Utils::getDecimal());
+    }
+    Serial.println(F(">"));
+}
@@ -1,31 +1,82 @@
 #include "Comms.h"
+#include "Trace.h"
+#include "MemoryMonitor.h"
+#include "Profiler.h"
+#include "TimingModel.h"
+#include "Checkpoint.h"
+#include "HopperEstimator.h"
+#include "DeviceConfig.h"
+#include "Capabilities.h"
+#include "IdleSleep.h"
+
+static_assert(ARENA_TX_BYTES >= ARENA_RX_BYTES, "The reply buffer must hold a full command.");
 
 // Static member variables
-char Comms::inputBuffer[Comms::buffSize] = {0};  // Buffer to store incoming data from the PC.
 unsigned long Comms::curMillis = 0;             // Tracks the current time in milliseconds.
 unsigned long Comms::prevReplyToPCmillis = 0;   // Tracks the last time a reply was sent to the PC.
 unsigned long Comms::replyToPCinterval = 1000;  // Interval (in milliseconds) for sending periodic replies to the PC.
 
+/**
+ * Reads the next argument of the frame being parsed with `strtok`.
+ *
+ * Returns:
+ * - The argument, or `current` if the frame has no more arguments.
+ */
+static float nextArg(float current) {
+    char* value = strtok(NULL, ",");
+    return value ? atof(value) : current;
+}
+
+/**
+ * Reads the next argument of the frame being parsed with `strtok` into an unsigned parameter.
+ *
+ * Parameters:
+ * - `current` (T): Value kept if the frame has no more arguments or the argument is out of range.
+ * - `inRange` (bool&): Cleared if the argument is NaN or outside 0 to the largest value of `T`.
+ *
+ * Returns:
+ * - The argument, or `current`.
+ */
+template <typename T>
+static T nextArg(T current, bool& inRange) {
+    float value = nextArg((float)current);
+    if (!(value >= 0 && value <= (T)~(T)0)) {  // Narrowing an out-of-range float is undefined.
+        inRange = false;
+        return current;
+    }
+    return (T)value;
+}
+
 /**
  * Constructor for the Comms class.
  * 
- * Initializes references to utility, scale, mixer, and dispenser control objects.
+ * Initializes references to utility, scale, mixer, and dispenser control objects and takes the
+ * receive, command, reply and pending-command buffers from the memory arena.
  * Parameters:
  * - `utils` (Utils&): Reference to the utility class for shared functionality.
  * - `scaleControls` (ScaleControls&): Reference to the scale control object.
  * - `mixerControls` (MixerControls&): Reference to the mixer control object.
  * - `dispenserControls` (DispenserControls&): Reference to the dispenser control object.
+ * - `doseController` (DoseController&): Reference to the closed-loop dose controller.
  */
-Comms::Comms(Utils& utils, ScaleControls& scaleControls, MixerControls& mixerControls, DispenserControls& dispenserControls)
-    : utils(utils), scaleControls(scaleControls), mixerControls(mixerControls), dispenserControls(dispenserControls) {}
+Comms::Comms(Utils& utils, ScaleControls& scaleControls, MixerControls& mixerControls, DispenserControls& dispenserControls,
+             DoseController& doseController)
+    : utils(utils), scaleControls(scaleControls), mixerControls(mixerControls), dispenserControls(dispenserControls),
+      doseController(doseController),
+      rxFrame(MemoryArena::allocate<char>(buffSize, PSTR("rx"))),
+      inputBuffer(MemoryArena::allocate<char>(buffSize, PSTR("cmd"))),
+      messageFromPC(MemoryArena::allocate<char>(ARENA_TX_BYTES, PSTR("tx"))),
+      pending(MemoryArena::allocate<RingBuffer<char, ARENA_PENDING_BYTES>>(1, PSTR("pending"))) {}
 
 /**
  * Reads data from the PC over Serial.
  * 
  * Behavior:
- * - Processes incoming characters and stores them in the `inputBuffer`.
+ * - Processes incoming characters and stores them in `rxFrame`.
  * - Recognizes the start and end markers to determine when a complete command is received.
- * - Calls `parseData()` to process the received command.
+ * - Hands every complete command to `dispatchFrame()`.
+ * - Also runs from the background task while an actuation command waits, so immediate commands
+ *   are still handled on receipt.
  */
 void Comms::getDataFromPC() {
     while (Serial.available() > 0) {  // Check if data is available on the Serial port.
@@ -33,11 +84,10 @@ void Comms::getDataFromPC() {
         if (bytesRecvd < buffSize - 1) {
             if (x == endMarker) {  // End of command detected.
                 readInProgress = false;
-                newDataFromPC = true;
-                inputBuffer[bytesRecvd] = 0;  // Null-terminate the string.
-                parseData();  // Process the complete command.
+                rxFrame[bytesRecvd] = 0;  // Null-terminate the string.
+                dispatchFrame();
             } else if (readInProgress) {  // Continue reading the command.
-                inputBuffer[bytesRecvd++] = x;
+                rxFrame[bytesRecvd++] = x;
             } else if (x == startMarker) {  // Start of command detected.
                 bytesRecvd = 0;
                 readInProgress = true;
@@ -48,6 +98,307 @@ void Comms::getDataFromPC() {
     }
 }
 
+/**
+ * Routes a complete command to its priority lane.
+ *
+ * Behavior:
+ * - Immediate commands (queries and `Abort`) are handled at once, even while an actuation
+ *   command is running; their replies go out in the order they were received.
+ * - Actuation commands run one at a time in the order they were received. One arriving while
+ *   another runs waits in the pending queue; `<Rejected ...>` is sent if the queue is full.
+ */
+void Comms::dispatchFrame() {
+    size_t commandLength = strcspn(rxFrame, ",");
+    char command[16];
+    if (commandLength >= sizeof(command)) {
+        commandLength = sizeof(command) - 1;
+    }
+    memcpy(command, rxFrame, commandLength);
+    command[commandLength] = 0;
+
+    if (isImmediate(command)) {
+        handleImmediate();
+    } else if (busy) {
+        if (!queueFrame()) {
+            Serial.print(F("<Rejected "));
+            Serial.print(rxFrame);
+            Serial.println(F(">"));
+        }
+    } else {
+        strcpy(inputBuffer, rxFrame);
+        runQueued();
+        runPending();
+    }
+}
+
+/**
+ * Tells whether a command belongs to the immediate lane.
+ *
+ * Parameters:
+ * - `command` (const char*): The command name (first token of the frame).
+ *
+ * Returns:
+ * - `true` for status queries, telemetry, diagnostics and `Abort`; `false` for commands that drive
+ *   hardware or change settings, and for `Meas` and `ADC`, which take fresh conversions through the
+ *   shared sample blocks and filters and so must not run inside another command's wait.
+ */
+bool Comms::isImmediate(const char* command) {
+    return strcmp_P(command, PSTR("Status")) == 0 || strcmp_P(command, PSTR("Abort")) == 0
+        || strcmp_P(command, PSTR("Stats")) == 0 || strcmp_P(command, PSTR("Mem")) == 0
+        || strcmp_P(command, PSTR("Trace")) == 0 || strcmp_P(command, PSTR("ProfDump")) == 0
+        || strcmp_P(command, PSTR("Predict")) == 0 || strcmp_P(command, PSTR("Hopper")) == 0
+        || strcmp_P(command, PSTR("Stream")) == 0 || strcmp_P(command, PSTR("Cfg")) == 0
+        || strcmp_P(command, PSTR("Caps")) == 0 || strcmp_P(command, PSTR("Idle")) == 0
+        || strcmp_P(command, PSTR("DoseQueue")) == 0;
+}
+
+/**
+ * Tells whether a command is a recipe step counted by the batch checkpoint.
+ *
+ * Parameters:
+ * - `message` (const char*): The full command frame.
+ *
+ * Returns:
+ * - `true` for commands that move powder or liquid (doses, mixing, draining, pumping).
+ */
+bool Comms::isRecipeStep(const char* message) {
+    size_t length = strcspn(message, ",");
+    return (length == 4 && strncmp_P(message, PSTR("Dose"), length) == 0)
+        || (length == 12 && strncmp_P(message, PSTR("DispenseMass"), length) == 0)
+        || (length == 8 && strncmp_P(message, PSTR("Dispense"), length) == 0)
+        || (length == 3 && strncmp_P(message, PSTR("Mix"), length) == 0)
+        || (length == 5 && strncmp_P(message, PSTR("Drain"), length) == 0)
+        || (length == 4 && strncmp_P(message, PSTR("Pump"), length) == 0);
+}
+
+/**
+ * Handles an immediate command in place in `rxFrame`.
+ *
+ * Behavior:
+ * - Leaves `inputBuffer` and `messageFromPC` to the running actuation command. Queued commands
+ *   read all their arguments before they wait, so the `strtok` state is free to reuse here.
+ * - `Abort` stops the running command at its next wait or driver command and drops the
+ *   pending queue, then sends `<Aborted busy:B dropped:N>`.
+ */
+void Comms::handleImmediate() {
+    char *token = strtok(rxFrame, ",");
+
+    if (strcmp_P(token, PSTR("Status")) == 0) {
+        sendStatus();
+    } else if (strcmp_P(token, PSTR("Abort")) == 0) {
+        Utils::requestAbort();
+        uint8_t dropped = pendingFrames;
+        pending->clear();
+        pendingFrames = 0;
+        Serial.print(F("<Aborted busy:"));
+        Serial.print(busy);
+        Serial.print(F(" dropped:"));
+        Serial.print(dropped);
+        Serial.println(F(">"));
+    } else if (strcmp_P(token, PSTR("Trace")) == 0) {
+        Trace::dump();  // Send and clear the queued trace events.
+    } else if (strcmp_P(token, PSTR("Mem")) == 0) {
+        MemoryArena::report();  // Send the SRAM arena layout.
+    } else if (strcmp_P(token, PSTR("Stats")) == 0) {
+        MemoryMonitor::sendStats();  // Send free memory and stack high-water marks.
+    } else if (strcmp_P(token, PSTR("ProfDump")) == 0) {
+        Profiler::dump();  // Send the sampled histogram.
+    } else if (strcmp_P(token, PSTR("Predict")) == 0) {
+        predictCommand();  // Estimate a command's duration and arm the actual-versus-predicted report.
+    } else if (strcmp_P(token, PSTR("Hopper")) == 0) {
+        char* channelStr = strtok(NULL, ",");  // Auger channel, 0 if omitted.
+        HopperEstimator::send(channelStr ? atoi(channelStr) : 0);  // Remaining powder and time to empty.
+    } else if (strcmp_P(token, PSTR("Stream")) == 0) {
+        char* everyStr = strtok(NULL, ",");  // Send every Nth conversion; 1 if omitted, 0 stops.
+        char* rawStr = strtok(NULL, ",");    // 1 to send ADC counts instead of grams.
+        uint8_t every = everyStr ? atoi(everyStr) : 1;
+        bool raw = rawStr && atoi(rawStr) != 0;
+        scaleControls.setStream(every, raw);
+        Serial.print(F("<Stream every:"));
+        Serial.print(every);
+        Serial.println(raw ? F(" raw>") : F(">"));
+    } else if (strcmp_P(token, PSTR("Cfg")) == 0) {
+        DeviceConfig::send();  // Summary of the stored configuration image.
+    } else if (strcmp_P(token, PSTR("Caps")) == 0) {
+        Capabilities::send(scaleControls.getSampleRate());  // Protocol version, commands, formats and limits.
+    } else if (strcmp_P(token, PSTR("Idle")) == 0) {
+        char* enableStr = strtok(NULL, ",");  // 1 sleeps between passes, 0 busy-loops; omitted to only report.
+        if (enableStr) {
+            IdleSleep::setEnabled(atoi(enableStr) != 0);
+        }
+        IdleSleep::send();  // Policy and time asleep since the last report.
+    } else if (strcmp_P(token, PSTR("DoseQueue")) == 0) {
+        char* gramsStr = strtok(NULL, ",");    // Target mass of the dose; 0 clears the queue, omitted only reports.
+        char* channelStr = strtok(NULL, ",");  // Auger channel, 0 if omitted.
+        bool full = false;
+        if (gramsStr && atof(gramsStr) > 0) {
+            full = !doseController.queueDose(atof(gramsStr), channelStr ? atoi(channelStr) : 0);
+        } else if (gramsStr) {
+            doseController.clearQueue();
+        }
+        Serial.print(F("<DoseQueue queued:"));
+        Serial.print(doseController.queuedDoses());
+        Serial.println(full ? F(" full>") : F(">"));
+    }
+}
+
+/**
+ * Appends the actuation command in `rxFrame` to the pending queue.
+ *
+ * Returns:
+ * - `true` if the whole frame fits, `false` if it was dropped.
+ */
+bool Comms::queueFrame() {
+    size_t length = strlen(rxFrame) + 1;  // Keep the terminator as the frame separator.
+    if (length > (size_t)(pending->capacity() - pending->count())) {
+        return false;
+    }
+    for (size_t i = 0; i < length; i++) {
+        pending->push(rxFrame[i]);
+    }
+    pendingFrames++;
+    return true;
+}
+
+/**
+ * Runs the actuation command in `inputBuffer`.
+ *
+ * Behavior:
+ * - Clears any earlier abort request, then calls `parseData()` with the lane marked busy and
+ *   vessel detection paused.
+ * - Records the command's peak stack depth and reports its actual duration if a prediction was
+ *   armed for it.
+ * - During a batch, checkpoints every recipe step; an aborted step saves its dispensed mass
+ *   without counting as completed.
+ */
+void Comms::runQueued() {
+    busy = true;
+    newDataFromPC = true;
+    Utils::clearAbort();
+    unsigned long commandStart = millis();
+    MemoryMonitor::beginCommand();
+    scaleControls.pausePlacement();  // Commands move weight on and off the scale.
+    parseData();  // Process the complete command.
+    scaleControls.resumePlacement();
+    MemoryMonitor::endCommand(messageFromPC);
+    TimingModel::completeCommand(messageFromPC, millis() - commandStart);
+    recordRecipeStep();
+    busy = false;
+}
+
+/**
+ * During a batch, checkpoints the command in `messageFromPC` if it is a recipe step; an aborted
+ * step saves its dispensed mass without counting as completed.
+ */
+void Comms::recordRecipeStep() {
+    if (Checkpoint::isActive() && isRecipeStep(messageFromPC)) {
+        if (Utils::isAbortRequested()) {
+            Checkpoint::save(scaleControls.getZeroOffset());
+        } else {
+            Checkpoint::completeStep(scaleControls.getZeroOffset());
+        }
+    }
+}
+
+/**
+ * Starts the next queued dose once a vessel has been placed on the armed scale (`<AutoDose>`).
+ *
+ * Behavior:
+ * - Runs from `loop()` between actuation commands, so a placement detected while one runs is
+ *   served right after it.
+ * - Sends `<Vessel g:G queued:N>` with the vessel's weight and the doses still queued, then tares
+ *   and runs the dose as an actuation command (`<Status>` shows it as `Dose`, batch checkpoints
+ *   count it, `<Abort>` stops it). The result follows as `<Dose ...>`.
+ * - A vessel placed with nothing queued is only reported. Detection resumes afterwards for the
+ *   next vessel; commands that arrived during the dose run after it.
+ */
+void Comms::runAutoDose() {
+    float vesselGrams;
+    if (busy || !scaleControls.takePlacement(vesselGrams)) {
+        return;
+    }
+    QueuedDose next;
+    bool start = doseController.nextQueued(next);
+    Serial.print(F("<Vessel g:"));
+    Serial.print(vesselGrams, Utils::getDecimal());
+    Serial.print(F(" queued:"));
+    Serial.print(doseController.queuedDoses());
+    Serial.println(F(">"));
+
+    if (start) {
+        busy = true;
+        Utils::clearAbort();
+        strcpy_P(messageFromPC, PSTR("Dose"));
+        scaleControls.tareScale();  // Doses and later readings are net of the vessel.
+        doseController.dose(next.grams, next.channel);
+        recordRecipeStep();
+        busy = false;
+    }
+    scaleControls.resumePlacement();
+    runPending();
+}
+
+/**
+ * Sends the auto-dose state as `<AutoDose state:S step:G stable:MS queued:N>`, with `S` the
+ * `PlacementState` (0 when disarmed).
+ */
+void Comms::sendAutoDose() {
+    Serial.print(F("<AutoDose state:"));
+    Serial.print(scaleControls.getPlacementState());
+    Serial.print(F(" step:"));
+    Serial.print(scaleControls.getPlacementStep(), Utils::getDecimal());
+    Serial.print(F(" stable:"));
+    Serial.print(scaleControls.getPlacementStableMs());
+    Serial.print(F(" queued:"));
+    Serial.print(doseController.queuedDoses());
+    Serial.println(F(">"));
+}
+
+/**
+ * Runs the actuation commands that arrived while another one was running, oldest first.
+ * Commands arriving meanwhile are appended and run in the same pass.
+ */
+void Comms::runPending() {
+    while (pendingFrames > 0) {
+        uint8_t i = 0;
+        char c;
+        while (pending->pop(c) && c != 0) {
+            if (i < buffSize - 1) {
+                inputBuffer[i++] = c;
+            }
+        }
+        inputBuffer[i] = 0;
+        pendingFrames--;
+        runQueued();
+    }
+}
+
+/**
+ * Sends the state of the command lanes and the hardware.
+ *
+ * Behavior:
+ * - Sends `<Status busy:C pending:N scale:S dispenser:D>`, where `C` is the running actuation
+ *   command (`-` if idle), `N` the number of waiting commands, `S` the `ScaleState` and `D`
+ *   whether the dispenser is enabled.
+ */
+void Comms::sendStatus() {
+    Serial.print(F("<Status busy:"));
+    if (busy) {
+        for (const char* c = messageFromPC; *c != 0 && *c != ','; c++) {
+            Serial.print(*c);
+        }
+    } else {
+        Serial.print(F("-"));
+    }
+    Serial.print(F(" pending:"));
+    Serial.print(pendingFrames);
+    Serial.print(F(" scale:"));
+    Serial.print(scaleControls.getScaleState());
+    Serial.print(F(" dispenser:"));
+    Serial.print(DispenserControls::dispenserEnabled);
+    Serial.println(F(">"));
+}
+
 /**
  * Sends a reply message back to the PC.
  * 
@@ -58,14 +409,57 @@ void Comms::getDataFromPC() {
 void Comms::replyToPC() {
     if (newDataFromPC) {
         newDataFromPC = false;  // Reset the new data flag.
-        Serial.print("<Msg ");  // Start the reply message.
+        Serial.print(F("<Msg "));  // Start the reply message.
         Serial.print(messageFromPC);  // Include the received message.
-        Serial.print(" Time ");
+        Serial.print(F(" Time "));
         Serial.print(curMillis >> 9);  // Shifted current time for reduced resolution.
-        Serial.println(">");  // End the reply message.
+        Serial.println(F(">"));  // End the reply message.
     }
 }
 
+/**
+ * Predicts the duration of a command without running it.
+ *
+ * Behavior:
+ * - Reads the command to predict and its arguments from the current `strtok` position, in the
+ *   same format as the command itself (e.g. `<Predict,DispenseMass,2.5,0>`, `<Predict,Mix,10>`).
+ * - Sends `<Predict kind:K ms:M>` and arms the `<Actual ...>` report for the next run of it.
+ * - Dispenser moves use the learned step period and per-move overhead; mixer, drain and pump runs
+ *   use the requested time plus the learned switching overhead; `ScaleOn` uses the learned settle time.
+ * - `Dose` is not predicted and answers `<Predict unknown>`, like any other command: its burst
+ *   count depends on how the powder flows during the dose, which the model does not learn.
+ */
+void Comms::predictCommand() {
+    char *command = strtok(NULL, ",");
+    if (command == NULL) {
+        Serial.println(F("<Predict unknown>"));
+        return;
+    }
+
+    unsigned long predictedMs;
+    if (strcmp_P(command, PSTR("DispenseMass")) == 0) {
+        float grams = atof(strtok(NULL, ","));
+        uint8_t channel = atoi(strtok(NULL, ","));
+        predictedMs = TimingModel::predictMove(dispenserControls.massToSteps(grams, channel));
+    } else if (strcmp_P(command, PSTR("Dispense")) == 0) {
+        long steps = atol(strtok(NULL, ","));
+        predictedMs = TimingModel::predictMove(steps);
+    } else if (strcmp_P(command, PSTR("Mix")) == 0 || strcmp_P(command, PSTR("Drain")) == 0) {
+        predictedMs = TimingModel::predictRelay(atof(strtok(NULL, ",")));
+    } else if (strcmp_P(command, PSTR("Pump")) == 0) {
+        strtok(NULL, ",");  // Skip the pin number.
+        predictedMs = TimingModel::predictRelay(atof(strtok(NULL, ",")));
+    } else if (strcmp_P(command, PSTR("ScaleOn")) == 0) {
+        // Time until <ScaleReady>; the command itself returns at once, so no actual is reported.
+        TimingModel::sendPrediction(command, scaleControls.predictReadyMs(), false);
+        return;
+    } else {
+        Serial.println(F("<Predict unknown>"));
+        return;
+    }
+    TimingModel::sendPrediction(command, predictedMs, true);
+}
+
 /**
  * Parses and processes the command received from the PC.
  * 
@@ -77,16 +471,157 @@ void Comms::replyToPC() {
 void Comms::parseData() {
     strcpy(messageFromPC, inputBuffer);  // Copy the input buffer for message storage.
     char *token = strtok(inputBuffer, ",");  // Extract the first token (command).
+    Trace::record(TRACE_COMMAND, strlen(messageFromPC));
 
     // Compare the command token and execute the corresponding operation.
-    if (strcmp(token, "Mix") == 0) {
+    if (strcmp_P(token, PSTR("Mix")) == 0) {
         float duration = atof(strtok(NULL, ","));  // Get duration from the command.
         mixerControls.run(mixerControls.getMixerRelay(), duration);
         replyToPC();
-    } else if (strcmp(token, "Drain") == 0) {
+    } else if (strcmp_P(token, PSTR("Drain")) == 0) {
         float duration = atof(strtok(NULL, ","));  // Get duration for draining.
         mixerControls.run(mixerControls.getDrainRelay(), duration);
         replyToPC();
-    } else if (strcmp(token, "Pump") == 0) {
+    } else if (strcmp_P(token, PSTR("ScaleOn")) == 0) {
+        scaleControls.scaleOn();  // `update()` sends <ScaleReady> once the first stable sample arrives.
+        replyToPC();
+    } else if (strcmp_P(token, PSTR("ScaleOff")) == 0) {
+        scaleControls.scaleOff();  // Warm standby; powers down fully after the idle time.
+        replyToPC();
+    } else if (strcmp_P(token, PSTR("Meas")) == 0 || strcmp_P(token, PSTR("ADC")) == 0) {
+        bool raw = strcmp_P(token, PSTR("ADC")) == 0;
+        char* samplesStr = strtok(NULL, ",");  // Optional number of samples to average.
+        char* filterStr = strtok(NULL, ",");   // Optional filter name.
+        uint8_t samples = samplesStr ? atoi(samplesStr) : 100;
+        FilterType filterType = filterStr ? ScaleControls::getFilterTypeFromString(filterStr) : EWMA;
+        replyToPC();  // The host reads the reply first, then waits for the measurement.
+        if (raw) {
+            scaleControls.sendRaw(samples, filterType);
+        } else {
+            scaleControls.sendWeight(samples, filterType);
+        }
+    } else if (strcmp_P(token, PSTR("Tare")) == 0) {
+        scaleControls.tareScale();
+        replyToPC();
+    } else if (strcmp_P(token, PSTR("Dispense")) == 0) {
+        long steps = atol(strtok(NULL, ","));  // Number of microsteps.
+        int dir = atoi(strtok(NULL, ","));     // Direction of rotation.
+        dispenserControls.dispense(steps, dir);
+        replyToPC();
+    } else if (strcmp_P(token, PSTR("ScaleIdle")) == 0) {
+        float idleTime = atof(strtok(NULL, ","));  // Standby time in seconds before full power-down.
+        scaleControls.setIdlePowerDown(idleTime * 1000);
+        replyToPC();
+    } else if (strcmp_P(token, PSTR("BatchStart")) == 0) {
+        uint16_t batchId = atoi(strtok(NULL, ","));  // Non-zero batch identifier chosen by the PC.
+        if (batchId != 0) {
+            Checkpoint::begin(batchId, scaleControls.getZeroOffset());
+        }
+        replyToPC();
+    } else if (strcmp_P(token, PSTR("BatchEnd")) == 0) {
+        Checkpoint::end();
+        replyToPC();
+    } else if (strcmp_P(token, PSTR("Resume")) == 0) {
+        if (Checkpoint::isActive()) {
+            scaleControls.setZeroOffset(Checkpoint::current().zeroOffset);  // Restore the tare baseline.
+        }
+        Checkpoint::send();  // Report the steps and masses already completed.
+    } else if (strcmp_P(token, PSTR("Flow")) == 0) {
+        uint8_t channel = atoi(strtok(NULL, ","));  // Auger channel of the last move.
+        float grams = atof(strtok(NULL, ","));      // Mass measured for that move.
+        HopperEstimator::observe(channel, grams);
+        replyToPC();
+    } else if (strcmp_P(token, PSTR("Refill")) == 0) {
+        uint8_t channel = atoi(strtok(NULL, ","));  // Refilled auger channel.
+        char* gramsStr = strtok(NULL, ",");         // Optional mass loaded.
+        char* warnStr = strtok(NULL, ",");          // Optional remaining mass that raises the warning.
+        HopperEstimator::refill(channel, gramsStr ? atof(gramsStr) : 0, warnStr ? atof(warnStr) : 0);
+        replyToPC();
+    } else if (strcmp_P(token, PSTR("AfeCal")) == 0) {
+        float interval = atof(strtok(NULL, ","));  // Seconds between background AFE recalibrations; 0 disables.
+        scaleControls.setAfeCalInterval(interval * 1000);
+        replyToPC();
+    } else if (strcmp_P(token, PSTR("ProfStart")) == 0) {
+        char* shiftStr = strtok(NULL, ",");  // Optional log2 of bytes per bucket.
+        char* baseStr = strtok(NULL, ",");   // Optional first flash address.
+        uint8_t shift = shiftStr ? atoi(shiftStr) : Profiler::defaultShift;
+        uint16_t base = baseStr ? strtoul(baseStr, NULL, 0) : 0;
+        Profiler::start(shift, base);
+        replyToPC();
+    } else if (strcmp_P(token, PSTR("ProfStop")) == 0) {
+        Profiler::stop();
+        replyToPC();
+    } else if (strcmp_P(token, PSTR("DispenseMass")) == 0) {
+        float grams = atof(strtok(NULL, ","));      // Mass to dispense in grams.
+        uint8_t channel = atoi(strtok(NULL, ","));  // Auger channel for the calibration.
+        dispenserControls.dispenseMass(grams, channel);
+        replyToPC();
+    } else if (strcmp_P(token, PSTR("Dose")) == 0) {
+        float grams = atof(strtok(NULL, ","));      // Target mass in grams.
+        uint8_t channel = atoi(strtok(NULL, ","));  // Auger channel.
+        doseController.dose(grams, channel);        // Sends <Dose ...> with the result.
+        replyToPC();
+    } else if (strcmp_P(token, PSTR("AutoDose")) == 0) {
+        char* armStr = strtok(NULL, ",");     // 1 arms vessel detection, 0 disarms; omitted only reports.
+        char* stepStr = strtok(NULL, ",");    // Optional weight rise in grams that counts as a vessel.
+        char* stableStr = strtok(NULL, ",");  // Optional time in ms the vessel must hold still.
+        if (armStr && atoi(armStr) != 0) {
+            scaleControls.armPlacement(stepStr ? atof(stepStr) : ScaleControls::defaultPlacementStepGrams,
+                                       stableStr ? atol(stableStr) : ScaleControls::defaultPlacementStableMs);
+        } else if (armStr) {
+            scaleControls.disarmPlacement();
+        }
+        sendAutoDose();
+        replyToPC();
+    } else if (strcmp_P(token, PSTR("DoseParam")) == 0) {
+        // Omitted trailing values keep their current setting; no values only reports them.
+        DoseParams params = doseController.getParams();
+        bool inRange = true;
+        params.initialFraction = nextArg(params.initialFraction);
+        for (uint8_t phase = 0; phase < 3; phase++) {
+            params.phaseFraction[phase] = nextArg(params.phaseFraction[phase]);
+        }
+        for (uint8_t phase = 0; phase < 3; phase++) {
+            params.phaseSteps[phase] = nextArg(params.phaseSteps[phase], inRange);
+        }
+        params.settleMs = nextArg(params.settleMs, inRange);
+        params.measSamples = nextArg(params.measSamples, inRange);
+        params.maxBursts = nextArg(params.maxBursts, inRange);
+        params.approachFraction = nextArg(params.approachFraction);
+        if (!inRange || !doseController.setParams(params)) {
+            Serial.println(F("<DoseParam invalid>"));
+        }
+        doseController.sendParams();
+        replyToPC();
+    } else if (strcmp_P(token, PSTR("CfgLoad")) == 0) {
+        uint16_t length = atol(strtok(NULL, ","));              // Image bytes that follow the frame.
+        uint16_t crc = strtoul(strtok(NULL, ","), NULL, 0);    // CRC-16/CCITT of the image.
+        if (DeviceConfig::receive(length, crc)) {
+            // Auger calibrations take effect at once (and `<AugerCal>` can refine them later);
+            // scale settings and the load cell calibration apply from the next startup.
+            float gramsPerStep;
+            for (uint8_t ch = 0; ch < DispenserControls::numChannels; ch++) {
+                if (DeviceConfig::getAugerCal(ch, gramsPerStep)) {
+                    dispenserControls.setAugerCal(ch, gramsPerStep);
+                }
+            }
+        }
+        replyToPC();
+    } else if (strcmp_P(token, PSTR("AugerCal")) == 0) {
+        uint8_t channel = atoi(strtok(NULL, ","));     // Auger channel.
+        float gramsPerStep = atof(strtok(NULL, ","));  // Calibration in grams per microstep.
+        dispenserControls.setAugerCal(channel, gramsPerStep);
+        replyToPC();
+    } else if (strcmp_P(token, PSTR("Pump")) == 0) {
         int pin = atoi(strtok(NULL, ","));         // Get pin number.
-        float duration = atof(strtok(N
+        float duration = atof(strtok(NULL, ","));  // Get duration for pumping.
+        mixerControls.runPump(pin, duration);
+        replyToPC();
+    } else if (strcmp_P(token, PSTR("DispenserOn")) == 0) {
+        dispenserControls.enableDispenser();
+        replyToPC();
+    } else if (strcmp_P(token, PSTR("DispenserOff")) == 0) {
+        dispenserControls.disableDispenser();
+        replyToPC();
+    }
+}
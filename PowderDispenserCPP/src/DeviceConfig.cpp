@@ -0,0 +1,247 @@
+#include "DeviceConfig.h"
+
+const int DeviceConfig::LOC_DEVICE_CONFIG = 640;  // EEPROM location of the configuration image (`maxBytes` bytes, to the end).
+
+static const char configMagic[4] = {'P', 'D', 'C', 'F'};
+static const unsigned long byteTimeoutMs = 1000;  // A transfer stalled this long is abandoned.
+
+bool DeviceConfig::valid = false;         // The EEPROM holds a complete image with a valid CRC.
+uint16_t DeviceConfig::payloadBytes = 0;  // Section bytes after the header.
+uint16_t DeviceConfig::revision = 0;      // Host-chosen revision of the image.
+uint8_t DeviceConfig::sectionCount = 0;
+
+/**
+ * Adds one byte to a CRC-16/CCITT (polynomial 0x1021, initial value 0xFFFF).
+ */
+uint16_t DeviceConfig::crc16(uint16_t crc, uint8_t byte) {
+    crc ^= (uint16_t)byte << 8;
+    for (uint8_t bit = 0; bit < 8; bit++) {
+        crc = (crc & 0x8000) ? (crc << 1) ^ 0x1021 : crc << 1;
+    }
+    return crc;
+}
+
+uint16_t DeviceConfig::readU16(int address) {
+    return EEPROM.read(address) | (uint16_t)EEPROM.read(address + 1) << 8;
+}
+
+/**
+ * Steps to the next section of the stored image.
+ *
+ * Parameters:
+ * - `address` (int&): Section start; 0 for the first section. Advanced to the section's data.
+ *
+ * Returns:
+ * - `false` after the last section.
+ */
+bool DeviceConfig::nextSection(int& address, uint8_t& tag, uint8_t& length) {
+    int end = LOC_DEVICE_CONFIG + headerBytes + payloadBytes;
+    if (address == 0) {
+        address = LOC_DEVICE_CONFIG + headerBytes;
+    }
+    if (!valid || address + 2 > end) {
+        return false;
+    }
+    tag = EEPROM.read(address);
+    length = EEPROM.read(address + 1);
+    address += 2;
+    return address + length <= end;
+}
+
+/**
+ * Validates the stored image. Called at startup and after every transfer.
+ *
+ * Returns:
+ * - `true` if the image is complete: known magic and format version, matching payload CRC and
+ *   sections that exactly fill the payload. Otherwise the firmware keeps its built-in settings.
+ */
+bool DeviceConfig::load() {
+    valid = false;
+    for (uint8_t i = 0; i < sizeof(configMagic); i++) {
+        if (EEPROM.read(LOC_DEVICE_CONFIG + i) != (uint8_t)configMagic[i]) {
+            return false;
+        }
+    }
+    payloadBytes = readU16(LOC_DEVICE_CONFIG + 6);
+    if (EEPROM.read(LOC_DEVICE_CONFIG + 4) != formatVersion || payloadBytes > maxBytes - headerBytes) {
+        return false;
+    }
+    uint16_t crc = 0xFFFF;
+    for (uint16_t i = 0; i < payloadBytes; i++) {
+        crc = crc16(crc, EEPROM.read(LOC_DEVICE_CONFIG + headerBytes + i));
+    }
+    if (crc != readU16(LOC_DEVICE_CONFIG + 8)) {
+        return false;
+    }
+
+    // Walk the sections: a length running past the payload means a malformed image.
+    valid = true;
+    int address = 0;
+    uint8_t tag, length;
+    uint8_t sections = 0;
+    while (nextSection(address, tag, length)) {
+        address += length;
+        sections++;
+    }
+    valid = address == LOC_DEVICE_CONFIG + headerBytes + payloadBytes && sections == EEPROM.read(LOC_DEVICE_CONFIG + 5);
+    sectionCount = sections;
+    revision = readU16(LOC_DEVICE_CONFIG + 10);
+    return valid;
+}
+
+/**
+ * Receives an image sent right after `<CfgLoad,LENGTH,CRC>` and stores it in EEPROM.
+ *
+ * Parameters:
+ * - `length` (uint16_t): Image bytes, header included.
+ * - `imageCrc` (uint16_t): CRC-16/CCITT of the whole image.
+ *
+ * Behavior:
+ * - Sends `<CfgLoad ready bytes:N>`, then reads the raw image from Serial. The host must pace it
+ *   to the EEPROM write rate (about 3.3 ms per changed byte; 64 bytes of receive buffer).
+ * - The stored image is invalidated first and its header, magic last, is written only once the
+ *   whole image has arrived with the right CRC, so a reset or a failed transfer never leaves a
+ *   partial image that passes `load()`.
+ * - Sends `<CfgLoad ok rev:R bytes:N sections:S>`, or `<CfgLoad error:REASON ...>` with REASON
+ *   one of `size`, `timeout`, `crc`, `format`. After an error the built-in settings apply until a
+ *   valid image is loaded.
+ *
+ * Returns:
+ * - `true` if a valid image is stored.
+ */
+bool DeviceConfig::receive(uint16_t length, uint16_t imageCrc) {
+    if (length < headerBytes || length > maxBytes) {
+        Serial.println(F("<CfgLoad error:size>"));
+        return false;
+    }
+    valid = false;
+    EEPROM.update(LOC_DEVICE_CONFIG, 0);  // Invalidate the magic until the new image is complete.
+    Serial.print(F("<CfgLoad ready bytes:"));
+    Serial.print(length);
+    Serial.println(F(">"));
+
+    uint8_t header[headerBytes];
+    uint16_t crc = 0xFFFF;
+    uint16_t received = 0;
+    unsigned long lastByte = millis();
+    while (received < length) {
+        if (Serial.available() > 0) {
+            uint8_t byte = Serial.read();
+            crc = crc16(crc, byte);
+            if (received < headerBytes) {
+                header[received] = byte;
+            } else {
+                EEPROM.update(LOC_DEVICE_CONFIG + received, byte);
+            }
+            received++;
+            lastByte = millis();
+        } else if (millis() - lastByte > byteTimeoutMs) {
+            Serial.print(F("<CfgLoad error:timeout got:"));
+            Serial.print(received);
+            Serial.println(F(">"));
+            return false;
+        }
+    }
+    if (crc != imageCrc) {
+        Serial.println(F("<CfgLoad error:crc>"));
+        return false;
+    }
+    if (memcmp(header, configMagic, sizeof(configMagic)) != 0 || header[4] != formatVersion
+        || (header[6] | (uint16_t)header[7] << 8) != length - headerBytes) {
+        Serial.println(F("<CfgLoad error:format>"));
+        return false;
+    }
+
+    for (int8_t i = headerBytes - 1; i >= 0; i--) {
+        EEPROM.update(LOC_DEVICE_CONFIG + i, header[i]);  // Magic last: the commit point.
+    }
+    if (!load()) {
+        Serial.println(F("<CfgLoad error:format>"));
+        return false;
+    }
+    Serial.print(F("<CfgLoad ok rev:"));
+    Serial.print(revision);
+    Serial.print(F(" bytes:"));
+    Serial.print(length);
+    Serial.print(F(" sections:"));
+    Serial.print(sectionCount);
+    Serial.println(F(">"));
+    return true;
+}
+
+/**
+ * Sends the stored image's summary.
+ *
+ * Format: `<Cfg rev:R bytes:N sections:S crc:C>`, or `<Cfg none>` without a valid image.
+ */
+void DeviceConfig::send() {
+    if (!valid) {
+        Serial.println(F("<Cfg none>"));
+        return;
+    }
+    Serial.print(F("<Cfg rev:"));
+    Serial.print(revision);
+    Serial.print(F(" bytes:"));
+    Serial.print(headerBytes + payloadBytes);
+    Serial.print(F(" sections:"));
+    Serial.print(sectionCount);
+    Serial.print(F(" crc:"));
+    Serial.print(readU16(LOC_DEVICE_CONFIG + 8));
+    Serial.println(F(">"));
+}
+
+/**
+ * Overwrites `settings` with the scale section of the image, if there is one.
+ */
+void DeviceConfig::getScale(ScaleSettings& settings) {
+    int address = 0;
+    uint8_t tag, length;
+    while (nextSection(address, tag, length)) {
+        if (tag == CFG_SCALE && length >= 4) {
+            settings.sampleRate = readU16(address);
+            settings.gain = EEPROM.read(address + 2);
+            settings.ldoVoltage = EEPROM.read(address + 3);
+            return;
+        }
+        address += length;
+    }
+}
+
+/**
+ * Reads the calibration of the active load cell.
+ *
+ * Returns:
+ * - `false` if the image has no active load cell.
+ */
+bool DeviceConfig::getLoadCell(float& slope, float& intercept) {
+    int address = 0;
+    uint8_t tag, length;
+    while (nextSection(address, tag, length)) {
+        if (tag == CFG_LOAD_CELL && length >= 11 && EEPROM.read(address + 10) != 0) {
+            EEPROM.get(address + 2, slope);
+            EEPROM.get(address + 6, intercept);
+            return true;
+        }
+        address += length;
+    }
+    return false;
+}
+
+/**
+ * Reads the calibration of the auger assigned to a channel.
+ *
+ * Returns:
+ * - `false` if no auger section is assigned to `channel`.
+ */
+bool DeviceConfig::getAugerCal(uint8_t channel, float& gramsPerStep) {
+    int address = 0;
+    uint8_t tag, length;
+    while (nextSection(address, tag, length)) {
+        if (tag == CFG_AUGER && length >= 5 && EEPROM.read(address) == channel) {
+            EEPROM.get(address + 1, gramsPerStep);
+            return true;
+        }
+        address += length;
+    }
+    return false;
+}
@@ -1,4 +1,8 @@
 #include "DispenserControls.h"
+#include "Trace.h"
+#include "TimingModel.h"
+#include "Checkpoint.h"
+#include "HopperEstimator.h"
 
 /**
  * Static variable to track whether the dispenser is enabled.
@@ -6,13 +10,22 @@
  */
 bool DispenserControls::dispenserEnabled = false;
 
+int DispenserControls::dispenseDir = 1;                                  // Default dispensing direction.
+const float DispenserControls::dispenserCalFactor = 2.1130909090909088e-05;  // Default grams per step (8mm auger, dishwasher salt).
+const int DispenserControls::LOC_AUGER_CAL = 40;                         // EEPROM location of the per-channel auger calibration.
+const unsigned long DispenserControls::serviceChunkMs = 10;              // Longest driver command between background task runs.
+
 /**
  * Constructor for the DispenserControls class.
  * 
  * Parameters:
  * - `utils` (Utils&): Reference to the utility class for shared functionality.
  */
-DispenserControls::DispenserControls(Utils& utils) : utils(utils) {}
+DispenserControls::DispenserControls(Utils& utils) : utils(utils) {
+    for (uint8_t ch = 0; ch < numChannels; ch++) {
+        augerCal[ch] = dispenserCalFactor;  // Until `loadAugerCal()` reads the EEPROM.
+    }
+}
 
 /**
  * Sets up the dispenser by configuring its settings and initializing the driver.
@@ -37,7 +50,7 @@ void DispenserControls::setupDispenser(int resVar) {
         case 32:    Dispenser.settings.stepResolutionMode = PRODRIVER_STEP_RESOLUTION_VARIABLE_1_32; break;
         case 64:    Dispenser.settings.stepResolutionMode = PRODRIVER_STEP_RESOLUTION_VARIABLE_1_64; break;
         case 128:   Dispenser.settings.stepResolutionMode = PRODRIVER_STEP_RESOLUTION_VARIABLE_1_128; break;
-        default: Serial.println("Error: Invalid resolution."); return;
+        default: Serial.println(F("Error: Invalid resolution.")); return;
     }
     */
 
@@ -52,6 +65,9 @@ void DispenserControls::setupDispenser(int resVar) {
 
     // Disable the dispenser to ensure it's off by default.
     Dispenser.disable();
+
+    // Load the per-channel auger calibration used by mass-unit dispensing.
+    loadAugerCal();
 }
 
 /**
@@ -96,7 +112,7 @@ void DispenserControls::changeDir(int dir) {
     if (dir == 0 || dir == 1) {
         dispenseDir = dir;  // Update the dispensing direction.
     } else {
-        Serial.println("Error: Invalid direction.");  // Print error message.
+        Serial.println(F("Error: Invalid direction."));  // Print error message.
         disableDispenser();                           // Disable the dispenser.
         while (1);                                    // Halt execution.
     }
@@ -106,12 +122,109 @@ void DispenserControls::changeDir(int dir) {
  * Performs a dispensing operation by moving the stepper motor.
  * 
  * Parameters:
- * - `steps` (int): Number of steps to move the motor.
+ * - `steps` (long): Number of steps to move the motor (32-bit).
  * - `dir` (int): Direction to move the motor (0 or 1).
+ * - `channel` (uint8_t): Auger channel that moves (default 0).
  * 
  * Behavior:
- * - Sends a command to the dispenser to perform the specified number of steps in the given direction.
+ * - Sends the move to the dispenser as a sequence of driver commands, each sized by the timing
+ *   model to take about `serviceChunkMs`, so moves of any length need a single command from the PC.
+ * - Runs the background task between driver commands so status queries and aborts are handled
+ *   within about `serviceChunkMs` during long moves; an abort stops the move after the current
+ *   driver command. The driver call blocks and there is no step interrupt to serve them from, so
+ *   the auger stops briefly at each chunk boundary; the move is not one continuous motion.
+ * - Records the completed move as a trace event (negative step count for direction 0) and feeds
+ *   its duration to the timing model.
+ * - Moves in the dispensing direction add their mass to the batch checkpoint and the hopper estimate.
+ */
+void DispenserControls::dispense(long steps, int dir, uint8_t channel) {
+    unsigned long startUs = micros();
+    long remaining = steps;
+    uint16_t chunkSteps = TimingModel::stepsWithin(serviceChunkMs);
+    while (remaining > 0 && !Utils::isAbortRequested()) {
+        uint16_t chunk = remaining > chunkSteps ? chunkSteps : remaining;
+        Dispenser.stepSerial(chunk, dir);  // Command the dispenser to step.
+        remaining -= chunk;
+        utils.runBackgroundTask();
+    }
+    steps -= remaining;  // Steps actually moved.
+    TimingModel::observeMove(steps, micros() - startUs);
+    Trace::record(TRACE_STEP, dir ? steps : -steps);
+    if (dir == dispenseDir && channel < numChannels) {
+        Checkpoint::addDose(channel, steps * augerCal[channel]);
+        HopperEstimator::recordMove(channel, steps, steps * augerCal[channel]);
+    }
+}
+
+/**
+ * Converts a powder mass into microsteps using the on-device calibration.
+ *
+ * Parameters:
+ * - `grams` (float): Mass to dispense.
+ * - `channel` (uint8_t): Auger channel whose calibration is used.
+ *
+ * Returns:
+ * - The number of microsteps (32-bit), or 0 for an invalid channel or a non-positive mass.
+ */
+long DispenserControls::massToSteps(float grams, uint8_t channel) {
+    if (channel >= numChannels || grams <= 0) {
+        return 0;
+    }
+    return lround(grams / augerCal[channel]);
+}
+
+/**
+ * Dispenses a powder mass as one move (see `dispense()` for how it is chunked).
+ *
+ * Parameters:
+ * - `grams` (float): Mass to dispense.
+ * - `channel` (uint8_t): Auger channel whose calibration is used.
+ *
+ * Returns:
+ * - The number of microsteps moved.
+ */
+long DispenserControls::dispenseMass(float grams, uint8_t channel) {
+    long steps = massToSteps(grams, channel);
+    if (steps > 0) {
+        dispense(steps, dispenseDir, channel);
+    }
+    return steps;
+}
+
+/**
+ * Stores the calibration of an auger channel in RAM and EEPROM.
+ *
+ * Parameters:
+ * - `channel` (uint8_t): Auger channel (0 to `numChannels - 1`).
+ * - `gramsPerStep` (float): Dispensed mass per microstep; must be positive.
+ *
+ * Returns:
+ * - `true` if the calibration was stored, `false` for an invalid channel or value.
+ */
+bool DispenserControls::setAugerCal(uint8_t channel, float gramsPerStep) {
+    if (channel >= numChannels || !(gramsPerStep > 0)) {
+        return false;
+    }
+    augerCal[channel] = gramsPerStep;
+    EEPROM.put(LOC_AUGER_CAL + channel * sizeof(float), gramsPerStep);
+    return true;
+}
+
+/**
+ * Returns the calibration (grams per microstep) of an auger channel, or 0 for an invalid channel.
  */
-void DispenserControls::dispense(int steps, int dir) {
-    Dispenser.stepSerial(steps, dir);  // Command the dispenser to step.
+float DispenserControls::getAugerCal(uint8_t channel) {
+    return channel < numChannels ? augerCal[channel] : 0;
+}
+
+/**
+ * Loads the per-channel auger calibration from EEPROM.
+ * - Channels that were never calibrated (cleared or erased EEPROM) fall back to `dispenserCalFactor`.
+ */
+void DispenserControls::loadAugerCal() {
+    for (uint8_t ch = 0; ch < numChannels; ch++) {
+        float gramsPerStep;
+        EEPROM.get(LOC_AUGER_CAL + ch * sizeof(float), gramsPerStep);
+        augerCal[ch] = (gramsPerStep > 0 && gramsPerStep < 1.0) ? gramsPerStep : dispenserCalFactor;
+    }
 }
@@ -0,0 +1,222 @@
+#include "DoseController.h"
+#include "HopperEstimator.h"
+
+const unsigned long DoseController::scaleReadyTimeoutMs = 5000;  // Longest wait for the scale to settle.
+const int DoseController::LOC_DOSE_PARAMS = 600;                 // EEPROM location of the dose parameters (after the checkpoint ring).
+
+/**
+ * Constructor for the DoseController class.
+ *
+ * Parameters:
+ * - `utils` (Utils&): Reference to the utility class for shared functionality.
+ * - `scaleControls` (ScaleControls&): Scale used to weigh the dose.
+ * - `dispenserControls` (DispenserControls&): Dispenser that moves the powder.
+ *
+ * Takes the dose queue from the memory arena.
+ */
+DoseController::DoseController(Utils& utils, ScaleControls& scaleControls, DispenserControls& dispenserControls)
+    : utils(utils), scaleControls(scaleControls), dispenserControls(dispenserControls), startWeight(0),
+      queue(MemoryArena::allocate<RingBuffer<QueuedDose, queueSize>>(1, PSTR("doses"))) {}
+
+/**
+ * Checks that a parameter set describes a dose that can finish.
+ * - Phase fractions must rise strictly, start above the initial fraction and end at most at 1.0.
+ * - Burst sizes, weighing samples and the burst limit must be non-zero.
+ * - A burst must cover part of the remaining gap, and at most all of it.
+ */
+bool DoseController::isValid(const DoseParams& candidate) {
+    if (!(candidate.initialFraction >= 0 && candidate.initialFraction < candidate.phaseFraction[0])) {
+        return false;  // Also rejects NaN (erased EEPROM).
+    }
+    for (uint8_t phase = 0; phase < 3; phase++) {
+        bool below = phase < 2 ? candidate.phaseFraction[phase] < candidate.phaseFraction[phase + 1]
+                               : candidate.phaseFraction[phase] <= 1.0;
+        if (!below || candidate.phaseSteps[phase] == 0) {
+            return false;
+        }
+    }
+    if (!(candidate.approachFraction > 0 && candidate.approachFraction <= 1.0)) {
+        return false;  // Also rejects parameters stored before `approachFraction` existed.
+    }
+    return candidate.measSamples > 0 && candidate.maxBursts > 0;
+}
+
+/**
+ * Replaces the dose parameters and stores them in EEPROM.
+ *
+ * Returns:
+ * - `true` if the parameters were stored, `false` if they are invalid (the current ones are kept).
+ */
+bool DoseController::setParams(const DoseParams& newParams) {
+    if (!isValid(newParams)) {
+        return false;
+    }
+    params = newParams;
+    EEPROM.put(LOC_DOSE_PARAMS, params);
+    return true;
+}
+
+/**
+ * Loads the dose parameters from EEPROM.
+ * - Invalid contents (never stored, cleared or erased EEPROM) keep the defaults.
+ */
+void DoseController::loadParams() {
+    DoseParams stored;
+    EEPROM.get(LOC_DOSE_PARAMS, stored);
+    if (isValid(stored)) {
+        params = stored;
+    }
+}
+
+/**
+ * Sends the dose parameters as
+ * `<DoseParam initial:I phases:F0,F1,F2 steps:S0,S1,S2 settle:MS samples:N bursts:B approach:A>`.
+ */
+void DoseController::sendParams() {
+    Serial.print(F("<DoseParam initial:"));
+    Serial.print(params.initialFraction, 3);
+    Serial.print(F(" phases:"));
+    for (uint8_t phase = 0; phase < 3; phase++) {
+        Serial.print(params.phaseFraction[phase], 3);
+        Serial.print(phase < 2 ? F(",") : F(" steps:"));
+    }
+    for (uint8_t phase = 0; phase < 3; phase++) {
+        Serial.print(params.phaseSteps[phase]);
+        Serial.print(phase < 2 ? F(",") : F(" settle:"));
+    }
+    Serial.print(params.settleMs);
+    Serial.print(F(" samples:"));
+    Serial.print(params.measSamples);
+    Serial.print(F(" bursts:"));
+    Serial.print(params.maxBursts);
+    Serial.print(F(" approach:"));
+    Serial.print(params.approachFraction, 3);
+    Serial.println(F(">"));
+}
+
+/**
+ * Weighs the scale and returns the mass relative to the start of the dose, in grams.
+ */
+float DoseController::weigh() {
+    return scaleControls.convertToWeight(scaleControls.getReading(params.measSamples, NONE)) - startWeight;
+}
+
+/**
+ * Waits `settleMs` for the powder to land, then weighs.
+ *
+ * Returns:
+ * - `false` if the wait was aborted or the scale gave no reading.
+ */
+bool DoseController::settleAndWeigh(float& grams) {
+    if (!utils.wait(params.settleMs)) {
+        return false;
+    }
+    float weighed = weigh();
+    if (isnan(weighed)) {
+        return false;
+    }
+    grams = weighed;
+    return true;
+}
+
+/**
+ * Dispenses a target mass with scale feedback.
+ *
+ * Parameters:
+ * - `grams` (float): Target mass.
+ * - `channel` (uint8_t): Auger channel whose calibration sizes the initial move.
+ *
+ * Returns:
+ * - The measured mass, the number of bursts and the duration of the dose.
+ *
+ * Behavior:
+ * - Rejects a target that is not a positive finite mass, or a channel the dispenser does not have,
+ *   with `<Dose error:mass>` or `<Dose error:channel>` and moves nothing.
+ * - Turns the scale on and waits for it to be ready, and enables the dispenser, if needed; both
+ *   are left as they were found.
+ * - Each burst covers `approachFraction` of the gap to the current phase, and at least the phase's
+ *   `phaseSteps`, so the number of bursts grows with the log of the target instead of linearly.
+ * - Feeds the measured mass of the initial move and of every burst to the hopper estimator.
+ * - Stops early on `<Abort>` (also while waiting for the scale), if the scale stops delivering
+ *   readings, or after `maxBursts` bursts.
+ * - Sends `<Dose target:T mass:M bursts:B ms:D>` when done.
+ */
+DoseResult DoseController::dose(float grams, uint8_t channel) {
+    unsigned long start = millis();
+    DoseResult result = {0, 0, 0, false};
+    if (!(grams > 0) || isinf(grams)) {  // Also rejects NaN (a malformed frame).
+        Serial.println(F("<Dose error:mass>"));
+        return result;
+    }
+    if (channel >= DispenserControls::numChannels) {
+        Serial.println(F("<Dose error:channel>"));
+        return result;
+    }
+
+    bool scaleWasReady = scaleControls.isScaleReady();
+    if (!scaleWasReady) {
+        scaleControls.scaleOn();
+        while (!scaleControls.isScaleReady() && millis() - start < scaleReadyTimeoutMs && !Utils::isAbortRequested()) {
+            utils.runBackgroundTask();  // The scale state machine runs in the background task.
+        }
+    }
+    bool dispenserWasEnabled = DispenserControls::dispenserEnabled;
+    if (!dispenserWasEnabled) {
+        dispenserControls.enableDispenser();
+    }
+
+    startWeight = 0;
+    float current = 0;
+    bool running = !Utils::isAbortRequested();
+    if (running) {
+        startWeight = weigh();
+        running = !isnan(startWeight);  // Dispense nothing without a starting weight.
+    }
+    if (running && params.initialFraction > 0) {
+        dispenserControls.dispenseMass(grams * params.initialFraction, channel);
+        running = settleAndWeigh(current);
+        if (running) {
+            HopperEstimator::observe(channel, current);
+        }
+    }
+
+    for (uint8_t phase = 0; phase < 3 && running; phase++) {
+        float phaseGrams = grams * params.phaseFraction[phase];
+        while (current < phaseGrams && result.bursts < params.maxBursts) {
+            long steps = dispenserControls.massToSteps((phaseGrams - current) * params.approachFraction, channel);
+            if (steps < params.phaseSteps[phase]) {
+                steps = params.phaseSteps[phase];
+            }
+            dispenserControls.dispense(steps, DispenserControls::dispenseDir, channel);
+            result.bursts++;
+            float before = current;
+            if (!settleAndWeigh(current)) {
+                running = false;
+                break;
+            }
+            HopperEstimator::observe(channel, current - before);  // Ignored for bursts under `minObserveSteps`.
+        }
+    }
+
+    if (!dispenserWasEnabled) {
+        dispenserControls.disableDispenser();
+    }
+    if (!scaleWasReady) {
+        scaleControls.scaleOff();
+    }
+
+    result.grams = current;
+    result.ms = millis() - start;
+    result.completed = running && current >= grams * params.phaseFraction[2];
+
+    Serial.print(F("<Dose target:"));
+    Serial.print(grams, Utils::getDecimal());
+    Serial.print(F(" mass:"));
+    Serial.print(result.grams, Utils::getDecimal());
+    Serial.print(F(" bursts:"));
+    Serial.print(result.bursts);
+    Serial.print(F(" ms:"));
+    Serial.print(result.ms);
+    Serial.println(result.completed ? F(">") : F(" incomplete>"));
+    return result;
+}
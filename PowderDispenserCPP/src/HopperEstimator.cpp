@@ -0,0 +1,196 @@
+#include "HopperEstimator.h"
+#include "TimingModel.h"
+#include "Utils.h"
+
+static_assert(sizeof(HopperState) <= ARENA_HOPPER_ENTRY_BYTES, "HopperState exceeds its arena budget.");
+
+static const char hopperRegion[] PROGMEM = "hopper";  // Arena region name.
+
+// Per-channel estimator state.
+HopperState* HopperEstimator::hoppers = MemoryArena::allocate<HopperState>(HopperEstimator::numChannels, hopperRegion);
+
+uint8_t HopperEstimator::lastChannel = 0;  // Channel of the last move.
+long HopperEstimator::lastSteps = 0;       // Steps of the last move, until its mass is observed.
+float HopperEstimator::lastEstimate = 0;   // Calibrated mass credited for the last move.
+
+/**
+ * Records a dispensing move. Called by the dispenser after every move in the dispensing direction.
+ *
+ * Parameters:
+ * - `channel` (uint8_t): Auger channel that moved.
+ * - `steps` (long): Steps moved.
+ * - `estimatedGrams` (float): Mass from the auger calibration, used until a measurement is reported.
+ */
+void HopperEstimator::recordMove(uint8_t channel, long steps, float estimatedGrams) {
+    if (channel >= numChannels || steps <= 0) {
+        return;
+    }
+    HopperState& hopper = hoppers[channel];
+    hopper.stepsSinceRefill += steps;
+    hopper.dispensedGrams += estimatedGrams;
+    lastChannel = channel;
+    lastSteps = steps;
+    lastEstimate = estimatedGrams;
+    checkWarning(channel);
+}
+
+/**
+ * Learns the flow from the measured mass of the last move.
+ *
+ * Parameters:
+ * - `channel` (uint8_t): Auger channel the mass was dispensed from; must match the last move.
+ * - `grams` (float): Mass measured on the scale for that move.
+ *
+ * Returns:
+ * - `true` if the observation was used, `false` if it does not match the last move, the move
+ *   was shorter than `minObserveSteps` or the mass is not positive.
+ */
+bool HopperEstimator::observe(uint8_t channel, float grams) {
+    if (channel != lastChannel || lastSteps < minObserveSteps || !(grams > 0)) {
+        return false;
+    }
+    HopperState& hopper = hoppers[channel];
+    float gps = grams / lastSteps;
+    float pos = hopper.stepsSinceRefill - lastSteps / 2.0;  // Middle of the move.
+
+    if (hopper.freshCount < freshSamples) {
+        hopper.freshCount++;
+        hopper.freshGps += (gps - hopper.freshGps) / hopper.freshCount;
+        hopper.freshPos += (pos - hopper.freshPos) / hopper.freshCount;
+        hopper.recentGps = hopper.freshGps;
+        hopper.recentPos = hopper.freshPos;
+    } else {
+        hopper.recentGps += recentWeight * (gps - hopper.recentGps);
+        hopper.recentPos += recentWeight * (pos - hopper.recentPos);
+    }
+
+    hopper.dispensedGrams += grams - lastEstimate;  // Replace the calibrated estimate.
+    lastSteps = 0;
+    checkWarning(channel);
+    return true;
+}
+
+/**
+ * Resets a channel after its hopper was refilled.
+ *
+ * Parameters:
+ * - `channel` (uint8_t): Auger channel.
+ * - `grams` (float): Mass in the hopper after the refill; 0 if unknown.
+ * - `warnGrams` (float): Remaining mass that raises the warning; 0 for `defaultWarnFraction` of `grams`.
+ */
+void HopperEstimator::refill(uint8_t channel, float grams, float warnGrams) {
+    if (channel >= numChannels) {
+        return;
+    }
+    hoppers[channel] = HopperState();
+    hoppers[channel].fillGrams = grams > 0 ? grams : 0;
+    hoppers[channel].warnGrams = warnGrams > 0 ? warnGrams : hoppers[channel].fillGrams * defaultWarnFraction;
+    if (lastChannel == channel) {
+        lastSteps = 0;
+    }
+}
+
+/**
+ * Predicts the steps left until the flow falls to `emptyFlowRatio` of the fresh flow.
+ *
+ * Returns:
+ * - The step count, or -1 while there is no fresh flow or the flow has not yet dropped by
+ *   `minTrendDrop` (a smaller drop is within the flow noise and would extrapolate wildly).
+ */
+long HopperEstimator::stepsToEmpty(uint8_t channel) {
+    if (channel >= numChannels) {
+        return -1;
+    }
+    const HopperState& hopper = hoppers[channel];
+    if (hopper.freshCount < freshSamples || hopper.recentPos <= hopper.freshPos
+        || hopper.recentGps > (1 - minTrendDrop) * hopper.freshGps) {
+        return -1;
+    }
+    float slope = (hopper.recentGps - hopper.freshGps) / (hopper.recentPos - hopper.freshPos);
+    if (slope >= 0) {
+        return -1;
+    }
+    float emptyPos = hopper.recentPos + (emptyFlowRatio * hopper.freshGps - hopper.recentGps) / slope;
+    float left = emptyPos - hopper.stepsSinceRefill;
+    return left > 0 ? (long)left : 0;
+}
+
+/**
+ * Estimates the powder left in a hopper.
+ *
+ * Returns:
+ * - The smaller of the flow-trend estimate and the refill mass minus the dispensed mass, or -1
+ *   if neither is known.
+ */
+float HopperEstimator::remainingGrams(uint8_t channel) {
+    if (channel >= numChannels) {
+        return -1;
+    }
+    const HopperState& hopper = hoppers[channel];
+    float remaining = -1;
+
+    long left = stepsToEmpty(channel);
+    if (left >= 0) {
+        // Flow falls linearly from the recent to the empty flow over the remaining steps.
+        remaining = left * (hopper.recentGps + emptyFlowRatio * hopper.freshGps) / 2;
+    }
+    if (hopper.fillGrams > 0) {
+        float fromFill = hopper.fillGrams - hopper.dispensedGrams;
+        if (fromFill < 0) fromFill = 0;
+        if (remaining < 0 || fromFill < remaining) remaining = fromFill;
+    }
+    return remaining;
+}
+
+/**
+ * Sends `<HopperLow ...>` once per refill when the flow or the remaining mass crosses its threshold.
+ */
+void HopperEstimator::checkWarning(uint8_t channel) {
+    HopperState& hopper = hoppers[channel];
+    if (hopper.warned) {
+        return;
+    }
+    bool flowLow = hopper.freshCount >= freshSamples && hopper.recentGps < warnFlowRatio * hopper.freshGps;
+    float remaining = remainingGrams(channel);
+    bool massLow = remaining >= 0 && hopper.warnGrams > 0 && remaining < hopper.warnGrams;
+    if (flowLow || massLow) {
+        hopper.warned = true;
+        Serial.print(F("<HopperLow ch:"));
+        Serial.print(channel);
+        Serial.print(F(" remaining:"));
+        Serial.print(remaining, Utils::getDecimal());
+        Serial.println(F(">"));
+    }
+}
+
+/**
+ * Sends the estimate of a channel to the PC.
+ *
+ * Format: `<Hopper ch:C steps:S flow:F remaining:G emptyMs:T>`, where `F` is the latest flow
+ * relative to the fresh flow, `G` the remaining grams and `T` the motor time to empty (both -1
+ * if unknown).
+ */
+void HopperEstimator::send(uint8_t channel) {
+    if (channel >= numChannels) {
+        Serial.println(F("<Hopper unknown>"));
+        return;
+    }
+    const HopperState& hopper = hoppers[channel];
+    float remaining = remainingGrams(channel);
+    long left = stepsToEmpty(channel);
+    if (left < 0 && remaining >= 0 && hopper.recentGps > 0) {
+        left = remaining / hopper.recentGps;  // No trend yet: assume the latest flow holds.
+    }
+
+    Serial.print(F("<Hopper ch:"));
+    Serial.print(channel);
+    Serial.print(F(" steps:"));
+    Serial.print(hopper.stepsSinceRefill);
+    Serial.print(F(" flow:"));
+    Serial.print(hopper.freshGps > 0 ? hopper.recentGps / hopper.freshGps : 1.0, Utils::getDecimal());
+    Serial.print(F(" remaining:"));
+    Serial.print(remaining, Utils::getDecimal());
+    Serial.print(F(" emptyMs:"));
+    Serial.print(left >= 0 ? (long)TimingModel::predictMove(left) : -1L);
+    Serial.println(F(">"));
+}
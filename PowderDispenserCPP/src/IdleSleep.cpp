@@ -0,0 +1,72 @@
+#include "IdleSleep.h"
+
+#if defined(__AVR__)
+#include <avr/sleep.h>
+#endif
+
+bool IdleSleep::enabled = false;  // Off until `compare_idle_sleep()` shows a gain on the board.
+uint32_t IdleSleep::sleeps = 0;
+uint32_t IdleSleep::asleepUs = 0;
+uint32_t IdleSleep::windowStartUs = 0;
+
+/**
+ * Sleeps until the next interrupt, unless a received byte is already waiting.
+ *
+ * Behavior:
+ * - The receive check runs with interrupts disabled and `sei` is directly followed by `sleep`, so
+ *   a byte arriving in between still wakes the CPU (the instruction after `sei` always executes
+ *   before a pending interrupt is served).
+ * - Serial transmission continues while asleep: the transmit interrupt drains the buffer.
+ */
+void IdleSleep::enter() {
+    if (!enabled) {
+        return;
+    }
+#if defined(__AVR__)
+    uint32_t start = micros();
+    set_sleep_mode(SLEEP_MODE_IDLE);
+    cli();
+    if (Serial.available() > 0) {
+        sei();
+        return;
+    }
+    sleep_enable();
+    sei();
+    sleep_cpu();
+    sleep_disable();
+    asleepUs += micros() - start;
+    sleeps++;
+#endif
+}
+
+/**
+ * Selects idle sleep (`true`) or the busy loop (`false`, the default), and starts a new reporting window.
+ */
+void IdleSleep::setEnabled(bool enable) {
+    enabled = enable;
+    sleeps = 0;
+    asleepUs = 0;
+    windowStartUs = micros();
+}
+
+/**
+ * Sends the policy and the sleep statistics since the last report, then starts a new window.
+ *
+ * Format: `<Idle on:0|1 sleeps:N asleep:PCT ms:WINDOW>`, with PCT the share of the window spent
+ * asleep in percent.
+ */
+void IdleSleep::send() {
+    uint32_t windowUs = micros() - windowStartUs;
+    Serial.print(F("<Idle on:"));
+    Serial.print(enabled);
+    Serial.print(F(" sleeps:"));
+    Serial.print(sleeps);
+    Serial.print(F(" asleep:"));
+    Serial.print(windowUs > 0 ? 100.0 * asleepUs / windowUs : 0.0, 1);
+    Serial.print(F(" ms:"));
+    Serial.print(windowUs / 1000);
+    Serial.println(F(">"));
+    sleeps = 0;
+    asleepUs = 0;
+    windowStartUs = micros();
+}
@@ -0,0 +1,37 @@
+#include "MemoryArena.h"
+
+// Static member variables
+alignas(uint64_t) uint8_t MemoryArena::storage[MemoryArena::arenaBytes];  // Backing storage for every arena region.
+uint16_t MemoryArena::used = 0;                                 // Bytes handed out so far.
+bool MemoryArena::overflow = false;                             // Set if an allocation did not fit.
+MemoryArena::Region MemoryArena::regions[MemoryArena::maxRegions];  // Layout of the allocated regions.
+uint8_t MemoryArena::regionCount = 0;                           // Number of allocated regions.
+
+/**
+ * Sends the arena layout to the PC in a single frame.
+ *
+ * Format: `<Mem profile:P size:S used:U free:F [overflow] name:offset:bytes;...>`
+ */
+void MemoryArena::report() {
+    Serial.print(F("<Mem profile:"));
+    Serial.print(MEMORY_PROFILE);
+    Serial.print(F(" size:"));
+    Serial.print(arenaBytes);
+    Serial.print(F(" used:"));
+    Serial.print(used);
+    Serial.print(F(" free:"));
+    Serial.print(bytesFree());
+    if (overflow) {
+        Serial.print(F(" overflow"));
+    }
+    Serial.print(F(" "));
+    for (uint8_t i = 0; i < regionCount; i++) {
+        Serial.print(reinterpret_cast<const __FlashStringHelper*>(regions[i].name));
+        Serial.print(F(":"));
+        Serial.print(regions[i].offset);
+        Serial.print(F(":"));
+        Serial.print(regions[i].bytes);
+        Serial.print(F(";"));
+    }
+    Serial.println(F(">"));
+}
@@ -0,0 +1,197 @@
+#include "MemoryMonitor.h"
+
+static_assert(sizeof(CommandStackStat) <= ARENA_COMMAND_STAT_BYTES, "CommandStackStat exceeds its arena budget.");
+
+// Static member variables
+uint16_t MemoryMonitor::peakStack = 0;  // Deepest stack use seen since boot, in bytes.
+static const char statsRegion[] PROGMEM = "stats";  // Arena region name.
+CommandStackStat* MemoryMonitor::commands = MemoryArena::allocate<CommandStackStat>(MemoryMonitor::maxCommands, statsRegion);
+uint8_t MemoryMonitor::commandCount = 0;  // Number of commands tracked in `commands`.
+
+#if defined(__AVR__)
+extern uint8_t __heap_start;  // End of .bss, start of the (unused) heap.
+extern uint8_t* __brkval;     // Current heap end, or 0 if malloc was never called.
+
+/**
+ * Returns the first address above the heap, where the free RAM begins.
+ */
+static inline uint8_t* heapEnd() {
+    return __brkval ? __brkval : &__heap_start;
+}
+
+/**
+ * Fills the free RAM between the heap and the stack pointer with the canary byte.
+ */
+static inline void paintFreeMemory() {
+    uint8_t* p = heapEnd();
+    uint8_t* top = (uint8_t*)SP;
+    while (p < top) {
+        *p++ = MemoryMonitor::canary;
+    }
+}
+
+/**
+ * Paints the free RAM once at boot, before any constructor runs.
+ * Placed in .init3, which runs after the stack pointer and the zero register are set up but
+ * before .bss is zeroed, so `__brkval` (read by `heapEnd()`) is still garbage. Nothing has
+ * called malloc yet, so the heap ends at `__heap_start`.
+ *
+ * The startup code falls through the .init sections, so the function is naked (no prologue,
+ * epilogue or `ret`). A naked function may only contain basic asm: compiled C could need a
+ * stack frame or registers the missing prologue never saved.
+ */
+static_assert(MemoryMonitor::canary == 0xC5, "paintStackAtBoot() paints 0xC5; update its asm.");
+extern "C" void paintStackAtBoot(void) __attribute__((naked, used, section(".init3")));
+void paintStackAtBoot(void) {
+    asm volatile(
+        "ldi r30, lo8(__heap_start)\n\t"  // Z: first free byte.
+        "ldi r31, hi8(__heap_start)\n\t"
+        "in r26, __SP_L__\n\t"            // X: stack pointer.
+        "in r27, __SP_H__\n\t"
+        "ldi r24, 0xC5\n\t"               // MemoryMonitor::canary.
+        "1:\n\t"
+        "cp r30, r26\n\t"
+        "cpc r31, r27\n\t"
+        "brsh 2f\n\t"
+        "st Z+, r24\n\t"
+        "rjmp 1b\n\t"
+        "2:\n\t");
+}
+#endif
+
+/**
+ * Returns the current free RAM between the heap and the stack pointer, in bytes.
+ */
+uint16_t MemoryMonitor::freeMemory() {
+#if defined(__AVR__)
+    return (uint16_t)SP - (uint16_t)heapEnd();
+#else
+    return 0;
+#endif
+}
+
+/**
+ * Returns the free RAM that has never been touched since boot, in bytes.
+ */
+uint16_t MemoryMonitor::minFreeMemory() {
+#if defined(__AVR__)
+    return RAMEND + 1 - (uint16_t)heapEnd() - stackPeak();
+#else
+    return 0;
+#endif
+}
+
+/**
+ * Returns the deepest stack use since boot, in bytes.
+ */
+uint16_t MemoryMonitor::stackPeak() {
+    uint16_t current = scanStackPeak();
+    if (current > peakStack) {
+        peakStack = current;
+    }
+    return peakStack;
+}
+
+/**
+ * Measures the stack depth recorded in the paint since it was last applied.
+ *
+ * Returns:
+ * - Bytes between the top of RAM and the lowest address whose canary was overwritten.
+ */
+uint16_t MemoryMonitor::scanStackPeak() {
+#if defined(__AVR__)
+    uint8_t* p = heapEnd();
+    uint8_t* top = (uint8_t*)SP;
+    while (p < top && *p == canary) {
+        p++;
+    }
+    return RAMEND + 1 - (uint16_t)p;
+#else
+    return 0;
+#endif
+}
+
+/**
+ * Prepares the measurement of one command's stack depth.
+ *
+ * Behavior:
+ * - Folds the depth recorded so far into the boot high-water mark.
+ * - Repaints the free RAM below the current stack pointer.
+ */
+void MemoryMonitor::beginCommand() {
+    stackPeak();
+#if defined(__AVR__)
+    paintFreeMemory();
+#endif
+}
+
+/**
+ * Records the stack depth reached by the command that just ran.
+ *
+ * Parameters:
+ * - `command` (const char*): The received command; only the token before the first comma is used.
+ *
+ * Behavior:
+ * - Keeps the peak per command name. Once `maxCommands` names are tracked, new names only
+ *   contribute to the overall high-water mark.
+ */
+void MemoryMonitor::endCommand(const char* command) {
+    uint16_t depth = scanStackPeak();
+    if (depth > peakStack) {
+        peakStack = depth;
+    }
+    if (commands == nullptr) {
+        return;
+    }
+
+    char name[sizeof(commands[0].name)];
+    uint8_t len = 0;
+    while (command[len] != '\0' && command[len] != ',' && len < sizeof(name) - 1) {
+        name[len] = command[len];
+        len++;
+    }
+    name[len] = '\0';
+
+    for (uint8_t i = 0; i < commandCount; i++) {
+        if (strcmp(commands[i].name, name) == 0) {
+            if (depth > commands[i].peak) commands[i].peak = depth;
+            return;
+        }
+    }
+    if (commandCount < maxCommands) {
+        strcpy(commands[commandCount].name, name);
+        commands[commandCount].peak = depth;
+        commandCount++;
+    }
+}
+
+/**
+ * Sends memory statistics to the PC in a single frame.
+ *
+ * Format: `<Stats free:F minFree:M stack:S arena:U/A name:peak;...>`
+ * - `free`: Current free RAM between heap and stack.
+ * - `minFree`: Free RAM never touched since boot (the stack/heap collision margin).
+ * - `stack`: Stack high-water mark since boot.
+ * - `arena`: Bytes used and size of the static memory arena.
+ * - `name:peak`: Peak stack depth per command.
+ */
+void MemoryMonitor::sendStats() {
+    Serial.print(F("<Stats free:"));
+    Serial.print(freeMemory());
+    Serial.print(F(" minFree:"));
+    Serial.print(minFreeMemory());
+    Serial.print(F(" stack:"));
+    Serial.print(stackPeak());
+    Serial.print(F(" arena:"));
+    Serial.print(MemoryArena::bytesUsed());
+    Serial.print(F("/"));
+    Serial.print(MemoryArena::arenaBytes);
+    Serial.print(F(" "));
+    for (uint8_t i = 0; i < commandCount; i++) {
+        Serial.print(commands[i].name);
+        Serial.print(F(":"));
+        Serial.print(commands[i].peak);
+        Serial.print(F(";"));
+    }
+    Serial.println(F(">"));
+}
@@ -1,4 +1,8 @@
 #include "MixerControls.h"
+#include "TimingModel.h"
+
+static const uint8_t relayOnCommand = 0x01;   // Qwiic single relay command bytes.
+static const uint8_t relayOffCommand = 0x00;
 
 /**
  * Constructor for the MixerControls class.
@@ -9,7 +13,13 @@
  */
 MixerControls::MixerControls(Utils& utils) 
     : utils(utils), relay_mixer(RELAY_ADDR2), relay_drain(RELAY_ADDR1) {
-    // Constructor body (no additional initialization required here)
+    const uint8_t addresses[2] = {RELAY_ADDR2, RELAY_ADDR1};
+    for (uint8_t i = 0; i < 2; i++) {
+        relayCommands[i].address = addresses[i];
+        relayCommands[i].writeData = &relayCommandBytes[i];
+        relayCommands[i].writeLength = 1;
+        relayCommands[i].done = onRelaySwitched;
+    }
 }
 
 /**
@@ -24,9 +34,9 @@ MixerControls::MixerControls(Utils& utils)
  */
 void MixerControls::setupRelay(Qwiic_Relay &relay) {
     if (!relay.begin()) {
-        Serial.println("Can't communicate with relay at the current address. Trying suggested address...");
+        Serial.println(F("Can't communicate with relay at the current address. Trying suggested address..."));
     } else {
-        Serial.println("Relay connected at the current address!");
+        Serial.println(F("Relay connected at the current address!"));
     }
 }
 
@@ -53,13 +63,53 @@ bool MixerControls::checkRelayState(Qwiic_Relay &relay) {
  * 
  * Behavior:
  * - Turns the relay on.
- * - Waits for the specified duration.
+ * - Waits for the specified duration, serving immediate commands meanwhile; an abort ends the wait early.
  * - Turns the relay off.
+ * - Feeds the measured duration of a run that was not aborted to the timing model.
+ * - Both switches are queued on the TWI engine, so neither waits for the bus.
  */
 void MixerControls::run(Qwiic_Relay &relay, float runTime) {
-    relay.turnRelayOn();                 // Activate the relay.
-    delay(runTime * 1000);               // Wait for the specified time in milliseconds.
-    relay.turnRelayOff();                // Deactivate the relay.
+    unsigned long startTime = millis();
+    switchRelay(relay, true);                      // Activate the relay.
+    bool completed = utils.wait(runTime * 1000);   // Wait for the specified time in milliseconds.
+    switchRelay(relay, false);                     // Deactivate the relay.
+    if (completed) {
+        TimingModel::observeRelay(runTime, millis() - startTime);
+    }
+}
+
+/**
+ * Queues a relay command without waiting for the transfer.
+ *
+ * Parameters:
+ * - `relay` (Qwiic_Relay&): The mixer or drain relay.
+ * - `on` (bool): State to switch to.
+ *
+ * Behavior:
+ * - Waits only if the previous command to the same relay is still on the bus.
+ * - Falls back to the relay library's blocking call if the transaction queue is full.
+ */
+void MixerControls::switchRelay(Qwiic_Relay &relay, bool on) {
+    uint8_t index = &relay == &relay_mixer ? 0 : 1;
+    TwiTransaction& command = relayCommands[index];
+    if (command.isBusy()) {
+        TwiEngine::wait(command);
+    }
+    relayCommandBytes[index] = on ? relayOnCommand : relayOffCommand;
+    if (!TwiEngine::submit(command)) {
+        if (on) relay.turnRelayOn(); else relay.turnRelayOff();
+    }
+}
+
+/**
+ * Completion callback of the relay commands: reports a relay that did not take its command.
+ */
+void MixerControls::onRelaySwitched(TwiTransaction& transaction) {
+    if (transaction.status != TWI_OK) {
+        Serial.print(F("Relay at 0x"));
+        Serial.print(transaction.address, HEX);
+        Serial.println(F(" did not respond."));
+    }
 }
 
 /**
@@ -86,11 +136,16 @@ void MixerControls::setupPump(uint8_t pin) {
  * 
  * Behavior:
  * - Sets the pin HIGH to activate the pump.
- * - Waits for the specified duration.
+ * - Waits for the specified duration, serving immediate commands meanwhile; an abort ends the wait early.
  * - Sets the pin LOW to deactivate the pump.
+ * - Feeds the measured duration of a run that was not aborted to the timing model.
  */
 void MixerControls::runPump(uint8_t pin, float runTime) {
-    digitalWrite(pin, HIGH);    // Turn the pump on.
-    delay(runTime * 1000);      // Wait for the specified duration in milliseconds.
-    digitalWrite(pin, LOW);     // Turn the pump off.
+    unsigned long startTime = millis();
+    digitalWrite(pin, HIGH);                       // Turn the pump on.
+    bool completed = utils.wait(runTime * 1000);   // Wait for the specified duration in milliseconds.
+    digitalWrite(pin, LOW);                        // Turn the pump off.
+    if (completed) {
+        TimingModel::observeRelay(runTime, millis() - startTime);
+    }
 }
@@ -0,0 +1,150 @@
+#include "Profiler.h"
+
+#if defined(ENABLE_PROFILER) && defined(__AVR__)
+#include <avr/interrupt.h>
+
+static_assert(Profiler::buckets > 0, "The profiler needs histogram buckets in the memory arena.");
+
+static const char profileRegion[] PROGMEM = "profile";  // Arena region name.
+
+// Histogram state, shared with the timer ISR.
+static uint16_t* histogram = MemoryArena::allocate<uint16_t>(Profiler::buckets, profileRegion);
+static volatile uint16_t windowBase = 0;   // First flash byte address covered by the histogram.
+static volatile uint8_t windowShift = Profiler::defaultShift;  // log2 of the bytes per bucket.
+static volatile uint32_t totalSamples = 0; // All samples taken since `start()` (49 days at 1 kHz).
+static volatile uint32_t otherSamples = 0; // Samples outside the histogram window.
+
+// Word address of the interrupted instruction, captured by the naked vector below.
+extern "C" volatile uint16_t profSampledPc;
+volatile uint16_t profSampledPc = 0;
+
+/**
+ * Timer2 compare vector.
+ *
+ * Naked, so the return address sits at a known stack offset: after the four pushes below,
+ * SP+5 holds the high byte and SP+6 the low byte of the interrupted program counter. The
+ * address is stored and execution continues in `__vector_profile_tick`, a regular signal
+ * handler that does the bookkeeping and returns with `reti`.
+ */
+ISR(TIMER2_COMPA_vect, ISR_NAKED) {
+    __asm__ __volatile__(
+        "push r30                    \n\t"
+        "push r31                    \n\t"
+        "push r24                    \n\t"
+        "push r25                    \n\t"
+        "in   r30, __SP_L__          \n\t"
+        "in   r31, __SP_H__          \n\t"
+        "ldd  r25, Z+5               \n\t"
+        "ldd  r24, Z+6               \n\t"
+        "sts  profSampledPc + 1, r25 \n\t"
+        "sts  profSampledPc, r24     \n\t"
+        "pop  r25                    \n\t"
+        "pop  r24                    \n\t"
+        "pop  r31                    \n\t"
+        "pop  r30                    \n\t"
+        "jmp  __vector_profile_tick  \n\t"
+    );
+}
+
+/**
+ * Adds the captured address to the histogram. Entered by a jump from the Timer2 vector.
+ */
+extern "C" void __vector_profile_tick(void) __attribute__((signal, used, externally_visible));
+void __vector_profile_tick(void) {
+    uint16_t address = profSampledPc << 1;  // Word address to byte address.
+    totalSamples++;
+    if (address < windowBase) {
+        otherSamples++;
+        return;
+    }
+    uint16_t index = (address - windowBase) >> windowShift;
+    if (index >= Profiler::buckets) {
+        otherSamples++;
+    } else if (histogram[index] != 0xFFFF) {
+        histogram[index]++;
+    }
+}
+
+/**
+ * Clears the histogram and starts sampling.
+ *
+ * Parameters:
+ * - `shift` (uint8_t): log2 of the flash bytes per bucket.
+ * - `base` (uint16_t): First flash byte address covered by the histogram.
+ *
+ * Behavior:
+ * - Runs Timer2 in CTC mode with a /128 prescaler, interrupting at `sampleRateHz`.
+ */
+void Profiler::start(uint8_t shift, uint16_t base) {
+    stop();
+    for (uint8_t i = 0; i < buckets; i++) {
+        histogram[i] = 0;
+    }
+    windowBase = base;
+    windowShift = shift;
+    totalSamples = 0;
+    otherSamples = 0;
+
+    TCCR2A = _BV(WGM21);                                  // CTC mode.
+    TCCR2B = _BV(CS22) | _BV(CS20);                       // clk/128.
+    OCR2A = F_CPU / 128 / sampleRateHz - 1;               // 124 at 16 MHz -> 1 kHz.
+    TCNT2 = 0;
+    TIMSK2 = _BV(OCIE2A);
+}
+
+/**
+ * Stops sampling; the histogram is kept for `dump()`.
+ */
+void Profiler::stop() {
+    TIMSK2 = 0;
+    TCCR2B = 0;
+}
+
+/**
+ * Sends the histogram to the PC in a single frame. Only non-empty buckets are listed.
+ *
+ * Format: `<Prof base:B shift:S total:T other:O index:count;...>`
+ */
+void Profiler::dump() {
+    uint8_t savedMask = TIMSK2;
+    TIMSK2 = 0;  // Freeze the histogram while it is printed.
+
+    noInterrupts();  // The 32-bit counters are read byte by byte.
+    uint32_t total = totalSamples;
+    uint32_t other = otherSamples;
+    interrupts();
+
+    Serial.print(F("<Prof base:"));
+    Serial.print(windowBase);
+    Serial.print(F(" shift:"));
+    Serial.print(windowShift);
+    Serial.print(F(" total:"));
+    Serial.print(total);
+    Serial.print(F(" other:"));
+    Serial.print(other);
+    Serial.print(F(" "));
+    for (uint8_t i = 0; i < buckets; i++) {
+        if (histogram[i] == 0) continue;
+        Serial.print(i);
+        Serial.print(F(":"));
+        Serial.print(histogram[i]);
+        Serial.print(F(";"));
+    }
+    Serial.println(F(">"));
+
+    TIMSK2 = savedMask;
+}
+
+#else
+
+// Profiler not built in: commands are answered but do nothing.
+void Profiler::start(uint8_t shift, uint16_t base) {
+    (void)shift;
+    (void)base;
+}
+void Profiler::stop() {}
+void Profiler::dump() {
+    Serial.println(F("<Prof disabled>"));
+}
+
+#endif
@@ -1,11 +1,22 @@
 #include "ScaleControls.h"
+#include "Trace.h"
+#include "TimingModel.h"
 
 // Definitions for static constants and variables.
 const uint8_t ScaleControls::numMeas = 10;  // Default number of measurements.
 const float ScaleControls::MANUAL_SLOPE = 3.06828559218341e-05;  // Default manual slope for calibration.
 const float ScaleControls::MANUAL_INTERCEPT = -12.9400964147;    // Default manual intercept for calibration.
 const float ScaleControls::lpfAlpha = 0.5;                      // Low-pass filter alpha value.
-float ScaleControls::smaFilterValues[numReadings] = {0};         // Buffer for SMA filter values.
+const uint8_t ScaleControls::settleSamples = 4;                  // Conversions discarded before the scale reports ready.
+const unsigned long ScaleControls::powerUpSettleMs = 500;        // Analog settle time after a full power-up.
+const unsigned long ScaleControls::defaultIdlePowerDownMs = 600000;  // Standby time before a full power-down (10 min).
+const unsigned long ScaleControls::tareSettleTimeoutMs = 1000;         // Longest a tare waits for the scale to settle.
+const unsigned long ScaleControls::defaultAfeCalIntervalMs = 1800000;  // Time between background AFE recalibrations (30 min).
+const unsigned long ScaleControls::afeCalTimeoutMs = 1000;             // Longest an AFE recalibration may take.
+const float ScaleControls::placementNoiseGrams = 0.05;                // Spread of a still window (vessel detection).
+const float ScaleControls::defaultPlacementStepGrams = 1.0;           // Lightest vessel detected by default.
+const unsigned long ScaleControls::defaultPlacementStableMs = 500;    // Default still time of a placed vessel.
+static const uint8_t scaleAddress = 0x2A;                              // NAU7802 I2C address.
 
 const int ScaleControls::LOC_CALIBRATION_FACTOR = 0;  // EEPROM location for calibration factor.
 const int ScaleControls::LOC_ZERO_OFFSET = 10;        // EEPROM location for zero offset.
@@ -13,8 +24,26 @@ const int ScaleControls::LOC_CH1_OFFSET = 20;         // EEPROM location for cha
 
 // Constructor for ScaleControls class.
 // - Initializes utility class and sets up default values for filters and flags.
+// - Takes the SMA window and the two sample blocks from the memory arena.
 ScaleControls::ScaleControls(Utils& utils)
-    : utils(utils), ewmaFilter(0.05), lpfFilterValue(0.5), settingsDetected(false), scaleRunning(false) {}
+    : utils(utils), ewmaFilter(0.05), smaFilter(MemoryArena::allocate<float>(numReadings, PSTR("sma")), numReadings),
+      lpfFilter(lpfAlpha, 0.5), sampleBlocks(MemoryArena::allocate<int32_t>(2 * sampleBlockSize, PSTR("samples"))),
+      fillBlock(0), fillCount(0), restartBlocks(false), readingTimedOut(false), settingsDetected(false), scaleRunning(false),
+      scaleState(SCALE_OFF), notifyReady(false), settleCount(0), stateSince(0), settleMs(0), idlePowerDownMs(defaultIdlePowerDownMs),
+      afeCalibrating(false), afeCalSince(0), lastAfeCal(0), afeCalIntervalMs(defaultAfeCalIntervalMs),
+      sampleRate(0), conversionRegister(NAU7802_PU_CTRL), pendingRaw(0), hasPending(false),
+      placementState(PLACEMENT_OFF), placementPaused(false), placementStepGrams(0), placementStableMs(0), placementHasBaseline(false),
+      placementBaseline(0), placementLastMean(0), placementMin(0), placementMax(0), placementSum(0), placementCount(0),
+      placementSince(0), placementVesselGrams(0),
+      streamEvery(0), streamCount(0), streamRaw(false) {
+    conversionRead.address = scaleAddress;
+    conversionRead.writeData = &conversionRegister;
+    conversionRead.writeLength = 1;
+    conversionRead.readData = conversionBytes;
+    conversionRead.readLength = 1;
+    conversionRead.done = onConversionRead;
+    conversionRead.context = this;
+}
 
 /**
  * Sets up the scale by configuring its sample rate, gain, and LDO voltage.
@@ -27,7 +56,7 @@ ScaleControls::ScaleControls(Utils& utils)
  */
 void ScaleControls::setupScale(int sampleRate, int gain, int ldoVoltage) {
     if (!Scale.begin()) {
-        Serial.println("Scale not detected. Please check wiring.");
+        Serial.println(F("Scale not detected. Please check wiring."));
         while (1);  // Halts execution if the scale is not detected.
     }
 
@@ -38,8 +67,9 @@ void ScaleControls::setupScale(int sampleRate, int gain, int ldoVoltage) {
         case 40:  Scale.setSampleRate(NAU7802_SPS_40); break;
         case 80:  Scale.setSampleRate(NAU7802_SPS_80); break;
         case 320: Scale.setSampleRate(NAU7802_SPS_320); break;
-        default:  Serial.println("Error: Invalid sample rate."); return;
+        default:  Serial.println(F("Error: Invalid sample rate.")); return;
     }
+    this->sampleRate = sampleRate;
 
     // Configure gain.
     switch (gain) {
@@ -51,7 +81,7 @@ void ScaleControls::setupScale(int sampleRate, int gain, int ldoVoltage) {
         case 32:  Scale.setGain(NAU7802_GAIN_32); break;
         case 64:  Scale.setGain(NAU7802_GAIN_64); break;
         case 128: Scale.setGain(NAU7802_GAIN_128); break;
-        default:  Serial.println("Error: Invalid gain."); return;
+        default:  Serial.println(F("Error: Invalid gain.")); return;
     }
 
     // Configure LDO voltage.
@@ -63,29 +93,220 @@ void ScaleControls::setupScale(int sampleRate, int gain, int ldoVoltage) {
         case 6: Scale.setLDO(NAU7802_LDO_3V9); break;
         case 7: Scale.setLDO(NAU7802_LDO_4V2); break;
         case 8: Scale.setLDO(NAU7802_LDO_4V5); break;
-        default: Serial.println("Error: Invalid LDO voltage."); return;
+        default: Serial.println(F("Error: Invalid LDO voltage.")); return;
     }
 
-    // Perform AFE (Analog Front End) calibration.
+    // Perform AFE (Analog Front End) calibration. Later ones run in the background from `update()`.
     Scale.calibrateAFE();
+    lastAfeCal = millis();
 
-    // Mark the scale as running and power it down.
+    // Mark the scale as running and park it in warm standby.
     scaleRunning = true;
-    Scale.powerDown();
+    scaleState = SCALE_READY;
+    scaleOff();
 }
 
 /**
- * Powers up the scale to make it operational.
+ * Starts conversions so the scale becomes operational.
+ *
+ * Behavior:
+ * - From standby, only the conversion cycle is restarted; the front end is already biased.
+ * - From a full power-down, the analog and digital sections are powered up first.
+ * - The scale enters the settling state and `update()` reports `<ScaleReady>` once the first
+ *   stable sample is available (immediately if the scale is already settled).
  */
 void ScaleControls::scaleOn() {
-    Scale.powerUp();
+    waitForAfeCal();
+    notifyReady = true;
+    if (scaleState == SCALE_READY || scaleState == SCALE_SETTLING) {
+        return;  // Already converting; the ready report follows from `update()`.
+    }
+
+    settleMs = 0;
+    if (scaleState == SCALE_OFF) {
+        Scale.powerUp();  // Power up the analog and digital sections.
+        settleMs = powerUpSettleMs;
+    }
+    Scale.setBit(NAU7802_PU_CTRL_CS, NAU7802_PU_CTRL);  // Start the conversion cycle.
+
+    settleCount = 0;
+    stateSince = millis();
+    scaleState = SCALE_SETTLING;
 }
 
 /**
- * Powers down the scale to save energy when not in use.
+ * Puts the scale into warm standby.
+ *
+ * Behavior:
+ * - Stops conversions but keeps the analog front end biased, so the next `scaleOn()` settles
+ *   within a few conversions instead of seconds.
+ * - A full power-down follows from `update()` once the scale has idled for `idlePowerDownMs`.
  */
 void ScaleControls::scaleOff() {
+    waitForAfeCal();
+    if (scaleState == SCALE_OFF) {
+        return;
+    }
+    Scale.clearBit(NAU7802_PU_CTRL_CS, NAU7802_PU_CTRL);  // Stop the conversion cycle.
+    notifyReady = false;
+    stateSince = millis();
+    scaleState = SCALE_STANDBY;
+}
+
+/**
+ * Fully powers down the scale to save energy when not in use.
+ */
+void ScaleControls::powerDownScale() {
+    waitForAfeCal();
     Scale.powerDown();
+    notifyReady = false;
+    scaleState = SCALE_OFF;
+}
+
+/**
+ * Sets how long the scale may idle in standby before it is fully powered down.
+ *
+ * Parameters:
+ * - `idleMs` (unsigned long): Idle time in milliseconds; 0 keeps the scale in standby indefinitely.
+ */
+void ScaleControls::setIdlePowerDown(unsigned long idleMs) {
+    idlePowerDownMs = idleMs;
+}
+
+/**
+ * Sets how often the analog front end is recalibrated in the background.
+ *
+ * Parameters:
+ * - `intervalMs` (unsigned long): Time between recalibrations in milliseconds; 0 disables them.
+ */
+void ScaleControls::setAfeCalInterval(unsigned long intervalMs) {
+    afeCalIntervalMs = intervalMs;
+}
+
+/**
+ * Starts an AFE recalibration without waiting for it to finish.
+ */
+void ScaleControls::startAfeCal(unsigned long now) {
+    Scale.beginCalibrateAFE();
+    afeCalibrating = true;
+    afeCalSince = now;
+}
+
+/**
+ * Ends the running AFE recalibration.
+ *
+ * Behavior:
+ * - Records the outcome as a trace event; a failed or timed-out calibration is retried after
+ *   the next interval.
+ * - If the scale was converting, it settles again so no conversion taken across the
+ *   calibration reaches a reading. The settle is silent unless `scaleOn()` asks for a report.
+ */
+void ScaleControls::finishAfeCal(unsigned long now) {
+    bool success = Scale.calAFEStatus() == NAU7802_CAL_SUCCESS;
+    afeCalibrating = false;
+    lastAfeCal = now;
+    Trace::record(TRACE_AFE_CAL, success ? (int32_t)(now - afeCalSince) : -1);
+
+    if (scaleState == SCALE_READY) {
+        restartBlocks = true;
+        settleCount = 0;
+        settleMs = 0;
+        stateSince = now;
+        scaleState = SCALE_SETTLING;
+    }
+}
+
+/**
+ * Blocks until a running AFE recalibration finishes (at most `afeCalTimeoutMs`).
+ * Used before operations that need the front end, so a reading never overlaps a calibration.
+ */
+void ScaleControls::waitForAfeCal() {
+    if (!afeCalibrating) {
+        return;
+    }
+    while (Scale.calAFEStatus() == NAU7802_CAL_IN_PROGRESS && millis() - afeCalSince < afeCalTimeoutMs) {
+    }
+    finishAfeCal(millis());
+}
+
+/**
+ * Predicts the time until the scale reports ready if `scaleOn()` is called now, in milliseconds.
+ */
+unsigned long ScaleControls::predictReadyMs() {
+    switch (scaleState) {
+        case SCALE_READY:    return 0;
+        case SCALE_OFF:      return powerUpSettleMs + TimingModel::predictSettle();
+        case SCALE_SETTLING:
+        case SCALE_STANDBY:
+        default:             return TimingModel::predictSettle();
+    }
+}
+
+/**
+ * Advances the scale power state machine. Called from the background task, i.e. on every pass
+ * of `loop()` and while commands wait.
+ *
+ * Parameters:
+ * - `now` (unsigned long): Current time in milliseconds.
+ * - `systemIdle` (bool): `false` while a command (e.g. a dose) is running.
+ *
+ * Behavior:
+ * - Every `afeCalIntervalMs`, when the system is idle and the scale is ready or in standby with
+ *   no ready report pending, starts a background AFE recalibration and polls it on later calls.
+ *   Conversions are ignored until it finishes.
+ * - While settling, discards the first `settleSamples` conversions (and waits `powerUpSettleMs`
+ *   after a full power-up), then marks the scale ready and sends `<ScaleReady>` if requested.
+ *   Wake-ups from standby feed their settle time to the timing model.
+ * - While in standby, powers the scale down after `idlePowerDownMs` without activity.
+ */
+void ScaleControls::update(unsigned long now, bool systemIdle) {
+    if (afeCalibrating) {
+        if (Scale.calAFEStatus() != NAU7802_CAL_IN_PROGRESS || now - afeCalSince >= afeCalTimeoutMs) {
+            finishAfeCal(now);
+        }
+        return;  // Conversions are not valid while the front end calibrates.
+    }
+
+    if (systemIdle && afeCalIntervalMs > 0 && now - lastAfeCal >= afeCalIntervalMs && !notifyReady
+        && (scaleState == SCALE_READY || scaleState == SCALE_STANDBY)) {
+        startAfeCal(now);
+        return;
+    }
+
+    int32_t unsettled;
+    switch (scaleState) {
+        case SCALE_SETTLING:
+            if (takeConversion(unsettled)) {  // Discard the unsettled conversion.
+                if (settleCount < settleSamples) settleCount++;
+            }
+            if (settleCount >= settleSamples && now - stateSince >= settleMs) {
+                scaleState = SCALE_READY;
+                Trace::record(TRACE_SCALE_READY, now - stateSince);
+                if (settleMs == 0) {
+                    TimingModel::observeSettle(now - stateSince);  // Learn standby wake-ups only.
+                }
+            }
+            break;
+
+        case SCALE_STANDBY:
+            if (idlePowerDownMs > 0 && now - stateSince >= idlePowerDownMs) {
+                powerDownScale();
+            }
+            break;
+
+        case SCALE_READY:
+            pollSample();  // Keep the sample queue topped up while converting.
+            break;
+
+        case SCALE_OFF:
+        default:
+            break;
+    }
+
+    if (notifyReady && scaleState == SCALE_READY) {
+        notifyReady = false;
+        Serial.println(F("<ScaleReady>"));
+    }
 }
 
 /**
@@ -113,36 +334,287 @@ void ScaleControls::calculateCalParams(float manual_slope, float manual_intercep
  * - The filtered reading (float).
  */
 float ScaleControls::applyFilter(float reading, FilterType filterType) {
-    float filteredReading = reading;
+    switch (filterType) {
+        case EWMA:  return ewmaFilter.filter(reading);  // Exponentially Weighted Moving Average filter.
+        case SMA:   return smaFilter.filter(reading);   // Simple Moving Average filter.
+        case LPF:   return lpfFilter.filter(reading);   // Low-Pass Filter.
+        case NONE:  // No filtering.
+        default:    return reading;
+    }
+}
 
+/**
+ * Applies a specified filter to a block of raw scale readings.
+ * Parameters:
+ * - `block` (const int32_t*): The raw scale readings, oldest first.
+ * - `n` (uint8_t): Number of readings in the block.
+ * - `filterType` (FilterType): The type of filter to apply (e.g., EWMA, SMA, LPF, or NONE).
+ *
+ * Returns:
+ * - The sum of the filtered readings (float).
+ *
+ * Behavior:
+ * - Dispatches on the filter type once per block and runs the filter in a tight loop, giving
+ *   the same result as calling `applyFilter()` on each reading in turn.
+ */
+float ScaleControls::processBlock(const int32_t* block, uint8_t n, FilterType filterType) {
     switch (filterType) {
-        case EWMA:  // Exponentially Weighted Moving Average filter.
-            filteredReading = ewmaFilter.filter(reading);
-            break;
+        case EWMA:  return ewmaFilter.process(block, n);
+        case SMA:   return smaFilter.process(block, n);
+        case LPF:   return lpfFilter.process(block, n);
+        case NONE:
+        default:    return NoFilter().process(block, n);
+    }
+}
 
-        case SMA:  // Simple Moving Average filter.
-            static int index = 0;
-            static float sum = 0;
-            static int count = 0;
-
-            sum -= smaFilterValues[index];  // Subtract the oldest value from the sum.
-            smaFilterValues[index] = reading;  // Add the new value to the buffer.
-            sum += reading;  // Add the new value to the sum.
-            index = (index + 1) % numReadings;  // Update the buffer index.
-            if (count < numReadings) count++;
-            filteredReading = sum / count;  // Compute the average.
-            break;
+/**
+ * Moves the latest conversion, if one is available, into the sample block being filled.
+ *
+ * Returns:
+ * - `true` if a sample was stored, `false` if no conversion was ready or both blocks are busy.
+ *
+ * Behavior:
+ * - This is the acquisition side of the double buffer; it can be driven from the main loop or a
+ *   data-ready interrupt. Conversions arrive through `takeConversion()` without blocking.
+ * - A full block is handed to the consumer and filling continues in the other block. While the
+ *   consumer still holds the other block, the conversion is left unread, so none is lost.
+ */
+bool ScaleControls::pollSample() {
+    if (restartBlocks) {
+        fillCount = 0;  // Discard the partial block on the consumer's request.
+        restartBlocks = false;
+    }
+    bool store = true;
+    if (fillCount == sampleBlockSize) {
+        if (fullBlocks.push(fillBlock)) {
+            fillBlock ^= 1;
+            fillCount = 0;
+        } else if (streamEvery == 0 && placementState == PLACEMENT_OFF) {
+            return false;  // The consumer has not released the previous block yet.
+        } else {
+            store = false;  // Nobody is averaging; keep streaming and detecting without storing.
+        }
+    }
+    int32_t raw;
+    if (!takeConversion(raw)) {
+        return false;
+    }
+    if (store) {
+        sampleBlocks[fillBlock * sampleBlockSize + fillCount++] = raw;
+    }
+    if (streamEvery > 0 && ++streamCount >= streamEvery) {
+        streamCount = 0;
+        streamSample(raw);
+    }
+    if (!placementPaused && (placementState == PLACEMENT_EMPTY || placementState == PLACEMENT_SETTLING)) {
+        trackPlacement(raw);
+    }
+    return store;
+}
 
-        case LPF:  // Low-Pass Filter.
-            filteredReading = lpfAlpha * reading + (1.0 - lpfAlpha) * lpfFilterValue;
-            lpfFilterValue = filteredReading;
-            break;
+/**
+ * Arms vessel placement detection and turns the scale on to watch for it.
+ *
+ * Parameters:
+ * - `stepGrams` (float): Weight rise that counts as a vessel being placed.
+ * - `stableMs` (unsigned long): How long the raised weight must hold still before it counts.
+ *
+ * Behavior:
+ * - The first still window becomes the empty-scale baseline. The baseline then follows still
+ *   windows below the step (drift, a filled vessel being lifted off), so each placement is
+ *   measured from the scale as it was just before.
+ * - A rise of more than `stepGrams` that holds within `placementNoiseGrams` for `stableMs` is a
+ *   placement, reported once by `takePlacement()`. A rise that falls back (a bump) is dropped.
+ * - Detection runs on the conversions read while the scale is ready, so it stops while the scale
+ *   is off or calibrating and continues when it converts again.
+ */
+void ScaleControls::armPlacement(float stepGrams, unsigned long stableMs) {
+    placementStepGrams = stepGrams;
+    placementStableMs = stableMs;
+    placementState = PLACEMENT_EMPTY;
+    placementPaused = true;
+    resumePlacement();
+    scaleOn();
+}
 
-        case NONE:  // No filtering.
-        default:
-            break;
+/**
+ * Suspends detection while a command moves the weight on the scale. A detected vessel that has
+ * not been taken yet is kept.
+ */
+void ScaleControls::pausePlacement() {
+    placementPaused = true;
+}
+
+/**
+ * Resumes paused detection with a new baseline taken from the next still window.
+ */
+void ScaleControls::resumePlacement() {
+    if (!placementPaused) {
+        return;
+    }
+    placementPaused = false;
+    if (placementState == PLACEMENT_EMPTY || placementState == PLACEMENT_SETTLING) {
+        placementHasBaseline = false;
+        placementCount = 0;
+        placementState = PLACEMENT_EMPTY;
+    }
+}
+
+/**
+ * Takes a detected vessel.
+ *
+ * Parameters:
+ * - `vesselGrams` (float&): Receives the weight rise of the vessel.
+ *
+ * Returns:
+ * - `true` once per placement. Detection is then paused until `resumePlacement()`.
+ */
+bool ScaleControls::takePlacement(float& vesselGrams) {
+    if (placementState != PLACEMENT_PLACED) {
+        return false;
+    }
+    vesselGrams = placementVesselGrams;
+    placementState = PLACEMENT_EMPTY;
+    placementPaused = true;
+    return true;
+}
+
+/**
+ * Feeds one conversion to the placement detector; the detector acts on each full window of
+ * `placementWindow` conversions.
+ */
+void ScaleControls::trackPlacement(int32_t raw) {
+    if (placementCount == 0) {
+        placementMin = raw;
+        placementMax = raw;
+        placementSum = 0;
+    }
+    placementMin = raw < placementMin ? raw : placementMin;
+    placementMax = raw > placementMax ? raw : placementMax;
+    placementSum += raw;
+    if (++placementCount < placementWindow) {
+        return;
+    }
+    placementCount = 0;
+
+    float countsPerGram = Scale.getCalibrationFactor();
+    int32_t mean = placementSum / placementWindow;
+    float rise = (mean - placementBaseline) / countsPerGram;
+    bool still = (placementMax - placementMin) / fabs(countsPerGram) <= placementNoiseGrams
+                 && fabs((mean - placementLastMean) / countsPerGram) <= placementNoiseGrams;
+    unsigned long now = millis();
+    placementLastMean = mean;
+
+    if (placementState == PLACEMENT_EMPTY) {
+        if (!placementHasBaseline) {
+            if (still) {
+                placementBaseline = mean;
+                placementHasBaseline = true;
+            }
+        } else if (rise > placementStepGrams) {
+            placementSince = now;
+            placementState = PLACEMENT_SETTLING;
+        } else if (still || rise < -placementStepGrams) {
+            placementBaseline = mean;  // Drift, or the previous vessel lifted off.
+        }
+    } else if (rise <= placementStepGrams) {
+        placementState = PLACEMENT_EMPTY;  // Fell back: a bump, not a vessel.
+    } else if (!still) {
+        placementSince = now;
+    } else if (now - placementSince >= placementStableMs) {
+        placementVesselGrams = rise;
+        placementState = PLACEMENT_PLACED;
+        Trace::record(TRACE_VESSEL, (int32_t)(rise * 1000));
+    }
+}
+
+/**
+ * Takes the conversion fetched in the background, or starts fetching the next one.
+ *
+ * Parameters:
+ * - `raw` (int32_t&): Receives the ADC counts.
+ *
+ * Returns:
+ * - `true` if a conversion was taken.
+ *
+ * Behavior:
+ * - Reads run on the TWI engine while the CPU carries on: a PU_CTRL read checks the cycle-ready
+ *   bit and, once it is set, the completion callback reads the three ADCO bytes. Each call
+ *   collects finished reads and starts the next status read, so no call waits for the bus.
+ */
+bool ScaleControls::takeConversion(int32_t& raw) {
+    TwiEngine::poll();
+    if (hasPending) {
+        hasPending = false;
+        raw = pendingRaw;
+        return true;
+    }
+    if (!conversionRead.isBusy()) {
+        TwiEngine::submit(conversionRead);
+    }
+    return false;
+}
+
+/**
+ * Completion callback of `conversionRead`: chains the ADCO read after a ready status and stores
+ * the sign-extended 24-bit conversion. A failed transfer starts over at the status read.
+ */
+void ScaleControls::onConversionRead(TwiTransaction& transaction) {
+    ScaleControls* scale = (ScaleControls*)transaction.context;
+    const uint8_t* bytes = scale->conversionBytes;
+
+    if (transaction.status == TWI_OK && scale->conversionRegister == NAU7802_PU_CTRL) {
+        if (bytes[0] & (1 << NAU7802_PU_CTRL_CR)) {
+            scale->conversionRegister = NAU7802_ADCO_B2;
+            transaction.readLength = 3;
+            TwiEngine::submit(transaction);
+        }
+        return;
+    }
+    if (transaction.status == TWI_OK) {
+        uint32_t value = ((uint32_t)bytes[0] << 16) | ((uint32_t)bytes[1] << 8) | bytes[2];
+        if (value & 0x800000UL) {
+            value |= 0xFF000000UL;  // Sign-extend the 24-bit two's complement value.
+        }
+        scale->pendingRaw = (int32_t)value;
+        scale->hasPending = true;
+    }
+    scale->conversionRegister = NAU7802_PU_CTRL;
+    transaction.readLength = 1;
+}
+
+/**
+ * Starts or stops weight telemetry.
+ *
+ * Parameters:
+ * - `every` (uint8_t): Send every Nth conversion (1 for every one); 0 stops the stream.
+ * - `raw` (bool): Send the ADC counts instead of the weight, e.g. to capture filter test traces.
+ *
+ * Behavior:
+ * - Conversions are streamed as they are read while the scale is on, including during commands,
+ *   as `<S t:MS g:G>` with the conversion time in milliseconds and the unfiltered weight, or as
+ *   `<S t:MS r:COUNTS>` when raw.
+ */
+void ScaleControls::setStream(uint8_t every, bool raw) {
+    streamEvery = every;
+    streamCount = 0;
+    streamRaw = raw;
+}
+
+/**
+ * Sends one telemetry sample (see `setStream()`).
+ */
+void ScaleControls::streamSample(int32_t raw) {
+    Serial.print(F("<S t:"));
+    Serial.print(millis());
+    if (streamRaw) {
+        Serial.print(F(" r:"));
+        Serial.print(raw);
+    } else {
+        Serial.print(F(" g:"));
+        Serial.print(convertToWeight(raw), Utils::getDecimal());
     }
-    return filteredReading;
+    Serial.println(F(">"));
 }
 
 /**
@@ -153,21 +625,145 @@ float ScaleControls::applyFilter(float reading, FilterType filterType) {
  * - `timeout_ms` (unsigned long): Maximum time allowed for the readings.
  * 
  * Returns:
- * - The averaged reading (float).
+ * - The averaged reading (float), or NAN if no conversion arrived before the timeout.
+ *
+ * Behavior:
+ * - Consumes fresh conversions block by block; samples acquired before the call are discarded.
+ * - Each full block is filtered in one pass while the next block is being acquired. The last,
+ *   partial block is filtered as soon as it holds the samples still needed, so a request smaller
+ *   than `sampleBlockSize` does not wait for a whole block.
+ * - On timeout, the samples collected so far (including a partial block) are averaged and
+ *   `lastReadingTimedOut()` reports the short reading until the next call.
+ * - Runs the background task while waiting for conversions, so immediate commands are answered
+ *   during a long average.
  */
 float ScaleControls::getReading(uint8_t avgReadingSamples, FilterType filterType, unsigned long timeout_ms) {
+    waitForAfeCal();
+
     float sum = 0;
+    uint8_t count = 0;
     unsigned long startTime = millis();
+    readingTimedOut = false;
 
-    for (uint8_t i = 0; i < avgReadingSamples; i++) {
-        if (millis() - startTime > timeout_ms) {
-            Serial.println("Timeout while averaging scale readings.");
+    // Only average conversions taken after the request.
+    fullBlocks.clear();
+    restartBlocks = true;
+
+    while (count < avgReadingSamples) {
+        uint8_t remaining = avgReadingSamples - count;
+        uint8_t block;
+        if (fullBlocks.peek(block)) {
+            uint8_t n = remaining < sampleBlockSize ? remaining : sampleBlockSize;
+            sum += processBlock(sampleBlocks + block * sampleBlockSize, n, filterType);  // Filter the whole block.
+            count += n;
+            fullBlocks.pop(block);  // Release the block to the acquisition side.
+            continue;
+        }
+
+        bool timedOut = millis() - startTime > timeout_ms;
+        if (!restartBlocks && (fillCount >= remaining || (timedOut && fillCount > 0))) {
+            // Filter the partial block in place; the acquisition side runs in this context too.
+            uint8_t n = fillCount < remaining ? fillCount : remaining;
+            sum += processBlock(sampleBlocks + fillBlock * sampleBlockSize, n, filterType);
+            count += n;
+            restartBlocks = true;  // Its samples are used; the next reading starts a fresh block.
+            continue;
+        }
+        if (timedOut) {
+            readingTimedOut = true;
             break;
         }
+        utils.runBackgroundTask();
+        pollSample();  // No block ready yet; fetch the next conversion.
+    }
+    readingTimedOut = count < avgReadingSamples;
+    return count > 0 ? sum / count : NAN;  // Return the average.
+}
+
+/**
+ * Converts a raw (or averaged) ADC reading into a weight with the current calibration.
+ * Parameters:
+ * - `reading` (float): The ADC reading in counts.
+ *
+ * Returns:
+ * - The weight in grams, relative to the zero offset set by `tareScale()`.
+ */
+float ScaleControls::convertToWeight(float reading) {
+    return (reading - Scale.getZeroOffset()) / Scale.getCalibrationFactor();
+}
+
+/**
+ * Measures the weight and sends it to the PC as `<Weight:G>`, or `<Weight:G,timeout>` if fewer
+ * readings than requested arrived in time (`nan` if none did).
+ * Parameters:
+ * - `avgReadingSamples` (uint8_t): Number of readings to average.
+ * - `filterType` (FilterType): The type of filter to apply to each reading.
+ * - `timeout_ms` (unsigned long): Maximum time allowed for the readings.
+ */
+void ScaleControls::sendWeight(uint8_t avgReadingSamples, FilterType filterType, unsigned long timeout_ms) {
+    float weight = convertToWeight(getReading(avgReadingSamples, filterType, timeout_ms));
+    Serial.print(F("<Weight:"));
+    Serial.print(weight, Utils::getDecimal());
+    Serial.println(readingTimedOut ? F(",timeout>") : F(">"));
+}
+
+/**
+ * Measures the averaged ADC reading and sends it to the PC as `<ADC:COUNTS>`, with the same
+ * `,timeout` marker as `sendWeight()`.
+ * Parameters:
+ * - `avgReadingSamples` (uint8_t): Number of readings to average.
+ * - `filterType` (FilterType): The type of filter to apply to each reading.
+ * - `timeout_ms` (unsigned long): Maximum time allowed for the readings.
+ */
+void ScaleControls::sendRaw(uint8_t avgReadingSamples, FilterType filterType, unsigned long timeout_ms) {
+    float raw = getReading(avgReadingSamples, filterType, timeout_ms);
+    Serial.print(F("<ADC:"));
+    Serial.print(raw, 1);
+    Serial.println(readingTimedOut ? F(",timeout>") : F(">"));
+}
+
+/**
+ * Maps a filter name sent by the PC to its filter type.
+ * Parameters:
+ * - `filterTypeStr` (const char*): `NONE`, `EWMA`, `SMA` or `LPF`.
+ *
+ * Returns:
+ * - The matching filter type; EWMA for an unknown name.
+ */
+FilterType ScaleControls::getFilterTypeFromString(const char* filterTypeStr) {
+    if (strcmp_P(filterTypeStr, PSTR("NONE")) == 0) return NONE;
+    if (strcmp_P(filterTypeStr, PSTR("SMA")) == 0)  return SMA;
+    if (strcmp_P(filterTypeStr, PSTR("LPF")) == 0)  return LPF;
+    return EWMA;
+}
+
+/**
+ * Zeroes the scale at the current load.
+ *
+ * Behavior:
+ * - A scale in standby or powered down is woken silently, given up to `tareSettleTimeoutMs`
+ *   (after the power-up settle time) to settle, and put back into standby afterwards.
+ * - The zero offset becomes the unfiltered average of `numMeas` fresh conversions; it is kept if
+ *   no conversion arrives.
+ */
+void ScaleControls::tareScale() {
+    bool wasConverting = scaleState == SCALE_SETTLING || scaleState == SCALE_READY;
+    bool reportReady = notifyReady;
+    scaleOn();
+    notifyReady = reportReady;  // Only report ready if the PC already asked for it.
+
+    unsigned long start = millis();
+    while (scaleState == SCALE_SETTLING && millis() - start < settleMs + tareSettleTimeoutMs) {
+        utils.runBackgroundTask();
+        update(millis(), false);
+    }
+
+    float reading = getReading(numMeas, NONE);
+    if (!isnan(reading)) {
+        Scale.setZeroOffset((int32_t)reading);
+    }
 
-        float reading = Scale.getReading();  // Raw reading from the scale.
-        float filteredReading = applyFilter(reading, filterType);  // Apply filter.
-        sum += filteredReading;
+    if (!wasConverting) {
+        scaleOff();
     }
-    return sum / avgReadingSamples;  // Return the average.
 }
@@ -0,0 +1,136 @@
+#include "TimingModel.h"
+
+// Model state, seeded with conservative defaults until observations arrive.
+float TimingModel::usPerStep = 500;        // Dispenser time per microstep in microseconds.
+float TimingModel::moveOverheadMs = 5;     // Fixed cost per move in milliseconds.
+float TimingModel::relayOverheadMs = 20;   // Relay/pump time beyond the requested duration.
+float TimingModel::settleMs = 50;          // Scale wake-to-ready time in milliseconds.
+
+char TimingModel::armedCommand[14] = {0};      // Command whose completion is reported.
+unsigned long TimingModel::armedPredictionMs = 0;  // Prediction for the armed command.
+
+/**
+ * Blends a new observation into an exponentially weighted average.
+ */
+static inline void blend(float& average, float observation) {
+    average += TimingModel::learnRate * (observation - average);
+}
+
+/**
+ * Learns the dispenser step period from a completed move.
+ *
+ * Parameters:
+ * - `steps` (long): Steps moved.
+ * - `elapsedUs` (unsigned long): Duration of the move in microseconds.
+ */
+void TimingModel::observeMove(long steps, unsigned long elapsedUs) {
+    if (steps >= minLearnSteps) {
+        blend(usPerStep, (elapsedUs - moveOverheadMs * 1000.0) / steps);
+    } else if (steps > 0) {
+        blend(moveOverheadMs, elapsedUs / 1000.0 - steps * usPerStep / 1000.0);
+    }
+}
+
+/**
+ * Learns the switching overhead of relays and pumps from a completed run.
+ *
+ * Parameters:
+ * - `requestedS` (float): Requested run time in seconds.
+ * - `elapsedMs` (unsigned long): Measured duration in milliseconds.
+ */
+void TimingModel::observeRelay(float requestedS, unsigned long elapsedMs) {
+    blend(relayOverheadMs, elapsedMs - requestedS * 1000.0);
+}
+
+/**
+ * Learns the scale settle time from a completed wake-up.
+ */
+void TimingModel::observeSettle(unsigned long elapsedMs) {
+    blend(settleMs, elapsedMs);
+}
+
+/**
+ * Predicts the duration of a dispenser move in milliseconds.
+ */
+unsigned long TimingModel::predictMove(long steps) {
+    if (steps <= 0) {
+        return 0;
+    }
+    return moveOverheadMs + steps * (usPerStep / 1000.0);
+}
+
+/**
+ * Number of dispenser steps that take about `ms` milliseconds at the learned step period, at
+ * least 1. Sizes the driver commands of a move (see `DispenserControls::dispense()`).
+ */
+uint16_t TimingModel::stepsWithin(unsigned long ms) {
+    float steps = ms * 1000.0 / usPerStep;
+    return steps < 1 ? 1 : steps > 65535 ? 65535 : (uint16_t)steps;
+}
+
+/**
+ * Predicts the duration of a relay or pump run in milliseconds.
+ */
+unsigned long TimingModel::predictRelay(float requestedS) {
+    return requestedS * 1000.0 + relayOverheadMs;
+}
+
+/**
+ * Predicts the time until the scale reports ready after waking, in milliseconds.
+ */
+unsigned long TimingModel::predictSettle() {
+    return settleMs;
+}
+
+/**
+ * Arms the actual-versus-predicted report for the next run of a command.
+ *
+ * Parameters:
+ * - `command` (const char*): Command token (e.g. "DispenseMass", "Mix").
+ * - `predictedMs` (unsigned long): The prediction sent to the PC.
+ */
+void TimingModel::arm(const char* command, unsigned long predictedMs) {
+    strncpy(armedCommand, command, sizeof(armedCommand) - 1);
+    armedCommand[sizeof(armedCommand) - 1] = '\0';
+    armedPredictionMs = predictedMs;
+}
+
+/**
+ * Sends a prediction to the PC and optionally arms the completion report for that command.
+ *
+ * Format: `<Predict kind:K ms:M>`
+ */
+void TimingModel::sendPrediction(const char* command, unsigned long predictedMs, bool armReport) {
+    if (armReport) {
+        arm(command, predictedMs);
+    }
+    Serial.print(F("<Predict kind:"));
+    Serial.print(command);
+    Serial.print(F(" ms:"));
+    Serial.print(predictedMs);
+    Serial.println(F(">"));
+}
+
+/**
+ * Reports the actual duration of a command if a prediction was armed for it.
+ *
+ * Parameters:
+ * - `command` (const char*): The completed command (token followed by its arguments).
+ * - `elapsedMs` (unsigned long): Time from receipt to completion in milliseconds.
+ *
+ * Format: `<Actual kind:K ms:A predicted:P>`
+ */
+void TimingModel::completeCommand(const char* command, unsigned long elapsedMs) {
+    size_t len = strlen(armedCommand);
+    if (len == 0 || strncmp(command, armedCommand, len) != 0 || (command[len] != ',' && command[len] != '\0')) {
+        return;
+    }
+    Serial.print(F("<Actual kind:"));
+    Serial.print(armedCommand);
+    Serial.print(F(" ms:"));
+    Serial.print(elapsedMs);
+    Serial.print(F(" predicted:"));
+    Serial.print(armedPredictionMs);
+    Serial.println(F(">"));
+    armedCommand[0] = '\0';
+}
@@ -0,0 +1,42 @@
+#include "Trace.h"
+
+static_assert(sizeof(TraceEvent) <= ARENA_TRACE_EVENT_BYTES, "TraceEvent exceeds its arena budget.");
+
+static const char traceRegion[] PROGMEM = "trace";  // Arena region name.
+
+// Queue of the most recent trace events, drained by `dump()`.
+RingBuffer<TraceEvent, Trace::traceSize>* Trace::events = MemoryArena::allocate<RingBuffer<TraceEvent, Trace::traceSize>>(1, traceRegion);
+
+/**
+ * Records a trace event with the current timestamp.
+ *
+ * Parameters:
+ * - `type` (uint8_t): The event type (see `TraceEventType`).
+ * - `value` (int32_t): Event specific payload.
+ *
+ * Behavior:
+ * - Events are dropped silently when the queue is full; tracing never blocks the caller.
+ */
+void Trace::record(uint8_t type, int32_t value) {
+    TraceEvent event = {(uint32_t)millis(), type, value};
+    events->push(event);
+}
+
+/**
+ * Sends all queued trace events to the PC in a single frame and empties the queue.
+ *
+ * Format: `<Trace time:type:value;time:type:value;...>`
+ */
+void Trace::dump() {
+    TraceEvent event;
+    Serial.print(F("<Trace "));
+    while (events->pop(event)) {
+        Serial.print(event.time);
+        Serial.print(F(":"));
+        Serial.print(event.type);
+        Serial.print(F(":"));
+        Serial.print(event.value);
+        Serial.print(F(";"));
+    }
+    Serial.println(F(">"));
+}
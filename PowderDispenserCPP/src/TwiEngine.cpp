@@ -0,0 +1,209 @@
+#include "TwiEngine.h"
+
+#if defined(__AVR__)
+#include <util/twi.h>
+#else
+#include <Wire.h>
+#endif
+
+static const char twiRegion[] PROGMEM = "twi";  // Arena region name.
+TwiEngine::Queues* TwiEngine::queues = MemoryArena::allocate<TwiEngine::Queues>(1, twiRegion);
+TwiTransaction* volatile TwiEngine::current = nullptr;  // Transaction on the bus.
+volatile bool TwiEngine::busy = false;                  // A transaction is on the bus.
+unsigned long TwiEngine::startedMs = 0;                 // Start of the current transaction.
+
+static uint8_t inFlight = 0;  // Submitted transactions whose callback has not run yet.
+
+#if defined(__AVR__)
+
+static volatile uint8_t writeIndex = 0;
+static volatile uint8_t readIndex = 0;
+
+static inline void hardwareStart() {
+    writeIndex = 0;
+    readIndex = 0;
+    TWCR = _BV(TWINT) | _BV(TWEN) | _BV(TWIE) | _BV(TWSTA);
+}
+
+static inline void hardwareReset() {
+    TWCR = 0;  // Release the bus lines and drop the transfer.
+    TWCR = _BV(TWEN);
+}
+
+/**
+ * TWI state machine. One interrupt per bus event (start sent, address or byte acknowledged,
+ * byte received); each step loads the next byte or condition and returns at once.
+ */
+ISR(TWI_vect) {
+    TwiTransaction* t = TwiEngine::current;
+    const uint8_t run = _BV(TWINT) | _BV(TWEN) | _BV(TWIE);
+
+    switch (TW_STATUS) {
+        case TW_START:
+        case TW_REP_START:
+            // Address for reading once the write part is sent; a transfer with no data is a write.
+            TWDR = (t->address << 1) | (writeIndex == t->writeLength && t->readLength > 0 ? TW_READ : TW_WRITE);
+            TWCR = run;
+            break;
+        case TW_MT_SLA_ACK:
+        case TW_MT_DATA_ACK:
+            if (writeIndex < t->writeLength) {
+                TWDR = t->writeData[writeIndex++];
+                TWCR = run;
+            } else if (t->readLength > 0) {
+                TWCR = run | _BV(TWSTA);  // Repeated start for the read.
+            } else {
+                TWCR = _BV(TWINT) | _BV(TWEN) | _BV(TWSTO);
+                TwiEngine::complete(TWI_OK);
+            }
+            break;
+        case TW_MR_DATA_ACK:
+            t->readData[readIndex++] = TWDR;
+            // Fall through: acknowledge every byte but the last.
+        case TW_MR_SLA_ACK:
+            TWCR = run | (readIndex + 1 < t->readLength ? _BV(TWEA) : 0);
+            break;
+        case TW_MR_DATA_NACK:
+            t->readData[readIndex++] = TWDR;
+            TWCR = _BV(TWINT) | _BV(TWEN) | _BV(TWSTO);
+            TwiEngine::complete(TWI_OK);
+            break;
+        case TW_MT_SLA_NACK:
+        case TW_MT_DATA_NACK:
+        case TW_MR_SLA_NACK:
+            TWCR = _BV(TWINT) | _BV(TWEN) | _BV(TWSTO);
+            TwiEngine::complete(TWI_NACK);
+            break;
+        default:  // Arbitration lost or bus error.
+            hardwareReset();
+            TwiEngine::complete(TWI_BUS_ERROR);
+            break;
+    }
+}
+
+#else
+
+static void hardwareStart() {
+    TwiTransaction* t = TwiEngine::current;
+    sim::twiTransfer(t->address, t->writeData, t->writeLength, t->readData, t->readLength, [t](uint8_t status) {
+        if (TwiEngine::current == t) {  // Not aborted by the timeout meanwhile.
+            TwiEngine::complete((TwiStatus)status);
+        }
+    });
+}
+
+static void hardwareReset() {}
+
+#endif
+
+/**
+ * Enables the TWI hardware.
+ *
+ * Parameters:
+ * - `frequency` (uint32_t): SCL clock in Hz (the NAU7802 and the Qwiic relays run at 400 kHz).
+ */
+void TwiEngine::begin(uint32_t frequency) {
+#if defined(__AVR__)
+    pinMode(SDA, INPUT_PULLUP);
+    pinMode(SCL, INPUT_PULLUP);
+    TWSR = 0;  // Prescaler 1.
+    TWBR = ((F_CPU / frequency) - 16) / 2;
+    TWCR = _BV(TWEN);
+#else
+    (void)frequency;
+#endif
+}
+
+/**
+ * Queues a transaction.
+ *
+ * Returns:
+ * - `false` if the queue is full or the transaction is still pending; it is not queued then.
+ *
+ * Behavior:
+ * - Starts the bus at once if it is idle; otherwise the transaction runs after the ones queued
+ *   before it. Its status stays `TWI_PENDING` until it leaves the bus; the callback (if any)
+ *   runs from the next `poll()`.
+ */
+bool TwiEngine::submit(TwiTransaction& transaction) {
+    if (transaction.isBusy() || inFlight >= queueSize - 1) {
+        return false;
+    }
+    transaction.status = TWI_PENDING;
+    inFlight++;
+    queues->submitted.push(&transaction);
+    noInterrupts();
+    if (!busy) {
+        startNext();
+    }
+    interrupts();
+    return true;
+}
+
+/**
+ * Starts the next queued transaction, if any. Runs with interrupts disabled.
+ */
+void TwiEngine::startNext() {
+    TwiTransaction* next;
+    if (!queues->submitted.pop(next)) {
+        busy = false;
+        current = nullptr;
+        return;
+    }
+    current = next;
+    busy = true;
+    startedMs = millis();
+    hardwareStart();
+}
+
+/**
+ * Ends the transaction on the bus and starts the next one. Called by the bus back end.
+ */
+void TwiEngine::complete(TwiStatus status) {
+    TwiTransaction* t = current;
+    t->status = status;
+    queues->finished.push(t);
+#if defined(__AVR__)
+    while (TWCR & _BV(TWSTO)) {}  // The stop condition takes a few microseconds.
+#endif
+    startNext();
+}
+
+/**
+ * Runs the callbacks of finished transactions and aborts a transfer stuck past `timeoutMs`.
+ *
+ * Behavior:
+ * - Callbacks run in completion order. A transaction can be submitted again from its own
+ *   callback, e.g. to poll a register.
+ */
+void TwiEngine::poll() {
+    if (busy && millis() - startedMs > timeoutMs) {
+        noInterrupts();
+        if (busy) {
+            hardwareReset();
+            complete(TWI_BUS_ERROR);
+        }
+        interrupts();
+    }
+    TwiTransaction* t;
+    while (queues->finished.pop(t)) {
+        inFlight--;
+        if (t->done) {
+            t->done(*t);
+        }
+    }
+}
+
+/**
+ * Blocks until a transaction completes, running the callbacks of others meanwhile.
+ *
+ * Returns:
+ * - The final status.
+ */
+TwiStatus TwiEngine::wait(TwiTransaction& transaction) {
+    while (transaction.isBusy()) {
+        poll();
+    }
+    poll();  // Deliver the callback of `transaction` itself.
+    return transaction.status;
+}
@@ -1,4 +1,10 @@
 #include "Utils.h"
+#include "IdleSleep.h"
+#include "TwiEngine.h"
+
+void (*Utils::backgroundTask)() = nullptr;  // Work run while a command waits (see `wait()`).
+bool Utils::inBackgroundTask = false;       // Guards against re-entering the background task.
+volatile bool Utils::abortRequested = false;  // Set by `<Abort>`; ends waits and moves early.
 
 /**
  * Constructor for the Utils class.
@@ -10,12 +16,12 @@ Utils::Utils() {}
  * Prepares the Arduino environment for operation.
  * - Initializes Serial communication at a baud rate of 115200.
  * - Includes a small delay to ensure the Serial interface is ready.
- * - Starts I2C (Wire library) communication for connected devices.
+ * - Starts the interrupt-driven I2C engine for connected devices.
  */
 void Utils::setupArduino() {
-    Serial.begin(115200);  // Initialize Serial communication for debugging or data exchange.
+    Serial.begin(BAUD_RATE);  // Initialize Serial communication for debugging or data exchange.
     delay(500);            // Wait 500ms for Serial initialization.
-    Wire.begin();          // Enable I2C communication for peripherals like sensors.
+    TwiEngine::begin();    // Enable I2C; the device libraries' `Wire` runs on the same engine.
 }
 
 /**
@@ -27,4 +33,46 @@ void Utils::clearEEPROM() {
     for (int i = 0; i < EEPROM.length(); i++) { // Iterate over all addresses in EEPROM.
         EEPROM.write(i, 0);                     // Write 0 to clear the stored value.
     }
-}
\ No newline at end of file
+}
+
+/**
+ * Runs the registered background task once.
+ *
+ * Behavior:
+ * - Lets long-running commands keep serving the immediate command lane and the scale state
+ *   machine between their own steps.
+ * - Does nothing if no task is registered or if called from within the task itself.
+ */
+void Utils::runBackgroundTask() {
+    if (backgroundTask == nullptr || inBackgroundTask) {
+        return;
+    }
+    inBackgroundTask = true;
+    backgroundTask();
+    inBackgroundTask = false;
+}
+
+/**
+ * Waits for a duration while running the background task.
+ *
+ * Parameters:
+ * - `ms` (unsigned long): Time to wait in milliseconds.
+ *
+ * Returns:
+ * - `true` if the full time elapsed, `false` if the wait ended early because of an abort request.
+ *
+ * Behavior:
+ * - Replaces `delay()` inside commands so status queries and aborts are handled while they run.
+ * - Sleeps between background passes when idle sleep is on (see `IdleSleep`), e.g. while a dose settles.
+ */
+bool Utils::wait(unsigned long ms) {
+    unsigned long start = millis();
+    while (millis() - start < ms) {
+        if (abortRequested) {
+            return false;
+        }
+        runBackgroundTask();
+        IdleSleep::enter();
+    }
+    return !abortRequested;
+}
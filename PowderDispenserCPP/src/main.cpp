@@ -1,13 +1,38 @@
 #include "Utils.h"
 #include "MixerControls.h"
 #include "Comms.h"
+#include "Checkpoint.h"
+#include "DeviceConfig.h"
+#include "IdleSleep.h"
+#include "TwiEngine.h"
 
 // Global object initialization
 Utils utils;  // Utility object for shared functionality.
 ScaleControls scaleControls(utils);  // Scale control object using the utility class.
 MixerControls mixerControls(utils); // Mixer control object using the utility class.
 DispenserControls dispenserControls(utils); // Dispenser control object using the utility class.
-Comms comms(utils, scaleControls, mixerControls, dispenserControls); // Communication object linking all controls.
+DoseController doseController(utils, scaleControls, dispenserControls); // Closed-loop dosing on the scale.
+Comms comms(utils, scaleControls, mixerControls, dispenserControls, doseController); // Communication object linking all controls.
+
+/**
+ * Work that must keep running even while a command is in progress.
+ *
+ * Called from `loop()` and, through `Utils::wait()`, from inside long-running commands, so
+ * immediate commands are answered and the scale state machine advances during them.
+ */
+void serviceTasks() {
+    // Update the current time for communication synchronization.
+    comms.updateCurMillis(millis());
+
+    // Check for and process any incoming data from the PC.
+    comms.getDataFromPC();
+
+    // Run the completion callbacks of finished I2C transfers.
+    TwiEngine::poll();
+
+    // Advance the scale power state (settle detection, idle power-down, AFE recalibration when idle).
+    scaleControls.update(millis(), !comms.isBusy());
+}
 
 /**
  * Arduino `setup()` function.
@@ -17,10 +42,16 @@ Comms comms(utils, scaleControls, mixerControls, dispenserControls); // Communic
  */
 void setup() {
     utils.setupArduino();  // Initialize Arduino Serial communication and I2C.
+    utils.setBackgroundTask(serviceTasks);  // Serve immediate commands while commands wait.
     delay(200);            // Short delay to allow the Serial Monitor to open.
 
+    // Configuration image flashed from the host (<CfgLoad>); built-in settings without one.
+    DeviceConfig::load();
+
     // Set up the scale with specific parameters (sample rate, gain, LDO voltage).
-    scaleControls.setupScale(320, 128, 3);  // Sample rate: 320 Hz, Gain: 128x, LDO: 3.0V.
+    ScaleSettings scaleSettings = {320, 128, 3};  // Sample rate: 320 Hz, Gain: 128x, LDO: 3.0V.
+    DeviceConfig::getScale(scaleSettings);
+    scaleControls.setupScale(scaleSettings.sampleRate, scaleSettings.gain, scaleSettings.ldoVoltage);
     delay(200);
 
     // Initialize relays for the mixer and drain.
@@ -37,11 +68,20 @@ void setup() {
     dispenserControls.setupDispenser(128);
     delay(200);
 
+    // Dose parameters tuned on the host (<DoseParam>); defaults until one is stored.
+    doseController.loadParams();
+
+    // Restore the progress of a batch interrupted by a reset (reported by <Resume>).
+    Checkpoint::load();
+
     // Send a ready message to the PC.
-    Serial.println("<Ready to push powder, baby!>");
+    Serial.println(F("<Ready to push powder, baby!>"));
 
-    // Calculate calibration parameters for the scale using manual slope and intercept.
-    scaleControls.calculateCalParams(scaleControls.MANUAL_SLOPE, scaleControls.MANUAL_INTERCEPT);
+    // Calculate calibration parameters for the scale from the configured load cell, or the manual slope and intercept.
+    float slope = scaleControls.MANUAL_SLOPE;
+    float intercept = scaleControls.MANUAL_INTERCEPT;
+    DeviceConfig::getLoadCell(slope, intercept);
+    scaleControls.calculateCalParams(slope, intercept);
 
     // Tare the scale to zero the readings.
     scaleControls.tareScale();
@@ -50,14 +90,13 @@ void setup() {
 /**
  * Arduino `loop()` function.
  * 
- * Continuously handles communication updates and processes incoming data from the PC.
+ * Continuously handles communication updates and processes incoming data from the PC, sleeping
+ * until the next interrupt between passes.
  */
 void loop() {
-    // Update the current time for communication synchronization.
-    comms.updateCurMillis(millis());
-
-    // Check for and process any incoming data from the PC.
-    comms.getDataFromPC();
+    serviceTasks();
+    comms.runAutoDose();  // Start the next queued dose once a vessel is placed (<AutoDose>).
+    IdleSleep::enter();
 
     // Placeholder for replying to the PC (commented out).
     // replyToPC();
@@ -0,0 +1,138 @@
+#include <Arduino.h>
+#include <unity.h>
+#include <chrono>
+
+#include "Comms.h"
+#include "TimingModel.h"
+
+// Firmware objects and entry points from src/main.cpp.
+extern ScaleControls scaleControls;
+extern MixerControls mixerControls;
+extern DispenserControls dispenserControls;
+extern Comms comms;
+void setup();
+void loop();
+
+/**
+ * Runs `loop()` until the firmware prints `expected` or `timeoutMs` of simulated time pass.
+ *
+ * Returns:
+ * - Everything printed meanwhile.
+ */
+static std::string loopUntil(const char* expected, unsigned long timeoutMs) {
+    std::string output;
+    unsigned long start = millis();
+    while (output.find(expected) == std::string::npos && millis() - start < timeoutMs) {
+        loop();
+        output += Serial.takeOutput();
+    }
+    return output;
+}
+
+static double realSeconds(std::chrono::steady_clock::time_point since) {
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - since).count();
+}
+
+void setUp() {
+    sim::World& world = sim::world();
+    world.massOnScaleG = 0;
+    world.flowNoise = 0.05;
+    Serial.takeOutput();
+}
+
+void tearDown() {}
+
+void test_delay_skips_virtual_time() {
+    auto realStart = std::chrono::steady_clock::now();
+    unsigned long start = millis();
+    delay(3600000UL);  // One hour.
+    TEST_ASSERT_UINT32_WITHIN(1, 3600000UL, millis() - start);
+    TEST_ASSERT_TRUE(realSeconds(realStart) < 0.1);
+}
+
+void test_mixer_run_takes_virtual_seconds() {
+    auto realStart = std::chrono::steady_clock::now();
+    unsigned long start = millis();
+    mixerControls.run(mixerControls.getMixerRelay(), 10.0);
+    unsigned long elapsed = millis() - start;
+    TEST_ASSERT_TRUE(elapsed >= 10000 && elapsed < 10100);
+    TEST_ASSERT_FALSE(sim::world().mixerOn);
+    TEST_ASSERT_TRUE(realSeconds(realStart) < 1.0);
+}
+
+void test_scale_converts_at_sample_rate() {
+    sim::world().massOnScaleG = 10.0;
+    Serial.inject("<ScaleOn>");
+    std::string output = loopUntil("<ScaleReady>", 5000);
+    TEST_ASSERT_TRUE(output.find("<ScaleReady>") != std::string::npos);
+
+    unsigned long start = millis();
+    float raw = scaleControls.getReading(32, NONE);
+    unsigned long elapsed = millis() - start;
+    TEST_ASSERT_TRUE(elapsed >= 90 && elapsed < 200);  // 32 conversions at 320 SPS.
+
+    const sim::World& world = sim::world();
+    float expected = (10.0 - world.interceptG) / world.slopeGPerCount;
+    TEST_ASSERT_FLOAT_WITHIN(expected * 0.001, expected, raw);
+}
+
+void test_short_reading_does_not_wait_for_a_block() {
+    unsigned long start = millis();
+    scaleControls.getReading(4, NONE);
+    unsigned long elapsed = millis() - start;
+    TEST_ASSERT_TRUE(elapsed < 30);  // 4 conversions at 320 SPS, not a 20-sample block.
+    TEST_ASSERT_FALSE(scaleControls.lastReadingTimedOut());
+}
+
+void test_timed_out_reading_averages_what_arrived() {
+    const sim::World& world = sim::world();
+    float expected = (world.massOnScaleG - world.interceptG) / world.slopeGPerCount;
+    float raw = scaleControls.getReading(100, NONE, 100);  // 100 ms holds about 32 conversions.
+    TEST_ASSERT_TRUE(scaleControls.lastReadingTimedOut());
+    TEST_ASSERT_FLOAT_WITHIN(expected * 0.001, expected, raw);
+}
+
+void test_dispensed_powder_lands_on_scale() {
+    sim::World& world = sim::world();
+    world.flowNoise = 0;
+    dispenserControls.enableDispenser();
+
+    uint16_t chunkSteps = TimingModel::stepsWithin(DispenserControls::serviceChunkMs);
+    unsigned long start = millis();
+    long steps = dispenserControls.dispenseMass(1.0, 0);
+    unsigned long elapsed = millis() - start;
+    long commands = (steps + chunkSteps - 1) / chunkSteps;  // One driver command per time-bounded chunk.
+    TEST_ASSERT_UINT32_WITHIN(steps / 100 + 20, (steps * world.stepPeriodUs + commands * world.moveOverheadUs) / 1000, elapsed);
+
+    delay(world.fallDelayUs / 1000 + 1);
+    TEST_ASSERT_FLOAT_WITHIN(0.01, 1.0, world.massOnScaleG);
+    dispenserControls.disableDispenser();
+}
+
+void test_hour_long_sequence_runs_in_real_milliseconds() {
+    Serial.inject("<ScaleOff>");  // Standby: no conversions to poll while mixing.
+    loopUntil("<Msg ScaleOff", 1000);
+
+    auto realStart = std::chrono::steady_clock::now();
+    unsigned long start = millis();
+    for (int i = 0; i < 360; i++) {
+        Serial.inject("<Mix,10>");
+        std::string output = loopUntil("<Msg Mix", 20000);
+        TEST_ASSERT_TRUE(output.find("<Msg Mix") != std::string::npos);
+    }
+    TEST_ASSERT_TRUE(millis() - start >= 3600000UL);
+    TEST_ASSERT_TRUE(realSeconds(realStart) < 1.0);
+}
+
+int main() {
+    setup();
+    UNITY_BEGIN();
+    RUN_TEST(test_delay_skips_virtual_time);
+    RUN_TEST(test_mixer_run_takes_virtual_seconds);
+    RUN_TEST(test_scale_converts_at_sample_rate);
+    RUN_TEST(test_short_reading_does_not_wait_for_a_block);
+    RUN_TEST(test_timed_out_reading_averages_what_arrived);
+    RUN_TEST(test_dispensed_powder_lands_on_scale);
+    RUN_TEST(test_hour_long_sequence_runs_in_real_milliseconds);
+    return UNITY_END();
+}
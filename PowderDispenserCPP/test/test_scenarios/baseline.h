@@ -0,0 +1,37 @@
+#ifndef BASELINE_H
+#define BASELINE_H
+
+/**
+ * Recorded results of the scenario corpus, one row per scenario in corpus order.
+ *
+ * Regenerate after an intentional behavior change: run the suite, check the printed table and
+ * paste its `baseline` block here. Every scenario must complete; one that does not fails the suite.
+ */
+struct Baseline {
+    const char* name;
+    unsigned long doseMs;     // Virtual time of the dose.
+    float errorMg;            // |delivered - target|.
+    unsigned int bursts;      // Feedback bursts after the initial move.
+    unsigned long latencyMs;  // Longest gap between serial polls (one time-bounded driver command).
+};
+
+static const Baseline baseline[] = {
+    {"salt_100mg", 21570, 1.2, 13, 12},
+    {"salt_250mg", 32567, 2.5, 18, 10},
+    {"salt_1g", 65314, 9.9, 26, 10},
+    {"fine_powder_250mg", 47536, 2.8, 20, 9},
+    {"cohesive_250mg", 31385, 2.6, 17, 9},
+    {"flows_fast_250mg", 27070, 2.5, 15, 9},
+    {"flows_slow_250mg", 50376, 2.7, 29, 9},
+    {"noisy_scale_250mg", 31389, 3.6, 17, 9},
+    {"mixer_vibration_250mg", 25820, 13.9, 13, 9},
+    {"jam_250mg", 41857, 2.4, 23, 9},
+};
+
+// A metric regresses when it exceeds `baseline * (1 + relative) + absolute`.
+static const float doseMsTolerance = 0.10, doseMsSlack = 1000;
+static const float errorMgTolerance = 0.25, errorMgSlack = 5;
+static const float burstsTolerance = 0.20, burstsSlack = 2;
+static const float latencyMsTolerance = 0.25, latencyMsSlack = 5;
+
+#endif // BASELINE_H
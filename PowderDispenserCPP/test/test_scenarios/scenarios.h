@@ -0,0 +1,66 @@
+#ifndef SCENARIOS_H
+#define SCENARIOS_H
+
+#include <stdint.h>
+
+/**
+ * One simulated dosing situation: the powder, the target and the disturbances.
+ * Fields left at their defaults keep the `sim::World` defaults (dishwasher salt, 8 mm auger).
+ */
+struct Scenario {
+    const char* name;
+    float targetG;
+    float flowScale = 1.0;        // Actual flow relative to the device calibration.
+    float gramsPerStep = 2.1130909090909088e-05;  // Calibrated flow of the powder.
+    float flowNoise = 0.05;       // Relative flow noise per driver command.
+    float scaleNoiseG = 0.002;    // Conversion noise.
+    bool mixerRunning = false;    // Mixer vibration on the scale during the dose.
+    uint64_t jamAfterSteps = 0;   // Auger jam window (0 for none).
+    uint32_t jamSteps = 0;
+    uint32_t seed = 1;
+};
+
+static Scenario makeScenario(const char* name, float targetG) {
+    Scenario scenario;
+    scenario.name = name;
+    scenario.targetG = targetG;
+    return scenario;
+}
+
+/**
+ * The regression corpus. Add scenarios at the end and record their baseline in `baseline.h`.
+ */
+static Scenario* scenarioCorpus(uint8_t& count) {
+    static Scenario corpus[10];
+    corpus[0] = makeScenario("salt_100mg", 0.1);
+    corpus[1] = makeScenario("salt_250mg", 0.25);
+    corpus[2] = makeScenario("salt_1g", 1.0);
+
+    corpus[3] = makeScenario("fine_powder_250mg", 0.25);
+    corpus[3].gramsPerStep = 8e-06;
+    corpus[3].flowNoise = 0.10;
+
+    corpus[4] = makeScenario("cohesive_250mg", 0.25);
+    corpus[4].flowNoise = 0.30;
+
+    corpus[5] = makeScenario("flows_fast_250mg", 0.25);
+    corpus[5].flowScale = 1.3;
+
+    corpus[6] = makeScenario("flows_slow_250mg", 0.25);
+    corpus[6].flowScale = 0.7;
+
+    corpus[7] = makeScenario("noisy_scale_250mg", 0.25);
+    corpus[7].scaleNoiseG = 0.02;
+
+    corpus[8] = makeScenario("mixer_vibration_250mg", 0.25);
+    corpus[8].mixerRunning = true;
+
+    corpus[9] = makeScenario("jam_250mg", 0.25);
+    corpus[9].jamAfterSteps = 3000;  // Inside the initial move.
+    corpus[9].jamSteps = 4000;
+
+    count = sizeof(corpus) / sizeof(corpus[0]);
+    return corpus;
+}
+
+#endif // SCENARIOS_H
@@ -0,0 +1,130 @@
+#include <Arduino.h>
+#include <unity.h>
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "Comms.h"
+#include "scenarios.h"
+#include "baseline.h"
+
+// Firmware entry points from src/main.cpp.
+void setup();
+void loop();
+
+struct Metrics {
+    bool completed;
+    unsigned long doseMs;
+    float errorMg;
+    unsigned int bursts;
+    unsigned long latencyMs;
+};
+
+static Scenario* corpus;
+static uint8_t corpusSize;
+static uint8_t current;
+static Metrics results[sizeof(baseline) / sizeof(baseline[0]) + 16];
+
+static std::string loopUntil(const char* expected, unsigned long timeoutMs) {
+    std::string output;
+    unsigned long start = millis();
+    while (output.find(expected) == std::string::npos && millis() - start < timeoutMs) {
+        loop();
+        output += Serial.takeOutput();
+    }
+    return output;
+}
+
+static unsigned long field(const std::string& frame, const char* key) {
+    size_t at = frame.find(key);
+    return at == std::string::npos ? 0 : strtoul(frame.c_str() + at + strlen(key), NULL, 10);
+}
+
+/**
+ * Runs one scenario through the serial protocol and measures it against the true world state.
+ */
+static Metrics runScenario(const Scenario& scenario) {
+    sim::resetWorld(scenario.seed);
+    sim::World& world = sim::world();
+    world.gramsPerStep = scenario.gramsPerStep * scenario.flowScale;
+    world.flowNoise = scenario.flowNoise;
+    world.scaleNoiseG = scenario.scaleNoiseG;
+    world.mixerOn = scenario.mixerRunning;
+    world.jamAfterSteps = scenario.jamAfterSteps;
+    world.jamSteps = scenario.jamSteps;
+
+    char frame[64];
+    snprintf(frame, sizeof(frame), "<AugerCal,0,%.9g>", scenario.gramsPerStep);
+    Serial.inject(frame);
+    loopUntil("<Msg AugerCal", 1000);
+
+    Serial.resetPollGap();
+    snprintf(frame, sizeof(frame), "<Dose,%.4f,0>", scenario.targetG);
+    Serial.inject(frame);
+    std::string output = loopUntil("<Dose ", 3600000UL);
+    Metrics metrics;
+    metrics.latencyMs = Serial.maxPollGapUs() / 1000;
+
+    delay(world.fallDelayUs / 1000 + 1);  // Let the last burst land.
+    size_t at = output.find("<Dose ");
+    std::string reply = at == std::string::npos ? "" : output.substr(at);
+    metrics.doseMs = field(reply, "ms:");
+    metrics.bursts = field(reply, "bursts:");
+    metrics.completed = !reply.empty() && reply.find("incomplete") > reply.find('>');
+    metrics.errorMg = fabsf(world.massOnScaleG - scenario.targetG) * 1000;
+    return metrics;
+}
+
+static void checkMetric(const char* metric, float value, float base, float tolerance, float slack) {
+    char message[96];
+    float limit = base * (1 + tolerance) + slack;
+    snprintf(message, sizeof(message), "%s %s: %.1f exceeds %.1f (baseline %.1f)",
+             corpus[current].name, metric, value, limit, base);
+    TEST_ASSERT_LESS_OR_EQUAL_MESSAGE(limit, value, message);
+}
+
+void setUp() {
+    Serial.takeOutput();
+}
+
+void tearDown() {}
+
+void test_scenario() {
+    Metrics& metrics = results[current];
+    metrics = runScenario(corpus[current]);
+
+    TEST_ASSERT_TRUE_MESSAGE(current < sizeof(baseline) / sizeof(baseline[0]), "No baseline for this scenario.");
+    const Baseline& base = baseline[current];
+    TEST_ASSERT_EQUAL_STRING(base.name, corpus[current].name);
+    TEST_ASSERT_TRUE_MESSAGE(metrics.completed, "The dose did not complete.");
+    checkMetric("dose ms", metrics.doseMs, base.doseMs, doseMsTolerance, doseMsSlack);
+    checkMetric("error mg", metrics.errorMg, base.errorMg, errorMgTolerance, errorMgSlack);
+    checkMetric("bursts", metrics.bursts, base.bursts, burstsTolerance, burstsSlack);
+    checkMetric("latency ms", metrics.latencyMs, base.latencyMs, latencyMsTolerance, latencyMsSlack);
+}
+
+/**
+ * Prints the results as a table and as a `baseline.h` block.
+ */
+static void printReport() {
+    printf("\n%-22s %5s %9s %9s %7s %10s\n", "scenario", "done", "dose ms", "error mg", "bursts", "latency ms");
+    for (uint8_t i = 0; i < corpusSize; i++) {
+        printf("%-22s %5s %9lu %9.1f %7u %10lu\n", corpus[i].name, results[i].completed ? "yes" : "no",
+               results[i].doseMs, results[i].errorMg, results[i].bursts, results[i].latencyMs);
+    }
+    printf("\nbaseline:\n");
+    for (uint8_t i = 0; i < corpusSize; i++) {
+        printf("    {\"%s\", %lu, %.1f, %u, %lu},\n", corpus[i].name, results[i].doseMs, results[i].errorMg, results[i].bursts, results[i].latencyMs);
+    }
+}
+
+int main() {
+    setup();
+    corpus = scenarioCorpus(corpusSize);
+    UNITY_BEGIN();
+    for (current = 0; current < corpusSize; current++) {
+        UnityDefaultTestRun(test_scenario, corpus[current].name, __LINE__);
+    }
+    printReport();
+    return UNITY_END();
+}
@@ -0,0 +1,97 @@
+"""
+Device capabilities reported by `<Caps>` (firmware `Capabilities`, see
+`PowderDispenserCPP/include/Capabilities.h`).
+
+Firmware versions differ in the commands, frame formats and stream rates they support. The
+controllers query `<Caps>` once when they connect and pick the fastest mode each device offers,
+e.g. device-side mass conversion (`<DispenseMass>`) over host-side step counts, or the densest
+telemetry stream the serial link carries. A device that does not answer `<Caps>` gets
+`LEGACY_CAPS`, the protocol version 1 command set.
+
+Classes:
+    DeviceCaps - Parsed capabilities with `supports()` and `stream_every()`.
+
+Functions:
+    parse_caps(msg) - Parses a `<Caps ...>` reply.
+"""
+
+import math
+from dataclasses import dataclass, field
+
+COMMANDS = (  # Firmware `CommandBit` order; append-only.
+    'Dispense', 'DispenserOn', 'DispenserOff', 'ScaleOn', 'ScaleOff', 'Tare', 'Meas', 'ADC', 'Mix', 'Drain', 'Pump',
+    'Status', 'Abort', 'Stats', 'Mem', 'Trace', 'ProfStart', 'ProfStop', 'ProfDump', 'Predict', 'DispenseMass',
+    'AugerCal', 'ScaleIdle', 'AfeCal', 'BatchStart', 'BatchEnd', 'Resume', 'Refill', 'Flow', 'Hopper', 'Dose',
+    'DoseParam', 'Stream', 'CfgLoad', 'Cfg', 'Caps', 'Idle', 'DoseQueue', 'AutoDose',
+)
+LEGACY_COMMANDS = COMMANDS[:11]  # Protocol version 1.
+
+
+@dataclass(frozen=True)
+class DeviceCaps:
+    """
+    Capabilities of one device.
+
+    Attributes:
+        protocol (int): Protocol version (1: firmware without `<Caps>`).
+        commands (frozenset): Supported command names.
+        formats (frozenset): Frame formats: 'ascii', 'stream', 'raw' and 'image'.
+        rx_bytes (int): Longest command frame.
+        queue_bytes (int): Actuation commands the device holds while one runs.
+        serial_bytes (int): Device receive FIFO, the most raw bytes to send ahead.
+        baud (int): Serial baud rate.
+        sample_rate (int): Scale conversions per second (0 if unknown).
+        stream_rate (int): Most telemetry samples per second the link carries (0 without streaming).
+        filters (tuple): Filter names accepted by `<Meas>` and `<ADC>`.
+    """
+    protocol: int = 1
+    commands: frozenset = frozenset(LEGACY_COMMANDS)
+    formats: frozenset = frozenset({'ascii'})
+    rx_bytes: int = 63
+    queue_bytes: int = 0
+    serial_bytes: int = 64
+    baud: int = 115200
+    sample_rate: int = 0
+    stream_rate: int = 0
+    filters: tuple = field(default=('NONE', 'EWMA', 'SMA', 'LPF'))
+
+    def supports(self, command):
+        """Returns True if the device handles `command` (a name such as 'DispenseMass')."""
+        return command in self.commands
+
+    def stream_every(self):
+        """
+        Returns the smallest `<Stream>` decimation the link carries without dropping samples
+        (1 streams every conversion).
+        """
+        if not self.sample_rate or not self.stream_rate or self.stream_rate >= self.sample_rate:
+            return 1
+        return math.ceil(self.sample_rate / self.stream_rate)
+
+
+LEGACY_CAPS = DeviceCaps()
+
+
+def parse_caps(msg):
+    """
+    Parses a `<Caps ...>` reply (markers optional).
+
+    Returns:
+        DeviceCaps: The capabilities; fields missing from the reply keep their defaults, and
+        command bits newer than this module are ignored.
+    """
+    fields = dict(item.split(':', 1) for item in msg.strip('<>').split() if ':' in item)
+    bitmap = int(fields.get('cmds', '0'), 16)
+    defaults = LEGACY_CAPS
+    return DeviceCaps(
+        protocol=int(fields.get('proto', defaults.protocol)),
+        commands=frozenset(name for bit, name in enumerate(COMMANDS) if bitmap >> bit & 1),
+        formats=frozenset(fields['fmt'].split(',')) if 'fmt' in fields else defaults.formats,
+        rx_bytes=int(fields.get('rx', defaults.rx_bytes)),
+        queue_bytes=int(fields.get('queue', defaults.queue_bytes)),
+        serial_bytes=int(fields.get('serial', defaults.serial_bytes)),
+        baud=int(fields.get('baud', defaults.baud)),
+        sample_rate=int(fields.get('sps', defaults.sample_rate)),
+        stream_rate=int(fields.get('stream', defaults.stream_rate)),
+        filters=tuple(fields['filters'].split(',')) if 'filters' in fields else defaults.filters,
+    )
@@ -3,6 +3,9 @@ This module defines the PowderDispenseController class which manages operations
 It includes methods to operate the scale, mixer, and pumps based on pre-defined calibration parameters,
 and execute sequences for dispensing, flushing, draining, and more.
 
+The controller queries the firmware's capabilities (`<Caps>`, see `caps`) when it connects and uses
+the fastest mode each device supports.
+
 Classes:
     PowderDispenseController - A controller to manage dispensing operations including scale and mixer functions.
 """
@@ -17,6 +20,8 @@ import os
 import datetime
 from scipy import stats
 from .utils import get_config, read_logfile, write_to_logfile, list_serial_ports, save_config
+from .dose_optimizer import to_frame
+from . import caps, devconfig, native
 
 class PowderDispenseController:
     """
@@ -32,9 +37,11 @@ class PowderDispenseController:
         defPowderType (str, optional): Default powder type (default: 'dishwasher_salt').
         config_file (str): Path to the configuration file (default: 'config.json').
     """
+    DEFAULT_timeout = 10  # Seconds, until the configuration is loaded.
+
     def __init__(self, ser_port, baud_rate=115200, mixTime=10.0, drainTime=10.0, defAugerType=None, defPowderType=None, config_file='config.json') -> None:
         # Initialize the serial connection to the Arduino.
-        self.ser = serial.Serial(ser_port, baud_rate)
+        self.ser = self._open_serial(ser_port, baud_rate)
         print(f"Serial port {ser_port} opened at baud rate {baud_rate}")
 
         # Wait for the Arduino to signal readiness.
@@ -44,6 +51,9 @@ class PowderDispenseController:
         self.config_file = config_file
         self.powder_config = get_config(config_file)
 
+        # Ask the firmware what it supports, so the fastest mode of each device is used.
+        self.caps = self.get_caps()
+
         # Initialize scale and stepper states.
         self.isScaleOn = True
         self.isStepperOn = True
@@ -60,6 +70,9 @@ class PowderDispenseController:
         self.DEFAULT_direction = self.powder_config['default_constants']['DEFAULT_DISPENSE_DIR']
         self.DEFAULT_flushVolume = 1
 
+        # Auger calibration factors loaded into each device channel.
+        self.deviceAugerCal = {}
+
         # Set default operational times and pin configurations.
         self.drainTime = drainTime
         self.mixTime = mixTime
@@ -80,13 +93,25 @@ class PowderDispenseController:
         if not os.path.exists('logs'):
             os.makedirs('logs')
 
-        # Initialize a new log file for this session.
+        # Initialize a new log file for this session: a binary dose log if the native library is built.
         now = datetime.datetime.now()
-        self.log_file = f"logs/log_{now.strftime('%d%m%Y_%H%M%S')}.csv"
-        log_df = pd.DataFrame(columns=['desired amount', 'measured amount', '# of steps', 'filter type'])
-        log_df.to_csv(self.log_file, index=False)
+        if native.available():
+            self.log_file = f"logs/log_{now.strftime('%d%m%Y_%H%M%S')}.pdlog"
+        else:
+            self.log_file = f"logs/log_{now.strftime('%d%m%Y_%H%M%S')}.csv"
+            log_df = pd.DataFrame(columns=['desired amount', 'measured amount', '# of steps', 'filter type'])
+            log_df.to_csv(self.log_file, index=False)
 
     ### COMMS #####################
+    def _open_serial(self, ser_port, baud_rate):
+        """
+        Opens the serial connection to the device. Subclasses replace the transport here.
+
+        Returns:
+            serial.Serial: The open port.
+        """
+        return serial.Serial(ser_port, baud_rate)
+
     def send_to_arduino(self, send_str):
         """
         Sends a specified string to the connected Arduino device over the serial port.
@@ -96,6 +121,12 @@ class PowderDispenseController:
         """
         self.ser.write(send_str.encode('utf-8'))  # Encode and send the string.
 
+    def _write_raw(self, data):
+        """
+        Sends raw bytes (e.g. a configuration image) without framing.
+        """
+        self.ser.write(data)
+
     def recv_from_arduino(self, timeout=None):
         """
         Receives a string from the Arduino device over the serial port with an optional timeout.
@@ -110,21 +141,25 @@ class PowderDispenseController:
             TimeoutError: If no response is received within the specified timeout.
         """
         timeout = timeout or self.DEFAULT_timeout  # Use default timeout if none is provided.
-        start_marker = 60  # ASCII code for '<'.
-        end_marker = 62    # ASCII code for '>'.
-        start_time = time.time()
-        ck = ""  # Buffer to store the received string.
-
-        while time.time() - start_time < timeout:
-            # Wait for the start marker.
-            while ord(self.ser.read()) != start_marker:
-                pass
-
-            # Read characters until the end marker is encountered.
-            while ord(self.ser.read()) != end_marker:
-                char = self.ser.read().decode("utf-8")
-                ck += char
-            return ck
+        start_marker = b"<"
+        end_marker = b">"
+        deadline = time.time() + timeout
+        frame = None  # Bytes of the frame once its start marker has been seen.
+
+        # Read one byte at a time, and only what has arrived, so the deadline is always checked.
+        while time.time() < deadline:
+            if self.ser.in_waiting == 0:
+                time.sleep(0.001)
+                continue
+            byte = self.ser.read(1)
+            if byte == start_marker:
+                frame = bytearray()  # A new frame; text outside frames is ignored.
+            elif frame is None:
+                continue
+            elif byte == end_marker:
+                return frame.decode("utf-8", errors="replace")
+            else:
+                frame += byte
 
         raise TimeoutError("Arduino did not respond within timeout. Try resetting the device.")
 
@@ -185,6 +220,8 @@ class PowderDispenseController:
                 try:
                     raw_data = msg.split(':')[1]  # Extract the data after the "ADC:" prefix.
                     raw_val = float(raw_data.split(',')[0])  # Parse the first value as a float.
+                    if 'timeout' in raw_data:  # Fewer samples than requested arrived in time.
+                        print(f"ADC reading timed out: {msg}")
                     return raw_val
                 except (IndexError, ValueError) as e:
                     # Handle cases where the message format is unexpected or invalid.
@@ -212,6 +249,8 @@ class PowderDispenseController:
                 try:
                     weight_data = msg.split(':')[1]  # Extract the data after the "Weight:" prefix.
                     weight_val = float(weight_data.split(',')[0])  # Parse the first value as a float.
+                    if 'timeout' in weight_data:  # Fewer samples than requested arrived in time.
+                        print(f"Weight reading timed out: {msg}")
                     return weight_val
                 except (IndexError, ValueError) as e:
                     # Handle cases where the message format is unexpected or invalid.
@@ -222,6 +261,434 @@ class PowderDispenseController:
                 print(f"Received message does not contain 'Weight:' {msg}")  # Log unexpected messages.
         return None
 
+    def predict(self, command, *args):
+        """
+        Asks the device how long a command will take, without running it.
+        The device learns from its own moves, relay runs and scale settle times.
+
+        Parameters:
+            command (str): The command to predict, e.g. 'DispenseMass', 'Dispense', 'Mix', 'Drain', 'Pump' or 'ScaleOn'.
+            *args: The command's arguments, in the same order as for the command itself.
+
+        Returns:
+            float: The predicted duration in seconds, or None if the device cannot predict the command
+                (e.g. 'Dose', whose burst count depends on how the powder flows).
+
+        Behavior:
+            - Except for 'ScaleOn', the device reports the actual duration after the next run of the command;
+              read it with `get_actual()`.
+        """
+        fields = ",".join(str(field) for field in (command,) + args)
+        self.clear_serial_buffer()
+        self.send_to_arduino(f"<Predict,{fields}>")
+        msg = ""
+        while "Predict" not in msg:
+            while self.ser.in_waiting == 0:  # Wait for data in the Serial buffer.
+                pass
+            msg = self.recv_from_arduino()
+        if "ms:" not in msg:
+            print(f"Device cannot predict: {command}")
+            return None
+        return float(msg.split("ms:")[1].split()[0]) / 1000.0
+
+    def get_actual(self):
+        """
+        Reads the actual-versus-predicted report sent after a predicted command completes.
+
+        Returns:
+            tuple: (actual, predicted) durations in seconds, or None if the report could not be parsed.
+        """
+        msg = ""
+        while "Actual" not in msg:
+            while self.ser.in_waiting == 0:  # Wait for data in the Serial buffer.
+                pass
+            msg = self.recv_from_arduino()
+        try:
+            actual_ms = float(msg.split("ms:")[1].split()[0])
+            predicted_ms = float(msg.split("predicted:")[1].split()[0])
+            return actual_ms / 1000.0, predicted_ms / 1000.0
+        except (IndexError, ValueError) as e:
+            print(f"Error parsing actual duration from message: {msg}")
+            print(f"Exception: {e}")
+            return None
+
+    def status(self):
+        """
+        Queries the device state. Answered at once, even while a mix, pump run or dispense is running.
+
+        Returns:
+            dict: 'busy' (the running command, or None), 'pending' (queued commands), 'scale' (scale
+                  state: 0 off, 1 standby, 2 settling, 3 ready) and 'dispenser' (True if enabled).
+        """
+        self.send_to_arduino("<Status>")  # No buffer clear: replies of a running command may be waiting.
+        msg = ""
+        while "Status" not in msg:
+            while self.ser.in_waiting == 0:  # Wait for data in the Serial buffer.
+                pass
+            msg = self.recv_from_arduino()
+        fields = dict(field.split(":", 1) for field in msg.split() if ":" in field)
+        return {
+            'busy': None if fields.get('busy', '-') == '-' else fields['busy'],
+            'pending': int(fields.get('pending', 0)),
+            'scale': int(fields.get('scale', 0)),
+            'dispenser': fields.get('dispenser') == '1',
+        }
+
+    def get_caps(self, timeout=1.0):
+        """
+        Queries the device's protocol capabilities (`<Caps>`, answered at once).
+
+        Parameters:
+            timeout (float, optional): Seconds to wait before treating the device as firmware
+                without `<Caps>` (default: 1.0).
+
+        Returns:
+            caps.DeviceCaps: The capabilities, or `caps.LEGACY_CAPS` for firmware without `<Caps>`.
+        """
+        self.send_to_arduino("<Caps>")
+        deadline = time.time() + timeout
+        while time.time() < deadline:
+            if self.ser.in_waiting == 0:
+                time.sleep(0.005)
+                continue
+            msg = self.recv_from_arduino(timeout)
+            if msg.startswith("Caps "):
+                return caps.parse_caps(msg)
+            if "Msg Caps" in msg:  # Queued and acknowledged as an unknown command.
+                break
+        print("Device does not report capabilities; using protocol version 1.")
+        return caps.LEGACY_CAPS
+
+    def idle_sleep(self, enabled=None):
+        """
+        Reports, and optionally sets, the device's idle policy: sleeping between main loop passes
+        or the busy loop (the default). Answered at once.
+
+        Parameters:
+            enabled (bool, optional): True to sleep, False to busy-loop; None only reports.
+
+        Returns:
+            dict: 'enabled', 'sleeps' and 'asleep_pct' (share of the time spent asleep) since the
+                  last report, and the report window 'seconds'.
+        """
+        self.send_to_arduino("<Idle>" if enabled is None else f"<Idle,{int(enabled)}>")
+        msg = ""
+        while "Idle on" not in msg:
+            while self.ser.in_waiting == 0:  # Wait for data in the Serial buffer.
+                pass
+            msg = self.recv_from_arduino()
+        fields = dict(field.split(":", 1) for field in msg.split() if ":" in field)
+        return {
+            'enabled': fields.get('on') == '1',
+            'sleeps': int(fields.get('sleeps', 0)),
+            'asleep_pct': float(fields.get('asleep', 0)),
+            'seconds': int(fields.get('ms', 0)) / 1000.0,
+        }
+
+    def abort(self):
+        """
+        Stops the running command at its next wait or stepper chunk and drops the queued commands.
+        The aborted command still sends its normal reply when it returns.
+        """
+        self.send_to_arduino("<Abort>")
+        print("Sent from PC -- ABORT")
+
+    def batch_start(self, batch_id):
+        """
+        Starts a batch checkpoint on the device. From now on, the device saves the completed step count,
+        the dispensed mass per channel and the tare baseline to EEPROM after every dose, mix, drain or pump run.
+
+        Parameters:
+            batch_id (int): Batch identifier between 1 and 65535, reported back by `resume()`.
+        """
+        self.run_command(f"<BatchStart,{int(batch_id)}>")
+
+    def batch_end(self):
+        """
+        Ends the batch checkpoint, so a later `resume()` finds nothing to continue.
+        """
+        self.run_command("<BatchEnd>")
+
+    def resume(self):
+        """
+        Reads the checkpoint of a batch interrupted by a device reset and restores its tare baseline.
+        Skip the first `step` recipe steps of batch `batch` to continue it.
+
+        Returns:
+            dict: 'batch', 'step', 'zero' and 'mass' (grams per channel), or None if no batch is active.
+        """
+        self.clear_serial_buffer()
+        self.send_to_arduino("<Resume>")
+        msg = ""
+        while "Resume" not in msg:
+            while self.ser.in_waiting == 0:  # Wait for data in the Serial buffer.
+                pass
+            msg = self.recv_from_arduino()
+        if "batch:" not in msg:
+            return None
+        fields = dict(field.split(":", 1) for field in msg.strip("<>").split() if ":" in field)
+        return {
+            'batch': int(fields['batch']),
+            'step': int(fields['step']),
+            'zero': int(fields['zero']),
+            'mass': [float(m) for m in fields['mass'].split(',')],
+        }
+
+    def refill(self, channel=0, grams=0, warn_grams=0):
+        """
+        Tells the device a hopper was refilled, restarting its level and flow estimate.
+        The estimate is kept in device RAM only; call this again after the device resets.
+
+        Parameters:
+            channel (int, optional): Auger channel (default: 0).
+            grams (float, optional): Mass now in the hopper; 0 if unknown (default: 0).
+            warn_grams (float, optional): Remaining mass that raises the refill warning; 0 uses 10% of `grams`.
+        """
+        self.run_command(f"<Refill,{channel},{grams},{warn_grams}>")
+
+    def report_flow(self, channel, grams):
+        """
+        Reports the measured mass of the last dispenser move so the device can track the flow per step.
+        Moves shorter than 100 steps are ignored by the device.
+
+        Parameters:
+            channel (int): Auger channel of the last move.
+            grams (float): Mass measured on the scale for that move.
+        """
+        self.run_command(f"<Flow,{channel},{grams}>")
+
+    def hopper_status(self, channel=0):
+        """
+        Queries the device's hopper estimate. Answered at once, even while a command is running.
+
+        Parameters:
+            channel (int, optional): Auger channel (default: 0).
+
+        Returns:
+            dict: 'steps' since refill, 'flow' (latest flow relative to a fresh hopper), 'remaining' grams
+                  and 'empty_time' (motor seconds to empty); the last two are None if unknown.
+        """
+        self.send_to_arduino(f"<Hopper,{channel}>")  # No buffer clear: replies of a running command may be waiting.
+        msg = ""
+        while "Hopper" not in msg:
+            while self.ser.in_waiting == 0:  # Wait for data in the Serial buffer.
+                pass
+            msg = self.recv_from_arduino()
+        fields = dict(field.split(":", 1) for field in msg.strip("<>").split() if ":" in field)
+        remaining = float(fields.get('remaining', -1))
+        empty_ms = float(fields.get('emptyMs', -1))
+        return {
+            'steps': int(fields.get('steps', 0)),
+            'flow': float(fields.get('flow', 1)),
+            'remaining': remaining if remaining >= 0 else None,
+            'empty_time': empty_ms / 1000.0 if empty_ms >= 0 else None,
+        }
+
+    def dose(self, grams, channel=0):
+        """
+        Dispenses a target mass with the device's own scale feedback loop (`<Dose>`).
+
+        Parameters:
+            grams (float): Target mass in grams.
+            channel (int, optional): Auger channel (default: 0).
+
+        Returns:
+            dict: Measured 'mass' in grams, feedback 'bursts', dose 'time' in seconds and 'completed'.
+
+        Raises:
+            RuntimeError: If the firmware has no `<Dose>`; use `dispense_powder_seq()` instead.
+            ValueError: If the device rejected the target mass or the channel.
+        """
+        if not self.caps.supports('Dose'):
+            raise RuntimeError("The device firmware has no <Dose>; use dispense_powder_seq().")
+        self.send_to_arduino(f"<Dose,{grams},{channel}>")
+        msg = ""
+        while "Dose target" not in msg and "Dose error" not in msg:
+            while self.ser.in_waiting == 0:  # The dose runs on the device; wait for its report.
+                pass
+            msg = self.recv_from_arduino()
+        ack = ""
+        while "Msg Dose" not in ack:  # Drain the acknowledgement so the next dose does not read it.
+            ack = self.recv_from_arduino()
+        if "Dose error" in msg:
+            raise ValueError(f"The device rejected the dose ({_fields(msg)['error']}).")
+        return _parse_dose(msg)
+
+    def queue_dose(self, grams, channel=0):
+        """
+        Queues a dose on the device; queued doses start one per vessel placed on the scale once
+        auto-dosing is armed (`auto_dose()`). Answered at once, also while a dose runs.
+
+        Parameters:
+            grams (float): Target mass in grams; 0 clears the queue.
+            channel (int, optional): Auger channel (default: 0).
+
+        Returns:
+            int: Doses now queued.
+
+        Raises:
+            RuntimeError: If the firmware has no dose queue, or the queue is full.
+        """
+        if not self.caps.supports('DoseQueue'):
+            raise RuntimeError("The device firmware has no <DoseQueue>; send dose() per vessel instead.")
+        self.send_to_arduino(f"<DoseQueue,{grams},{channel}>")
+        msg = ""
+        while "DoseQueue queued" not in msg:
+            while self.ser.in_waiting == 0:  # Wait for data in the Serial buffer.
+                pass
+            msg = self.recv_from_arduino()
+        if "full" in msg:
+            raise RuntimeError(f"The device dose queue is full: {msg}")
+        return int(_fields(msg)['queued'])
+
+    def auto_dose(self, armed=True, step_grams=None, stable_ms=None):
+        """
+        Arms or disarms vessel placement detection. While armed, the device tares and starts the
+        next queued dose as soon as a vessel is placed and holds still, with no host round trip.
+
+        Parameters:
+            armed (bool, optional): True to arm (turns the scale on), False to disarm, None to only report.
+            step_grams (float, optional): Weight rise that counts as a vessel (device default: 1 g).
+            stable_ms (int, optional): How long the vessel must hold still (device default: 500 ms).
+
+        Returns:
+            dict: Detector 'state' (0 disarmed, 1 waiting, 2 settling, 3 vessel detected),
+                  'step_grams', 'stable_ms' and 'queued' doses.
+        """
+        if armed is None:
+            frame = "<AutoDose>"
+        else:
+            args = [int(armed)] + [value for value in (step_grams, stable_ms) if value is not None]
+            if stable_ms is not None and step_grams is None:
+                raise ValueError("Give step_grams along with stable_ms.")
+            frame = "<AutoDose," + ",".join(str(value) for value in args) + ">"
+        self.send_to_arduino(frame)
+        msg = ""
+        while "AutoDose state" not in msg:
+            while self.ser.in_waiting == 0:  # Wait for data in the Serial buffer.
+                pass
+            msg = self.recv_from_arduino()
+        fields = _fields(msg)
+        return {
+            'state': int(fields['state']),
+            'step_grams': float(fields['step']),
+            'stable_ms': int(fields['stable']),
+            'queued': int(fields['queued']),
+        }
+
+    def wait_auto_dose(self, timeout=None):
+        """
+        Waits for the device to detect a vessel and finish the queued dose it starts.
+
+        Parameters:
+            timeout (float, optional): Seconds to wait; None waits indefinitely.
+
+        Returns:
+            dict: The dose result as from `dose()`, plus the 'vessel' weight in grams; None on timeout.
+                  A vessel placed with nothing queued is skipped.
+
+        Raises:
+            ValueError: If the device rejected the queued dose's target mass or channel.
+        """
+        deadline = None if timeout is None else time.monotonic() + timeout
+        vessel = None
+        while deadline is None or time.monotonic() < deadline:
+            if self.ser.in_waiting == 0:  # Wait for data in the Serial buffer.
+                time.sleep(0.005)
+                continue
+            msg = self.recv_from_arduino()
+            if "Vessel g" in msg:
+                vessel = float(_fields(msg)['g'])
+            elif "Dose target" in msg and vessel is not None:
+                return dict(_parse_dose(msg), vessel=vessel)
+            elif "Dose error" in msg and vessel is not None:
+                raise ValueError(f"The device rejected the queued dose ({_fields(msg)['error']}).")
+        return None
+
+    def set_dose_params(self, params):
+        """
+        Stores dose controller parameters on the device (EEPROM), e.g. the result of `dose_optimizer`.
+
+        Parameters:
+            params (dict): 'initial', 'phases', 'steps', 'settle_ms', 'samples', 'max_bursts' and
+                'approach' (see `dose_optimizer.DEFAULT_PARAMS`).
+
+        Returns:
+            str: The parameters the device reports afterwards (unchanged if `params` were rejected).
+        """
+        self.send_to_arduino(to_frame(params))
+        msg = ""
+        while "DoseParam initial" not in msg:
+            while self.ser.in_waiting == 0:  # Wait for data in the Serial buffer.
+                pass
+            msg = self.recv_from_arduino()
+        return msg
+
+    def load_device_config(self, channels=None, load_cell=None, revision=0):
+        """
+        Compiles the loaded configuration into the device's configuration image (see `devconfig`)
+        and flashes it. The device applies the auger calibrations of `channels` at once and the
+        scale settings and load cell calibration from its next startup.
+
+        Parameters:
+            channels (dict, optional): Auger channel to 'auger/powder' calibration, e.g.
+                {0: '8mm_base/dishwasher_salt'}.
+            load_cell (str, optional): Load cell used by the scale (default: the first configured).
+            revision (int, optional): Revision number reported by `<Cfg>`.
+
+        Returns:
+            str: The device's `CfgLoad ok` report.
+        """
+        image = devconfig.compile_config(self.powder_config, channels, load_cell, revision)
+        msg = self.send_config_image(image)
+        for channel, name in (channels or {}).items():
+            augerType, powderType = name.split('/', 1)
+            self.deviceAugerCal[channel] = self.powder_config['calibration']['augers'][augerType][powderType]
+        return msg
+
+    def send_config_image(self, image):
+        """
+        Flashes a configuration image to the device in one `<CfgLoad>` transfer.
+
+        Parameters:
+            image (bytes): The image (see `devconfig.compile_config()`).
+
+        Returns:
+            str: The device's `CfgLoad ok` report.
+
+        Raises:
+            RuntimeError: If the device rejects the image or the transfer fails.
+
+        Behavior:
+            - Waits for `<CfgLoad ready>`, then writes the raw image paced to the device's EEPROM
+              write rate (`devconfig.FLASH_BYTES_PER_S`), about 2 s for a full image, in chunks of at
+              most a quarter of the device's receive FIFO.
+        """
+        if not self.caps.supports('CfgLoad'):
+            raise RuntimeError("The device firmware has no <CfgLoad>.")
+        chunk = max(1, min(devconfig.FLASH_CHUNK_BYTES, self.caps.serial_bytes // 4))
+        self.send_to_arduino(f"<CfgLoad,{len(image)},{devconfig.crc16(image)}>")
+        msg = ""
+        while "CfgLoad" not in msg:
+            while self.ser.in_waiting == 0:  # Wait for the device to be ready for the image.
+                pass
+            msg = self.recv_from_arduino()
+        if "ready" not in msg:
+            raise RuntimeError(f"Device refused the configuration image: {msg}")
+
+        for start in range(0, len(image), chunk):
+            self._write_raw(image[start:start + chunk])
+            time.sleep(chunk / devconfig.FLASH_BYTES_PER_S)
+
+        msg = ""
+        while "CfgLoad" not in msg:
+            while self.ser.in_waiting == 0:  # Wait for the device to store and check the image.
+                pass
+            msg = self.recv_from_arduino()
+        if "CfgLoad ok" not in msg:
+            raise RuntimeError(f"Configuration image not stored: {msg}")
+        return msg
+
 ### CONTROL FUNCTIONS ##############################
     def set_mixTime(self, mixTime):
         """
@@ -270,7 +737,7 @@ class PowderDispenseController:
 
 ### Single Control Functions
     ## Dispense controller functions
-    def dispense(self, amount_or_steps, direction=None, runSteps=False, augerType=None, powderType=None):
+    def dispense(self, amount_or_steps, direction=None, runSteps=False, augerType=None, powderType=None, channel=0):
         """
         Controls the dispenser to dispense a specified amount or number of steps of powder.
 
@@ -280,6 +747,16 @@ class PowderDispenseController:
             runSteps (bool, optional): If True, the input is treated as the number of steps; if False, as the amount in grams.
             augerType (str, optional): The type of auger to use for the operation.
             powderType (str, optional): The type of powder to be dispensed.
+            channel (int, optional): Device auger channel holding the calibration for mass dispensing (default: 0).
+
+        Behavior:
+            - Steps are sent with `<Dispense>`.
+            - Masses are sent with `<DispenseMass>`; the device converts them with its own calibration and
+              runs the whole dose from one command. The channel calibration is synced first if needed.
+            - The device drives a move as driver commands of about 10 ms each and serves status
+              queries and `<Abort>` between them, so they are answered within about 10 ms and the
+              auger pauses briefly between driver commands. Commands are not re-sent per chunk.
+            - Firmware without `<DispenseMass>` gets the mass converted to steps here instead.
         """
         # Use defaults if no specific auger or powder type is provided.
         augerType = augerType or self.DEFAULT_augerType
@@ -287,15 +764,32 @@ class PowderDispenseController:
         direction = direction or self.dispenseDir
 
         if runSteps:
-            # Use the specified number of steps directly.
-            neededSteps = amount_or_steps
-        else:
-            # Calculate the number of steps based on the desired amount and calibration factor.
+            # Send the step count directly to the Arduino.
+            self.run_command(f"<Dispense,{int(amount_or_steps)},{direction}>")
+        elif not self.caps.supports('DispenseMass'):
+            # Older firmware: convert grams to steps with the host's calibration.
             augCalFactor = self.powder_config['calibration']['augers'][augerType][powderType]
-            neededSteps = amount_or_steps / augCalFactor
+            self.run_command(f"<Dispense,{int(round(amount_or_steps / augCalFactor))},{direction}>")
+        else:
+            # Let the device convert grams to steps with the calibration of the selected channel.
+            self.sync_auger_cal(channel, augerType, powderType)
+            self.run_command(f"<DispenseMass,{amount_or_steps},{channel}>")
 
-        # Send the dispense command to the Arduino.
-        self.run_command(f"<Dispense,{neededSteps},{direction}>")
+    def sync_auger_cal(self, channel, augerType=None, powderType=None):
+        """
+        Loads the calibration factor of an auger/powder pair into a device channel, if it is not already there.
+
+        Parameters:
+            channel (int): Device auger channel.
+            augerType (str, optional): The auger type. Defaults to the default auger type.
+            powderType (str, optional): The powder type. Defaults to the default powder type.
+        """
+        augerType = augerType or self.DEFAULT_augerType
+        powderType = powderType or self.DEFAULT_powderType
+        augCalFactor = self.powder_config['calibration']['augers'][augerType][powderType]
+        if self.deviceAugerCal.get(channel) != augCalFactor:
+            self.run_command(f"<AugerCal,{channel},{augCalFactor}>")
+            self.deviceAugerCal[channel] = augCalFactor
 
     def enableStepper(self):
         """
@@ -348,16 +842,38 @@ class PowderDispenseController:
 
     def scaleOn(self, settle_time=5):
         """
-        Turns on the scale and waits for it to settle.
+        Turns on the scale and waits until the device reports the first stable sample.
         Only turns on the scale if it is not already on, to prevent redundant operations.
 
         Parameters:
-            settle_time (int, optional): Time in seconds to wait after turning on the scale. Defaults to 5 seconds.
+            settle_time (int, optional): Maximum time in seconds to wait for the ready report. Defaults to 5 seconds.
         """
         if not self.isScaleOn:  # Only power on the scale if it is currently off.
             self.run_command(f"<ScaleOn>")
             self.isScaleOn = True
-            time.sleep(settle_time)  # Allow time for the scale to stabilize.
+            self.wait_for_scale_ready(settle_time)  # Returns as soon as the scale has settled.
+
+    def wait_for_scale_ready(self, timeout=5):
+        """
+        Waits for the `<ScaleReady>` report sent once the scale delivers its first stable sample.
+
+        Parameters:
+            timeout (float, optional): Maximum time in seconds to wait. Defaults to 5 seconds.
+
+        Returns:
+            bool: True if the scale reported ready, False if the timeout expired.
+        """
+        start_time = time.time()
+        while time.time() - start_time < timeout:
+            if self.ser.in_waiting == 0:  # Wait for data in the Serial buffer.
+                time.sleep(0.005)
+                continue
+            msg = self.recv_from_arduino(timeout)
+            if "ScaleReady" in msg:
+                return True
+            print(f"Received message does not contain 'ScaleReady': {msg}")  # Log unexpected messages.
+        print("Scale did not report ready within timeout.")
+        return False
 
     def scaleOff(self):
         """
@@ -368,6 +884,25 @@ class PowderDispenseController:
             self.run_command(f"<ScaleOff>")
             self.isScaleOn = False
 
+    def setScaleIdle(self, idle_time):
+        """
+        Sets how long the scale stays in warm standby before the device fully powers it down.
+
+        Parameters:
+            idle_time (float): Idle time in seconds; 0 keeps the scale in standby indefinitely.
+        """
+        self.run_command(f"<ScaleIdle,{idle_time}>")
+
+    def setAfeCalInterval(self, interval):
+        """
+        Sets how often the device recalibrates the scale's analog front end to correct offset drift.
+        Recalibration only runs while the device is idle, so it never interrupts a dose.
+
+        Parameters:
+            interval (float): Time between recalibrations in seconds; 0 disables them.
+        """
+        self.run_command(f"<AfeCal,{interval}>")
+
     def tare(self):
         """
         Tares the scale, setting the current weight as the zero reference point.
@@ -621,9 +1156,11 @@ class PowderDispenseController:
 
         # Iteratively dispense smaller amounts based on remaining weight.
         while current_amount < desired_amount * 0.80:
+            previous_amount = current_amount
             self.dispense(400, direction=self.dispenseDir, runSteps=True)  # Dispense steps in chunks.
             time.sleep(1)
             current_amount = self.measWeight()  # Update the current weight.
+            self.report_flow(0, current_amount - previous_amount)  # Feed the device's hopper estimate.
 
         while current_amount < desired_amount * 0.97:
             self.dispense(20, direction=self.dispenseDir, runSteps=True)  # Fine-tune with smaller steps.
@@ -676,4 +1213,20 @@ class PowderDispenseController:
 
         self.scaleOff()
         self.disableStepper()
-        print("Sensitivity test complete.")
\ No newline at end of file
+        print("Sensitivity test complete.")
+
+
+def _fields(msg):
+    """Parses the 'name:value' fields of a reply such as '<Dose target:1 mass:0.98 ...>'."""
+    return dict(field.split(":", 1) for field in msg.strip("<>").split() if ":" in field)
+
+
+def _parse_dose(msg):
+    """Parses a `<Dose target:T mass:M bursts:B ms:D>` report (see `dose()`)."""
+    fields = _fields(msg)
+    return {
+        'mass': float(fields['mass']),
+        'bursts': int(fields['bursts']),
+        'time': int(fields['ms']) / 1000.0,
+        'completed': 'incomplete' not in msg,
+    }
@@ -0,0 +1,239 @@
+"""
+Compiles `config.json` into the device's configuration image (firmware `DeviceConfig`, see
+`PowderDispenserCPP/include/DeviceConfig.h`).
+
+The image holds the augers, load cells, pumps, calibration weights and constants of the
+configuration in a versioned, CRC-checked binary layout of at most 384 bytes, flashed to the
+device's EEPROM in one `<CfgLoad>` transfer (`PowderDispenseController.load_device_config()`).
+The firmware applies the scale settings and the active load cell calibration at startup and the
+auger calibrations of assigned channels at once.
+
+Functions:
+    compile_config(config, channels=None, load_cell=None, revision=0) - Builds the image.
+    decode_image(image) - Parses an image back into its sections, e.g. to check one.
+    crc16(data) - CRC-16/CCITT used by the image and `<CfgLoad>`.
+
+Command line:
+    python -m PowderDispenserController.devconfig config.json -o config.pdcf
+        [--channel 0=8mm_base/dishwasher_salt] [--load-cell 20g] [--revision N] [--port PORT]
+"""
+
+import argparse
+import binascii
+import re
+import struct
+
+from .utils import get_config
+
+MAGIC = b'PDCF'
+FORMAT_VERSION = 1
+HEADER = struct.Struct('<4sBBHHH')  # magic, version, sections, payload bytes, payload CRC, revision.
+MAX_BYTES = 384                     # DeviceConfig::maxBytes.
+FLASH_BYTES_PER_S = 160             # Below the device's EEPROM write rate (about 300 bytes/s).
+FLASH_CHUNK_BYTES = 16              # Well inside the device's 64-byte receive buffer.
+
+CFG_SCALE = 1
+CFG_LOAD_CELL = 2
+CFG_AUGER = 3
+CFG_PUMP = 4
+CFG_CONSTANTS = 5
+CFG_DEFAULTS = 6
+CFG_WEIGHT = 7
+
+NO_CHANNEL = 0xFF
+I2C_PIN = 0xFF
+FILTER_CODES = {'NONE': 0, 'EWMA': 1, 'SMA': 2, 'LPF': 3}  # Firmware FilterType.
+UNIT_GRAMS = {'g': 1.0, 'mg': 1e-3, 'kg': 1e3}
+
+_SCALE = struct.Struct('<HBBBBBB')
+_LOAD_CELL = struct.Struct('<HffB')
+_AUGER = struct.Struct('<Bf')
+_PUMP = struct.Struct('<Bff')
+_CONSTANTS = struct.Struct('<ffbBB')
+_DEFAULTS = struct.Struct('<HHHBBB')
+_WEIGHT = struct.Struct('<f')
+
+
+def crc16(data, crc=0xFFFF):
+    """Returns the CRC-16/CCITT (polynomial 0x1021, initial value 0xFFFF) of `data`."""
+    return binascii.crc_hqx(bytes(data), crc)
+
+
+def _section(tag, payload):
+    if len(payload) > 255:
+        raise ValueError(f"Section {tag} is too long ({len(payload)} bytes).")
+    return bytes((tag, len(payload))) + payload
+
+
+def _name(text, limit=24):
+    return text.encode('ascii', 'replace')[:limit]
+
+
+def _grams(label):
+    """Parses a capacity label like '100g' into grams (0 if it has no number)."""
+    match = re.match(r'\s*([\d.]+)\s*(mg|kg|g)?', str(label))
+    if not match:
+        return 0
+    return float(match.group(1)) * UNIT_GRAMS[match.group(2) or 'g']
+
+
+def compile_config(config, channels=None, load_cell=None, revision=0):
+    """
+    Builds the configuration image of a parsed `config.json`.
+
+    Parameters:
+        config (dict): The configuration (see `utils.get_config()`).
+        channels (dict, optional): Auger channel to 'auger/powder' calibration, e.g.
+            {0: '8mm_base/dishwasher_salt'}. Unassigned calibrations are still stored.
+        load_cell (str, optional): Load cell whose calibration the scale uses (default: the first).
+        revision (int, optional): Revision number reported by `<Cfg>` (0 to 65535).
+
+    Returns:
+        bytes: The image.
+
+    Raises:
+        KeyError: If `channels` or `load_cell` names an entry the configuration does not have.
+        ValueError: If the image exceeds the device's EEPROM region.
+    """
+    calibration = config.get('calibration', {})
+    constants = config.get('constants', {})
+    defaults = config.get('default_constants', {})
+    channel_of = {name: channel for channel, name in (channels or {}).items()}
+    sections = []
+
+    sections.append(_section(CFG_SCALE, _SCALE.pack(
+        int(constants.get('scaleSamplerate', defaults.get('DEFAULT_SCALE_SAMPLERATE', 320))),
+        int(constants.get('scaleGain', defaults.get('DEFAULT_SCALE_GAIN', 128))),
+        int(constants.get('scaleLDOVoltage', defaults.get('DEFAULT_SCALE_LDOVOLTAGE', 3))),
+        FILTER_CODES.get(str(constants.get('scaleFilterType', 'EWMA')).upper(), FILTER_CODES['EWMA']),
+        int(bool(calibration.get('scaleSinglePointCal', False))),
+        int(constants.get('numMeas', 5)),
+        int(constants.get('numReadings', 10)))))
+
+    load_cells = calibration.get('loadCells', {})
+    if load_cell is not None and load_cell not in load_cells:
+        raise KeyError(f"No load cell '{load_cell}' in the configuration.")
+    active = load_cell if load_cell is not None else next(iter(load_cells), None)
+    for name, cell in load_cells.items():
+        sections.append(_section(CFG_LOAD_CELL, _LOAD_CELL.pack(
+            int(_grams(name)), cell['Slope'], cell['Intercept'], int(name == active))))
+
+    known = set()
+    for auger, powders in calibration.get('augers', {}).items():
+        for powder, grams_per_step in powders.items():
+            name = f'{auger}/{powder}'
+            known.add(name)
+            sections.append(_section(CFG_AUGER, _AUGER.pack(channel_of.get(name, NO_CHANNEL), grams_per_step)
+                                     + _name(name)))
+    missing = set(channel_of) - known
+    if missing:
+        raise KeyError(f"No auger calibration for {', '.join(sorted(missing))} in the configuration.")
+
+    for name, pump in calibration.get('pumps', {}).items():
+        pin = pump.get('pin')
+        sections.append(_section(CFG_PUMP, _PUMP.pack(pin if isinstance(pin, int) else I2C_PIN,
+                                                      pump.get('a', 0), pump.get('b', 0)) + _name(name)))
+
+    sections.append(_section(CFG_CONSTANTS, _CONSTANTS.pack(
+        float(constants.get('mixTime', 10.0)), float(constants.get('drainTime', 10.0)),
+        int(constants.get('dispenseDir', 1)), int(bool(constants.get('allowNegative', True))),
+        int(constants.get('decimal', 4)))))
+
+    sections.append(_section(CFG_DEFAULTS, _DEFAULTS.pack(
+        int(defaults.get('DEFAULT_AVG_READING_SAMPLES', 100)), int(defaults.get('DEFAULT_AVG_WEIGHT_SAMPLES', 100)),
+        int(defaults.get('DEFAULT_TIMEOUT_MS', 1000)), int(defaults.get('DEFAULT_REPS', 3)),
+        int(defaults.get('DEFAULT_SAMPLES', 3)), int(defaults.get('DEFAULT_SCALE_CALMODE', 1)))))
+
+    for weight in calibration.get('weights', []):
+        grams = float(weight['value']) * UNIT_GRAMS[weight.get('unit', 'g')]
+        sections.append(_section(CFG_WEIGHT, _WEIGHT.pack(grams)))
+
+    payload = b''.join(sections)
+    image = HEADER.pack(MAGIC, FORMAT_VERSION, len(sections), len(payload), crc16(payload), revision) + payload
+    if len(image) > MAX_BYTES:
+        raise ValueError(f"The configuration image takes {len(image)} bytes; the device holds {MAX_BYTES}.")
+    return image
+
+
+def decode_image(image):
+    """
+    Parses an image into its sections.
+
+    Returns:
+        dict: 'revision', 'scale', 'load_cells', 'augers', 'pumps', 'constants', 'defaults' and
+        'weights', with the values as stored (floats in single precision).
+
+    Raises:
+        ValueError: If the header or CRC is wrong.
+    """
+    magic, version, count, length, crc, revision = HEADER.unpack_from(image)
+    payload = bytes(image[HEADER.size:HEADER.size + length])
+    if magic != MAGIC or version != FORMAT_VERSION or len(payload) != length or crc16(payload) != crc:
+        raise ValueError("Not a valid configuration image.")
+    result = {'revision': revision, 'scale': None, 'load_cells': [], 'augers': [], 'pumps': [], 'constants': None,
+              'defaults': None, 'weights': []}
+    offset = 0
+    for _ in range(count):
+        tag, size = payload[offset], payload[offset + 1]
+        data = payload[offset + 2:offset + 2 + size]
+        offset += 2 + size
+        if tag == CFG_SCALE:
+            rate, gain, ldo, filt, single, meas, readings = _SCALE.unpack_from(data)
+            result['scale'] = {'sample_rate': rate, 'gain': gain, 'ldo_voltage': ldo, 'filter': filt,
+                               'single_point_cal': bool(single), 'num_meas': meas, 'num_readings': readings}
+        elif tag == CFG_LOAD_CELL:
+            capacity, slope, intercept, active = _LOAD_CELL.unpack_from(data)
+            result['load_cells'].append({'capacity_g': capacity, 'slope': slope, 'intercept': intercept,
+                                         'active': bool(active)})
+        elif tag == CFG_AUGER:
+            channel, grams_per_step = _AUGER.unpack_from(data)
+            result['augers'].append({'name': data[_AUGER.size:].decode('ascii'), 'grams_per_step': grams_per_step,
+                                     'channel': None if channel == NO_CHANNEL else channel})
+        elif tag == CFG_PUMP:
+            pin, a, b = _PUMP.unpack_from(data)
+            result['pumps'].append({'name': data[_PUMP.size:].decode('ascii'), 'a': a, 'b': b,
+                                    'pin': 'I2C' if pin == I2C_PIN else pin})
+        elif tag == CFG_CONSTANTS:
+            mix, drain, direction, negative, decimal = _CONSTANTS.unpack_from(data)
+            result['constants'] = {'mix_time': mix, 'drain_time': drain, 'dispense_dir': direction,
+                                   'allow_negative': bool(negative), 'decimal': decimal}
+        elif tag == CFG_DEFAULTS:
+            reading, weight, timeout_ms, reps, samples, cal_mode = _DEFAULTS.unpack_from(data)
+            result['defaults'] = {'avg_reading_samples': reading, 'avg_weight_samples': weight,
+                                  'timeout_ms': timeout_ms, 'reps': reps, 'samples': samples, 'cal_mode': cal_mode}
+        elif tag == CFG_WEIGHT:
+            result['weights'].append(_WEIGHT.unpack_from(data)[0])
+    return result
+
+
+def _parse_channel(text):
+    channel, _, name = text.partition('=')
+    if not name:
+        raise argparse.ArgumentTypeError("expected CHANNEL=AUGER/POWDER")
+    return int(channel), name
+
+
+def main(argv=None):
+    parser = argparse.ArgumentParser(description="Compile config.json into the device's configuration image.")
+    parser.add_argument('config', help="configuration file (comments allowed)")
+    parser.add_argument('-o', '--output', help="image file to write")
+    parser.add_argument('--channel', type=_parse_channel, action='append', default=[],
+                        help="assign an auger calibration to a channel, e.g. 0=8mm_base/dishwasher_salt")
+    parser.add_argument('--load-cell', help="load cell used by the scale (default: the first)")
+    parser.add_argument('--revision', type=int, default=0, help="revision reported by <Cfg>")
+    parser.add_argument('--port', help="flash the image to the device on this serial port")
+    args = parser.parse_args(argv)
+
+    image = compile_config(get_config(args.config), dict(args.channel), args.load_cell, args.revision)
+    print(f"{len(image)} bytes, CRC 0x{crc16(image):04x}")
+    if args.output:
+        with open(args.output, 'wb') as file:
+            file.write(image)
+    if args.port:
+        from .controller import PowderDispenseController
+        controller = PowderDispenseController(args.port, config_file=args.config)
+        print(controller.send_config_image(image))
+
+
+if __name__ == '__main__':
+    main()
@@ -0,0 +1,395 @@
+"""
+Host tool that tunes the on-device dose controller (`<Dose>`) against the native simulator.
+
+The dose runs an initial open-loop move followed by three phases of bursts, each covering a share
+of the remaining gap but at least the phase's step count (see `DoseParams` in the firmware). This
+module searches those parameters, including the share, with a separable CMA-ES, scoring each
+candidate by simulating the scenario corpus of the firmware's regression suite with the firmware
+built for `pio run -e native`. Candidates that miss the accuracy target in any scenario are penalized, so
+the search minimizes the mean dose time among parameter sets that meet it. The result is printed
+as a `<DoseParam,...>` frame, which the device stores in EEPROM.
+
+Functions:
+    encode(params) / decode(x) - Map parameter sets to and from the unit search cube.
+    to_frame(params) - Formats a parameter set as a `<DoseParam,...>` command.
+    load_scenarios(path) - Reads the scenario corpus of the firmware's scenario test suite.
+    simulate(program, params, scenario) - Runs one dose on the simulator.
+    score(results, tolerance_mg) - Mean dose time with a penalty for inaccurate or unfinished doses.
+    optimize(program, scenarios, ...) - Runs the CMA-ES search with parallel evaluations.
+
+Usage:
+    (cd PowderDispenserCPP && pio run -e native)
+    python -m PowderDispenserController.dose_optimizer --tolerance 3 --generations 40
+    python -m PowderDispenserController.dose_optimizer --tolerance 3 --port COM3  # Store the result.
+"""
+
+import argparse
+import json
+import math
+import os
+import random
+import re
+import subprocess
+import time
+from concurrent.futures import ThreadPoolExecutor
+
+DEFAULT_PROGRAM = os.path.join(os.path.dirname(__file__), '..', 'PowderDispenserCPP', '.pio', 'build', 'native', 'program')
+DOSE_TIMEOUT_MS = 3600000  # Simulated time after which a dose counts as hung.
+FAILURE_PENALTY_MS = 1e6   # Added per scenario that misses the accuracy target or does not finish.
+
+# Firmware defaults (the hand-picked `dispense_powder_seq()` thresholds).
+DEFAULT_PARAMS = {
+    'initial': 0.50,
+    'phases': [0.80, 0.97, 0.99],
+    'steps': [400, 20, 5],
+    'settle_ms': 1000,
+    'samples': 100,
+    'max_bursts': 500,
+    'approach': 0.50,
+}
+
+# Search space: (name, low, high, logarithmic). Steps, settle time and samples are rounded.
+SPACE = [
+    ('initial', 0.20, 0.95, False),
+    ('phase0', 0.50, 0.99, False),
+    ('phase1', 0.80, 0.999, False),
+    ('phase2', 0.90, 1.00, False),
+    ('steps0', 50, 4000, True),
+    ('steps1', 2, 400, True),
+    ('steps2', 1, 50, True),
+    ('settle_ms', 200, 2000, False),
+    ('samples', 10, 200, True),
+    ('approach', 0.10, 1.00, False),
+]
+
+# The corpus of the firmware's scenario suite (`pio test -e native -f test_scenarios`), read by `load_scenarios()`.
+SCENARIOS_HEADER = os.path.join(os.path.dirname(__file__), '..', 'PowderDispenserCPP', 'test', 'test_scenarios',
+                                'scenarios.h')
+
+
+def load_scenarios(path=SCENARIOS_HEADER):
+    """
+    Reads the scenario corpus from the firmware's `scenarios.h`, so the optimizer scores exactly the
+    scenarios the regression suite checks.
+
+    Parameters:
+        path (str, optional): The header (default: the firmware's scenario suite).
+
+    Returns:
+        list: One dict per scenario, in corpus order: 'name', 'target' (g), 'cal' (the device auger
+              calibration in grams per microstep), 'seed' and 'world' (`sim::World` settings).
+
+    Behavior:
+    - Reads the field defaults of `struct Scenario`, then the `makeScenario(...)` calls and the field
+      assignments that follow them.
+    - Maps the fields the way `runScenario()` of the suite does: the true flow is the calibration
+      times `flowScale`.
+    """
+    with open(path) as file:
+        text = re.sub(r'//[^\n]*', '', file.read())
+
+    struct = re.search(r'struct Scenario \{(.*?)\};', text, re.S).group(1)
+    defaults = {name: value for name, value in re.findall(r'(\w+) = ([^;]+);', struct)}
+    corpus = {}
+    for index, name, target in re.findall(r'corpus\[(\d+)\] = makeScenario\("([^"]+)", ([^)]+)\);', text):
+        corpus[int(index)] = dict(defaults, name=name, targetG=target)
+    for index, field, value in re.findall(r'corpus\[(\d+)\]\.(\w+) = ([^;]+);', text):
+        corpus[int(index)][field] = value
+
+    scenarios = []
+    for index in sorted(corpus):
+        fields = {k: v if k == 'name' else float({'true': 1, 'false': 0}.get(v.strip(), v))
+                  for k, v in corpus[index].items()}
+        scenarios.append({
+            'name': fields['name'],
+            'target': fields['targetG'],
+            'cal': fields['gramsPerStep'],
+            'seed': int(fields['seed']),
+            'world': {
+                'gramsPerStep': fields['gramsPerStep'] * fields['flowScale'],
+                'flowNoise': fields['flowNoise'],
+                'scaleNoiseG': fields['scaleNoiseG'],
+                'mixerOn': int(fields['mixerRunning']),
+                'jamAfterSteps': int(fields['jamAfterSteps']),
+                'jamSteps': int(fields['jamSteps']),
+            },
+        })
+    return scenarios
+
+
+SCENARIOS = load_scenarios()
+
+
+def _to_unit(value, low, high, log):
+    if log:
+        value, low, high = math.log(value), math.log(low), math.log(high)
+    return (value - low) / (high - low)
+
+
+def _from_unit(u, low, high, log):
+    u = min(max(u, 0.0), 1.0)
+    if log:
+        return math.exp(math.log(low) + u * (math.log(high) - math.log(low)))
+    return low + u * (high - low)
+
+
+def encode(params):
+    """
+    Maps a parameter set into the unit search cube.
+
+    Parameters:
+        params (dict): Parameter set in the format of `DEFAULT_PARAMS`.
+
+    Returns:
+        list: One coordinate in [0, 1] per entry of `SPACE`.
+    """
+    values = [params['initial'], *params['phases'], *params['steps'], params['settle_ms'], params['samples'],
+              params['approach']]
+    return [_to_unit(min(max(v, low), high), low, high, log) for v, (_, low, high, log) in zip(values, SPACE)]
+
+
+def decode(x):
+    """
+    Maps a point of the search cube to a parameter set the firmware accepts.
+
+    Parameters:
+        x (list): Coordinates, clipped to [0, 1].
+
+    Returns:
+        dict: Parameter set with strictly rising phase fractions and an initial fraction below the
+              first phase.
+    """
+    values = [_from_unit(u, low, high, log) for u, (_, low, high, log) in zip(x, SPACE)]
+    phases = sorted(round(v, 3) for v in values[1:4])
+    for i in (1, 0):  # The firmware rejects equal phases; push ties down by the rounding step.
+        phases[i] = round(min(phases[i], phases[i + 1] - 0.001), 3)
+    return {
+        'initial': round(min(values[0], phases[0] - 0.01), 3),
+        'phases': phases,
+        'steps': [max(1, round(v)) for v in values[4:7]],
+        'settle_ms': round(values[7]),
+        'samples': min(255, round(values[8])),
+        'max_bursts': DEFAULT_PARAMS['max_bursts'],
+        'approach': round(values[9], 3),
+    }
+
+
+def to_frame(params):
+    """
+    Formats a parameter set as the `<DoseParam,...>` command that stores it on the device.
+    """
+    values = [params['initial'], *params['phases'], *params['steps'],
+              params['settle_ms'], params['samples'], params['max_bursts'], params['approach']]
+    return "<DoseParam," + ",".join(f"{v:g}" for v in values) + ">"
+
+
+def simulate(program, params, scenario, seed=1):
+    """
+    Runs one dose on the simulator.
+
+    Parameters:
+        program (str): The native simulator (`pio run -e native`).
+        params (dict): Dose parameters.
+        scenario (dict): Target, world settings and device calibration ('cal'), see `load_scenarios()`.
+        seed (int, optional): Random seed of the simulated world (default: 1).
+
+    Returns:
+        dict: 'ms' (simulated dose time), 'error_mg' (true mass minus target, in mg), 'bursts' and
+              'completed'.
+    """
+    lines = [f"!seed {seed}"]
+    lines += [f"!set {name} {value}" for name, value in scenario['world'].items()]
+    lines += [
+        to_frame(params), "!until <Msg",
+        f"<AugerCal,0,{scenario['cal']}>", "!until <Msg",
+        f"<Dose,{scenario['target']},0>", f"!until <Dose {DOSE_TIMEOUT_MS}",
+        "!run 1000",  # Let the last burst land.
+        "!mass", "!quit",
+    ]
+    output = subprocess.run([program], input="\n".join(lines) + "\n", capture_output=True, text=True,
+                            check=True).stdout
+
+    dose = re.search(r'<Dose target:\S+ mass:\S+ bursts:(\d+) ms:(\d+)( incomplete)?>', output)
+    mass = re.search(r'^!mass (\S+)', output, re.M)
+    if dose is None or mass is None:
+        return {'ms': DOSE_TIMEOUT_MS, 'error_mg': float('inf'), 'bursts': 0, 'completed': False}
+    return {
+        'ms': int(dose.group(2)),
+        'error_mg': (float(mass.group(1)) - scenario['target']) * 1000,
+        'bursts': int(dose.group(1)),
+        'completed': dose.group(3) is None,
+    }
+
+
+def score(results, tolerance_mg):
+    """
+    Scores the results of one parameter set over all scenarios (lower is better).
+
+    Parameters:
+        results (list): Results of `simulate()`.
+        tolerance_mg (float): Largest acceptable |error| of a dose.
+
+    Returns:
+        float: Mean dose time in ms, plus `FAILURE_PENALTY_MS` (scaled by the excess error) for each
+               dose that missed the tolerance or did not complete.
+    """
+    cost = sum(r['ms'] for r in results) / len(results)
+    for r in results:
+        excess = abs(r['error_mg']) / tolerance_mg
+        if not r['completed'] or excess > 1:
+            cost += FAILURE_PENALTY_MS * (1 + min(excess, 100.0))
+    return cost
+
+
+class SepCmaEs:
+    """
+    Separable CMA-ES (diagonal covariance; Ros and Hansen, 2008) on the unit cube.
+
+    Candidates are clipped to [0, 1] for evaluation; the distribution is updated with the
+    unclipped samples.
+    """
+
+    def __init__(self, x0, sigma0, population=None, seed=None):
+        self.n = n = len(x0)
+        self.rng = random.Random(seed)
+        self.mean = list(x0)
+        self.sigma = sigma0
+        self.lam = population or 4 + int(3 * math.log(n))
+        self.mu = self.lam // 2
+        weights = [math.log(self.mu + 0.5) - math.log(i + 1) for i in range(self.mu)]
+        total = sum(weights)
+        self.weights = [w / total for w in weights]
+        self.mueff = 1 / sum(w * w for w in self.weights)
+
+        self.cs = (self.mueff + 2) / (n + self.mueff + 5)
+        self.ds = 1 + 2 * max(0.0, math.sqrt((self.mueff - 1) / (n + 1)) - 1) + self.cs
+        self.cc = (4 + self.mueff / n) / (n + 4 + 2 * self.mueff / n)
+        c1 = 2 / ((n + 1.3) ** 2 + self.mueff)
+        cmu = 2 * (self.mueff - 2 + 1 / self.mueff) / ((n + 2) ** 2 + self.mueff)
+        self.c1 = min(1.0, c1 * (n + 2) / 3)  # The diagonal model learns faster.
+        self.cmu = min(1 - self.c1, cmu * (n + 2) / 3)
+        self.chin = math.sqrt(n) * (1 - 1 / (4 * n) + 1 / (21 * n * n))
+
+        self.diag = [1.0] * n  # Variances of the diagonal covariance.
+        self.ps = [0.0] * n
+        self.pc = [0.0] * n
+        self.generation = 0
+
+    def ask(self):
+        """Samples one population; returns (steps, candidates) where candidates are clipped to [0, 1]."""
+        self._steps = []
+        for _ in range(self.lam):
+            self._steps.append([math.sqrt(d) * self.rng.gauss(0, 1) for d in self.diag])
+        return [[min(max(m + self.sigma * y, 0.0), 1.0) for m, y in zip(self.mean, ys)] for ys in self._steps]
+
+    def tell(self, costs):
+        """Updates the distribution with the costs of the last `ask()` population (in order)."""
+        order = sorted(range(self.lam), key=lambda i: costs[i])
+        best = [self._steps[i] for i in order[:self.mu]]
+        yw = [sum(w * ys[k] for w, ys in zip(self.weights, best)) for k in range(self.n)]
+        self.mean = [m + self.sigma * y for m, y in zip(self.mean, yw)]
+
+        cs_norm = math.sqrt(self.cs * (2 - self.cs) * self.mueff)
+        self.ps = [(1 - self.cs) * p + cs_norm * y / math.sqrt(d) for p, y, d in zip(self.ps, yw, self.diag)]
+        ps_len = math.sqrt(sum(p * p for p in self.ps))
+        self.generation += 1
+        hsig = ps_len / math.sqrt(1 - (1 - self.cs) ** (2 * self.generation)) < (1.4 + 2 / (self.n + 1)) * self.chin
+        cc_norm = math.sqrt(self.cc * (2 - self.cc) * self.mueff)
+        self.pc = [(1 - self.cc) * p + (cc_norm * y if hsig else 0) for p, y in zip(self.pc, yw)]
+        self.diag = [(1 - self.c1 - self.cmu) * d + self.c1 * p * p
+                     + self.cmu * sum(w * ys[k] ** 2 for w, ys in zip(self.weights, best))
+                     for k, (d, p) in enumerate(zip(self.diag, self.pc))]
+        self.sigma *= math.exp(min(1.0, (self.cs / self.ds) * (ps_len / self.chin - 1)))
+
+
+def optimize(program, scenarios, tolerance_mg, generations=30, population=None, sigma0=0.2, seeds=1,
+             jobs=None, rng_seed=None, log=print):
+    """
+    Searches dose parameters that minimize the mean dose time within the accuracy target.
+
+    Parameters:
+        program (str): The native simulator.
+        scenarios (list): Scenarios in the format of `SCENARIOS`.
+        tolerance_mg (float): Largest acceptable |error| of a dose.
+        generations (int, optional): CMA-ES generations (default: 30).
+        population (int, optional): Candidates per generation (default: CMA-ES default for `SPACE`).
+        sigma0 (float, optional): Initial step size in the unit cube (default: 0.2).
+        seeds (int, optional): Simulated repetitions of each scenario with different noise, starting at
+            the scenario's own seed (default: 1).
+        jobs (int, optional): Simulations run at once (default: all cores).
+        rng_seed (int, optional): Seed of the search for reproducible runs.
+        log (callable, optional): Progress output (default: print).
+
+    Returns:
+        tuple: (best parameter set, its score, its per-scenario results).
+
+    Behavior:
+    - Starts from the firmware defaults, which are scored first as the reference.
+    - Every simulation is an independent process, so a generation runs on all cores at once.
+    """
+    jobs = jobs or os.cpu_count() or 1
+    cases = [(scenario, seed) for scenario in scenarios for seed in range(scenario['seed'], scenario['seed'] + seeds)]
+
+    with ThreadPoolExecutor(max_workers=jobs) as pool:  # Threads only wait on the simulator processes.
+        def evaluate_all(candidates):
+            futures = [[pool.submit(simulate, program, params, scenario, seed) for scenario, seed in cases]
+                       for params in candidates]
+            results = [[f.result() for f in row] for row in futures]
+            return [score(r, tolerance_mg) for r in results], results
+
+        (best_cost,), (best_results,) = evaluate_all([DEFAULT_PARAMS])
+        best = DEFAULT_PARAMS
+        log(f"defaults: score {best_cost:.0f}")
+
+        es = SepCmaEs(encode(DEFAULT_PARAMS), sigma0, population, rng_seed)
+        for generation in range(generations):
+            start = time.time()
+            candidates = [decode(x) for x in es.ask()]
+            costs, results = evaluate_all(candidates)
+            es.tell(costs)
+            i = min(range(len(costs)), key=costs.__getitem__)
+            if costs[i] < best_cost:
+                best, best_cost, best_results = candidates[i], costs[i], results[i]
+            log(f"generation {generation + 1}: best {costs[i]:.0f}, overall {best_cost:.0f}, "
+                f"sigma {es.sigma:.3f}, {time.time() - start:.1f} s")
+
+    return best, best_cost, best_results
+
+
+def main():
+    parser = argparse.ArgumentParser(description="Tune the dose controller parameters on the native simulator.")
+    parser.add_argument('--program', default=DEFAULT_PROGRAM, help="Native simulator built with `pio run -e native`.")
+    parser.add_argument('--tolerance', type=float, default=3.0, help="Accuracy target: largest |error| in mg.")
+    parser.add_argument('--generations', type=int, default=30, help="CMA-ES generations.")
+    parser.add_argument('--population', type=int, help="Candidates per generation.")
+    parser.add_argument('--seeds', type=int, default=1, help="Noise repetitions of each scenario.")
+    parser.add_argument('--jobs', type=int, help="Parallel simulations (default: all cores).")
+    parser.add_argument('--rng-seed', type=int, help="Seed of the search.")
+    parser.add_argument('--output', help="Write the result to this JSON file.")
+    parser.add_argument('--port', help="Store the result on the device at this serial port.")
+    args = parser.parse_args()
+
+    best, cost, results = optimize(args.program, SCENARIOS, args.tolerance, args.generations, args.population,
+                                   seeds=args.seeds, jobs=args.jobs, rng_seed=args.rng_seed)
+
+    print(f"\n{'scenario':<24} {'dose s':>8} {'error mg':>9} {'bursts':>7}")
+    cases = [s for s in SCENARIOS for _ in range(args.seeds)]
+    for scenario, r in zip(cases, results):
+        print(f"{scenario['name']:<24} {r['ms'] / 1000:8.1f} {r['error_mg']:9.2f} {r['bursts']:7d}"
+              f"{'' if r['completed'] else ' incomplete'}")
+    print(f"\nscore {cost:.0f}\n{json.dumps(best)}\n{to_frame(best)}")
+
+    if args.output:
+        with open(args.output, 'w') as file:
+            json.dump(best, file, indent=2)
+    if args.port:
+        import serial
+        with serial.Serial(args.port, 115200, timeout=5) as ser:
+            time.sleep(2)  # The board resets when the port opens.
+            ser.reset_input_buffer()
+            ser.write(to_frame(best).encode('utf-8'))
+            print(ser.readline().decode('utf-8', errors='replace').strip())
+
+
+if __name__ == '__main__':
+    main()
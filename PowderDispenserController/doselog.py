@@ -0,0 +1,242 @@
+"""
+Append-only binary dose log (native `DoseLog`, see `native/include/DoseLog.h`).
+
+Each dose, calibration point or measurement is one fixed-size 64-byte record appended with a
+single write, so logging costs microseconds however long the log is. Readers map the file and
+see the records as a NumPy structured array without copying or parsing.
+
+Classes:
+    DoseLogWriter - Appends records to a log.
+    DoseLogReader - Maps a log read-only; `records()` is a zero-copy NumPy view.
+
+Functions:
+    append(logfile, **fields) - Appends one record, keeping the writer of each log open.
+    read(logfile) - Reads a whole log into a pandas DataFrame.
+"""
+
+import ctypes
+
+import numpy as np
+
+from . import native
+
+KIND_DOSE = 1
+KIND_CALIBRATION = 2
+KIND_MEASUREMENT = 3
+KIND_EVENT = 4
+
+FIELD_DESIRED = 1 << 0
+FIELD_MEASURED = 1 << 1
+FIELD_STEPS = 1 << 2
+FIELD_DURATION = 1 << 3
+FIELD_REPETITION = 1 << 4
+FIELD_SAMPLE = 1 << 5
+
+
+class DoseRecord(ctypes.Structure):
+    """Mirror of the native `DoseRecord` (64 bytes)."""
+    _fields_ = [
+        ('timeUs', ctypes.c_int64),
+        ('kind', ctypes.c_uint16),
+        ('fields', ctypes.c_uint16),
+        ('repetition', ctypes.c_uint16),
+        ('sample', ctypes.c_uint16),
+        ('desiredG', ctypes.c_float),
+        ('measuredG', ctypes.c_float),
+        ('steps', ctypes.c_int32),
+        ('durationMs', ctypes.c_uint32),
+        ('augerType', ctypes.c_char * 12),
+        ('powderType', ctypes.c_char * 12),
+        ('text', ctypes.c_char * 8),
+    ]
+
+
+assert ctypes.sizeof(DoseRecord) == 64, "DoseRecord must match the native file format."
+
+RECORD_DTYPE = np.dtype([
+    ('timeUs', '<i8'), ('kind', '<u2'), ('fields', '<u2'), ('repetition', '<u2'), ('sample', '<u2'),
+    ('desiredG', '<f4'), ('measuredG', '<f4'), ('steps', '<i4'), ('durationMs', '<u4'),
+    ('augerType', 'S12'), ('powderType', 'S12'), ('text', 'S8'),
+])
+
+
+def _bind(lib):
+    if getattr(lib, '_doselog_bound', False):
+        return lib
+    lib.doselog_writer_open.argtypes = [ctypes.c_char_p, ctypes.c_int]
+    lib.doselog_writer_open.restype = ctypes.c_void_p
+    lib.doselog_writer_append.argtypes = [ctypes.c_void_p, ctypes.POINTER(DoseRecord)]
+    lib.doselog_writer_append.restype = ctypes.c_int
+    lib.doselog_writer_close.argtypes = [ctypes.c_void_p]
+    lib.doselog_writer_close.restype = None
+    lib.doselog_reader_open.argtypes = [ctypes.c_char_p]
+    lib.doselog_reader_open.restype = ctypes.c_void_p
+    lib.doselog_reader_refresh.argtypes = [ctypes.c_void_p]
+    lib.doselog_reader_refresh.restype = ctypes.c_int
+    lib.doselog_reader_count.argtypes = [ctypes.c_void_p]
+    lib.doselog_reader_count.restype = ctypes.c_uint64
+    lib.doselog_reader_records.argtypes = [ctypes.c_void_p]
+    lib.doselog_reader_records.restype = ctypes.c_void_p
+    lib.doselog_reader_close.argtypes = [ctypes.c_void_p]
+    lib.doselog_reader_close.restype = None
+    lib._doselog_bound = True
+    return lib
+
+
+def _text(value):
+    return str(value).encode('utf-8') if value is not None else b''
+
+
+class DoseLogWriter:
+    """
+    Appends records to a dose log, creating it if needed.
+
+    Parameters:
+        path (str): Log file (conventionally `*.pdlog`).
+        sync (bool, optional): Flush every record to disk before `append()` returns (default: False).
+    """
+
+    def __init__(self, path, sync=False):
+        self._handle = None
+        self._lib = _bind(native.load())
+        self._handle = native.check(self._lib.doselog_writer_open(path.encode('utf-8'), int(sync)))
+
+    def append(self, kind=KIND_DOSE, desired=None, measured=None, steps=None, duration_ms=None,
+               repetition=None, sample=None, auger_type=None, powder_type=None, text=None, time_us=0):
+        """
+        Appends one record. Fields left as None are recorded as unset.
+
+        Parameters:
+            kind (int, optional): KIND_DOSE, KIND_CALIBRATION, KIND_MEASUREMENT or KIND_EVENT.
+            desired, measured (float, optional): Target and measured mass in grams.
+            steps (int, optional): Stepper steps moved.
+            duration_ms (int, optional): Duration of the operation.
+            repetition, sample (int, optional): Position in a repeated test.
+            auger_type, powder_type (str, optional): Up to 12 bytes each.
+            text (str, optional): Filter type or event tag, up to 8 bytes.
+            time_us (int, optional): Timestamp in microseconds since the epoch (default: now).
+        """
+        record = DoseRecord(timeUs=time_us, kind=kind, augerType=_text(auger_type)[:12],
+                            powderType=_text(powder_type)[:12], text=_text(text)[:8])
+        for value, field, name in ((desired, FIELD_DESIRED, 'desiredG'), (measured, FIELD_MEASURED, 'measuredG'),
+                                   (steps, FIELD_STEPS, 'steps'), (duration_ms, FIELD_DURATION, 'durationMs'),
+                                   (repetition, FIELD_REPETITION, 'repetition'), (sample, FIELD_SAMPLE, 'sample')):
+            if value is not None:
+                setattr(record, name, value)
+                record.fields |= field
+        native.check(self._lib.doselog_writer_append(self._handle, ctypes.byref(record)))
+
+    def close(self):
+        if self._handle:
+            self._lib.doselog_writer_close(self._handle)
+            self._handle = None
+
+    def __enter__(self):
+        return self
+
+    def __exit__(self, *exc):
+        self.close()
+
+    def __del__(self):
+        self.close()
+
+
+class DoseLogReader:
+    """
+    Maps a dose log read-only.
+
+    Parameters:
+        path (str): Log file.
+    """
+
+    def __init__(self, path):
+        self._handle = None
+        self._lib = _bind(native.load())
+        self._handle = native.check(self._lib.doselog_reader_open(path.encode('utf-8')))
+
+    def __len__(self):
+        return self._lib.doselog_reader_count(self._handle)
+
+    def refresh(self):
+        """Picks up records appended since opening. Arrays from earlier `records()` calls become invalid."""
+        native.check(self._lib.doselog_reader_refresh(self._handle))
+
+    def records(self):
+        """
+        Returns the records as a NumPy structured array (dtype `RECORD_DTYPE`) backed by the mapping.
+
+        The array is read-only and valid until `refresh()` or `close()`; copy it to keep it longer.
+        """
+        count = len(self)
+        if count == 0:
+            return np.empty(0, dtype=RECORD_DTYPE)
+        address = self._lib.doselog_reader_records(self._handle)
+        buffer = (ctypes.c_char * (count * RECORD_DTYPE.itemsize)).from_address(address)
+        array = np.frombuffer(buffer, dtype=RECORD_DTYPE, count=count)
+        array.flags.writeable = False
+        return array
+
+    def to_dataframe(self):
+        """
+        Copies the records into a pandas DataFrame with the columns of the CSV log.
+
+        Unset values become NaN (numbers) or empty strings; 'time' is a UTC timestamp.
+        """
+        import pandas as pd
+        r = self.records()
+        fields = r['fields']
+
+        def optional(column, bit):
+            return np.where(fields & bit, r[column].astype(float), np.nan)
+
+        def strings(column):
+            return [value.decode('utf-8', errors='replace') for value in r[column]]
+
+        return pd.DataFrame({
+            'time': pd.to_datetime(r['timeUs'], unit='us', utc=True),
+            'kind': r['kind'],
+            'desired_amount': optional('desiredG', FIELD_DESIRED),
+            'measured_amount': optional('measuredG', FIELD_MEASURED),
+            '# of steps': optional('steps', FIELD_STEPS),
+            'duration_ms': optional('durationMs', FIELD_DURATION),
+            'repetition': optional('repetition', FIELD_REPETITION),
+            'sample': optional('sample', FIELD_SAMPLE),
+            'auger_type': strings('augerType'),
+            'powder_type': strings('powderType'),
+            'filter_type': strings('text'),
+        })
+
+    def close(self):
+        if self._handle:
+            self._lib.doselog_reader_close(self._handle)
+            self._handle = None
+
+    def __enter__(self):
+        return self
+
+    def __exit__(self, *exc):
+        self.close()
+
+    def __del__(self):
+        self.close()
+
+
+_writers = {}  # Open writer per log path, so appends do not reopen the file.
+
+
+def append(logfile, **fields):
+    """
+    Appends one record to `logfile` (see `DoseLogWriter.append()` for the fields).
+    """
+    writer = _writers.get(logfile)
+    if writer is None:
+        writer = _writers[logfile] = DoseLogWriter(logfile)
+    writer.append(**fields)
+
+
+def read(logfile):
+    """
+    Reads a whole dose log into a pandas DataFrame (see `DoseLogReader.to_dataframe()`).
+    """
+    with DoseLogReader(logfile) as reader:
+        return reader.to_dataframe()
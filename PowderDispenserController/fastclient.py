@@ -0,0 +1,429 @@
+"""
+Native serial client for the dispenser (native `ProtocolClient`, see `native/include/ProtocolClient.h`).
+
+A reader thread in libpowderhost receives and splits frames while Python runs, so replies are
+never lost between polls, waiting for a reply does not spin on `in_waiting`, and `<S>` telemetry
+from `<Stream>` is collected into NumPy arrays instead of being parsed frame by frame.
+
+Classes:
+    NativeClient - Thin wrapper of the native client: send frames, wait for replies, read telemetry.
+    FastPowderDispenseController - PowderDispenseController on top of NativeClient. Same API,
+        plus `run_command(..., wait=False)`, telemetry streaming, recording and publishing.
+
+Requires the native library (see `native.py`); POSIX only.
+"""
+
+import ctypes
+import errno
+import time
+
+import numpy as np
+import pandas as pd
+
+from . import native, telemetry, telemetry_bus
+from .controller import PowderDispenseController
+
+_FRAME_BYTES = 512  # Longest frame the native client keeps.
+
+
+def _bind(lib):
+    if getattr(lib, '_client_bound', False):
+        return lib
+    lib.client_open.argtypes = [ctypes.c_char_p, ctypes.c_ulong]
+    lib.client_open.restype = ctypes.c_void_p
+    lib.client_send.argtypes = [ctypes.c_void_p, ctypes.c_char_p]
+    lib.client_send.restype = ctypes.c_int
+    lib.client_write.argtypes = [ctypes.c_void_p, ctypes.c_char_p, ctypes.c_size_t]
+    lib.client_write.restype = ctypes.c_int
+    lib.client_next_frame.argtypes = [ctypes.c_void_p, ctypes.c_char_p, ctypes.c_size_t, ctypes.c_int]
+    lib.client_next_frame.restype = ctypes.c_int
+    lib.client_wait_for.argtypes = [ctypes.c_void_p, ctypes.c_char_p, ctypes.c_char_p, ctypes.c_size_t, ctypes.c_int]
+    lib.client_wait_for.restype = ctypes.c_int
+    lib.client_pending_frames.argtypes = [ctypes.c_void_p]
+    lib.client_pending_frames.restype = ctypes.c_size_t
+    lib.client_clear_frames.argtypes = [ctypes.c_void_p]
+    lib.client_clear_frames.restype = None
+    lib.client_read_telemetry.argtypes = [ctypes.c_void_p, ctypes.POINTER(ctypes.c_double),
+                                          ctypes.POINTER(ctypes.c_float), ctypes.c_size_t]
+    lib.client_read_telemetry.restype = ctypes.c_size_t
+    lib.client_dropped_telemetry.argtypes = [ctypes.c_void_p]
+    lib.client_dropped_telemetry.restype = ctypes.c_uint64
+    lib.client_set_recorder.argtypes = [ctypes.c_void_p, ctypes.c_void_p]
+    lib.client_set_recorder.restype = None
+    lib.client_set_publisher.argtypes = [ctypes.c_void_p, ctypes.c_void_p]
+    lib.client_set_publisher.restype = None
+    lib.client_close.argtypes = [ctypes.c_void_p]
+    lib.client_close.restype = None
+    lib._client_bound = True
+    return lib
+
+
+def _timeout_ms(timeout):
+    return -1 if timeout is None else max(0, int(timeout * 1000))
+
+
+class NativeClient:
+    """
+    Serial connection to the device, served by the native reader thread.
+
+    Parameters:
+        port (str): Serial device (e.g. /dev/ttyUSB0).
+        baud_rate (int, optional): Baud rate (default: 115200).
+    """
+
+    def __init__(self, port, baud_rate=115200):
+        self._handle = None
+        self._lib = _bind(native.load())
+        self._buffer = ctypes.create_string_buffer(_FRAME_BYTES)
+        self._handle = native.check(self._lib.client_open(port.encode('utf-8'), baud_rate))
+
+    def send(self, frame):
+        """Sends a frame such as '<Meas,100,EWMA>' without waiting for a reply."""
+        native.check(self._lib.client_send(self._handle, frame.encode('utf-8')))
+
+    def write(self, data):
+        """Sends raw bytes, e.g. a configuration image, without framing."""
+        data = bytes(data)
+        native.check(self._lib.client_write(self._handle, data, len(data)))
+
+    def _frame(self, length):
+        if length == -1 and ctypes.get_errno() == errno.ETIMEDOUT:
+            raise TimeoutError("Arduino did not respond within timeout. Try resetting the device.")
+        native.check(length)
+        return self._buffer.raw[:length].decode('utf-8', errors='replace')
+
+    def next_frame(self, timeout=None):
+        """
+        Returns the oldest received frame, without its markers.
+
+        Parameters:
+            timeout (float, optional): Seconds to wait; None waits forever.
+
+        Raises:
+            TimeoutError: If no frame arrived in time.
+            OSError: If the port was closed or the device went away.
+        """
+        return self._frame(self._lib.client_next_frame(self._handle, self._buffer, _FRAME_BYTES, _timeout_ms(timeout)))
+
+    def wait_for(self, text, timeout=None):
+        """
+        Returns the first received frame containing `text`; frames received before it are dropped.
+
+        Raises:
+            TimeoutError, OSError: As `next_frame()`.
+        """
+        length = self._lib.client_wait_for(self._handle, text.encode('utf-8'), self._buffer, _FRAME_BYTES,
+                                           _timeout_ms(timeout))
+        return self._frame(length)
+
+    def pending(self):
+        """Returns the number of received frames not read yet (telemetry excluded)."""
+        return self._lib.client_pending_frames(self._handle)
+
+    def clear(self):
+        """Drops received frames not read yet."""
+        self._lib.client_clear_frames(self._handle)
+
+    def read_telemetry(self, max_samples=65536):
+        """
+        Takes the telemetry samples received since the last call.
+
+        Returns:
+            tuple: (time_ms, grams) NumPy arrays (float64, float32), oldest first.
+        """
+        times = np.empty(max_samples, dtype=np.float64)
+        grams = np.empty(max_samples, dtype=np.float32)
+        count = self._lib.client_read_telemetry(self._handle, times.ctypes.data_as(ctypes.POINTER(ctypes.c_double)),
+                                                grams.ctypes.data_as(ctypes.POINTER(ctypes.c_float)), max_samples)
+        return times[:count], grams[:count]
+
+    def dropped_telemetry(self):
+        """Returns the number of samples overwritten because they were not read in time."""
+        return self._lib.client_dropped_telemetry(self._handle)
+
+    def set_recorder(self, writer):
+        """
+        Records every telemetry sample to a `telemetry.TelemetryWriter` from the reader thread, or
+        stops recording if `writer` is None. Keep the writer open until recording is stopped.
+        """
+        self._lib.client_set_recorder(self._handle, writer.handle if writer is not None else None)
+
+    def set_publisher(self, bus):
+        """
+        Publishes every telemetry sample on a `telemetry_bus.BusWriter` from the reader thread, or
+        stops publishing if `bus` is None. Keep the bus open until publishing is stopped.
+        """
+        self._lib.client_set_publisher(self._handle, bus.handle if bus is not None else None)
+
+    def close(self):
+        if self._handle:
+            self._lib.client_close(self._handle)
+            self._handle = None
+
+    def __enter__(self):
+        return self
+
+    def __exit__(self, *exc):
+        self.close()
+
+    def __del__(self):
+        self.close()
+
+
+class _PortAdapter:
+    """The part of `serial.Serial` the base controller touches, backed by a NativeClient."""
+
+    def __init__(self, client):
+        self.client = client
+
+    @property
+    def in_waiting(self):
+        return self.client.pending()
+
+    def reset_input_buffer(self):
+        self.client.clear()
+
+    def write(self, data):
+        self.client.send(data.decode('utf-8') if isinstance(data, bytes) else data)
+
+    def close(self):
+        self.client.close()
+
+
+class FastPowderDispenseController(PowderDispenseController):
+    """
+    PowderDispenseController using the native client; a drop-in replacement.
+
+    Parameters:
+        As PowderDispenseController.
+
+    Behavior:
+        - Replies are matched to their command by name and waited for without polling.
+        - `run_command(..., wait=False)` returns right after sending.
+        - `start_stream()` makes the device send every scale conversion; `read_stream()` returns
+          them as NumPy arrays.
+        - `record_stream()` also stores them in a telemetry store, with dispenses, doses and tares
+          marked as events.
+        - `publish_stream()` shares them, events included, with other local processes.
+        - `compare_idle_sleep()` measures scale noise and settle time with and without the device's
+          idle sleep.
+    """
+
+    recorder = None
+    publisher = None
+
+    def _open_serial(self, ser_port, baud_rate):
+        self.client = NativeClient(ser_port, baud_rate)
+        print(f"Native client on {ser_port}")
+        return _PortAdapter(self.client)
+
+    def _timeout(self, timeout):
+        return timeout or getattr(self, 'DEFAULT_timeout', 10)  # The config is loaded after the handshake.
+
+    def send_to_arduino(self, send_str):
+        self.client.send(send_str)
+
+    def _write_raw(self, data):
+        self.client.write(data)
+
+    def recv_from_arduino(self, timeout=None):
+        return self.client.next_frame(self._timeout(timeout))
+
+    def wait_for_arduino(self):
+        msg = self.client.wait_for("Ready to push powder, baby!", None)
+        print(msg)
+
+    def run_command(self, command_str, wait=True):
+        """
+        Sends a command and, unless `wait` is False, waits for the device's acknowledgement.
+
+        Parameters:
+            command_str (str): The command frame.
+            wait (bool, optional): Wait for and print the reply (default: True).
+
+        Returns:
+            str: The reply, or None if `wait` is False.
+        """
+        self.client.clear()
+        self.client.send(command_str)
+        print(f"Sent from PC -- COMMAND -- {command_str}")
+        if not wait:
+            return None
+        response = self.client.next_frame(self._timeout(None))
+        print(f"Reply Received: {response}")
+        return response
+
+    def measWeight(self, avgReadingSamples=100, filterType=None):
+        filterType = filterType or self.DEFAULT_filterType
+        self.client.clear()
+        self.client.send(f"<Meas,{avgReadingSamples},{filterType}>")
+        return _first_value(self.client.wait_for("Weight:", self._timeout(None)))
+
+    def measRaw(self, avgReadingSamples=100, filterType=None):
+        filterType = filterType or self.DEFAULT_filterType
+        self.client.clear()
+        self.client.send(f"<ADC,{avgReadingSamples},{filterType}>")
+        return _first_value(self.client.wait_for("ADC:", self._timeout(None)))
+
+    def start_stream(self, every=None, raw=False):
+        """
+        Starts scale telemetry: the device sends every `every`-th conversion as `<S t:MS g:G>`.
+        Samples received before are discarded.
+
+        Parameters:
+            every (int, optional): Send every Nth conversion (default: the densest stream the
+                device's serial link carries, see `caps.DeviceCaps.stream_every()`).
+            raw (bool, optional): Send ADC counts instead of grams, e.g. to capture traces for the
+                `filtereval` tool (default: False).
+
+        Raises:
+            RuntimeError: If the device firmware cannot stream (or not raw counts).
+        """
+        if not self.caps.supports('Stream') or (raw and 'raw' not in self.caps.formats):
+            raise RuntimeError("The device firmware cannot stream this telemetry.")
+        every = every or self.caps.stream_every()
+        while len(self.client.read_telemetry()[0]):
+            pass
+        self.client.send(f"<Stream,{int(every)},{int(raw)}>")
+        self.client.wait_for("Stream every", self._timeout(None))
+
+    def stop_stream(self):
+        """Stops scale telemetry. Samples already received stay readable."""
+        self.client.send("<Stream,0>")
+        self.client.wait_for("Stream every", self._timeout(None))
+
+    def read_stream(self, max_samples=65536):
+        """
+        Returns the telemetry received since the last call.
+
+        Returns:
+            tuple: (time_ms, grams) NumPy arrays, in device time (milliseconds since boot). `grams`
+            holds ADC counts for a raw stream.
+        """
+        return self.client.read_telemetry(max_samples)
+
+    def record_stream(self, path):
+        """
+        Records streamed telemetry to a telemetry store (see `telemetry`) until `stop_recording()`.
+
+        Parameters:
+            path (str): Store file (conventionally `*.pdts`); appended to if it exists.
+        """
+        self.stop_recording()
+        self.recorder = telemetry.TelemetryWriter(path)
+        self.client.set_recorder(self.recorder)
+
+    def stop_recording(self):
+        """Stops recording and writes the rows still in memory."""
+        if self.recorder is not None:
+            self.client.set_recorder(None)
+            self.recorder.close()
+            self.recorder = None
+
+    def publish_stream(self, name):
+        """
+        Publishes streamed telemetry on a shared-memory bus until `stop_publishing()`, so other
+        processes can follow it with `telemetry_bus.BusReader(name)` while this one doses.
+
+        Parameters:
+            name (str): Bus name, e.g. the port's file name.
+        """
+        self.stop_publishing()
+        self.publisher = telemetry_bus.BusWriter(name)
+        self.client.set_publisher(self.publisher)
+
+    def stop_publishing(self):
+        """Stops publishing; readers keep what was published."""
+        if self.publisher is not None:
+            self.client.set_publisher(None)
+            self.publisher.close()
+            self.publisher = None
+
+    def compare_idle_sleep(self, seconds=10.0, repeats=3, window=32):
+        """
+        Measures scale noise and settle time with the device sleeping between loop passes and with
+        the busy loop, alternating the two policies. Restores the policy the device had before.
+
+        Parameters:
+            seconds (float, optional): Telemetry captured per run after the scale is ready (default: 10).
+            repeats (int, optional): Runs per policy (default: 3).
+            window (int, optional): Samples of the rolling standard deviation used for settling (default: 32).
+
+        Returns:
+            pandas.DataFrame: One row per run with 'policy' ('busy' or 'idle'), 'ready_s' (`<ScaleOn>`
+            to `<ScaleReady>`), 'settle_s' (first conversion until the rolling standard deviation
+            stays within 1.5x the steady noise), 'noise_g' (standard deviation after removing the
+            linear drift), 'drift_g_per_min' and 'asleep_pct'.
+        """
+        rows = []
+        previous = self.idle_sleep()['enabled']
+        try:
+            for repeat in range(repeats):
+                for enabled in (False, True):
+                    self.idle_sleep(enabled)
+                    self.scaleOff()
+                    self.start_stream()
+                    start = time.monotonic()
+                    self.isScaleOn = False
+                    self.scaleOn(settle_time=max(5, seconds))
+                    ready_s = time.monotonic() - start
+                    time.sleep(seconds)
+                    self.stop_stream()
+                    stats = self.idle_sleep()
+                    time_ms, grams = self.read_stream()
+                    rows.append(dict(policy='idle' if enabled else 'busy', repeat=repeat, ready_s=ready_s,
+                                     asleep_pct=stats['asleep_pct'], **_settle_stats(time_ms, grams, window)))
+        finally:
+            self.idle_sleep(previous)
+        return pd.DataFrame(rows)
+
+    def _mark(self, event, grams=0.0, steps=0):
+        if self.recorder is not None:
+            self.recorder.mark(event, grams, steps)
+        if self.publisher is not None:
+            self.publisher.publish(event, grams, steps)
+
+    def dispense(self, amount_or_steps, direction=None, runSteps=False, augerType=None, powderType=None, channel=0):
+        if runSteps:
+            self._mark(telemetry.EVENT_DISPENSE, steps=int(amount_or_steps))
+        else:
+            self._mark(telemetry.EVENT_DISPENSE, grams=amount_or_steps)
+        super().dispense(amount_or_steps, direction, runSteps, augerType, powderType, channel)
+
+    def dose(self, grams, channel=0):
+        self._mark(telemetry.EVENT_DOSE, grams=grams)
+        return super().dose(grams, channel)
+
+    def tare(self):
+        self._mark(telemetry.EVENT_TARE)
+        super().tare()
+
+    def close(self):
+        self.stop_recording()
+        self.stop_publishing()
+        self.client.close()
+
+
+def _settle_stats(time_ms, grams, window):
+    """Noise, drift and settle time of one `compare_idle_sleep()` capture."""
+    if len(grams) < 4 * window:
+        return dict(settle_s=np.nan, noise_g=np.nan, drift_g_per_min=np.nan)
+    steady_t, steady_g = time_ms[len(grams) // 2:], grams[len(grams) // 2:]  # Second half: settled.
+    slope, intercept = np.polyfit(steady_t, steady_g, 1)
+    noise = float(np.std(steady_g - (slope * steady_t + intercept), ddof=1))
+    rolling = np.lib.stride_tricks.sliding_window_view(grams, window).std(axis=1, ddof=1)
+    unsettled = np.flatnonzero(rolling > 1.5 * noise)
+    settled_at = unsettled[-1] + 1 if len(unsettled) else 0
+    if settled_at >= len(rolling):
+        settled_at = len(rolling) - 1
+    return dict(settle_s=(time_ms[settled_at + window - 1] - time_ms[0]) / 1000.0, noise_g=noise,
+                drift_g_per_min=slope * 60000.0)
+
+
+def _first_value(msg):
+    """Parses a reply like 'Weight:12.345,...' the way PowderDispenseController does."""
+    try:
+        return float(msg.split(':')[1].split(',')[0])
+    except (IndexError, ValueError):
+        print(f"Error parsing value from message: {msg}")
+        return None
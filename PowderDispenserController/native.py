@@ -0,0 +1,68 @@
+"""
+Loader for the package's native host library (libpowderhost, built from `native/`).
+
+Build it once with:
+    cmake -S PowderDispenserController/native -B PowderDispenserController/native/build
+    cmake --build PowderDispenserController/native/build
+
+Functions:
+    load() - Returns the loaded library, or raises OSError if it has not been built.
+    available() - Tells whether the library can be loaded.
+"""
+
+import ctypes
+import os
+import sys
+
+_library = None
+
+_NAMES = {'win32': 'powderhost.dll', 'darwin': 'libpowderhost.dylib'}
+
+
+def _candidates():
+    override = os.environ.get('POWDERHOST_LIBRARY')  # Explicit path to the library.
+    if override:
+        yield override
+    name = _NAMES.get(sys.platform, 'libpowderhost.so')
+    build = os.path.join(os.path.dirname(os.path.abspath(__file__)), 'native', 'build')
+    yield os.path.join(build, name)
+    yield os.path.join(build, 'Release', name)  # Multi-config generators.
+
+
+def load():
+    """
+    Loads libpowderhost once and returns it.
+
+    Returns:
+        ctypes.CDLL: The library, loaded with `use_errno` so failures can be reported as OSError.
+
+    Raises:
+        OSError: If the library has not been built (see the module docstring).
+    """
+    global _library
+    if _library is None:
+        for path in _candidates():
+            if os.path.exists(path):
+                _library = ctypes.CDLL(path, use_errno=True)
+                break
+        else:
+            raise OSError("libpowderhost is not built. Run: cmake -S PowderDispenserController/native "
+                          "-B PowderDispenserController/native/build && cmake --build PowderDispenserController/native/build")
+    return _library
+
+
+def available():
+    """Tells whether libpowderhost is built and loadable."""
+    try:
+        load()
+        return True
+    except OSError:
+        return False
+
+
+def check(result):
+    """Raises OSError from `errno` if a native call returned -1 or NULL."""
+    if result is None or result == -1:
+        errno = ctypes.get_errno()
+        raise OSError(errno, os.strerror(errno))
+    return result
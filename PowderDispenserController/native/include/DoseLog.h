@@ -0,0 +1,116 @@
+#ifndef DOSELOG_H
+#define DOSELOG_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+/**
+ * Append-only binary log of doses and events.
+ *
+ * File layout: one `DoseLogHeader`, then fixed-size `DoseRecord`s in append order. Appending a
+ * record is a single `write()` at the end of the file, so its cost does not depend on the log
+ * size, and readers map the file and index records directly.
+ *
+ * A record cut short by a crash is ignored by readers and dropped by the next writer.
+ */
+
+struct DoseLogHeader {
+    char magic[8];        // "PDLOG\0\0\0".
+    uint32_t version;
+    uint32_t recordSize;  // sizeof(DoseRecord) of the writer; readers reject a mismatch.
+    int64_t createdUs;    // Creation time (microseconds since the Unix epoch).
+    uint64_t reserved;
+};
+
+enum DoseRecordKind : uint16_t {
+    DOSE_RECORD_DOSE = 1,         // A dispensed mass (target, measured, steps).
+    DOSE_RECORD_CALIBRATION = 2,  // A calibration point (steps, measured).
+    DOSE_RECORD_MEASUREMENT = 3,  // A weighing (e.g. a sensitivity test sample).
+    DOSE_RECORD_EVENT = 4,        // Anything else; `text` says what.
+};
+
+// Bits of `DoseRecord::fields`: which optional values are set.
+enum DoseRecordField : uint16_t {
+    DOSE_FIELD_DESIRED = 1 << 0,
+    DOSE_FIELD_MEASURED = 1 << 1,
+    DOSE_FIELD_STEPS = 1 << 2,
+    DOSE_FIELD_DURATION = 1 << 3,
+    DOSE_FIELD_REPETITION = 1 << 4,
+    DOSE_FIELD_SAMPLE = 1 << 5,
+};
+
+struct DoseRecord {
+    int64_t timeUs;       // Microseconds since the Unix epoch; 0 is replaced by the append time.
+    uint16_t kind;        // DoseRecordKind.
+    uint16_t fields;      // DoseRecordField bits.
+    uint16_t repetition;
+    uint16_t sample;
+    float desiredG;
+    float measuredG;
+    int32_t steps;
+    uint32_t durationMs;
+    char augerType[12];   // Zero-padded; not necessarily zero-terminated.
+    char powderType[12];
+    char text[8];         // Filter type for doses and measurements, a short tag for events.
+};
+
+static_assert(sizeof(DoseLogHeader) == 32, "DoseLogHeader is part of the file format.");
+static_assert(sizeof(DoseRecord) == 64, "DoseRecord is part of the file format.");
+
+class DoseLogWriter {
+public:
+    DoseLogWriter() = default;
+    ~DoseLogWriter();
+    DoseLogWriter(const DoseLogWriter&) = delete;
+    DoseLogWriter& operator=(const DoseLogWriter&) = delete;
+
+    bool open(const char* path, bool syncEachRecord = false);
+    bool append(const DoseRecord& record);
+    void close();
+    bool isOpen() const { return fd >= 0; }
+
+    static const uint32_t version;
+
+private:
+    int fd = -1;
+    bool sync = false;
+    uint64_t fileBytes = 0;  // Size after the last complete record.
+};
+
+class DoseLogReader {
+public:
+    DoseLogReader() = default;
+    ~DoseLogReader();
+    DoseLogReader(const DoseLogReader&) = delete;
+    DoseLogReader& operator=(const DoseLogReader&) = delete;
+
+    bool open(const char* path);
+    bool refresh();
+    void close();
+
+    uint64_t count() const { return recordCount; }
+    const DoseRecord* records() const;
+
+private:
+    bool map();
+
+    int fd = -1;
+    void* mapping = nullptr;
+    size_t mappedBytes = 0;
+    uint64_t recordCount = 0;
+};
+
+// C interface for the Python bindings (ctypes). Functions returning int return 0 on success
+// and -1 with `errno` set on failure.
+extern "C" {
+DoseLogWriter* doselog_writer_open(const char* path, int syncEachRecord);
+int doselog_writer_append(DoseLogWriter* writer, const DoseRecord* record);
+void doselog_writer_close(DoseLogWriter* writer);
+DoseLogReader* doselog_reader_open(const char* path);
+int doselog_reader_refresh(DoseLogReader* reader);
+uint64_t doselog_reader_count(const DoseLogReader* reader);
+const DoseRecord* doselog_reader_records(const DoseLogReader* reader);
+void doselog_reader_close(DoseLogReader* reader);
+}
+
+#endif // DOSELOG_H
@@ -0,0 +1,119 @@
+#ifndef FILTEREVAL_H
+#define FILTEREVAL_H
+
+#include <math.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include <vector>
+
+/**
+ * Offline evaluation of scale filters over captured raw ADC traces.
+ *
+ * The firmware filters (`Filters.h`) and the candidates below are run over a trace for many
+ * parameter sets at once: one SIMD lane per configuration, with the same single-precision
+ * operations in the same order as the firmware, so every lane matches the firmware output bit for
+ * bit. Each configuration is scored against a zero-lag reference (a centered moving average of
+ * the trace):
+ * - lag: the delay that best explains the error on slopes, `sum(e * s) / sum(s * s)` with `e` the
+ *   reference minus the output and `s` the reference slope, in samples;
+ * - noise: the RMS error left after removing that lag, in ADC counts.
+ * Traces need some mass changes (dispenses) for the lag to mean anything.
+ */
+
+enum FilterKind : uint8_t {
+    FILTER_NONE,
+    FILTER_EWMA,
+    FILTER_SMA,
+    FILTER_LPF,
+    FILTER_EWMA2,     // Candidate: two cascaded EWMAs.
+    FILTER_ADAPTIVE,  // Candidate: EWMA that follows jumps faster.
+};
+
+struct FilterConfig {
+    FilterKind kind;
+    uint8_t window;   // SMA: window length.
+    float alpha;      // EWMA, LPF, EWMA2, ADAPTIVE: smoothing factor.
+    float alphaFast;  // ADAPTIVE: factor used while the input is more than `threshold` away.
+    float threshold;  // ADAPTIVE: in ADC counts.
+};
+
+// Candidate filters, with the interface of the firmware filters so they can move to `Filters.h`.
+
+// Two cascaded EWMAs with the same alpha: steeper noise roll-off than one EWMA for the same lag.
+struct EwmaCascadeFilter {
+    float alpha;
+    float first;
+    float output;
+    bool hasOutput;
+
+    explicit EwmaCascadeFilter(float alpha) : alpha(alpha), first(0), output(0), hasOutput(false) {}
+
+    inline float filter(float reading) {
+        if (hasOutput) {
+            first = alpha * (reading - first) + first;
+            output = alpha * (first - output) + output;
+        } else {
+            first = output = reading;
+            hasOutput = true;
+        }
+        return output;
+    }
+};
+
+// EWMA that switches to `alphaFast` while the reading is more than `threshold` from the output:
+// heavy smoothing at rest, quick tracking while powder lands.
+struct AdaptiveEwmaFilter {
+    float alpha;
+    float alphaFast;
+    float threshold;
+    float output;
+    bool hasOutput;
+
+    AdaptiveEwmaFilter(float alpha, float alphaFast, float threshold)
+        : alpha(alpha), alphaFast(alphaFast), threshold(threshold), output(0), hasOutput(false) {}
+
+    inline float filter(float reading) {
+        if (hasOutput) {
+            float error = reading - output;
+            output = (fabsf(error) > threshold ? alphaFast : alpha) * error + output;
+        } else {
+            output = reading;
+            hasOutput = true;
+        }
+        return output;
+    }
+};
+
+struct FilterTrace {
+    std::vector<float> raw;         // ADC counts, converted to float as the firmware does.
+    std::vector<double> reference;  // Centered moving average of `raw`.
+    std::vector<double> slope;      // Reference change per sample.
+    size_t from = 0;                // Scored samples: [from, to).
+    size_t to = 0;
+    double slopeEnergy = 0;         // Sum of slope^2 over the scored samples.
+};
+
+// Score accumulators of one configuration; sums over several traces pool them.
+struct FilterSums {
+    double samples;
+    double error2;      // sum(e * e)
+    double errorSlope;  // sum(e * s)
+    double slope2;      // sum(s * s)
+};
+
+struct FilterScore {
+    double noise;       // ADC counts RMS; NaN without scored samples.
+    double lagSamples;  // NaN if the traces have no slopes.
+};
+
+class FilterEval {
+public:
+    static FilterTrace prepare(std::vector<float> raw, uint32_t referenceWindow, uint32_t warmup);
+    static void score(const FilterTrace& trace, const FilterConfig* configs, size_t count, FilterSums* sums);
+    static void run(const FilterTrace& trace, const FilterConfig* configs, size_t count, float* outputs);
+    static FilterScore finish(const FilterSums& sums);
+    static const char* name(FilterKind kind);
+};
+
+#endif // FILTEREVAL_H
@@ -0,0 +1,99 @@
+#ifndef PROTOCOLCLIENT_H
+#define PROTOCOLCLIENT_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "TelemetryBus.h"
+#include "TelemetryStore.h"
+
+/**
+ * Serial client for the dispenser's `<...>` frame protocol.
+ *
+ * A reader thread owns the receive side of the port: it splits the byte stream into frames,
+ * keeps `<S t:MS g:G>` (or raw `r:`) telemetry samples in a ring of parsed values and queues
+ * every other frame (without its markers) for `nextFrame()`/`waitFor()`. Callers never block the
+ * reader, and sending does not wait for replies. With a recorder set, samples are also pushed to a
+ * `TelemetryWriter`, whose disk writes happen on its own thread; with a publisher set, they are
+ * published on a `TelemetryBusWriter` for other local processes.
+ */
+struct TelemetrySample {
+    double timeMs;  // Device time of the conversion.
+    float grams;    // ADC counts in a raw stream.
+};
+
+class ProtocolClient {
+public:
+    ProtocolClient() = default;
+    ~ProtocolClient();
+    ProtocolClient(const ProtocolClient&) = delete;
+    ProtocolClient& operator=(const ProtocolClient&) = delete;
+
+    bool open(const char* port, unsigned long baud);
+    void close();
+
+    bool send(const char* frame);
+    bool write(const void* data, size_t length);
+    int nextFrame(char* out, size_t size, int timeoutMs);
+    int waitFor(const char* text, char* out, size_t size, int timeoutMs);
+    size_t pendingFrames();
+    void clearFrames();
+
+    size_t readTelemetry(double* timesMs, float* grams, size_t max);
+    uint64_t droppedTelemetry() const { return telemetryDropped; }
+    void setRecorder(TelemetryWriter* writer);
+    void setPublisher(TelemetryBusWriter* bus);
+
+    static const size_t maxQueuedFrames;
+    static const size_t telemetryCapacity;
+
+private:
+    void readerLoop();
+    void handleFrame(const std::string& frame);
+    TelemetryRecord hostRecord(const TelemetrySample& sample);
+    int popFrame(char* out, size_t size);
+
+    int fd = -1;
+    int wakePipe[2] = {-1, -1};  // Written by `close()` to stop the reader.
+    std::thread reader;
+    std::atomic<bool> running{false};
+
+    std::mutex lock;
+    std::condition_variable frameReady;
+    std::deque<std::string> frames;        // Received frames, oldest first.
+    std::vector<TelemetrySample> samples;  // Telemetry ring of `telemetryCapacity` samples.
+    size_t sampleHead = 0;                 // Next slot to write.
+    size_t sampleCount = 0;
+    std::atomic<uint64_t> telemetryDropped{0};  // Overwritten before they were read.
+    TelemetryWriter* recorder = nullptr;
+    TelemetryBusWriter* publisher = nullptr;
+    double deviceOffsetUs = 0;  // Host time (Unix epoch) minus device time, for recorded samples.
+    double lastDeviceMs = -1;   // Device time of the last recorded sample; -1 before the first.
+};
+
+// C interface for the Python bindings (ctypes). Functions returning int return 0 (or a length)
+// on success and -1 with `errno` set on failure; ETIMEDOUT when no frame arrived in time.
+extern "C" {
+ProtocolClient* client_open(const char* port, unsigned long baud);
+int client_send(ProtocolClient* client, const char* frame);
+int client_write(ProtocolClient* client, const void* data, size_t length);
+int client_next_frame(ProtocolClient* client, char* out, size_t size, int timeoutMs);
+int client_wait_for(ProtocolClient* client, const char* text, char* out, size_t size, int timeoutMs);
+size_t client_pending_frames(ProtocolClient* client);
+void client_clear_frames(ProtocolClient* client);
+size_t client_read_telemetry(ProtocolClient* client, double* timesMs, float* grams, size_t max);
+uint64_t client_dropped_telemetry(const ProtocolClient* client);
+void client_set_recorder(ProtocolClient* client, TelemetryWriter* writer);
+void client_set_publisher(ProtocolClient* client, TelemetryBusWriter* bus);
+void client_close(ProtocolClient* client);
+}
+
+#endif // PROTOCOLCLIENT_H
@@ -0,0 +1,109 @@
+#ifndef TELEMETRYBUS_H
+#define TELEMETRYBUS_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <atomic>
+#include <mutex>
+#include <string>
+
+#include "TelemetryStore.h"
+
+/**
+ * Shared-memory fan-out of live telemetry to local processes.
+ *
+ * The process that owns the serial port publishes every sample into a ring in a POSIX shared
+ * memory segment (`/powderbus.<name>`); any number of readers map the segment and follow the ring
+ * with their own cursors. Publishing is wait-free and never looks at the readers, so a slow or
+ * stopped reader cannot hold up the serial link: it only loses the samples that were overwritten
+ * before it read them, and is told how many. Neither side makes a system call per sample.
+ *
+ * Each slot carries a sequence number (a seqlock): odd while the writer fills it, then
+ * `2 * index + 2` for sample number `index`. A reader copies a slot and accepts it only if the
+ * sequence was that value before and after the copy.
+ *
+ * The segment outlives its writer: a service that restarts under the same name reuses it and
+ * bumps the generation, and attached readers follow the new ring without reopening.
+ */
+
+struct TelemetryBusSlot {
+    std::atomic<uint64_t> sequence;
+    TelemetryRecord record;
+};
+
+struct TelemetryBusHeader {
+    char magic[8];                     // "PDBUS\0\0\0".
+    uint32_t version;
+    uint32_t capacity;                 // Slots; a power of two.
+    std::atomic<uint64_t> head;        // Samples published so far.
+    std::atomic<uint32_t> generation;  // Bumped whenever a writer (re)starts the ring.
+    std::atomic<uint32_t> writerPid;   // 0 once the writer has closed.
+    int64_t startedUs;
+    uint64_t reserved[3];
+};
+
+static_assert(sizeof(TelemetryBusSlot) == 32, "TelemetryBusSlot is shared between processes.");
+static_assert(sizeof(TelemetryBusHeader) == 64, "TelemetryBusHeader is shared between processes.");
+static_assert(std::atomic<uint64_t>::is_always_lock_free, "The bus needs lock-free 64-bit atomics.");
+
+class TelemetryBusWriter {
+public:
+    TelemetryBusWriter() = default;
+    ~TelemetryBusWriter();
+    TelemetryBusWriter(const TelemetryBusWriter&) = delete;
+    TelemetryBusWriter& operator=(const TelemetryBusWriter&) = delete;
+
+    bool open(const char* name, uint32_t capacity = 1 << 16);
+    void close();
+    void publish(const TelemetryRecord& record);
+
+    static const uint32_t version;
+
+private:
+    std::string path;
+    TelemetryBusHeader* header = nullptr;
+    TelemetryBusSlot* slots = nullptr;
+    size_t mappedBytes = 0;
+    std::mutex publishLock;  // Host marks are published from other threads than the serial reader.
+};
+
+class TelemetryBusReader {
+public:
+    TelemetryBusReader() = default;
+    ~TelemetryBusReader();
+    TelemetryBusReader(const TelemetryBusReader&) = delete;
+    TelemetryBusReader& operator=(const TelemetryBusReader&) = delete;
+
+    bool open(const char* name, bool fromOldest = false);
+    void close();
+
+    size_t read(TelemetryRecord* out, size_t max);
+    uint64_t lost() const { return lostSamples; }
+    uint64_t available() const;
+    bool writerAlive() const;
+
+private:
+    const TelemetryBusHeader* header = nullptr;
+    const TelemetryBusSlot* slots = nullptr;
+    size_t mappedBytes = 0;
+    uint64_t cursor = 0;      // Next sample index to read.
+    uint32_t generation = 0;  // Of the ring `cursor` belongs to.
+    uint64_t lostSamples = 0;
+};
+
+// C interface for the Python bindings (ctypes). Functions returning int return 0 on success
+// and -1 with `errno` set on failure.
+extern "C" {
+TelemetryBusWriter* bus_writer_open(const char* name, uint32_t capacity);
+void bus_writer_publish(TelemetryBusWriter* writer, const TelemetryRecord* record);
+void bus_writer_close(TelemetryBusWriter* writer);
+TelemetryBusReader* bus_reader_open(const char* name, int fromOldest);
+size_t bus_reader_read(TelemetryBusReader* reader, TelemetryRecord* out, size_t max);
+uint64_t bus_reader_lost(const TelemetryBusReader* reader);
+uint64_t bus_reader_available(const TelemetryBusReader* reader);
+int bus_reader_writer_alive(const TelemetryBusReader* reader);
+void bus_reader_close(TelemetryBusReader* reader);
+}
+
+#endif // TELEMETRYBUS_H
@@ -0,0 +1,168 @@
+#ifndef TELEMETRYSTORE_H
+#define TELEMETRYSTORE_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+/**
+ * Columnar store for streamed scale telemetry.
+ *
+ * File layout: one `TelemetryFileHeader`, then self-contained chunks in append order. A chunk is
+ * a `TelemetryChunkHeader` followed by its four columns (time, grams, steps, event), each stored
+ * as zigzag varint deltas from the previous row; grams are fixed point in units of the file's
+ * resolution. At 80 Hz a row takes 6 to 8 bytes instead of 24.
+ *
+ * Rows are ingested by `TelemetryWriter::push()`, which only copies into a ring; a writer thread
+ * encodes and appends whole chunks with one `write()` each. `TelemetryReader` maps the file,
+ * indexes the chunks by time range and decodes only the chunks a query touches.
+ *
+ * A chunk cut short by a crash is ignored by readers and dropped by the next writer.
+ */
+
+struct TelemetryRecord {
+    int64_t timeUs;  // Microseconds since the Unix epoch.
+    float grams;
+    int32_t steps;   // Stepper steps of the event (0 for plain samples).
+    uint16_t event;  // TelemetryEvent.
+};
+
+enum TelemetryEvent : uint16_t {
+    TELEMETRY_SAMPLE = 0,    // A scale conversion.
+    TELEMETRY_DISPENSE = 1,  // A dispense was sent; `steps` or `grams` is its size.
+    TELEMETRY_DOSE = 2,      // A closed-loop dose was sent; `grams` is the target.
+    TELEMETRY_TARE = 3,
+    TELEMETRY_MARK = 4,      // Anything else tagged by the host.
+};
+
+struct TelemetryFileHeader {
+    char magic[8];            // "PDTS\0\0\0\0".
+    uint32_t version;
+    uint32_t chunkRows;       // Rows per full chunk.
+    double gramsResolution;   // Grams per fixed-point unit.
+    int64_t createdUs;
+};
+
+struct TelemetryChunkHeader {
+    uint32_t magic;
+    uint32_t rows;
+    int64_t minUs;            // Time range of the rows, for skipping chunks in queries.
+    int64_t maxUs;
+    uint32_t columnBytes[4];  // Encoded size of each column, in column order.
+};
+
+static_assert(sizeof(TelemetryFileHeader) == 32, "TelemetryFileHeader is part of the file format.");
+static_assert(sizeof(TelemetryChunkHeader) == 40, "TelemetryChunkHeader is part of the file format.");
+
+class TelemetryWriter {
+public:
+    TelemetryWriter() = default;
+    ~TelemetryWriter();
+    TelemetryWriter(const TelemetryWriter&) = delete;
+    TelemetryWriter& operator=(const TelemetryWriter&) = delete;
+
+    bool open(const char* path, uint32_t chunkRows = 8192, double gramsResolution = 1e-5, uint32_t flushMs = 1000);
+    bool close();
+
+    bool push(const TelemetryRecord& record);
+    void mark(const TelemetryRecord& record);
+    uint64_t dropped() const { return droppedRows; }
+    int error() const { return writeError; }
+
+    static const uint32_t version;
+    static const size_t ringCapacity;
+
+private:
+    void writerLoop();
+    void drain(std::vector<TelemetryRecord>& rows);
+    bool writeChunk(const TelemetryRecord* rows, size_t count);
+
+    int fd = -1;
+    uint32_t rowsPerChunk = 0;
+    double resolution = 0;
+    uint32_t flushIntervalMs = 0;
+    uint64_t fileBytes = 0;  // Size after the last complete chunk.
+
+    // Single-producer ring from `push()` to the writer thread.
+    std::unique_ptr<TelemetryRecord[]> ring;
+    std::atomic<size_t> ringHead{0};  // Next slot `push()` writes.
+    std::atomic<size_t> ringTail{0};  // Next slot the writer thread reads.
+    std::atomic<uint64_t> droppedRows{0};
+
+    std::mutex markLock;
+    std::vector<TelemetryRecord> marks;  // Rows from `mark()`, merged by the writer thread.
+
+    std::thread writer;
+    std::atomic<bool> running{false};
+    std::atomic<int> writeError{0};  // errno of the first failed chunk write.
+};
+
+class TelemetryReader {
+public:
+    TelemetryReader() = default;
+    ~TelemetryReader();
+    TelemetryReader(const TelemetryReader&) = delete;
+    TelemetryReader& operator=(const TelemetryReader&) = delete;
+
+    bool open(const char* path);
+    bool refresh();
+    void close();
+
+    uint64_t count() const { return rowCount; }
+    bool timeRange(int64_t* minUs, int64_t* maxUs) const;
+    size_t query(int64_t fromUs, int64_t toUs);
+
+    // Columns of the last `query()`, valid until the next query.
+    const int64_t* times() const { return resultTimes.data(); }
+    const float* grams() const { return resultGrams.data(); }
+    const int32_t* steps() const { return resultSteps.data(); }
+    const uint16_t* events() const { return resultEvents.data(); }
+
+private:
+    struct ChunkIndex {
+        size_t offset;  // Of the chunk header.
+        TelemetryChunkHeader header;
+    };
+
+    bool map();
+    void decode(const ChunkIndex& chunk, int64_t fromUs, int64_t toUs);
+
+    int fd = -1;
+    void* mapping = nullptr;
+    size_t mappedBytes = 0;
+    size_t indexedBytes = 0;  // End of the last complete chunk indexed.
+    double resolution = 0;
+    uint64_t rowCount = 0;
+    std::vector<ChunkIndex> chunks;
+
+    std::vector<int64_t> resultTimes;
+    std::vector<float> resultGrams;
+    std::vector<int32_t> resultSteps;
+    std::vector<uint16_t> resultEvents;
+};
+
+// C interface for the Python bindings (ctypes). Functions returning int return 0 on success
+// and -1 with `errno` set on failure.
+extern "C" {
+TelemetryWriter* telemetry_writer_open(const char* path, uint32_t chunkRows, double gramsResolution, uint32_t flushMs);
+void telemetry_writer_mark(TelemetryWriter* writer, const TelemetryRecord* record);
+uint64_t telemetry_writer_dropped(const TelemetryWriter* writer);
+int telemetry_writer_close(TelemetryWriter* writer);
+TelemetryReader* telemetry_reader_open(const char* path);
+int telemetry_reader_refresh(TelemetryReader* reader);
+uint64_t telemetry_reader_count(const TelemetryReader* reader);
+int telemetry_reader_time_range(const TelemetryReader* reader, int64_t* minUs, int64_t* maxUs);
+size_t telemetry_reader_query(TelemetryReader* reader, int64_t fromUs, int64_t toUs);
+const int64_t* telemetry_reader_times(const TelemetryReader* reader);
+const float* telemetry_reader_grams(const TelemetryReader* reader);
+const int32_t* telemetry_reader_steps(const TelemetryReader* reader);
+const uint16_t* telemetry_reader_events(const TelemetryReader* reader);
+void telemetry_reader_close(TelemetryReader* reader);
+}
+
+#endif // TELEMETRYSTORE_H
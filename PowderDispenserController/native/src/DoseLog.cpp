@@ -0,0 +1,278 @@
+#include "DoseLog.h"
+
+#include <errno.h>
+#include <fcntl.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <time.h>
+#include <unistd.h>
+
+const uint32_t DoseLogWriter::version = 1;  // Bump when the header or record layout changes.
+
+static const char logMagic[8] = {'P', 'D', 'L', 'O', 'G', 0, 0, 0};
+
+static int64_t nowUs() {
+    timespec now;
+    clock_gettime(CLOCK_REALTIME, &now);
+    return (int64_t)now.tv_sec * 1000000 + now.tv_nsec / 1000;
+}
+
+/**
+ * Reads and checks the header of an open log.
+ *
+ * Returns:
+ * - `true` if the file starts with a header of this version and record size (`errno` is EINVAL otherwise).
+ */
+static bool readHeader(int fd) {
+    DoseLogHeader header;
+    ssize_t bytes = pread(fd, &header, sizeof(header), 0);
+    if (bytes != (ssize_t)sizeof(header)) {
+        if (bytes >= 0) {
+            errno = EINVAL;  // Shorter than a header.
+        }
+        return false;
+    }
+    if (memcmp(header.magic, logMagic, sizeof(logMagic)) != 0 || header.version != DoseLogWriter::version
+        || header.recordSize != sizeof(DoseRecord)) {
+        errno = EINVAL;
+        return false;
+    }
+    return true;
+}
+
+DoseLogWriter::~DoseLogWriter() {
+    close();
+}
+
+/**
+ * Opens a log for appending, creating it if needed.
+ *
+ * Parameters:
+ * - `path` (const char*): Log file.
+ * - `syncEachRecord` (bool): `fsync()` after every record, so a record survives a power loss
+ *   once `append()` returns (costs a disk flush per record).
+ *
+ * Returns:
+ * - `true` on success; `false` with `errno` set if the file cannot be opened or is not a log of
+ *   this version.
+ *
+ * Behavior:
+ * - Drops a partial record left at the end by a crash, so new records stay aligned.
+ */
+bool DoseLogWriter::open(const char* path, bool syncEachRecord) {
+    close();
+    fd = ::open(path, O_RDWR | O_CREAT | O_APPEND | O_CLOEXEC, 0644);
+    if (fd < 0) {
+        return false;
+    }
+    sync = syncEachRecord;
+
+    struct stat info;
+    if (fstat(fd, &info) != 0) {
+        close();
+        return false;
+    }
+    if (info.st_size == 0) {
+        DoseLogHeader header = {};
+        memcpy(header.magic, logMagic, sizeof(logMagic));
+        header.version = version;
+        header.recordSize = sizeof(DoseRecord);
+        header.createdUs = nowUs();
+        if (write(fd, &header, sizeof(header)) != (ssize_t)sizeof(header)) {
+            int error = errno;
+            ftruncate(fd, 0);
+            close();
+            errno = error;
+            return false;
+        }
+        fileBytes = sizeof(header);
+        return true;
+    }
+
+    if (!readHeader(fd)) {
+        int error = errno;
+        close();
+        errno = error;
+        return false;
+    }
+    uint64_t body = (uint64_t)info.st_size - sizeof(DoseLogHeader);
+    fileBytes = sizeof(DoseLogHeader) + body - body % sizeof(DoseRecord);
+    if (fileBytes != (uint64_t)info.st_size && ftruncate(fd, fileBytes) != 0) {
+        int error = errno;
+        close();
+        errno = error;
+        return false;
+    }
+    return true;
+}
+
+/**
+ * Appends one record.
+ *
+ * Returns:
+ * - `true` on success; `false` with `errno` set if the record could not be written in full
+ *   (a partial write is truncated away).
+ */
+bool DoseLogWriter::append(const DoseRecord& record) {
+    if (fd < 0) {
+        errno = EBADF;
+        return false;
+    }
+    DoseRecord stamped = record;
+    if (stamped.timeUs == 0) {
+        stamped.timeUs = nowUs();
+    }
+    ssize_t written = write(fd, &stamped, sizeof(stamped));
+    if (written != (ssize_t)sizeof(stamped)) {
+        int error = written < 0 ? errno : ENOSPC;
+        ftruncate(fd, fileBytes);
+        errno = error;
+        return false;
+    }
+    fileBytes += sizeof(stamped);
+    return !sync || fdatasync(fd) == 0;
+}
+
+void DoseLogWriter::close() {
+    if (fd >= 0) {
+        ::close(fd);
+        fd = -1;
+    }
+}
+
+DoseLogReader::~DoseLogReader() {
+    close();
+}
+
+/**
+ * Opens a log and maps it read-only.
+ *
+ * Returns:
+ * - `true` on success; `false` with `errno` set if the file cannot be opened or is not a log of
+ *   this version.
+ */
+bool DoseLogReader::open(const char* path) {
+    close();
+    fd = ::open(path, O_RDONLY | O_CLOEXEC);
+    if (fd < 0) {
+        return false;
+    }
+    if (!readHeader(fd) || !map()) {
+        int error = errno;
+        close();
+        errno = error;
+        return false;
+    }
+    return true;
+}
+
+/**
+ * Maps the whole file as it is now and counts its complete records.
+ */
+bool DoseLogReader::map() {
+    struct stat info;
+    if (fstat(fd, &info) != 0) {
+        return false;
+    }
+    size_t bytes = (size_t)info.st_size;
+    if (bytes == mappedBytes) {
+        return true;
+    }
+    void* next = mmap(nullptr, bytes, PROT_READ, MAP_SHARED, fd, 0);
+    if (next == MAP_FAILED) {
+        return false;
+    }
+    if (mapping != nullptr) {
+        munmap(mapping, mappedBytes);
+    }
+    mapping = next;
+    mappedBytes = bytes;
+    recordCount = (bytes - sizeof(DoseLogHeader)) / sizeof(DoseRecord);
+    return true;
+}
+
+/**
+ * Picks up records appended since `open()` or the last `refresh()`.
+ *
+ * Returns:
+ * - `true` on success. Pointers from `records()` are invalid after a refresh.
+ */
+bool DoseLogReader::refresh() {
+    if (fd < 0) {
+        errno = EBADF;
+        return false;
+    }
+    return map();
+}
+
+/**
+ * Returns the first of `count()` records, in append order.
+ */
+const DoseRecord* DoseLogReader::records() const {
+    return mapping ? reinterpret_cast<const DoseRecord*>(static_cast<const char*>(mapping) + sizeof(DoseLogHeader))
+                   : nullptr;
+}
+
+void DoseLogReader::close() {
+    if (mapping != nullptr) {
+        munmap(mapping, mappedBytes);
+        mapping = nullptr;
+    }
+    mappedBytes = 0;
+    recordCount = 0;
+    if (fd >= 0) {
+        ::close(fd);
+        fd = -1;
+    }
+}
+
+extern "C" {
+
+DoseLogWriter* doselog_writer_open(const char* path, int syncEachRecord) {
+    DoseLogWriter* writer = new DoseLogWriter();
+    if (!writer->open(path, syncEachRecord != 0)) {
+        int error = errno;
+        delete writer;
+        errno = error;
+        return nullptr;
+    }
+    return writer;
+}
+
+int doselog_writer_append(DoseLogWriter* writer, const DoseRecord* record) {
+    return writer->append(*record) ? 0 : -1;
+}
+
+void doselog_writer_close(DoseLogWriter* writer) {
+    delete writer;
+}
+
+DoseLogReader* doselog_reader_open(const char* path) {
+    DoseLogReader* reader = new DoseLogReader();
+    if (!reader->open(path)) {
+        int error = errno;
+        delete reader;
+        errno = error;
+        return nullptr;
+    }
+    return reader;
+}
+
+int doselog_reader_refresh(DoseLogReader* reader) {
+    return reader->refresh() ? 0 : -1;
+}
+
+uint64_t doselog_reader_count(const DoseLogReader* reader) {
+    return reader->count();
+}
+
+const DoseRecord* doselog_reader_records(const DoseLogReader* reader) {
+    return reader->records();
+}
+
+void doselog_reader_close(DoseLogReader* reader) {
+    delete reader;
+}
+
+}
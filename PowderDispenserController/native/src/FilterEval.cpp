@@ -0,0 +1,312 @@
+#include "FilterEval.h"
+
+#include <algorithm>
+#include <string.h>
+
+// Build without FMA contraction (-ffp-contract=off): the firmware rounds every multiply and add.
+
+// One configuration per lane, as many lanes as the target's vector registers hold
+// (8 with AVX, 4 with SSE or NEON).
+#if defined(__AVX__)
+typedef float Lanes __attribute__((vector_size(32)));
+#else
+typedef float Lanes __attribute__((vector_size(16)));
+#endif
+typedef double WideLanes __attribute__((vector_size(2 * sizeof(Lanes))));
+
+static const size_t laneCount = sizeof(Lanes) / sizeof(float);
+
+static Lanes broadcast(float value) {
+    return Lanes{} + value;
+}
+
+// One parameter of each configuration, lane by lane.
+static Lanes gather(const FilterConfig* configs, float FilterConfig::*field) {
+    float values[laneCount];
+    for (size_t k = 0; k < laneCount; k++) {
+        values[k] = configs[k].*field;
+    }
+    Lanes lanes;
+    memcpy(&lanes, values, sizeof(lanes));
+    return lanes;
+}
+
+// Lane kernels: `step(x, t)` returns the outputs for sample `t` of every lane, in the operation
+// order of the scalar filter they port.
+
+struct NoneKernel {
+    explicit NoneKernel(const FilterConfig*) {}
+
+    inline Lanes step(const float* x, size_t t) { return broadcast(x[t]); }
+};
+
+// EwmaFilter (Filters.h).
+struct EwmaKernel {
+    Lanes alpha;
+    Lanes output;
+
+    explicit EwmaKernel(const FilterConfig* configs) : alpha(gather(configs, &FilterConfig::alpha)), output{} {}
+
+    inline Lanes step(const float* x, size_t t) {
+        Lanes reading = broadcast(x[t]);
+        output = t > 0 ? alpha * (reading - output) + output : reading;
+        return output;
+    }
+};
+
+// SmaFilter (Filters.h): the window starts zero-filled, so the oldest value is 0 until it fills.
+struct SmaKernel {
+    uint8_t window[laneCount];
+    Lanes sum;
+
+    explicit SmaKernel(const FilterConfig* configs) : sum{} {
+        for (size_t k = 0; k < laneCount; k++) window[k] = configs[k].window;
+    }
+
+    inline Lanes step(const float* x, size_t t) {
+        Lanes oldest, count;
+        for (size_t k = 0; k < laneCount; k++) {
+            oldest[k] = t >= window[k] ? x[t - window[k]] : 0.0f;
+            count[k] = t + 1 < window[k] ? (float)(t + 1) : (float)window[k];
+        }
+        Lanes reading = broadcast(x[t]);
+        sum = (sum - oldest) + reading;
+        return sum / count;
+    }
+};
+
+// LpfFilter (Filters.h), with the firmware's initial state of 0.5.
+struct LpfKernel {
+    Lanes alpha;
+    Lanes keep;  // 1 - alpha.
+    Lanes state;
+
+    explicit LpfKernel(const FilterConfig* configs)
+        : alpha(gather(configs, &FilterConfig::alpha)), keep(1.0f - alpha), state(broadcast(0.5f)) {}
+
+    inline Lanes step(const float* x, size_t t) {
+        state = alpha * x[t] + keep * state;
+        return state;
+    }
+};
+
+// EwmaCascadeFilter.
+struct Ewma2Kernel {
+    Lanes alpha;
+    Lanes first;
+    Lanes output;
+
+    explicit Ewma2Kernel(const FilterConfig* configs) : alpha(gather(configs, &FilterConfig::alpha)), first{}, output{} {}
+
+    inline Lanes step(const float* x, size_t t) {
+        Lanes reading = broadcast(x[t]);
+        if (t > 0) {
+            first = alpha * (reading - first) + first;
+            output = alpha * (first - output) + output;
+        } else {
+            first = output = reading;
+        }
+        return output;
+    }
+};
+
+// AdaptiveEwmaFilter.
+struct AdaptiveKernel {
+    Lanes alpha;
+    Lanes alphaFast;
+    Lanes threshold;
+    Lanes output;
+
+    explicit AdaptiveKernel(const FilterConfig* configs)
+        : alpha(gather(configs, &FilterConfig::alpha)), alphaFast(gather(configs, &FilterConfig::alphaFast)),
+          threshold(gather(configs, &FilterConfig::threshold)), output{} {}
+
+    inline Lanes step(const float* x, size_t t) {
+        Lanes reading = broadcast(x[t]);
+        if (t == 0) {
+            output = reading;
+            return output;
+        }
+        Lanes error = reading - output;
+        Lanes factor = (error > threshold || error < -threshold) ? alphaFast : alpha;
+        output = factor * error + output;
+        return output;
+    }
+};
+
+// Accumulates the score of every lane over the scored samples.
+struct ScoreSink {
+    const FilterTrace& trace;
+    WideLanes error2;
+    WideLanes errorSlope;
+
+    explicit ScoreSink(const FilterTrace& trace) : trace(trace), error2{}, errorSlope{} {}
+
+    inline void operator()(size_t t, Lanes output) {
+        if (t < trace.from || t >= trace.to) {
+            return;
+        }
+        WideLanes error = trace.reference[t] - __builtin_convertvector(output, WideLanes);
+        error2 += error * error;
+        errorSlope += error * trace.slope[t];
+    }
+};
+
+// Stores the outputs of the first `count` lanes, one row of trace length per lane.
+struct OutputSink {
+    float* outputs;
+    size_t length;
+    size_t count;
+
+    inline void operator()(size_t t, Lanes output) {
+        for (size_t k = 0; k < count; k++) outputs[k * length + t] = output[k];
+    }
+};
+
+template <class Kernel, class Sink>
+static void runKernel(const FilterTrace& trace, const FilterConfig* configs, Sink& sink) {
+    Kernel kernel(configs);
+    const float* x = trace.raw.data();
+    size_t n = trace.raw.size();
+    for (size_t t = 0; t < n; t++) {
+        sink(t, kernel.step(x, t));
+    }
+}
+
+template <class Sink>
+static void runBatch(const FilterTrace& trace, const FilterConfig* configs, Sink& sink) {
+    switch (configs[0].kind) {
+        case FILTER_EWMA:     runKernel<EwmaKernel>(trace, configs, sink); break;
+        case FILTER_SMA:      runKernel<SmaKernel>(trace, configs, sink); break;
+        case FILTER_LPF:      runKernel<LpfKernel>(trace, configs, sink); break;
+        case FILTER_EWMA2:    runKernel<Ewma2Kernel>(trace, configs, sink); break;
+        case FILTER_ADAPTIVE: runKernel<AdaptiveKernel>(trace, configs, sink); break;
+        case FILTER_NONE:
+        default:              runKernel<NoneKernel>(trace, configs, sink); break;
+    }
+}
+
+/**
+ * Splits `configs` into batches of up to `laneCount` configurations of one kind. Short batches are
+ * padded with copies of their last configuration.
+ */
+template <class Visit>
+static void forEachBatch(const FilterConfig* configs, size_t count, Visit visit) {
+    size_t start = 0;
+    while (start < count) {
+        size_t n = 1;
+        while (n < laneCount && start + n < count && configs[start + n].kind == configs[start].kind) {
+            n++;
+        }
+        FilterConfig batch[laneCount];
+        for (size_t k = 0; k < laneCount; k++) {
+            batch[k] = configs[start + std::min(k, n - 1)];
+        }
+        visit(start, n, batch);
+        start += n;
+    }
+}
+
+/**
+ * Prepares a trace for scoring.
+ *
+ * Parameters:
+ * - `raw` (std::vector<float>): ADC counts, oldest first.
+ * - `referenceWindow` (uint32_t): Length of the centered moving average (rounded up to odd).
+ * - `warmup` (uint32_t): Leading samples not scored, so filter start-up does not count.
+ *
+ * Returns:
+ * - The trace with its reference; no samples are scored if it is shorter than the window.
+ */
+FilterTrace FilterEval::prepare(std::vector<float> raw, uint32_t referenceWindow, uint32_t warmup) {
+    FilterTrace trace;
+    trace.raw = std::move(raw);
+    size_t n = trace.raw.size();
+    size_t half = referenceWindow / 2;
+    trace.reference.assign(n, 0.0);
+    trace.slope.assign(n, 0.0);
+    if (n < 2 * half + 3) {
+        return trace;
+    }
+
+    std::vector<double> prefix(n + 1, 0.0);
+    for (size_t t = 0; t < n; t++) {
+        prefix[t + 1] = prefix[t] + trace.raw[t];
+    }
+    for (size_t t = half; t + half < n; t++) {
+        trace.reference[t] = (prefix[t + half + 1] - prefix[t - half]) / (2 * half + 1);
+    }
+    for (size_t t = half + 1; t + half + 1 < n; t++) {
+        trace.slope[t] = (trace.reference[t + 1] - trace.reference[t - 1]) / 2;
+    }
+
+    trace.from = std::max<size_t>(half + 1, warmup);
+    trace.to = n - half - 1;
+    for (size_t t = trace.from; t < trace.to; t++) {
+        trace.slopeEnergy += trace.slope[t] * trace.slope[t];
+    }
+    return trace;
+}
+
+/**
+ * Scores `count` configurations on a trace.
+ *
+ * Parameters:
+ * - `sums` (FilterSums*): One accumulator per configuration; this trace's sums are added to it.
+ */
+void FilterEval::score(const FilterTrace& trace, const FilterConfig* configs, size_t count, FilterSums* sums) {
+    double samples = trace.to > trace.from ? (double)(trace.to - trace.from) : 0;
+    forEachBatch(configs, count, [&](size_t start, size_t n, const FilterConfig* batch) {
+        ScoreSink sink(trace);
+        runBatch(trace, batch, sink);
+        for (size_t k = 0; k < n; k++) {
+            sums[start + k].samples += samples;
+            sums[start + k].error2 += sink.error2[k];
+            sums[start + k].errorSlope += sink.errorSlope[k];
+            sums[start + k].slope2 += trace.slopeEnergy;
+        }
+    });
+}
+
+/**
+ * Runs `count` configurations on a trace and keeps every output.
+ *
+ * Parameters:
+ * - `outputs` (float*): `count` rows of `trace.raw.size()` outputs, in configuration order.
+ */
+void FilterEval::run(const FilterTrace& trace, const FilterConfig* configs, size_t count, float* outputs) {
+    size_t length = trace.raw.size();
+    forEachBatch(configs, count, [&](size_t start, size_t n, const FilterConfig* batch) {
+        OutputSink sink = {outputs + start * length, length, n};
+        runBatch(trace, batch, sink);
+    });
+}
+
+/**
+ * Turns pooled sums into a score (see the header for the definitions).
+ */
+FilterScore FilterEval::finish(const FilterSums& sums) {
+    FilterScore result = {NAN, NAN};
+    if (sums.samples <= 0) {
+        return result;
+    }
+    double residual = sums.error2;
+    if (sums.slope2 > 0) {
+        result.lagSamples = sums.errorSlope / sums.slope2;
+        residual -= sums.errorSlope * result.lagSamples;
+    }
+    result.noise = sqrt(std::max(residual, 0.0) / sums.samples);
+    return result;
+}
+
+const char* FilterEval::name(FilterKind kind) {
+    switch (kind) {
+        case FILTER_EWMA:     return "EWMA";
+        case FILTER_SMA:      return "SMA";
+        case FILTER_LPF:      return "LPF";
+        case FILTER_EWMA2:    return "EWMA2";
+        case FILTER_ADAPTIVE: return "ADAPTIVE";
+        case FILTER_NONE:
+        default:              return "NONE";
+    }
+}
@@ -0,0 +1,321 @@
+// filtereval: scores scale filter configurations on captured raw ADC traces.
+//
+//   filtereval [--rate SPS] [--reference N] [--points N] [--threads N] [--cal COUNTS_PER_G] [--verify] TRACE...
+//
+// A trace is a text file of raw NAU7802 counts, one sample per line; with several fields on a
+// line (e.g. time and value) the last one is used, and lines that do not end in a number are
+// skipped. Capture one with `FastPowderDispenseController.start_stream(raw=True)`.
+//
+// Prints one CSV row per configuration: its parameters, noise (counts and, with --cal, grams),
+// lag (samples and ms), whether it is on the noise/lag Pareto front of its filter, and whether it
+// is the firmware's current setting. --verify first checks every configuration against the
+// scalar filters (the firmware's own Filters.h) bit for bit.
+
+#include "FilterEval.h"
+#include "Filters.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <thread>
+
+static const float firmwareEwmaAlpha = 0.05f;  // ScaleControls: ewmaFilter(0.05).
+static const float firmwareLpfAlpha = 0.5f;    // ScaleControls::lpfAlpha.
+static const uint8_t firmwareSmaWindow = 10;   // ARENA_SMA_WINDOW.
+
+struct Options {
+    double rate = 320;             // Samples per second of the traces.
+    uint32_t reference = 65;       // Reference window, samples.
+    uint32_t points = 64;          // Grid density.
+    unsigned threads = 0;          // 0: one per core.
+    double countsPerGram = 0;      // 0: no grams column.
+    bool verify = false;
+    std::vector<const char*> paths;
+};
+
+/**
+ * Reads a trace file (see the header comment).
+ *
+ * Returns:
+ * - `false` if the file cannot be read.
+ */
+static bool readTrace(const char* path, std::vector<float>& raw) {
+    FILE* file = fopen(path, "r");
+    if (file == nullptr) {
+        return false;
+    }
+    char line[256];
+    while (fgets(line, sizeof(line), file) != nullptr) {
+        char* end = line + strcspn(line, "\r\n");
+        *end = '\0';
+        char* field = line;
+        for (char* p = line; *p; p++) {
+            if (*p == ',' || *p == ' ' || *p == '\t' || *p == ';') {
+                if (p[1] != '\0') field = p + 1;
+            }
+        }
+        char* parsed;
+        double value = strtod(field, &parsed);
+        if (parsed != field && (*parsed == '\0' || strchr(",; \t", *parsed) != nullptr)) {
+            raw.push_back((float)value);  // Counts are integers, so this is the firmware's int32 -> float.
+        }
+    }
+    fclose(file);
+    return true;
+}
+
+static void addLogGrid(std::vector<FilterConfig>& configs, FilterKind kind, float low, float high, uint32_t points,
+                       float firmwareAlpha) {
+    for (uint32_t i = 0; i < points; i++) {
+        FilterConfig config = {};
+        config.kind = kind;
+        config.alpha = (float)(low * pow(high / low, points > 1 ? (double)i / (points - 1) : 0));
+        configs.push_back(config);
+    }
+    if (firmwareAlpha > 0) {
+        FilterConfig config = {};
+        config.kind = kind;
+        config.alpha = firmwareAlpha;
+        configs.push_back(config);
+    }
+}
+
+/**
+ * Builds the configurations to score: each filter over a log-spaced parameter range with
+ * `points` values (the adaptive EWMA over a grid of its three parameters), plus the firmware's
+ * current settings.
+ */
+static std::vector<FilterConfig> buildGrid(uint32_t points) {
+    std::vector<FilterConfig> configs;
+    FilterConfig none = {};
+    none.kind = FILTER_NONE;
+    configs.push_back(none);
+
+    addLogGrid(configs, FILTER_EWMA, 0.001f, 1.0f, points, firmwareEwmaAlpha);
+    addLogGrid(configs, FILTER_LPF, 0.001f, 1.0f, points, firmwareLpfAlpha);
+    addLogGrid(configs, FILTER_EWMA2, 0.001f, 1.0f, points, 0);
+
+    std::vector<uint8_t> windows = {firmwareSmaWindow};
+    for (uint32_t i = 0; i < points; i++) {
+        windows.push_back((uint8_t)lround(pow(255.0, points > 1 ? (double)i / (points - 1) : 0)));
+    }
+    std::sort(windows.begin(), windows.end());
+    windows.erase(std::unique(windows.begin(), windows.end()), windows.end());
+    for (uint8_t window : windows) {
+        FilterConfig config = {};
+        config.kind = FILTER_SMA;
+        config.window = window;
+        configs.push_back(config);
+    }
+
+    uint32_t side = std::max<uint32_t>(2, points / 4);
+    const float fast[] = {0.1f, 0.25f, 0.5f, 1.0f};
+    for (uint32_t a = 0; a < side; a++) {
+        for (float alphaFast : fast) {
+            for (uint32_t h = 0; h < side; h++) {
+                FilterConfig config = {};
+                config.kind = FILTER_ADAPTIVE;
+                config.alpha = (float)(0.001 * pow(200.0, (double)a / (side - 1)));     // 0.001 .. 0.2
+                config.alphaFast = alphaFast;
+                config.threshold = (float)(10.0 * pow(1000.0, (double)h / (side - 1)));  // 10 .. 10000 counts
+                configs.push_back(config);
+            }
+        }
+    }
+    return configs;
+}
+
+static bool isFirmware(const FilterConfig& config) {
+    return config.kind == FILTER_NONE || (config.kind == FILTER_EWMA && config.alpha == firmwareEwmaAlpha)
+        || (config.kind == FILTER_LPF && config.alpha == firmwareLpfAlpha)
+        || (config.kind == FILTER_SMA && config.window == firmwareSmaWindow);
+}
+
+/**
+ * Runs one configuration through its scalar filter.
+ */
+static void runScalar(const FilterConfig& config, const std::vector<float>& raw, std::vector<float>& out) {
+    out.resize(raw.size());
+    std::vector<float> window(config.window > 0 ? config.window : 1, 0.0f);
+    NoFilter none;
+    EwmaFilter ewma(config.alpha);
+    SmaFilter sma(window.data(), config.window);
+    LpfFilter lpf(config.alpha, 0.5);
+    EwmaCascadeFilter ewma2(config.alpha);
+    AdaptiveEwmaFilter adaptive(config.alpha, config.alphaFast, config.threshold);
+    for (size_t t = 0; t < raw.size(); t++) {
+        switch (config.kind) {
+            case FILTER_EWMA:     out[t] = ewma.filter(raw[t]); break;
+            case FILTER_SMA:      out[t] = sma.filter(raw[t]); break;
+            case FILTER_LPF:      out[t] = lpf.filter(raw[t]); break;
+            case FILTER_EWMA2:    out[t] = ewma2.filter(raw[t]); break;
+            case FILTER_ADAPTIVE: out[t] = adaptive.filter(raw[t]); break;
+            case FILTER_NONE:
+            default:              out[t] = none.filter(raw[t]); break;
+        }
+    }
+}
+
+/**
+ * Checks the lane kernels against the scalar filters on a trace.
+ *
+ * Returns:
+ * - The number of configurations whose outputs differ in any bit.
+ */
+static size_t verify(const FilterTrace& trace, const std::vector<FilterConfig>& configs) {
+    size_t length = std::min<size_t>(trace.raw.size(), 20000);
+    FilterTrace head;
+    head.raw.assign(trace.raw.begin(), trace.raw.begin() + length);
+    std::vector<float> lanes(configs.size() * length);
+    FilterEval::run(head, configs.data(), configs.size(), lanes.data());
+
+    size_t mismatches = 0;
+    std::vector<float> scalar;
+    for (size_t i = 0; i < configs.size(); i++) {
+        runScalar(configs[i], head.raw, scalar);
+        if (memcmp(scalar.data(), lanes.data() + i * length, length * sizeof(float)) != 0) {
+            fprintf(stderr, "verify: %s config %zu differs from the scalar filter\n", FilterEval::name(configs[i].kind), i);
+            mismatches++;
+        }
+    }
+    return mismatches;
+}
+
+/**
+ * Marks the configurations no other configuration of the same filter beats on both noise and lag.
+ */
+static std::vector<bool> paretoFront(const std::vector<FilterConfig>& configs, const std::vector<FilterScore>& scores) {
+    std::vector<bool> front(configs.size(), false);
+    for (size_t i = 0; i < configs.size(); i++) {
+        if (std::isnan(scores[i].noise) || std::isnan(scores[i].lagSamples)) {
+            continue;
+        }
+        double lag = fabs(scores[i].lagSamples);
+        front[i] = true;
+        for (size_t j = 0; j < configs.size() && front[i]; j++) {
+            if (j == i || configs[j].kind != configs[i].kind || std::isnan(scores[j].lagSamples)) {
+                continue;
+            }
+            double otherLag = fabs(scores[j].lagSamples);
+            if (scores[j].noise <= scores[i].noise && otherLag <= lag
+                && (scores[j].noise < scores[i].noise || otherLag < lag)) {
+                front[i] = false;
+            }
+        }
+    }
+    return front;
+}
+
+static bool parseOptions(int argc, char** argv, Options& options) {
+    for (int i = 1; i < argc; i++) {
+        const char* arg = argv[i];
+        bool hasValue = i + 1 < argc;
+        if (strcmp(arg, "--rate") == 0 && hasValue) {
+            options.rate = atof(argv[++i]);
+        } else if (strcmp(arg, "--reference") == 0 && hasValue) {
+            options.reference = (uint32_t)atoi(argv[++i]);
+        } else if (strcmp(arg, "--points") == 0 && hasValue) {
+            options.points = (uint32_t)std::max(2, atoi(argv[++i]));
+        } else if (strcmp(arg, "--threads") == 0 && hasValue) {
+            options.threads = (unsigned)atoi(argv[++i]);
+        } else if (strcmp(arg, "--cal") == 0 && hasValue) {
+            options.countsPerGram = atof(argv[++i]);
+        } else if (strcmp(arg, "--verify") == 0) {
+            options.verify = true;
+        } else if (arg[0] == '-') {
+            return false;
+        } else {
+            options.paths.push_back(arg);
+        }
+    }
+    return !options.paths.empty() && options.rate > 0;
+}
+
+int main(int argc, char** argv) {
+    Options options;
+    if (!parseOptions(argc, argv, options)) {
+        fprintf(stderr, "usage: filtereval [--rate SPS] [--reference N] [--points N] [--threads N] "
+                        "[--cal COUNTS_PER_G] [--verify] TRACE...\n");
+        return 2;
+    }
+
+    std::vector<FilterTrace> traces;
+    size_t samples = 0;
+    for (const char* path : options.paths) {
+        std::vector<float> raw;
+        if (!readTrace(path, raw)) {
+            perror(path);
+            return 1;
+        }
+        samples += raw.size();
+        traces.push_back(FilterEval::prepare(std::move(raw), options.reference, options.reference));
+    }
+    std::vector<FilterConfig> configs = buildGrid(options.points);
+
+    if (options.verify) {
+        size_t mismatches = verify(traces[0], configs);
+        fprintf(stderr, "verify: %zu of %zu configurations bit-exact\n", configs.size() - mismatches, configs.size());
+        if (mismatches > 0) {
+            return 1;
+        }
+    }
+
+    // Work items: every (trace, batch of configurations) pair, taken by the threads in turn.
+    const size_t batch = 64;
+    size_t batches = (configs.size() + batch - 1) / batch;
+    std::vector<FilterSums> sums(traces.size() * configs.size(), FilterSums{0, 0, 0, 0});
+    std::atomic<size_t> next{0};
+    auto worker = [&] {
+        for (size_t item; (item = next++) < traces.size() * batches;) {
+            size_t trace = item / batches;
+            size_t start = (item % batches) * batch;
+            size_t count = std::min(batch, configs.size() - start);
+            FilterEval::score(traces[trace], configs.data() + start, count, &sums[trace * configs.size() + start]);
+        }
+    };
+
+    auto started = std::chrono::steady_clock::now();
+    unsigned threadCount = options.threads > 0 ? options.threads : std::max(1u, std::thread::hardware_concurrency());
+    std::vector<std::thread> threads;
+    for (unsigned i = 0; i < threadCount; i++) {
+        threads.emplace_back(worker);
+    }
+    for (std::thread& thread : threads) {
+        thread.join();
+    }
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - started).count();
+
+    std::vector<FilterScore> scores(configs.size());
+    for (size_t i = 0; i < configs.size(); i++) {
+        FilterSums pooled = {0, 0, 0, 0};
+        for (size_t t = 0; t < traces.size(); t++) {
+            const FilterSums& s = sums[t * configs.size() + i];
+            pooled.samples += s.samples;
+            pooled.error2 += s.error2;
+            pooled.errorSlope += s.errorSlope;
+            pooled.slope2 += s.slope2;
+        }
+        scores[i] = FilterEval::finish(pooled);
+    }
+    std::vector<bool> front = paretoFront(configs, scores);
+
+    printf("filter,alpha,alpha_fast,threshold,window,noise,%slag_samples,lag_ms,pareto,firmware\n",
+           options.countsPerGram > 0 ? "noise_g," : "");
+    for (size_t i = 0; i < configs.size(); i++) {
+        const FilterConfig& c = configs[i];
+        printf("%s,%.6g,%.6g,%.6g,%u,%.6g,", FilterEval::name(c.kind), c.alpha, c.alphaFast, c.threshold, c.window,
+               scores[i].noise);
+        if (options.countsPerGram > 0) {
+            printf("%.6g,", scores[i].noise / options.countsPerGram);
+        }
+        printf("%.6g,%.6g,%d,%d\n", scores[i].lagSamples, scores[i].lagSamples * 1000.0 / options.rate, (int)front[i],
+               (int)isFirmware(c));
+    }
+    fprintf(stderr, "%zu configurations x %zu traces (%zu samples) in %.3f s on %u threads: %.0f configurations/s\n",
+            configs.size(), traces.size(), samples, seconds, threadCount, configs.size() * traces.size() / seconds);
+    return 0;
+}
@@ -0,0 +1,434 @@
+#include "ProtocolClient.h"
+
+#include <chrono>
+#include <errno.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <stdlib.h>
+#include <string.h>
+#include <termios.h>
+#include <time.h>
+#include <unistd.h>
+
+const size_t ProtocolClient::maxQueuedFrames = 4096;      // Oldest frames are dropped beyond this.
+const size_t ProtocolClient::telemetryCapacity = 1 << 20;  // About an hour at 320 SPS.
+
+static const size_t maxFrameBytes = 512;  // Longer frames are line noise; they are dropped.
+
+/**
+ * Maps a baud rate to its termios constant, or 0 if it is not supported.
+ */
+static speed_t baudConstant(unsigned long baud) {
+    switch (baud) {
+        case 9600:   return B9600;
+        case 19200:  return B19200;
+        case 38400:  return B38400;
+        case 57600:  return B57600;
+        case 115200: return B115200;
+        case 230400: return B230400;
+        default:     return 0;
+    }
+}
+
+ProtocolClient::~ProtocolClient() {
+    close();
+}
+
+/**
+ * Opens the serial port and starts the reader thread.
+ *
+ * Parameters:
+ * - `port` (const char*): Device path (e.g. /dev/ttyUSB0). A path that is not a terminal (e.g. a
+ *   pipe or pseudo-terminal in tests) is used as is.
+ * - `baud` (unsigned long): Baud rate of the firmware (115200).
+ *
+ * Returns:
+ * - `true` on success; `false` with `errno` set.
+ */
+bool ProtocolClient::open(const char* port, unsigned long baud) {
+    close();
+    fd = ::open(port, O_RDWR | O_NOCTTY | O_NONBLOCK | O_CLOEXEC);
+    if (fd < 0) {
+        return false;
+    }
+    if (isatty(fd)) {
+        speed_t speed = baudConstant(baud);
+        termios settings;
+        if (speed == 0 || tcgetattr(fd, &settings) != 0) {
+            int error = speed == 0 ? EINVAL : errno;
+            close();
+            errno = error;
+            return false;
+        }
+        cfmakeraw(&settings);
+        settings.c_cflag |= CLOCAL | CREAD;
+        cfsetispeed(&settings, speed);
+        cfsetospeed(&settings, speed);
+        if (tcsetattr(fd, TCSANOW, &settings) != 0) {
+            int error = errno;
+            close();
+            errno = error;
+            return false;
+        }
+    }
+    if (pipe(wakePipe) != 0) {
+        int error = errno;
+        close();
+        errno = error;
+        return false;
+    }
+
+    samples.assign(telemetryCapacity, TelemetrySample{0, 0});
+    sampleHead = 0;
+    sampleCount = 0;
+    telemetryDropped = 0;
+    running = true;
+    reader = std::thread(&ProtocolClient::readerLoop, this);
+    return true;
+}
+
+/**
+ * Stops the reader thread and closes the port. Queued frames and telemetry are discarded.
+ */
+void ProtocolClient::close() {
+    if (reader.joinable()) {
+        running = false;
+        char wake = 0;
+        (void)!::write(wakePipe[1], &wake, 1);
+        reader.join();
+    }
+    for (int& end : wakePipe) {
+        if (end >= 0) {
+            ::close(end);
+            end = -1;
+        }
+    }
+    if (fd >= 0) {
+        ::close(fd);
+        fd = -1;
+    }
+    std::lock_guard<std::mutex> guard(lock);
+    frames.clear();
+    sampleCount = 0;
+}
+
+/**
+ * Receives bytes until `close()` or a port error and splits them into frames.
+ * - Text outside `<...>` (e.g. plain debug prints) is ignored.
+ */
+void ProtocolClient::readerLoop() {
+    std::string frame;
+    bool inFrame = false;
+    char buffer[4096];
+    pollfd fds[2] = {{fd, POLLIN, 0}, {wakePipe[0], POLLIN, 0}};
+
+    while (running) {
+        if (poll(fds, 2, -1) < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            break;
+        }
+        if (fds[1].revents) {
+            break;  // close()
+        }
+        if (fds[0].revents & (POLLERR | POLLNVAL)) {
+            break;
+        }
+        ssize_t n = read(fd, buffer, sizeof(buffer));
+        if (n < 0 && (errno == EAGAIN || errno == EINTR)) {
+            continue;
+        }
+        if (n <= 0) {
+            break;  // The device went away.
+        }
+        for (ssize_t i = 0; i < n; i++) {
+            char c = buffer[i];
+            if (c == '<') {
+                frame.clear();
+                inFrame = true;
+            } else if (!inFrame) {
+                continue;
+            } else if (c == '>') {
+                handleFrame(frame);
+                inFrame = false;
+            } else if (frame.size() < maxFrameBytes) {
+                frame += c;
+            } else {
+                inFrame = false;
+            }
+        }
+    }
+
+    running = false;
+    frameReady.notify_all();  // Wake waiters so they see the port is gone.
+}
+
+/**
+ * Stores a telemetry sample or queues any other frame.
+ */
+void ProtocolClient::handleFrame(const std::string& frame) {
+    if (frame.compare(0, 4, "S t:") == 0) {
+        const char* text = frame.c_str() + 4;
+        char* end;
+        double timeMs = strtod(text, &end);
+        const char* valueText = strstr(end, "g:");
+        if (valueText == nullptr) {
+            valueText = strstr(end, "r:");  // Raw stream.
+        }
+        if (valueText != nullptr) {
+            TelemetrySample sample = {timeMs, strtof(valueText + 2, nullptr)};
+            std::lock_guard<std::mutex> guard(lock);
+            if (recorder != nullptr || publisher != nullptr) {
+                TelemetryRecord row = hostRecord(sample);
+                if (recorder != nullptr) {
+                    recorder->push(row);
+                }
+                if (publisher != nullptr) {
+                    publisher->publish(row);
+                }
+            }
+            samples[sampleHead] = sample;
+            sampleHead = (sampleHead + 1) % telemetryCapacity;
+            if (sampleCount < telemetryCapacity) {
+                sampleCount++;
+            } else {
+                telemetryDropped++;
+            }
+            return;
+        }
+    }
+
+    {
+        std::lock_guard<std::mutex> guard(lock);
+        if (frames.size() >= maxQueuedFrames) {
+            frames.pop_front();
+        }
+        frames.push_back(frame);
+    }
+    frameReady.notify_all();
+}
+
+/**
+ * Converts a telemetry sample to a record in host time. The caller holds `lock`.
+ * - Device time is mapped with the offset seen at the first sample, so sample spacing keeps the
+ *   device's precision; the offset is taken again if the device time goes back (a reset).
+ */
+TelemetryRecord ProtocolClient::hostRecord(const TelemetrySample& sample) {
+    if (sample.timeMs < lastDeviceMs || lastDeviceMs < 0) {
+        timespec now;
+        clock_gettime(CLOCK_REALTIME, &now);
+        deviceOffsetUs = (double)now.tv_sec * 1e6 + now.tv_nsec / 1e3 - sample.timeMs * 1e3;
+    }
+    lastDeviceMs = sample.timeMs;
+    return TelemetryRecord{(int64_t)(sample.timeMs * 1e3 + deviceOffsetUs), sample.grams, 0, TELEMETRY_SAMPLE};
+}
+
+/**
+ * Starts (or, with nullptr, stops) recording telemetry samples to `writer`. The writer must stay
+ * open until recording is stopped.
+ */
+void ProtocolClient::setRecorder(TelemetryWriter* writer) {
+    std::lock_guard<std::mutex> guard(lock);
+    recorder = writer;
+    lastDeviceMs = -1;
+}
+
+/**
+ * Starts (or, with nullptr, stops) publishing telemetry samples on `bus`. The bus must stay open
+ * until publishing is stopped.
+ */
+void ProtocolClient::setPublisher(TelemetryBusWriter* bus) {
+    std::lock_guard<std::mutex> guard(lock);
+    publisher = bus;
+}
+
+/**
+ * Sends a frame (e.g. `<Meas,100,EWMA>`) without waiting for a reply.
+ *
+ * Returns:
+ * - `true` once all bytes are written; `false` with `errno` set.
+ */
+bool ProtocolClient::send(const char* frame) {
+    return write(frame, strlen(frame));
+}
+
+/**
+ * Writes raw bytes, e.g. a configuration image after `<CfgLoad>`; blocks until all are queued.
+ */
+bool ProtocolClient::write(const void* data, size_t length) {
+    const char* bytes = static_cast<const char*>(data);
+    size_t sent = 0;
+    while (sent < length) {
+        ssize_t n = ::write(fd, bytes + sent, length - sent);
+        if (n < 0) {
+            if (errno == EAGAIN) {
+                pollfd out = {fd, POLLOUT, 0};
+                poll(&out, 1, 100);
+                continue;
+            }
+            if (errno == EINTR) {
+                continue;
+            }
+            return false;
+        }
+        sent += n;
+    }
+    return true;
+}
+
+/**
+ * Moves the oldest queued frame into `out` (truncated to `size - 1` bytes and terminated).
+ * The caller holds `lock`.
+ */
+int ProtocolClient::popFrame(char* out, size_t size) {
+    std::string frame = std::move(frames.front());
+    frames.pop_front();
+    size_t length = frame.size() < size - 1 ? frame.size() : size - 1;
+    memcpy(out, frame.data(), length);
+    out[length] = '\0';
+    return (int)length;
+}
+
+/**
+ * Returns the oldest received frame, without its markers.
+ *
+ * Parameters:
+ * - `out`, `size`: Destination buffer.
+ * - `timeoutMs` (int): Longest wait for a frame; negative waits forever.
+ *
+ * Returns:
+ * - The frame length, or -1 with `errno` ETIMEDOUT (no frame in time) or EIO (port closed).
+ */
+int ProtocolClient::nextFrame(char* out, size_t size, int timeoutMs) {
+    std::unique_lock<std::mutex> guard(lock);
+    auto ready = [this] { return !frames.empty() || !running; };
+    if (timeoutMs < 0) {
+        frameReady.wait(guard, ready);
+    } else {
+        frameReady.wait_for(guard, std::chrono::milliseconds(timeoutMs), ready);
+    }
+    if (frames.empty()) {
+        errno = running ? ETIMEDOUT : EIO;
+        return -1;
+    }
+    return popFrame(out, size);
+}
+
+/**
+ * Returns the first received frame that contains `text`; frames before it are dropped.
+ *
+ * Returns:
+ * - As `nextFrame()`; the timeout covers the whole wait.
+ */
+int ProtocolClient::waitFor(const char* text, char* out, size_t size, int timeoutMs) {
+    auto deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(timeoutMs < 0 ? 0 : timeoutMs);
+    std::unique_lock<std::mutex> guard(lock);
+    while (true) {
+        while (!frames.empty()) {
+            if (frames.front().find(text) != std::string::npos) {
+                return popFrame(out, size);
+            }
+            frames.pop_front();
+        }
+        if (!running) {
+            errno = EIO;
+            return -1;
+        }
+        if (timeoutMs < 0) {
+            frameReady.wait(guard);
+        } else if (frameReady.wait_until(guard, deadline) == std::cv_status::timeout && frames.empty()) {
+            errno = ETIMEDOUT;
+            return -1;
+        }
+    }
+}
+
+size_t ProtocolClient::pendingFrames() {
+    std::lock_guard<std::mutex> guard(lock);
+    return frames.size();
+}
+
+void ProtocolClient::clearFrames() {
+    std::lock_guard<std::mutex> guard(lock);
+    frames.clear();
+}
+
+/**
+ * Moves up to `max` telemetry samples, oldest first, into the caller's arrays.
+ *
+ * Returns:
+ * - The number of samples copied. Samples not read before the ring wrapped are counted by
+ *   `droppedTelemetry()`.
+ */
+size_t ProtocolClient::readTelemetry(double* timesMs, float* grams, size_t max) {
+    std::lock_guard<std::mutex> guard(lock);
+    size_t n = sampleCount < max ? sampleCount : max;
+    size_t tail = (sampleHead + telemetryCapacity - sampleCount) % telemetryCapacity;
+    for (size_t i = 0; i < n; i++) {
+        const TelemetrySample& sample = samples[(tail + i) % telemetryCapacity];
+        timesMs[i] = sample.timeMs;
+        grams[i] = sample.grams;
+    }
+    sampleCount -= n;
+    return n;
+}
+
+extern "C" {
+
+ProtocolClient* client_open(const char* port, unsigned long baud) {
+    ProtocolClient* client = new ProtocolClient();
+    if (!client->open(port, baud)) {
+        int error = errno;
+        delete client;
+        errno = error;
+        return nullptr;
+    }
+    return client;
+}
+
+int client_send(ProtocolClient* client, const char* frame) {
+    return client->send(frame) ? 0 : -1;
+}
+
+int client_write(ProtocolClient* client, const void* data, size_t length) {
+    return client->write(data, length) ? 0 : -1;
+}
+
+int client_next_frame(ProtocolClient* client, char* out, size_t size, int timeoutMs) {
+    return client->nextFrame(out, size, timeoutMs);
+}
+
+int client_wait_for(ProtocolClient* client, const char* text, char* out, size_t size, int timeoutMs) {
+    return client->waitFor(text, out, size, timeoutMs);
+}
+
+size_t client_pending_frames(ProtocolClient* client) {
+    return client->pendingFrames();
+}
+
+void client_clear_frames(ProtocolClient* client) {
+    client->clearFrames();
+}
+
+size_t client_read_telemetry(ProtocolClient* client, double* timesMs, float* grams, size_t max) {
+    return client->readTelemetry(timesMs, grams, max);
+}
+
+uint64_t client_dropped_telemetry(const ProtocolClient* client) {
+    return client->droppedTelemetry();
+}
+
+void client_set_recorder(ProtocolClient* client, TelemetryWriter* writer) {
+    client->setRecorder(writer);
+}
+
+void client_set_publisher(ProtocolClient* client, TelemetryBusWriter* bus) {
+    client->setPublisher(bus);
+}
+
+void client_close(ProtocolClient* client) {
+    delete client;
+}
+
+}
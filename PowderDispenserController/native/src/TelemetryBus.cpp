@@ -0,0 +1,376 @@
+#include "TelemetryBus.h"
+
+#include <errno.h>
+#include <fcntl.h>
+#include <signal.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <time.h>
+#include <unistd.h>
+
+const uint32_t TelemetryBusWriter::version = 1;  // Bump when the header or slot layout changes.
+
+static const char busMagic[8] = {'P', 'D', 'B', 'U', 'S', 0, 0, 0};
+static const size_t maxNameLength = 200;
+
+/**
+ * Builds the shared memory object name of a bus.
+ *
+ * Returns:
+ * - `false` with `errno` EINVAL if `name` is empty, too long or contains '/'.
+ */
+static bool busPath(const char* name, std::string& path) {
+    size_t length = name != nullptr ? strlen(name) : 0;
+    if (length == 0 || length > maxNameLength || strchr(name, '/') != nullptr) {
+        errno = EINVAL;
+        return false;
+    }
+    path = std::string("/powderbus.") + name;
+    return true;
+}
+
+static size_t busBytes(uint32_t capacity) {
+    return sizeof(TelemetryBusHeader) + (size_t)capacity * sizeof(TelemetryBusSlot);
+}
+
+static int64_t nowUs() {
+    timespec now;
+    clock_gettime(CLOCK_REALTIME, &now);
+    return (int64_t)now.tv_sec * 1000000 + now.tv_nsec / 1000;
+}
+
+static bool processAlive(uint32_t pid) {
+    return pid != 0 && (kill((pid_t)pid, 0) == 0 || errno == EPERM);
+}
+
+TelemetryBusWriter::~TelemetryBusWriter() {
+    close();
+}
+
+/**
+ * Creates the bus, or takes over the segment a previous writer of the same name left behind.
+ *
+ * Parameters:
+ * - `name` (const char*): Bus name, e.g. the device's; readers open the same name.
+ * - `capacity` (uint32_t): Ring slots, a power of two. Readers further behind than this lose samples.
+ *
+ * Returns:
+ * - `true` on success; `false` with `errno` set (EBUSY if another live process publishes on the bus).
+ */
+bool TelemetryBusWriter::open(const char* name, uint32_t capacity) {
+    close();
+    if (capacity < 2 || (capacity & (capacity - 1)) != 0) {
+        errno = EINVAL;
+        return false;
+    }
+    if (!busPath(name, path)) {
+        return false;
+    }
+    size_t bytes = busBytes(capacity);
+
+    int fd = shm_open(path.c_str(), O_RDWR | O_CREAT, 0644);
+    if (fd < 0) {
+        return false;
+    }
+    struct stat info;
+    if (fstat(fd, &info) != 0) {
+        int error = errno;
+        ::close(fd);
+        errno = error;
+        return false;
+    }
+    if ((size_t)info.st_size >= sizeof(TelemetryBusHeader)) {
+        // Left by an earlier writer: refuse if it is still running, reuse it if the size fits.
+        void* old = mmap(nullptr, sizeof(TelemetryBusHeader), PROT_READ, MAP_SHARED, fd, 0);
+        if (old != MAP_FAILED) {
+            bool busy = processAlive(((const TelemetryBusHeader*)old)->writerPid.load(std::memory_order_acquire));
+            munmap(old, sizeof(TelemetryBusHeader));
+            if (busy) {
+                ::close(fd);
+                errno = EBUSY;
+                return false;
+            }
+        }
+    }
+    if (info.st_size != 0 && (size_t)info.st_size != bytes) {
+        // Another capacity: readers of the old segment keep their mapping and see no live writer.
+        ::close(fd);
+        shm_unlink(path.c_str());
+        fd = shm_open(path.c_str(), O_RDWR | O_CREAT, 0644);
+        if (fd < 0) {
+            return false;
+        }
+        info.st_size = 0;
+    }
+    if (info.st_size == 0 && ftruncate(fd, (off_t)bytes) != 0) {
+        int error = errno;
+        ::close(fd);
+        errno = error;
+        return false;
+    }
+    void* address = mmap(nullptr, bytes, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    int error = errno;
+    ::close(fd);
+    if (address == MAP_FAILED) {
+        errno = error;
+        return false;
+    }
+    mappedBytes = bytes;
+    header = (TelemetryBusHeader*)address;
+    slots = (TelemetryBusSlot*)(header + 1);
+
+    // Reset the ring before announcing the new generation, so readers never pair an old slot
+    // with a new sample index.
+    header->version = version;
+    header->capacity = capacity;
+    for (uint32_t i = 0; i < capacity; i++) {
+        slots[i].sequence.store(0, std::memory_order_relaxed);
+    }
+    header->head.store(0, std::memory_order_relaxed);
+    header->startedUs = nowUs();
+    header->writerPid.store((uint32_t)getpid(), std::memory_order_relaxed);
+    header->generation.fetch_add(1, std::memory_order_release);
+    memcpy(header->magic, busMagic, sizeof(busMagic));
+    return true;
+}
+
+/**
+ * Detaches from the bus. The segment stays for attached readers and the next writer.
+ */
+void TelemetryBusWriter::close() {
+    if (header != nullptr) {
+        header->writerPid.store(0, std::memory_order_release);
+        munmap(header, mappedBytes);
+        header = nullptr;
+        slots = nullptr;
+        mappedBytes = 0;
+    }
+}
+
+/**
+ * Publishes one record; a zero time is set to now. Never waits for readers.
+ */
+void TelemetryBusWriter::publish(const TelemetryRecord& record) {
+    if (header == nullptr) {
+        return;
+    }
+    std::lock_guard<std::mutex> guard(publishLock);
+    uint64_t index = header->head.load(std::memory_order_relaxed);
+    TelemetryBusSlot& slot = slots[index & (header->capacity - 1)];
+    slot.sequence.store(2 * index + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+    memcpy(&slot.record, &record, sizeof(record));
+    if (record.timeUs == 0) {
+        slot.record.timeUs = nowUs();
+    }
+    slot.sequence.store(2 * index + 2, std::memory_order_release);
+    header->head.store(index + 1, std::memory_order_release);
+}
+
+TelemetryBusReader::~TelemetryBusReader() {
+    close();
+}
+
+/**
+ * Attaches to a bus.
+ *
+ * Parameters:
+ * - `name` (const char*): Bus name given to the writer.
+ * - `fromOldest` (bool): Start with the oldest sample still in the ring instead of the next new one.
+ *
+ * Returns:
+ * - `true` on success; `false` with `errno` set (ENOENT if no writer ever created the bus, EAGAIN
+ *   if one is creating it right now).
+ */
+bool TelemetryBusReader::open(const char* name, bool fromOldest) {
+    close();
+    std::string path;
+    if (!busPath(name, path)) {
+        return false;
+    }
+    int fd = shm_open(path.c_str(), O_RDONLY, 0);
+    if (fd < 0) {
+        return false;
+    }
+    struct stat info;
+    if (fstat(fd, &info) != 0) {
+        int error = errno;
+        ::close(fd);
+        errno = error;
+        return false;
+    }
+    if ((size_t)info.st_size < sizeof(TelemetryBusHeader)) {
+        ::close(fd);
+        errno = EAGAIN;
+        return false;
+    }
+    void* address = mmap(nullptr, info.st_size, PROT_READ, MAP_SHARED, fd, 0);
+    int error = errno;
+    ::close(fd);
+    if (address == MAP_FAILED) {
+        errno = error;
+        return false;
+    }
+    header = (const TelemetryBusHeader*)address;
+    slots = (const TelemetryBusSlot*)(header + 1);
+    mappedBytes = info.st_size;
+
+    generation = header->generation.load(std::memory_order_acquire);
+    if (memcmp(header->magic, busMagic, sizeof(busMagic)) != 0) {
+        close();
+        errno = EAGAIN;
+        return false;
+    }
+    if (header->version != TelemetryBusWriter::version || busBytes(header->capacity) != mappedBytes) {
+        close();
+        errno = EINVAL;
+        return false;
+    }
+    uint64_t head = header->head.load(std::memory_order_acquire);
+    cursor = !fromOldest ? head : head > header->capacity ? head - header->capacity + 1 : 0;
+    lostSamples = 0;
+    return true;
+}
+
+void TelemetryBusReader::close() {
+    if (header != nullptr) {
+        munmap((void*)header, mappedBytes);
+        header = nullptr;
+        slots = nullptr;
+        mappedBytes = 0;
+    }
+}
+
+/**
+ * Copies up to `max` records, oldest first, and advances past them.
+ * - Records overwritten before they were read are skipped and counted by `lost()`.
+ * - When a new writer restarts the ring, reading continues from its first record.
+ *
+ * Returns:
+ * - The number of records copied to `out`.
+ */
+size_t TelemetryBusReader::read(TelemetryRecord* out, size_t max) {
+    if (header == nullptr) {
+        return 0;
+    }
+    uint32_t current = header->generation.load(std::memory_order_acquire);
+    if (current != generation) {
+        generation = current;
+        cursor = 0;
+    }
+    uint64_t capacity = header->capacity;
+    uint64_t mask = capacity - 1;
+    uint64_t head = header->head.load(std::memory_order_acquire);
+    if (head < cursor) {
+        cursor = head;
+    }
+
+    size_t n = 0;
+    while (n < max && cursor < head) {
+        if (head - cursor >= capacity) {
+            // The writer may be filling the slot of `cursor` already: jump to the oldest safe record.
+            uint64_t oldest = head - capacity + 1;
+            lostSamples += oldest - cursor;
+            cursor = oldest;
+        }
+        const TelemetryBusSlot& slot = slots[cursor & mask];
+        uint64_t expected = 2 * cursor + 2;
+        uint64_t before = slot.sequence.load(std::memory_order_acquire);
+        memcpy(&out[n], (const void*)&slot.record, sizeof(TelemetryRecord));
+        std::atomic_thread_fence(std::memory_order_acquire);
+        uint64_t after = slot.sequence.load(std::memory_order_relaxed);
+        if (before == expected && after == expected) {
+            n++;
+            cursor++;
+            continue;
+        }
+        // Lapped while reading: the writer is at least a ring ahead now.
+        head = header->head.load(std::memory_order_acquire);
+        if (head < cursor || head - cursor < capacity) {
+            break;  // Restarted by a new writer; picked up on the next call.
+        }
+    }
+
+    if (header->generation.load(std::memory_order_acquire) != generation) {
+        return 0;  // The ring was reset under us; these records may mix two writers.
+    }
+    return n;
+}
+
+/**
+ * Returns the number of records waiting for this reader (at most the ring capacity).
+ */
+uint64_t TelemetryBusReader::available() const {
+    if (header == nullptr) {
+        return 0;
+    }
+    if (header->generation.load(std::memory_order_acquire) != generation) {
+        return header->head.load(std::memory_order_acquire);
+    }
+    uint64_t head = header->head.load(std::memory_order_acquire);
+    uint64_t waiting = head > cursor ? head - cursor : 0;
+    return waiting < header->capacity ? waiting : header->capacity;
+}
+
+/**
+ * Returns `true` if the writing process is running (and has not closed the bus). Makes one
+ * system call; the process must be in the same PID namespace.
+ */
+bool TelemetryBusReader::writerAlive() const {
+    return header != nullptr && processAlive(header->writerPid.load(std::memory_order_acquire));
+}
+
+extern "C" {
+
+TelemetryBusWriter* bus_writer_open(const char* name, uint32_t capacity) {
+    TelemetryBusWriter* writer = new TelemetryBusWriter();
+    if (!writer->open(name, capacity)) {
+        int error = errno;
+        delete writer;
+        errno = error;
+        return nullptr;
+    }
+    return writer;
+}
+
+void bus_writer_publish(TelemetryBusWriter* writer, const TelemetryRecord* record) {
+    writer->publish(*record);
+}
+
+void bus_writer_close(TelemetryBusWriter* writer) {
+    delete writer;
+}
+
+TelemetryBusReader* bus_reader_open(const char* name, int fromOldest) {
+    TelemetryBusReader* reader = new TelemetryBusReader();
+    if (!reader->open(name, fromOldest != 0)) {
+        int error = errno;
+        delete reader;
+        errno = error;
+        return nullptr;
+    }
+    return reader;
+}
+
+size_t bus_reader_read(TelemetryBusReader* reader, TelemetryRecord* out, size_t max) {
+    return reader->read(out, max);
+}
+
+uint64_t bus_reader_lost(const TelemetryBusReader* reader) {
+    return reader->lost();
+}
+
+uint64_t bus_reader_available(const TelemetryBusReader* reader) {
+    return reader->available();
+}
+
+int bus_reader_writer_alive(const TelemetryBusReader* reader) {
+    return reader->writerAlive() ? 1 : 0;
+}
+
+void bus_reader_close(TelemetryBusReader* reader) {
+    delete reader;
+}
+
+}
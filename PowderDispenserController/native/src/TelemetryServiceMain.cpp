@@ -0,0 +1,153 @@
+// telemetryd: owns a dispenser's serial port and publishes its scale telemetry to local processes.
+//
+//   telemetryd [--baud BAUD] [--name NAME] [--every N] [--raw] [--capacity SLOTS] [--record PATH] PORT
+//
+// Starts `<Stream>` on the device and publishes every sample on the shared-memory bus NAME
+// (default: the port's file name, e.g. ttyUSB0); read it with `telemetry_bus.BusReader(NAME)` from
+// any number of processes. With --record, samples are also appended to a telemetry store. Other
+// frames from the device are printed to stdout. Stops streaming and exits on SIGINT or SIGTERM.
+//
+// Only one process can own the port: to dose and share the stream at the same time, publish from
+// the controlling process instead (`FastPowderDispenseController.publish_stream()`).
+
+#include "ProtocolClient.h"
+#include "TelemetryBus.h"
+#include "TelemetryStore.h"
+
+#include <errno.h>
+#include <signal.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <vector>
+
+static const int readyTimeoutMs = 5000;   // The board resets when the port opens.
+static const int replyTimeoutMs = 2000;
+static const int pollMs = 200;            // Frame wait between checks for a stop signal.
+static const size_t drainSamples = 4096;  // The client's own copy of the samples is discarded.
+
+static volatile sig_atomic_t stopRequested = 0;
+
+static void requestStop(int) {
+    stopRequested = 1;
+}
+
+struct Options {
+    unsigned long baud = 115200;
+    const char* name = nullptr;
+    unsigned every = 1;
+    bool raw = false;
+    uint32_t capacity = 1 << 16;
+    const char* record = nullptr;
+    const char* port = nullptr;
+};
+
+static bool parseOptions(int argc, char** argv, Options& options) {
+    for (int i = 1; i < argc; i++) {
+        const char* arg = argv[i];
+        bool hasValue = i + 1 < argc;
+        if (strcmp(arg, "--baud") == 0 && hasValue) {
+            options.baud = strtoul(argv[++i], nullptr, 10);
+        } else if (strcmp(arg, "--name") == 0 && hasValue) {
+            options.name = argv[++i];
+        } else if (strcmp(arg, "--every") == 0 && hasValue) {
+            options.every = (unsigned)atoi(argv[++i]);
+        } else if (strcmp(arg, "--raw") == 0) {
+            options.raw = true;
+        } else if (strcmp(arg, "--capacity") == 0 && hasValue) {
+            options.capacity = (uint32_t)strtoul(argv[++i], nullptr, 10);
+        } else if (strcmp(arg, "--record") == 0 && hasValue) {
+            options.record = argv[++i];
+        } else if (arg[0] == '-' || options.port != nullptr) {
+            return false;
+        } else {
+            options.port = arg;
+        }
+    }
+    if (options.port == nullptr || options.every == 0) {
+        return false;
+    }
+    if (options.name == nullptr) {
+        const char* slash = strrchr(options.port, '/');
+        options.name = slash != nullptr ? slash + 1 : options.port;
+    }
+    return true;
+}
+
+int main(int argc, char** argv) {
+    Options options;
+    if (!parseOptions(argc, argv, options)) {
+        fprintf(stderr, "usage: telemetryd [--baud BAUD] [--name NAME] [--every N] [--raw] [--capacity SLOTS] "
+                        "[--record PATH] PORT\n");
+        return 2;
+    }
+
+    TelemetryBusWriter bus;
+    if (!bus.open(options.name, options.capacity)) {
+        fprintf(stderr, "telemetryd: bus %s: %s\n", options.name, strerror(errno));
+        return 1;
+    }
+    TelemetryWriter recorder;
+    if (options.record != nullptr && !recorder.open(options.record)) {
+        fprintf(stderr, "telemetryd: %s: %s\n", options.record, strerror(errno));
+        return 1;
+    }
+    ProtocolClient client;
+    if (!client.open(options.port, options.baud)) {
+        fprintf(stderr, "telemetryd: %s: %s\n", options.port, strerror(errno));
+        return 1;
+    }
+    client.setPublisher(&bus);
+    if (options.record != nullptr) {
+        client.setRecorder(&recorder);
+    }
+
+    struct sigaction action = {};
+    action.sa_handler = requestStop;
+    sigaction(SIGINT, &action, nullptr);
+    sigaction(SIGTERM, &action, nullptr);
+
+    char frame[512];
+    if (client.waitFor("Ready to push powder", frame, sizeof(frame), readyTimeoutMs) < 0) {
+        fprintf(stderr, "telemetryd: no start-up message from the device; assuming it is running\n");
+    }
+    char command[64];
+    snprintf(command, sizeof(command), "<Stream,%u,%d>", options.every, options.raw ? 1 : 0);
+    if (!client.send(command) || client.waitFor("Stream every", frame, sizeof(frame), replyTimeoutMs) < 0) {
+        fprintf(stderr, "telemetryd: the device did not start streaming: %s\n", strerror(errno));
+        return 1;
+    }
+    fprintf(stderr, "telemetryd: publishing %s on bus %s\n", options.port, options.name);
+
+    std::vector<double> times(drainSamples);
+    std::vector<float> values(drainSamples);
+    int status = 0;
+    while (!stopRequested) {
+        int length = client.nextFrame(frame, sizeof(frame), pollMs);
+        if (length >= 0) {
+            printf("%s\n", frame);
+            fflush(stdout);
+        } else if (errno != ETIMEDOUT) {
+            fprintf(stderr, "telemetryd: %s: %s\n", options.port, strerror(errno));
+            status = 1;
+            break;
+        }
+        while (client.readTelemetry(times.data(), values.data(), drainSamples) == drainSamples) {
+        }
+    }
+
+    if (status == 0) {
+        client.send("<Stream,0>");
+        client.waitFor("Stream every", frame, sizeof(frame), replyTimeoutMs);
+    }
+    client.setPublisher(nullptr);
+    client.setRecorder(nullptr);
+    client.close();
+    if (options.record != nullptr && !recorder.close()) {
+        fprintf(stderr, "telemetryd: %s: %s\n", options.record, strerror(recorder.error()));
+        status = 1;
+    }
+    bus.close();
+    return status;
+}
@@ -0,0 +1,569 @@
+#include "TelemetryStore.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <errno.h>
+#include <fcntl.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <time.h>
+#include <unistd.h>
+
+const uint32_t TelemetryWriter::version = 1;            // Bump when the header, chunk or column layout changes.
+const size_t TelemetryWriter::ringCapacity = 1 << 16;   // Over 10 minutes at 80 Hz; a power of two.
+
+static const char storeMagic[8] = {'P', 'D', 'T', 'S', 0, 0, 0, 0};
+static const uint32_t chunkMagic = 0x4b484354;  // "TCHK".
+static const int pollMs = 10;                    // Writer thread wake-up interval.
+
+static int64_t nowUs() {
+    timespec now;
+    clock_gettime(CLOCK_REALTIME, &now);
+    return (int64_t)now.tv_sec * 1000000 + now.tv_nsec / 1000;
+}
+
+static void putVarint(std::vector<uint8_t>& out, int64_t delta) {
+    uint64_t value = ((uint64_t)delta << 1) ^ (uint64_t)(delta >> 63);  // Zigzag: small magnitudes, few bytes.
+    while (value >= 0x80) {
+        out.push_back((uint8_t)value | 0x80);
+        value >>= 7;
+    }
+    out.push_back((uint8_t)value);
+}
+
+static int64_t getVarint(const uint8_t*& p, const uint8_t* end) {
+    uint64_t value = 0;
+    for (int shift = 0; p < end && shift < 64; shift += 7) {
+        uint8_t byte = *p++;
+        value |= (uint64_t)(byte & 0x7f) << shift;
+        if (!(byte & 0x80)) {
+            break;
+        }
+    }
+    return (int64_t)(value >> 1) ^ -(int64_t)(value & 1);
+}
+
+static uint64_t payloadBytes(const TelemetryChunkHeader& header) {
+    return (uint64_t)header.columnBytes[0] + header.columnBytes[1] + header.columnBytes[2] + header.columnBytes[3];
+}
+
+/**
+ * Reads and checks the header of an open store.
+ *
+ * Returns:
+ * - `true` if the file starts with a header of this version (`errno` is EINVAL otherwise).
+ */
+static bool readHeader(int fd, TelemetryFileHeader& header) {
+    ssize_t bytes = pread(fd, &header, sizeof(header), 0);
+    if (bytes != (ssize_t)sizeof(header)) {
+        if (bytes >= 0) {
+            errno = EINVAL;  // Shorter than a header.
+        }
+        return false;
+    }
+    if (memcmp(header.magic, storeMagic, sizeof(storeMagic)) != 0 || header.version != TelemetryWriter::version
+        || header.chunkRows == 0 || !(header.gramsResolution > 0)) {
+        errno = EINVAL;
+        return false;
+    }
+    return true;
+}
+
+TelemetryWriter::~TelemetryWriter() {
+    close();
+}
+
+/**
+ * Opens a store for appending, creating it if needed, and starts the writer thread.
+ *
+ * Parameters:
+ * - `path` (const char*): Store file.
+ * - `chunkRows` (uint32_t): Rows per chunk; the unit a query decodes.
+ * - `gramsResolution` (double): Grams per stored unit; finer than the scale's printed decimals.
+ * - `flushMs` (uint32_t): Longest time rows wait in memory before a (short) chunk is written.
+ *
+ * Returns:
+ * - `true` on success; `false` with `errno` set if the file cannot be opened or is not a store of
+ *   this version.
+ *
+ * Behavior:
+ * - An existing store keeps its own chunk size and resolution.
+ * - Drops a partial chunk left at the end by a crash.
+ */
+bool TelemetryWriter::open(const char* path, uint32_t chunkRows, double gramsResolution, uint32_t flushMs) {
+    close();
+    if (chunkRows == 0 || !(gramsResolution > 0)) {
+        errno = EINVAL;
+        return false;
+    }
+    fd = ::open(path, O_RDWR | O_CREAT | O_APPEND | O_CLOEXEC, 0644);
+    if (fd < 0) {
+        return false;
+    }
+
+    struct stat info;
+    TelemetryFileHeader header = {};
+    bool ok = fstat(fd, &info) == 0;
+    if (ok && info.st_size == 0) {
+        memcpy(header.magic, storeMagic, sizeof(storeMagic));
+        header.version = version;
+        header.chunkRows = chunkRows;
+        header.gramsResolution = gramsResolution;
+        header.createdUs = nowUs();
+        ok = write(fd, &header, sizeof(header)) == (ssize_t)sizeof(header);
+        if (!ok) {
+            int error = errno;
+            ftruncate(fd, 0);
+            errno = error;
+        }
+        fileBytes = sizeof(header);
+    } else if (ok && readHeader(fd, header)) {
+        fileBytes = sizeof(header);
+        TelemetryChunkHeader chunk;
+        while (pread(fd, &chunk, sizeof(chunk), fileBytes) == (ssize_t)sizeof(chunk) && chunk.magic == chunkMagic
+               && fileBytes + sizeof(chunk) + payloadBytes(chunk) <= (uint64_t)info.st_size) {
+            fileBytes += sizeof(chunk) + payloadBytes(chunk);
+        }
+        ok = fileBytes == (uint64_t)info.st_size || ftruncate(fd, fileBytes) == 0;
+    } else {
+        ok = false;
+    }
+    if (!ok) {
+        int error = errno;
+        ::close(fd);
+        fd = -1;
+        errno = error;
+        return false;
+    }
+
+    rowsPerChunk = header.chunkRows;
+    resolution = header.gramsResolution;
+    flushIntervalMs = flushMs;
+    ring.reset(new TelemetryRecord[ringCapacity]);
+    ringHead = 0;
+    ringTail = 0;
+    droppedRows = 0;
+    writeError = 0;
+    running = true;
+    writer = std::thread(&TelemetryWriter::writerLoop, this);
+    return true;
+}
+
+/**
+ * Writes the rows still in memory, stops the writer thread and closes the file.
+ *
+ * Returns:
+ * - `true` if every chunk was written; `false` with `errno` set to the first write error.
+ */
+bool TelemetryWriter::close() {
+    if (writer.joinable()) {
+        running = false;
+        writer.join();
+    }
+    if (fd >= 0) {
+        ::close(fd);
+        fd = -1;
+    }
+    if (writeError != 0) {
+        errno = writeError;
+        return false;
+    }
+    return true;
+}
+
+/**
+ * Queues a row for the writer thread. Wait-free; safe from one thread at a time (the serial
+ * reader).
+ *
+ * Returns:
+ * - `true` if queued; `false` if the ring is full (counted by `dropped()`) or the store is closed.
+ */
+bool TelemetryWriter::push(const TelemetryRecord& record) {
+    if (!running) {
+        return false;
+    }
+    size_t head = ringHead.load(std::memory_order_relaxed);
+    if (head - ringTail.load(std::memory_order_acquire) >= ringCapacity) {
+        droppedRows++;
+        return false;
+    }
+    ring[head & (ringCapacity - 1)] = record;
+    ringHead.store(head + 1, std::memory_order_release);
+    return true;
+}
+
+/**
+ * Queues a row from any thread (e.g. a host event). Takes a lock, so it is not for the reader.
+ * A `timeUs` of 0 is replaced by the current time.
+ */
+void TelemetryWriter::mark(const TelemetryRecord& record) {
+    TelemetryRecord stamped = record;
+    if (stamped.timeUs == 0) {
+        stamped.timeUs = nowUs();
+    }
+    std::lock_guard<std::mutex> guard(markLock);
+    marks.push_back(stamped);
+}
+
+/**
+ * Moves queued rows from the ring and the marks into `rows`.
+ */
+void TelemetryWriter::drain(std::vector<TelemetryRecord>& rows) {
+    size_t tail = ringTail.load(std::memory_order_relaxed);
+    size_t head = ringHead.load(std::memory_order_acquire);
+    for (; tail != head; tail++) {
+        rows.push_back(ring[tail & (ringCapacity - 1)]);
+    }
+    ringTail.store(tail, std::memory_order_release);
+
+    std::lock_guard<std::mutex> guard(markLock);
+    rows.insert(rows.end(), marks.begin(), marks.end());
+    marks.clear();
+}
+
+/**
+ * Collects rows and writes a chunk whenever `rowsPerChunk` rows are ready or the oldest waiting
+ * row is `flushIntervalMs` old; writes what is left when the store closes.
+ */
+void TelemetryWriter::writerLoop() {
+    std::vector<TelemetryRecord> rows;
+    auto oldest = std::chrono::steady_clock::now();
+    while (true) {
+        bool stopping = !running;
+        size_t before = rows.size();
+        drain(rows);
+        if (rows.size() == before) {
+            if (stopping && rows.empty()) {
+                break;
+            }
+        } else {
+            if (before == 0) {
+                oldest = std::chrono::steady_clock::now();
+            }
+            // Marks arrive out of order with the ring.
+            std::stable_sort(rows.begin(), rows.end(),
+                             [](const TelemetryRecord& a, const TelemetryRecord& b) { return a.timeUs < b.timeUs; });
+        }
+
+        size_t written = 0;
+        while (rows.size() - written >= rowsPerChunk) {
+            writeChunk(rows.data() + written, rowsPerChunk);
+            written += rowsPerChunk;
+        }
+        bool due = std::chrono::steady_clock::now() - oldest >= std::chrono::milliseconds(flushIntervalMs);
+        if (rows.size() > written && (due || stopping)) {
+            writeChunk(rows.data() + written, rows.size() - written);
+            written = rows.size();
+        }
+        if (written > 0) {
+            rows.erase(rows.begin(), rows.begin() + written);
+            oldest = std::chrono::steady_clock::now();
+        }
+        if (!stopping) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(pollMs));
+        }
+    }
+}
+
+/**
+ * Encodes `count` rows as one chunk and appends it.
+ *
+ * Returns:
+ * - `true` on success. A failed write is truncated away and its rows are lost; the first error
+ *   is kept for `close()`.
+ */
+bool TelemetryWriter::writeChunk(const TelemetryRecord* rows, size_t count) {
+    TelemetryChunkHeader header = {};
+    header.magic = chunkMagic;
+    header.rows = (uint32_t)count;
+    header.minUs = rows[0].timeUs;
+    header.maxUs = rows[count - 1].timeUs;
+
+    std::vector<uint8_t> buffer(sizeof(header));
+    buffer.reserve(sizeof(header) + count * 8);
+    for (int column = 0; column < 4; column++) {
+        size_t start = buffer.size();
+        int64_t previous = 0;
+        for (size_t i = 0; i < count; i++) {
+            const TelemetryRecord& row = rows[i];
+            int64_t value;
+            switch (column) {
+                case 0:  value = row.timeUs; break;
+                case 1:  value = std::isfinite(row.grams) ? llround(row.grams / resolution) : 0; break;
+                case 2:  value = row.steps; break;
+                default: value = row.event; break;
+            }
+            putVarint(buffer, value - previous);
+            previous = value;
+        }
+        header.columnBytes[column] = (uint32_t)(buffer.size() - start);
+    }
+    memcpy(buffer.data(), &header, sizeof(header));
+
+    ssize_t written = write(fd, buffer.data(), buffer.size());
+    if (written != (ssize_t)buffer.size()) {
+        int error = written < 0 ? errno : ENOSPC;
+        ftruncate(fd, fileBytes);
+        int expected = 0;
+        writeError.compare_exchange_strong(expected, error);
+        return false;
+    }
+    fileBytes += buffer.size();
+    return true;
+}
+
+TelemetryReader::~TelemetryReader() {
+    close();
+}
+
+/**
+ * Opens a store and maps it read-only.
+ *
+ * Returns:
+ * - `true` on success; `false` with `errno` set if the file cannot be opened or is not a store of
+ *   this version.
+ */
+bool TelemetryReader::open(const char* path) {
+    close();
+    fd = ::open(path, O_RDONLY | O_CLOEXEC);
+    if (fd < 0) {
+        return false;
+    }
+    TelemetryFileHeader header;
+    if (!readHeader(fd, header)) {
+        int error = errno;
+        close();
+        errno = error;
+        return false;
+    }
+    resolution = header.gramsResolution;
+    indexedBytes = sizeof(header);
+    if (!map()) {
+        int error = errno;
+        close();
+        errno = error;
+        return false;
+    }
+    return true;
+}
+
+/**
+ * Maps the whole file as it is now and indexes the complete chunks not indexed yet.
+ */
+bool TelemetryReader::map() {
+    struct stat info;
+    if (fstat(fd, &info) != 0) {
+        return false;
+    }
+    size_t bytes = (size_t)info.st_size;
+    if (bytes == mappedBytes) {
+        return true;
+    }
+    void* next = mmap(nullptr, bytes, PROT_READ, MAP_SHARED, fd, 0);
+    if (next == MAP_FAILED) {
+        return false;
+    }
+    if (mapping != nullptr) {
+        munmap(mapping, mappedBytes);
+    }
+    mapping = next;
+    mappedBytes = bytes;
+
+    const char* base = static_cast<const char*>(mapping);
+    ChunkIndex chunk;
+    while (indexedBytes + sizeof(chunk.header) <= mappedBytes) {
+        memcpy(&chunk.header, base + indexedBytes, sizeof(chunk.header));
+        uint64_t end = indexedBytes + sizeof(chunk.header) + payloadBytes(chunk.header);
+        if (chunk.header.magic != chunkMagic || end > mappedBytes) {
+            break;  // Still being written.
+        }
+        chunk.offset = indexedBytes;
+        chunks.push_back(chunk);
+        rowCount += chunk.header.rows;
+        indexedBytes = end;
+    }
+    return true;
+}
+
+/**
+ * Picks up chunks appended since `open()` or the last `refresh()`.
+ */
+bool TelemetryReader::refresh() {
+    if (fd < 0) {
+        errno = EBADF;
+        return false;
+    }
+    return map();
+}
+
+/**
+ * Gets the time range of the whole store.
+ *
+ * Returns:
+ * - `false` if the store has no rows.
+ */
+bool TelemetryReader::timeRange(int64_t* minUs, int64_t* maxUs) const {
+    if (chunks.empty()) {
+        return false;
+    }
+    *minUs = chunks[0].header.minUs;
+    *maxUs = chunks[0].header.maxUs;
+    for (const ChunkIndex& chunk : chunks) {
+        *minUs = std::min(*minUs, chunk.header.minUs);
+        *maxUs = std::max(*maxUs, chunk.header.maxUs);
+    }
+    return true;
+}
+
+/**
+ * Decodes the rows with `fromUs <= timeUs < toUs` into the result columns (`times()` etc.).
+ *
+ * Returns:
+ * - The number of rows, in store order. Only chunks overlapping the range are decoded.
+ */
+size_t TelemetryReader::query(int64_t fromUs, int64_t toUs) {
+    resultTimes.clear();
+    resultGrams.clear();
+    resultSteps.clear();
+    resultEvents.clear();
+    for (const ChunkIndex& chunk : chunks) {
+        if (chunk.header.maxUs >= fromUs && chunk.header.minUs < toUs) {
+            decode(chunk, fromUs, toUs);
+        }
+    }
+    return resultTimes.size();
+}
+
+void TelemetryReader::decode(const ChunkIndex& chunk, int64_t fromUs, int64_t toUs) {
+    const uint8_t* column[5];
+    column[0] = static_cast<const uint8_t*>(mapping) + chunk.offset + sizeof(TelemetryChunkHeader);
+    for (int i = 0; i < 4; i++) {
+        column[i + 1] = column[i] + chunk.header.columnBytes[i];
+    }
+    const uint8_t* time = column[0];
+    const uint8_t* grams = column[1];
+    const uint8_t* steps = column[2];
+    const uint8_t* event = column[3];
+
+    size_t needed = resultTimes.size() + chunk.header.rows;
+    if (resultTimes.capacity() < needed) {
+        size_t reserve = std::max(needed, 2 * resultTimes.capacity());  // Grow geometrically across chunks.
+        resultTimes.reserve(reserve);
+        resultGrams.reserve(reserve);
+        resultSteps.reserve(reserve);
+        resultEvents.reserve(reserve);
+    }
+
+    int64_t t = 0, g = 0, s = 0, e = 0;
+    for (uint32_t row = 0; row < chunk.header.rows; row++) {
+        t += getVarint(time, column[1]);
+        g += getVarint(grams, column[2]);
+        s += getVarint(steps, column[3]);
+        e += getVarint(event, column[4]);
+        if (t >= fromUs && t < toUs) {
+            resultTimes.push_back(t);
+            resultGrams.push_back((float)(g * resolution));
+            resultSteps.push_back((int32_t)s);
+            resultEvents.push_back((uint16_t)e);
+        }
+    }
+}
+
+void TelemetryReader::close() {
+    if (mapping != nullptr) {
+        munmap(mapping, mappedBytes);
+        mapping = nullptr;
+    }
+    mappedBytes = 0;
+    indexedBytes = 0;
+    rowCount = 0;
+    chunks.clear();
+    if (fd >= 0) {
+        ::close(fd);
+        fd = -1;
+    }
+}
+
+extern "C" {
+
+TelemetryWriter* telemetry_writer_open(const char* path, uint32_t chunkRows, double gramsResolution, uint32_t flushMs) {
+    TelemetryWriter* writer = new TelemetryWriter();
+    if (!writer->open(path, chunkRows, gramsResolution, flushMs)) {
+        int error = errno;
+        delete writer;
+        errno = error;
+        return nullptr;
+    }
+    return writer;
+}
+
+void telemetry_writer_mark(TelemetryWriter* writer, const TelemetryRecord* record) {
+    writer->mark(*record);
+}
+
+uint64_t telemetry_writer_dropped(const TelemetryWriter* writer) {
+    return writer->dropped();
+}
+
+int telemetry_writer_close(TelemetryWriter* writer) {
+    bool ok = writer->close();
+    int error = errno;
+    delete writer;
+    errno = error;
+    return ok ? 0 : -1;
+}
+
+TelemetryReader* telemetry_reader_open(const char* path) {
+    TelemetryReader* reader = new TelemetryReader();
+    if (!reader->open(path)) {
+        int error = errno;
+        delete reader;
+        errno = error;
+        return nullptr;
+    }
+    return reader;
+}
+
+int telemetry_reader_refresh(TelemetryReader* reader) {
+    return reader->refresh() ? 0 : -1;
+}
+
+uint64_t telemetry_reader_count(const TelemetryReader* reader) {
+    return reader->count();
+}
+
+int telemetry_reader_time_range(const TelemetryReader* reader, int64_t* minUs, int64_t* maxUs) {
+    if (!reader->timeRange(minUs, maxUs)) {
+        errno = ENODATA;
+        return -1;
+    }
+    return 0;
+}
+
+size_t telemetry_reader_query(TelemetryReader* reader, int64_t fromUs, int64_t toUs) {
+    return reader->query(fromUs, toUs);
+}
+
+const int64_t* telemetry_reader_times(const TelemetryReader* reader) {
+    return reader->times();
+}
+
+const float* telemetry_reader_grams(const TelemetryReader* reader) {
+    return reader->grams();
+}
+
+const int32_t* telemetry_reader_steps(const TelemetryReader* reader) {
+    return reader->steps();
+}
+
+const uint16_t* telemetry_reader_events(const TelemetryReader* reader) {
+    return reader->events();
+}
+
+void telemetry_reader_close(TelemetryReader* reader) {
+    delete reader;
+}
+
+}
@@ -0,0 +1,55 @@
+#ifndef CHECK_H
+#define CHECK_H
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string>
+#include <unistd.h>
+
+/**
+ * Minimal assertions for the native library tests, run by `ctest`.
+ *
+ * `CHECK()` reports a failed condition with its location and lets the test go on; `RUN_TEST()`
+ * prints PASS or FAIL per test function, and `checkResult()` is the exit code of `main()`.
+ */
+static int checkFailures = 0;
+
+#define CHECK(condition)                                                                  \
+    do {                                                                                  \
+        if (!(condition)) {                                                               \
+            fprintf(stderr, "%s:%d: CHECK(%s) failed\n", __FILE__, __LINE__, #condition); \
+            checkFailures++;                                                              \
+        }                                                                                 \
+    } while (0)
+
+#define RUN_TEST(test)                                                          \
+    do {                                                                        \
+        int failuresBefore = checkFailures;                                     \
+        test();                                                                 \
+        printf("%s %s\n", checkFailures == failuresBefore ? "PASS" : "FAIL", #test); \
+    } while (0)
+
+inline int checkResult() {
+    printf("%d failures\n", checkFailures);
+    return checkFailures == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+}
+
+/**
+ * Returns a path in a fresh temporary directory; `removeTemp()` deletes both.
+ */
+inline std::string tempPath(const char* name) {
+    const char* base = getenv("TMPDIR");
+    std::string dir = std::string(base ? base : "/tmp") + "/powderhost-test-XXXXXX";
+    if (mkdtemp(&dir[0]) == nullptr) {
+        perror("mkdtemp");
+        exit(EXIT_FAILURE);
+    }
+    return dir + "/" + name;
+}
+
+inline void removeTemp(const std::string& path) {
+    unlink(path.c_str());
+    rmdir(path.substr(0, path.rfind('/')).c_str());
+}
+
+#endif // CHECK_H
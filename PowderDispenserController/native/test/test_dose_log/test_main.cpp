@@ -0,0 +1,109 @@
+#include <errno.h>
+#include <fcntl.h>
+#include <string.h>
+#include <sys/stat.h>
+
+#include "Check.h"
+#include "DoseLog.h"
+
+static DoseRecord makeDose(float desiredG, float measuredG, int32_t steps) {
+    DoseRecord record = {};
+    record.kind = DOSE_RECORD_DOSE;
+    record.fields = DOSE_FIELD_DESIRED | DOSE_FIELD_MEASURED | DOSE_FIELD_STEPS;
+    record.desiredG = desiredG;
+    record.measuredG = measuredG;
+    record.steps = steps;
+    memcpy(record.augerType, "8mm_base", 8);
+    return record;
+}
+
+static off_t fileSize(const std::string& path) {
+    struct stat info;
+    return stat(path.c_str(), &info) == 0 ? info.st_size : -1;
+}
+
+static void appendBytes(const std::string& path, size_t count) {
+    int fd = open(path.c_str(), O_WRONLY | O_APPEND);
+    std::string garbage(count, '\x5a');
+    CHECK(write(fd, garbage.data(), count) == (ssize_t)count);
+    close(fd);
+}
+
+void test_records_round_trip() {
+    std::string path = tempPath("doses.log");
+    DoseLogWriter writer;
+    CHECK(writer.open(path.c_str()));
+    DoseRecord stamped = makeDose(0.25, 0.2481, 11830);
+    stamped.timeUs = 1234;
+    CHECK(writer.append(stamped));
+    CHECK(writer.append(makeDose(1.0, 0.9987, 47322)));
+
+    DoseLogReader reader;
+    CHECK(reader.open(path.c_str()));
+    CHECK(reader.count() == 2);
+    const DoseRecord* records = reader.records();
+    CHECK(records[0].timeUs == 1234);
+    CHECK(records[0].kind == DOSE_RECORD_DOSE);
+    CHECK(records[0].desiredG == 0.25f && records[0].measuredG == 0.2481f && records[0].steps == 11830);
+    CHECK(memcmp(records[0].augerType, "8mm_base", 8) == 0);
+    CHECK(records[1].timeUs > 1000000000LL * 1000000);  // Stamped with the append time.
+
+    CHECK(writer.append(makeDose(0.1, 0.1002, 4732)));
+    CHECK(reader.count() == 2);  // New records appear only after a refresh.
+    CHECK(reader.refresh());
+    CHECK(reader.count() == 3);
+    CHECK(reader.records()[2].steps == 4732);
+    removeTemp(path);
+}
+
+void test_partial_record_is_dropped() {
+    std::string path = tempPath("doses.log");
+    {
+        DoseLogWriter writer;
+        CHECK(writer.open(path.c_str()));
+        CHECK(writer.append(makeDose(0.25, 0.25, 100)));
+        CHECK(writer.append(makeDose(0.5, 0.5, 200)));
+    }
+    off_t complete = fileSize(path);
+    appendBytes(path, sizeof(DoseRecord) / 2);  // A crash in the middle of a record.
+
+    DoseLogReader reader;
+    CHECK(reader.open(path.c_str()));
+    CHECK(reader.count() == 2);  // Readers ignore the partial record.
+    reader.close();
+
+    DoseLogWriter writer;
+    CHECK(writer.open(path.c_str()));
+    CHECK(fileSize(path) == complete);  // The next writer drops it.
+    CHECK(writer.append(makeDose(1.0, 1.0, 300)));
+    CHECK(reader.open(path.c_str()));
+    CHECK(reader.count() == 3);
+    CHECK(reader.records()[2].steps == 300);  // Aligned after the two complete records.
+    removeTemp(path);
+}
+
+void test_foreign_file_is_rejected() {
+    std::string path = tempPath("doses.log");
+    int fd = open(path.c_str(), O_WRONLY | O_CREAT, 0644);
+    const char text[] = "timestamp,desired,measured\n0,0.25,0.2481\n";
+    CHECK(write(fd, text, sizeof(text)) == (ssize_t)sizeof(text));
+    close(fd);
+
+    DoseLogReader reader;
+    errno = 0;
+    CHECK(!reader.open(path.c_str()));
+    CHECK(errno == EINVAL);
+    DoseLogWriter writer;
+    errno = 0;
+    CHECK(!writer.open(path.c_str()));
+    CHECK(errno == EINVAL);
+    CHECK(fileSize(path) == (off_t)sizeof(text));  // Left untouched.
+    removeTemp(path);
+}
+
+int main() {
+    RUN_TEST(test_records_round_trip);
+    RUN_TEST(test_partial_record_is_dropped);
+    RUN_TEST(test_foreign_file_is_rejected);
+    return checkResult();
+}
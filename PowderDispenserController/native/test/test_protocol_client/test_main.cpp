@@ -0,0 +1,141 @@
+#include <errno.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <string.h>
+#include <termios.h>
+
+#include <chrono>
+#include <thread>
+
+#include "Check.h"
+#include "ProtocolClient.h"
+
+/**
+ * A pseudo-terminal standing in for the device: the client opens the slave side as its port and
+ * the test plays the firmware on the master side.
+ */
+struct FakeDevice {
+    int master = -1;
+    std::string port;
+
+    FakeDevice() {
+        master = posix_openpt(O_RDWR | O_NOCTTY);
+        if (master < 0 || grantpt(master) != 0 || unlockpt(master) != 0) {
+            perror("posix_openpt");
+            exit(EXIT_FAILURE);
+        }
+        port = ptsname(master);
+    }
+
+    ~FakeDevice() { close(master); }
+
+    void print(const std::string& text) {
+        CHECK(write(master, text.data(), text.size()) == (ssize_t)text.size());
+        std::this_thread::sleep_for(std::chrono::milliseconds(20));  // Separate reads for the client.
+    }
+
+    std::string received(size_t length) {
+        std::string text;
+        char buffer[256];
+        pollfd in = {master, POLLIN, 0};
+        while (text.size() < length && poll(&in, 1, 1000) > 0) {
+            ssize_t n = read(master, buffer, sizeof(buffer));
+            if (n <= 0) {
+                break;
+            }
+            text.append(buffer, n);
+        }
+        return text;
+    }
+};
+
+static std::string nextFrame(ProtocolClient& client, int timeoutMs = 1000) {
+    char frame[1024];
+    int length = client.nextFrame(frame, sizeof(frame), timeoutMs);
+    return length < 0 ? std::string("!error") : std::string(frame, length);
+}
+
+void test_frames_split_across_reads() {
+    FakeDevice device;
+    ProtocolClient client;
+    CHECK(client.open(device.port.c_str(), 115200));
+
+    device.print("Relay connected\r\n<Ready to push");  // Text outside frames is ignored.
+    device.print(" powder, baby!>\r\n<Msg Ta");
+    device.print("re Time 3>\r\n<Weight:0.2481><ScaleReady>\r\n");
+    CHECK(nextFrame(client) == "Ready to push powder, baby!");
+    CHECK(nextFrame(client) == "Msg Tare Time 3");
+    CHECK(nextFrame(client) == "Weight:0.2481");
+    CHECK(nextFrame(client) == "ScaleReady");
+
+    char frame[64];
+    errno = 0;
+    CHECK(client.nextFrame(frame, sizeof(frame), 50) == -1);
+    CHECK(errno == ETIMEDOUT);
+}
+
+void test_telemetry_bypasses_the_frame_queue() {
+    FakeDevice device;
+    ProtocolClient client;
+    CHECK(client.open(device.port.c_str(), 115200));
+
+    device.print("<S t:1000 g:0.2500><Msg Stream,1 Time 2><S t:10");
+    device.print("03.125 g:-0.0012>\r\n<S t:1006.25 r:8123456>");
+    device.print("<S t:1009 x:1>");  // Neither grams nor raw counts: an ordinary frame.
+    CHECK(nextFrame(client) == "Msg Stream,1 Time 2");
+    CHECK(nextFrame(client) == "S t:1009 x:1");
+    CHECK(client.pendingFrames() == 0);
+
+    double times[8];
+    float grams[8];
+    CHECK(client.readTelemetry(times, grams, 8) == 3);
+    CHECK(times[0] == 1000 && grams[0] == 0.25f);
+    CHECK(times[1] == 1003.125 && grams[1] == -0.0012f);
+    CHECK(times[2] == 1006.25 && grams[2] == 8123456.0f);
+    CHECK(client.readTelemetry(times, grams, 8) == 0);  // Each sample is returned once.
+    CHECK(client.droppedTelemetry() == 0);
+}
+
+void test_oversized_frame_is_dropped() {
+    FakeDevice device;
+    ProtocolClient client;
+    CHECK(client.open(device.port.c_str(), 115200));
+
+    device.print("<" + std::string(600, 'x') + ">");  // Line noise longer than any frame.
+    device.print("<Msg Meas,100 Time 320>");
+    CHECK(nextFrame(client) == "Msg Meas,100 Time 320");
+    CHECK(client.pendingFrames() == 0);
+
+    device.print("<Cfg rev:3 bytes:120 sections:4>");
+    char small[8];
+    CHECK(client.nextFrame(small, sizeof(small), 1000) == 7);  // Truncated to the caller's buffer.
+    CHECK(strcmp(small, "Cfg rev") == 0);
+}
+
+void test_send_and_wait_for() {
+    FakeDevice device;
+    ProtocolClient client;
+    CHECK(client.open(device.port.c_str(), 115200));
+
+    CHECK(client.send("<Dose,0.25,0>"));
+    CHECK(device.received(13) == "<Dose,0.25,0>");
+
+    device.print("<Msg Dose,0.25,0 Time 1><Dose target:0.2500 mass:0.2481 bursts:17 ms:29642>");
+    char frame[128];
+    int length = client.waitFor("Dose target", frame, sizeof(frame), 1000);
+    CHECK(length > 0 && strncmp(frame, "Dose target:0.2500", 18) == 0);
+    CHECK(client.pendingFrames() == 0);  // The acknowledgement before it was dropped.
+
+    client.close();
+    errno = 0;
+    CHECK(client.nextFrame(frame, sizeof(frame), 50) == -1);
+    CHECK(errno == EIO);
+}
+
+int main() {
+    RUN_TEST(test_frames_split_across_reads);
+    RUN_TEST(test_telemetry_bypasses_the_frame_queue);
+    RUN_TEST(test_oversized_frame_is_dropped);
+    RUN_TEST(test_send_and_wait_for);
+    return checkResult();
+}
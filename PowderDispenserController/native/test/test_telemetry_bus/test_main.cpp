@@ -0,0 +1,132 @@
+#include <errno.h>
+#include <sys/mman.h>
+
+#include "Check.h"
+#include "TelemetryBus.h"
+
+/**
+ * A bus name of this test run, so parallel runs do not share a segment; removed by `unlinkBus()`.
+ */
+static std::string busName(const char* test) {
+    return std::string("test-") + test + "." + std::to_string(getpid());
+}
+
+static void unlinkBus(const std::string& name) {
+    shm_unlink(("/powderbus." + name).c_str());
+}
+
+static TelemetryRecord sample(int i) {
+    return TelemetryRecord{1000000 + i, (float)(0.001 * i), 0, TELEMETRY_SAMPLE};
+}
+
+static void publishRange(TelemetryBusWriter& writer, int first, int count) {
+    for (int i = first; i < first + count; i++) {
+        writer.publish(sample(i));
+    }
+}
+
+void test_reader_sees_new_samples_in_order() {
+    std::string name = busName("order");
+    TelemetryBusWriter writer;
+    CHECK(writer.open(name.c_str(), 16));
+    publishRange(writer, 0, 5);
+
+    TelemetryBusReader reader;
+    CHECK(reader.open(name.c_str()));
+    CHECK(reader.writerAlive());
+    CHECK(reader.available() == 0);  // Starts at the next new sample.
+    publishRange(writer, 5, 10);
+    CHECK(reader.available() == 10);
+
+    TelemetryRecord out[32];
+    CHECK(reader.read(out, 4) == 4);
+    CHECK(out[0].timeUs == sample(5).timeUs && out[3].grams == sample(8).grams);
+    CHECK(reader.read(out, 32) == 6);
+    CHECK(out[5].timeUs == sample(14).timeUs);
+    CHECK(reader.read(out, 32) == 0);
+    CHECK(reader.lost() == 0);
+
+    TelemetryBusReader late;
+    CHECK(late.open(name.c_str(), true));  // From the oldest sample still in the ring.
+    CHECK(late.read(out, 32) == 15);
+    CHECK(out[0].timeUs == sample(0).timeUs);
+
+    writer.close();
+    CHECK(!reader.writerAlive());
+    unlinkBus(name);
+}
+
+void test_lapped_reader_counts_lost_samples() {
+    std::string name = busName("lapped");
+    TelemetryBusWriter writer;
+    CHECK(writer.open(name.c_str(), 16));
+    TelemetryBusReader reader;
+    CHECK(reader.open(name.c_str()));
+
+    publishRange(writer, 0, 40);  // Two and a half rings while the reader is stopped.
+    CHECK(reader.available() == 16);
+    TelemetryRecord out[32];
+    CHECK(reader.read(out, 32) == 15);  // The slot the writer would fill next is skipped too.
+    CHECK(reader.lost() == 25);
+    CHECK(out[0].timeUs == sample(25).timeUs && out[14].timeUs == sample(39).timeUs);
+
+    publishRange(writer, 40, 3);
+    CHECK(reader.read(out, 32) == 3);
+    CHECK(out[0].timeUs == sample(40).timeUs);
+    CHECK(reader.lost() == 25);
+
+    TelemetryBusReader full;
+    CHECK(full.open(name.c_str(), true));
+    CHECK(full.read(out, 32) == 15);
+    CHECK(full.lost() == 0);
+    unlinkBus(name);
+}
+
+void test_reader_follows_a_restarted_writer() {
+    std::string name = busName("restart");
+    TelemetryBusReader reader;
+    errno = 0;
+    CHECK(!reader.open(name.c_str()));  // No writer has created the bus yet.
+
+    TelemetryBusWriter writer;
+    CHECK(writer.open(name.c_str(), 16));
+    CHECK(reader.open(name.c_str()));
+    publishRange(writer, 0, 8);
+    TelemetryRecord out[32];
+    CHECK(reader.read(out, 32) == 8);
+
+    TelemetryBusWriter second;
+    errno = 0;
+    CHECK(!second.open(name.c_str(), 16));  // The first writer is still running.
+    CHECK(errno == EBUSY);
+
+    writer.close();  // The service restarts under the same name.
+    CHECK(second.open(name.c_str(), 16));
+    publishRange(second, 100, 3);
+    CHECK(reader.available() == 3);
+    CHECK(reader.read(out, 32) == 3);  // From the new ring's first sample, not from index 8.
+    CHECK(out[0].timeUs == sample(100).timeUs && out[2].timeUs == sample(102).timeUs);
+    CHECK(reader.lost() == 0);
+    CHECK(reader.writerAlive());
+
+    second.close();
+    unlinkBus(name);
+}
+
+void test_invalid_buses_are_rejected() {
+    TelemetryBusWriter writer;
+    errno = 0;
+    CHECK(!writer.open(busName("capacity").c_str(), 12));  // Not a power of two.
+    CHECK(errno == EINVAL);
+    errno = 0;
+    CHECK(!writer.open("a/b", 16));
+    CHECK(errno == EINVAL);
+}
+
+int main() {
+    RUN_TEST(test_reader_sees_new_samples_in_order);
+    RUN_TEST(test_lapped_reader_counts_lost_samples);
+    RUN_TEST(test_reader_follows_a_restarted_writer);
+    RUN_TEST(test_invalid_buses_are_rejected);
+    return checkResult();
+}
@@ -0,0 +1,135 @@
+#include <errno.h>
+#include <fcntl.h>
+#include <math.h>
+#include <sys/stat.h>
+
+#include <chrono>
+#include <thread>
+
+#include "Check.h"
+#include "TelemetryStore.h"
+
+static const int64_t startUs = 1760000000000000LL;  // Device samples in host time.
+static const int64_t periodUs = 12500;              // 80 Hz.
+
+static TelemetryRecord sampleRow(int i) {
+    return TelemetryRecord{startUs + i * periodUs, (float)(0.25 + 0.001 * i - 0.0000037 * (i % 7)), 0, TELEMETRY_SAMPLE};
+}
+
+static off_t fileSize(const std::string& path) {
+    struct stat info;
+    return stat(path.c_str(), &info) == 0 ? info.st_size : -1;
+}
+
+/**
+ * Writes `rows` samples starting at row `first` to the store at `path` and closes it.
+ */
+static void writeSamples(const std::string& path, int first, int rows, uint32_t chunkRows) {
+    TelemetryWriter writer;
+    CHECK(writer.open(path.c_str(), chunkRows));
+    for (int i = first; i < first + rows; i++) {
+        CHECK(writer.push(sampleRow(i)));
+    }
+    CHECK(writer.close());
+}
+
+void test_rows_round_trip() {
+    std::string path = tempPath("telemetry.pdts");
+    TelemetryWriter writer;
+    CHECK(writer.open(path.c_str(), 100, 1e-5));
+    for (int i = 0; i < 250; i++) {
+        TelemetryRecord row = sampleRow(i);
+        row.grams = i == 3 ? -0.0421f : row.grams;  // Deltas go both ways.
+        CHECK(writer.push(row));
+    }
+    writer.mark(TelemetryRecord{startUs + 10 * periodUs + 1, 0.5, 4096, TELEMETRY_DISPENSE});
+    CHECK(writer.close());
+    CHECK(writer.dropped() == 0);
+
+    TelemetryReader reader;
+    CHECK(reader.open(path.c_str()));
+    CHECK(reader.count() == 251);
+    int64_t minUs = 0, maxUs = 0;
+    CHECK(reader.timeRange(&minUs, &maxUs));
+    CHECK(minUs == startUs && maxUs == startUs + 249 * periodUs);
+
+    CHECK(reader.query(INT64_MIN, INT64_MAX) == 251);
+    CHECK(reader.times()[3] == startUs + 3 * periodUs);
+    CHECK(fabsf(reader.grams()[3] - -0.0421f) <= 0.5e-5f);
+    CHECK(reader.times()[11] == startUs + 10 * periodUs + 1);  // The mark, merged in time order.
+    CHECK(reader.events()[11] == TELEMETRY_DISPENSE && reader.steps()[11] == 4096);
+    bool gramsMatch = true;
+    for (int i = 12; i < 251; i++) {
+        TelemetryRecord expected = sampleRow(i - 1);
+        gramsMatch &= reader.times()[i] == expected.timeUs && fabsf(reader.grams()[i] - expected.grams) <= 0.5e-5f
+                      && reader.events()[i] == TELEMETRY_SAMPLE;
+    }
+    CHECK(gramsMatch);
+
+    CHECK(reader.query(startUs + 150 * periodUs, startUs + 160 * periodUs) == 10);  // From inside one chunk.
+    CHECK(reader.times()[0] == startUs + 150 * periodUs);
+    CHECK(reader.query(startUs + 300 * periodUs, INT64_MAX) == 0);
+    removeTemp(path);
+}
+
+void test_partial_chunk_is_dropped() {
+    std::string path = tempPath("telemetry.pdts");
+    writeSamples(path, 0, 200, 100);
+    off_t complete = fileSize(path);
+
+    // A crash in the middle of a chunk: its header and part of its payload made it to disk.
+    int fd = open(path.c_str(), O_RDWR | O_APPEND);
+    char partial[sizeof(TelemetryChunkHeader) + 10];
+    CHECK(pread(fd, partial, sizeof(partial), sizeof(TelemetryFileHeader)) == (ssize_t)sizeof(partial));
+    CHECK(write(fd, partial, sizeof(partial)) == (ssize_t)sizeof(partial));
+    close(fd);
+
+    TelemetryReader reader;
+    CHECK(reader.open(path.c_str()));
+    CHECK(reader.count() == 200);  // Readers ignore the partial chunk.
+    reader.close();
+
+    TelemetryWriter writer;
+    CHECK(writer.open(path.c_str(), 7, 1e-3));  // The store keeps its own chunk size and resolution.
+    CHECK(fileSize(path) == complete);          // The next writer drops the partial chunk.
+    for (int i = 200; i < 300; i++) {
+        CHECK(writer.push(sampleRow(i)));
+    }
+    CHECK(writer.close());
+
+    CHECK(reader.open(path.c_str()));
+    CHECK(reader.count() == 300);
+    CHECK(reader.query(startUs + 199 * periodUs, startUs + 201 * periodUs) == 2);
+    CHECK(fabsf(reader.grams()[1] - sampleRow(200).grams) <= 0.5e-5f);  // Still 1e-5 g resolution.
+    removeTemp(path);
+}
+
+void test_reader_follows_the_writer() {
+    std::string path = tempPath("telemetry.pdts");
+    TelemetryWriter writer;
+    CHECK(writer.open(path.c_str(), 50, 1e-5, 20));
+    TelemetryReader reader;
+    CHECK(reader.open(path.c_str()));
+    CHECK(reader.count() == 0);
+
+    for (int i = 0; i < 60; i++) {
+        CHECK(writer.push(sampleRow(i)));
+    }
+    std::this_thread::sleep_for(std::chrono::milliseconds(200));  // A full chunk, then the flush interval.
+    CHECK(reader.refresh());
+    CHECK(reader.count() == 60);
+    CHECK(writer.close());
+
+    TelemetryWriter other;
+    errno = 0;
+    CHECK(!other.open(path.c_str(), 0));
+    CHECK(errno == EINVAL);
+    removeTemp(path);
+}
+
+int main() {
+    RUN_TEST(test_rows_round_trip);
+    RUN_TEST(test_partial_chunk_is_dropped);
+    RUN_TEST(test_reader_follows_the_writer);
+    return checkResult();
+}
@@ -0,0 +1,185 @@
+"""
+Host tool for the firmware's statistical sampling profiler.
+
+The firmware (built with the `sparkfun_redboard_profile` PlatformIO environment) samples the
+interrupted program counter into a histogram and returns it with `<ProfDump>`. This module parses
+that dump, symbolizes the buckets against the firmware ELF and prints a flat profile.
+
+Functions:
+    parse_dump(dump) - Parses a `<Prof ...>` frame into window parameters and bucket counts.
+    load_symbols(elf_file, nm) - Reads the function symbols of the firmware ELF using avr-nm.
+    flat_profile(dump, symbols) - Attributes the bucket counts to functions.
+    print_profile(profile, total) - Prints a flat profile table.
+    collect(ser, duration, shift, base) - Runs a profiling window over an open serial port.
+
+Usage:
+    python -m PowderDispenserController.profiler --elf .pio/build/sparkfun_redboard_profile/firmware.elf --dump prof.txt
+    python -m PowderDispenserController.profiler --elf firmware.elf --port COM3 --duration 30
+"""
+
+import argparse
+import re
+import subprocess
+import time
+
+FLASH_BYTES = 32768  # ATmega328P flash size.
+
+
+def parse_dump(dump):
+    """
+    Parses a profiler dump frame.
+
+    Parameters:
+        dump (str): The `<Prof base:B shift:S total:T other:O index:count;...>` frame (markers optional).
+
+    Returns:
+        dict: `base`, `shift`, `total` and `other` as ints, and `buckets` mapping bucket index to count.
+
+    Raises:
+        ValueError: If the frame is not a profiler dump or the profiler is disabled.
+    """
+    dump = dump.strip().strip('<>').strip()
+    if dump.startswith('Prof disabled'):
+        raise ValueError("Profiler is not built into this firmware. Use the sparkfun_redboard_profile environment.")
+    header = re.match(r'Prof base:(\d+) shift:(\d+) total:(\d+) other:(\d+)\s*(.*)$', dump, re.S)
+    if header is None:
+        raise ValueError(f"Not a profiler dump: {dump[:40]}")
+
+    buckets = {}
+    for entry in header.group(5).split(';'):
+        if ':' in entry:
+            index, count = entry.split(':')
+            buckets[int(index)] = int(count)
+
+    return {
+        'base': int(header.group(1)),
+        'shift': int(header.group(2)),
+        'total': int(header.group(3)),
+        'other': int(header.group(4)),
+        'buckets': buckets,
+    }
+
+
+def load_symbols(elf_file, nm='avr-nm'):
+    """
+    Reads the sized function symbols of the firmware ELF.
+
+    Parameters:
+        elf_file (str): Path to the firmware ELF (e.g. `.pio/build/<env>/firmware.elf`).
+        nm (str, optional): The nm binary of the AVR toolchain (default: 'avr-nm').
+
+    Returns:
+        list: `(start, end, name)` tuples for text symbols, sorted by start address.
+    """
+    output = subprocess.run([nm, '--print-size', '--demangle', '--defined-only', elf_file],
+                            capture_output=True, text=True, check=True).stdout
+    symbols = []
+    for line in output.splitlines():
+        parts = line.split(None, 3)
+        if len(parts) == 4 and parts[2] in 'tTwW':
+            start, size = int(parts[0], 16), int(parts[1], 16)
+            if size > 0 and start < FLASH_BYTES:
+                symbols.append((start, start + size, parts[3]))
+    return sorted(symbols)
+
+
+def flat_profile(dump, symbols):
+    """
+    Attributes the samples of each bucket to the functions overlapping it, in proportion to the overlap.
+
+    Parameters:
+        dump (dict): A parsed dump from `parse_dump()`.
+        symbols (list): Symbols from `load_symbols()`.
+
+    Returns:
+        list: `(samples, name)` tuples sorted by descending sample count.
+    """
+    width = 1 << dump['shift']
+    samples = {}
+    for index, count in dump['buckets'].items():
+        low = dump['base'] + index * width
+        high = low + width
+        covered = 0
+        for start, end, name in symbols:
+            overlap = min(end, high) - max(start, low)
+            if overlap > 0:
+                samples[name] = samples.get(name, 0) + count * overlap / width
+                covered += overlap
+        if covered < width:
+            unknown = f"<unknown 0x{low:04x}-0x{high:04x}>"
+            samples[unknown] = samples.get(unknown, 0) + count * (width - covered) / width
+    if dump['other']:
+        samples['<outside window>'] = dump['other']
+    return sorted(((s, n) for n, s in samples.items()), reverse=True)
+
+
+def print_profile(profile, total, limit=30):
+    """
+    Prints a flat profile table.
+
+    Parameters:
+        profile (list): The result of `flat_profile()`.
+        total (int): Total number of samples in the dump.
+        limit (int, optional): Maximum number of rows to print (default: 30).
+    """
+    total = max(total, 1)
+    cumulative = 0.0
+    print(f"{'samples':>9} {'%':>6} {'cum %':>6}  function")
+    for samples, name in profile[:limit]:
+        cumulative += samples
+        print(f"{samples:9.1f} {100 * samples / total:6.2f} {100 * cumulative / total:6.2f}  {name}")
+
+
+def collect(ser, duration, shift=8, base=0):
+    """
+    Runs one profiling window on a connected device and returns the dump frame.
+
+    Parameters:
+        ser (serial.Serial): Open serial port to the device.
+        duration (float): Sampling time in seconds; run the workload meanwhile.
+        shift (int, optional): log2 of the flash bytes per bucket (default: 8).
+        base (int, optional): First flash byte address covered by the histogram (default: 0).
+
+    Returns:
+        str: The `<Prof ...>` frame.
+    """
+    ser.reset_input_buffer()
+    ser.write(f"<ProfStart,{shift},{base}>".encode('utf-8'))
+    time.sleep(duration)
+    ser.write(b"<ProfStop>")
+    ser.reset_input_buffer()
+    ser.write(b"<ProfDump>")
+    while True:
+        line = ser.readline().decode('utf-8', errors='replace')
+        if line.startswith('<Prof'):
+            return line
+
+
+def main():
+    parser = argparse.ArgumentParser(description="Symbolize a firmware profiler dump into a flat profile.")
+    parser.add_argument('--elf', required=True, help="Firmware ELF built with ENABLE_PROFILER.")
+    parser.add_argument('--dump', help="File containing a <Prof ...> frame.")
+    parser.add_argument('--port', help="Serial port to collect a dump from instead of --dump.")
+    parser.add_argument('--duration', type=float, default=10.0, help="Sampling time in seconds with --port.")
+    parser.add_argument('--shift', type=int, default=8, help="log2 of the bytes per bucket with --port.")
+    parser.add_argument('--base', type=lambda v: int(v, 0), default=0, help="First flash address with --port.")
+    parser.add_argument('--nm', default='avr-nm', help="avr-nm binary to use.")
+    args = parser.parse_args()
+
+    if args.port:
+        import serial
+        with serial.Serial(args.port, 115200, timeout=5) as ser:
+            time.sleep(2)  # The board resets when the port opens.
+            dump = collect(ser, args.duration, args.shift, args.base)
+    elif args.dump:
+        with open(args.dump) as file:
+            dump = file.read()
+    else:
+        parser.error("Either --dump or --port is required.")
+
+    parsed = parse_dump(dump)
+    print_profile(flat_profile(parsed, load_symbols(args.elf, args.nm)), parsed['total'])
+
+
+if __name__ == '__main__':
+    main()
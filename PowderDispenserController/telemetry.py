@@ -0,0 +1,234 @@
+"""
+Columnar store for streamed scale telemetry (native `TelemetryStore`, see `native/include/TelemetryStore.h`).
+
+Rows of (time, grams, steps, event) are kept in chunks of delta-encoded columns, 6 to 8 bytes a
+row, so hours of 80 Hz streaming from several devices stay small and fast to append. Readers map
+the file and decode only the chunks inside a queried time range; the result columns are NumPy
+views of the native buffers.
+
+Record one file per device: `FastPowderDispenseController.record_stream()` feeds a store straight
+from the serial reader thread.
+
+Classes:
+    TelemetryWriter - Appends rows; `mark()` tags host events (dispenses, doses, tares).
+    TelemetryReader - Maps a store; `query()` returns the rows of a time range.
+
+Functions:
+    read(path, start=None, end=None) - Reads a time range into a pandas DataFrame.
+"""
+
+import ctypes
+import datetime
+
+import numpy as np
+
+from . import native
+
+EVENT_SAMPLE = 0
+EVENT_DISPENSE = 1
+EVENT_DOSE = 2
+EVENT_TARE = 3
+EVENT_MARK = 4
+
+EVENT_NAMES = {EVENT_SAMPLE: 'sample', EVENT_DISPENSE: 'dispense', EVENT_DOSE: 'dose', EVENT_TARE: 'tare',
+               EVENT_MARK: 'mark'}
+
+_MIN_US = -(1 << 63)
+_MAX_US = (1 << 63) - 1
+
+
+class TelemetryRecord(ctypes.Structure):
+    """Mirror of the native `TelemetryRecord`."""
+    _fields_ = [
+        ('timeUs', ctypes.c_int64),
+        ('grams', ctypes.c_float),
+        ('steps', ctypes.c_int32),
+        ('event', ctypes.c_uint16),
+    ]
+
+
+def _bind(lib):
+    if getattr(lib, '_telemetry_bound', False):
+        return lib
+    lib.telemetry_writer_open.argtypes = [ctypes.c_char_p, ctypes.c_uint32, ctypes.c_double, ctypes.c_uint32]
+    lib.telemetry_writer_open.restype = ctypes.c_void_p
+    lib.telemetry_writer_mark.argtypes = [ctypes.c_void_p, ctypes.POINTER(TelemetryRecord)]
+    lib.telemetry_writer_mark.restype = None
+    lib.telemetry_writer_dropped.argtypes = [ctypes.c_void_p]
+    lib.telemetry_writer_dropped.restype = ctypes.c_uint64
+    lib.telemetry_writer_close.argtypes = [ctypes.c_void_p]
+    lib.telemetry_writer_close.restype = ctypes.c_int
+    lib.telemetry_reader_open.argtypes = [ctypes.c_char_p]
+    lib.telemetry_reader_open.restype = ctypes.c_void_p
+    lib.telemetry_reader_refresh.argtypes = [ctypes.c_void_p]
+    lib.telemetry_reader_refresh.restype = ctypes.c_int
+    lib.telemetry_reader_count.argtypes = [ctypes.c_void_p]
+    lib.telemetry_reader_count.restype = ctypes.c_uint64
+    lib.telemetry_reader_time_range.argtypes = [ctypes.c_void_p, ctypes.POINTER(ctypes.c_int64),
+                                                ctypes.POINTER(ctypes.c_int64)]
+    lib.telemetry_reader_time_range.restype = ctypes.c_int
+    lib.telemetry_reader_query.argtypes = [ctypes.c_void_p, ctypes.c_int64, ctypes.c_int64]
+    lib.telemetry_reader_query.restype = ctypes.c_size_t
+    for name in ('times', 'grams', 'steps', 'events'):
+        getattr(lib, f'telemetry_reader_{name}').argtypes = [ctypes.c_void_p]
+        getattr(lib, f'telemetry_reader_{name}').restype = ctypes.c_void_p
+    lib.telemetry_reader_close.argtypes = [ctypes.c_void_p]
+    lib.telemetry_reader_close.restype = None
+    lib._telemetry_bound = True
+    return lib
+
+
+def _time_us(value, default):
+    """Accepts None, microseconds since the epoch or a datetime."""
+    if value is None:
+        return default
+    if isinstance(value, datetime.datetime):
+        return int(value.timestamp() * 1e6)
+    return int(value)
+
+
+class TelemetryWriter:
+    """
+    Appends rows to a telemetry store, creating it if needed. Rows are written by a native thread.
+
+    Parameters:
+        path (str): Store file (conventionally `*.pdts`).
+        chunk_rows (int, optional): Rows per chunk (default: 8192).
+        resolution_g (float, optional): Stored mass resolution in grams (default: 1e-5).
+        flush_ms (int, optional): Longest time rows stay in memory before they are written (default: 1000).
+    """
+
+    def __init__(self, path, chunk_rows=8192, resolution_g=1e-5, flush_ms=1000):
+        self._handle = None
+        self._lib = _bind(native.load())
+        self._handle = native.check(self._lib.telemetry_writer_open(path.encode('utf-8'), chunk_rows,
+                                                                    resolution_g, flush_ms))
+
+    @property
+    def handle(self):
+        """The native writer, for `NativeClient.set_recorder()`."""
+        return self._handle
+
+    def mark(self, event=EVENT_MARK, grams=0.0, steps=0, time_us=0):
+        """
+        Appends one host-side row, e.g. the start of a dispense.
+
+        Parameters:
+            event (int, optional): One of the EVENT_* codes.
+            grams (float, optional): Mass of the event (target or amount).
+            steps (int, optional): Steps of the event.
+            time_us (int, optional): Microseconds since the epoch (default: now).
+        """
+        record = TelemetryRecord(timeUs=time_us, grams=grams, steps=steps, event=event)
+        self._lib.telemetry_writer_mark(self._handle, ctypes.byref(record))
+
+    def dropped(self):
+        """Returns the number of streamed rows dropped because the writer thread fell behind."""
+        return self._lib.telemetry_writer_dropped(self._handle)
+
+    def close(self):
+        """Writes the rows still in memory and closes the store. Raises OSError if a write failed."""
+        if self._handle:
+            handle, self._handle = self._handle, None
+            native.check(self._lib.telemetry_writer_close(handle))
+
+    def __enter__(self):
+        return self
+
+    def __exit__(self, *exc):
+        self.close()
+
+    def __del__(self):
+        if self._handle:
+            self._lib.telemetry_writer_close(self._handle)
+            self._handle = None
+
+
+class TelemetryReader:
+    """
+    Maps a telemetry store read-only.
+
+    Parameters:
+        path (str): Store file.
+    """
+
+    def __init__(self, path):
+        self._handle = None
+        self._lib = _bind(native.load())
+        self._handle = native.check(self._lib.telemetry_reader_open(path.encode('utf-8')))
+
+    def __len__(self):
+        return self._lib.telemetry_reader_count(self._handle)
+
+    def refresh(self):
+        """Picks up rows written since opening (or the last refresh)."""
+        native.check(self._lib.telemetry_reader_refresh(self._handle))
+
+    def time_range(self):
+        """Returns (first, last) row time in microseconds since the epoch, or None if the store is empty."""
+        first, last = ctypes.c_int64(), ctypes.c_int64()
+        if self._lib.telemetry_reader_time_range(self._handle, ctypes.byref(first), ctypes.byref(last)) != 0:
+            return None
+        return first.value, last.value
+
+    def _column(self, name, dtype, count):
+        if count == 0:
+            return np.empty(0, dtype=dtype)
+        address = getattr(self._lib, f'telemetry_reader_{name}')(self._handle)
+        buffer = (ctypes.c_char * (count * np.dtype(dtype).itemsize)).from_address(address)
+        array = np.frombuffer(buffer, dtype=dtype, count=count)
+        array.flags.writeable = False
+        return array
+
+    def query(self, start=None, end=None):
+        """
+        Returns the rows with start <= time < end.
+
+        Parameters:
+            start, end (int or datetime, optional): Microseconds since the epoch; open-ended if None.
+
+        Returns:
+            dict: 'time_us' (int64), 'grams' (float32), 'steps' (int32) and 'event' (uint16) NumPy
+            arrays. They are read-only views of the native result, valid until the next `query()`,
+            `refresh()` or `close()`; copy them to keep them longer.
+        """
+        count = self._lib.telemetry_reader_query(self._handle, _time_us(start, _MIN_US), _time_us(end, _MAX_US))
+        return {
+            'time_us': self._column('times', np.int64, count),
+            'grams': self._column('grams', np.float32, count),
+            'steps': self._column('steps', np.int32, count),
+            'event': self._column('events', np.uint16, count),
+        }
+
+    def to_dataframe(self, start=None, end=None):
+        """Copies the rows of a time range into a pandas DataFrame with a UTC 'time' column."""
+        import pandas as pd
+        rows = self.query(start, end)
+        return pd.DataFrame({
+            'time': pd.to_datetime(rows['time_us'], unit='us', utc=True),
+            'grams': rows['grams'].copy(),
+            'steps': rows['steps'].copy(),
+            'event': rows['event'].copy(),
+        })
+
+    def close(self):
+        if self._handle:
+            self._lib.telemetry_reader_close(self._handle)
+            self._handle = None
+
+    def __enter__(self):
+        return self
+
+    def __exit__(self, *exc):
+        self.close()
+
+    def __del__(self):
+        self.close()
+
+
+def read(path, start=None, end=None):
+    """
+    Reads the rows of a time range of a store into a pandas DataFrame (see `TelemetryReader.to_dataframe()`).
+    """
+    with TelemetryReader(path) as reader:
+        return reader.to_dataframe(start, end)
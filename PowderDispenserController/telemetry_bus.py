@@ -0,0 +1,184 @@
+"""
+Shared-memory fan-out of live scale telemetry (native `TelemetryBus`, see `native/include/TelemetryBus.h`).
+
+Only one process can own a dispenser's serial port. That process publishes every telemetry sample
+on a named bus, a lock-free ring in shared memory, and any number of local processes (operator
+UI, logger, SPC notebook) read it with their own cursor. Reading takes no system calls, and a slow
+reader never holds up the serial link: it skips what was overwritten and `lost` counts it.
+
+Publish with the `telemetryd` service (monitoring only) or from a controller that also doses,
+with `FastPowderDispenseController.publish_stream(name)`.
+
+Classes:
+    BusReader - Follows a bus: `read()` returns the records published since the last call.
+    BusWriter - Publishes records; used through `NativeClient.set_publisher()`.
+"""
+
+import ctypes
+import time
+
+import numpy as np
+
+from . import native
+from .telemetry import EVENT_MARK, TelemetryRecord
+
+RECORD_DTYPE = np.dtype([('time_us', np.int64), ('grams', np.float32), ('steps', np.int32), ('event', np.uint16)],
+                        align=True)  # Layout of `TelemetryRecord`.
+
+
+def _bind(lib):
+    if getattr(lib, '_bus_bound', False):
+        return lib
+    lib.bus_writer_open.argtypes = [ctypes.c_char_p, ctypes.c_uint32]
+    lib.bus_writer_open.restype = ctypes.c_void_p
+    lib.bus_writer_publish.argtypes = [ctypes.c_void_p, ctypes.POINTER(TelemetryRecord)]
+    lib.bus_writer_publish.restype = None
+    lib.bus_writer_close.argtypes = [ctypes.c_void_p]
+    lib.bus_writer_close.restype = None
+    lib.bus_reader_open.argtypes = [ctypes.c_char_p, ctypes.c_int]
+    lib.bus_reader_open.restype = ctypes.c_void_p
+    lib.bus_reader_read.argtypes = [ctypes.c_void_p, ctypes.c_void_p, ctypes.c_size_t]
+    lib.bus_reader_read.restype = ctypes.c_size_t
+    lib.bus_reader_lost.argtypes = [ctypes.c_void_p]
+    lib.bus_reader_lost.restype = ctypes.c_uint64
+    lib.bus_reader_available.argtypes = [ctypes.c_void_p]
+    lib.bus_reader_available.restype = ctypes.c_uint64
+    lib.bus_reader_writer_alive.argtypes = [ctypes.c_void_p]
+    lib.bus_reader_writer_alive.restype = ctypes.c_int
+    lib.bus_reader_close.argtypes = [ctypes.c_void_p]
+    lib.bus_reader_close.restype = None
+    lib._bus_bound = True
+    return lib
+
+
+class BusWriter:
+    """
+    Creates (or takes over) a telemetry bus.
+
+    Parameters:
+        name (str): Bus name, e.g. the device's port name.
+        capacity (int, optional): Ring slots, a power of two (default: 65536, over 3 minutes at 320 SPS).
+
+    Raises:
+        OSError: EBUSY if another running process publishes on the bus.
+    """
+
+    def __init__(self, name, capacity=1 << 16):
+        self._handle = None
+        self._lib = _bind(native.load())
+        self._handle = native.check(self._lib.bus_writer_open(name.encode('utf-8'), capacity))
+        self.name = name
+
+    @property
+    def handle(self):
+        """The native writer, for `NativeClient.set_publisher()`."""
+        return self._handle
+
+    def publish(self, event=EVENT_MARK, grams=0.0, steps=0, time_us=0):
+        """
+        Publishes one host-side record, e.g. the start of a dose.
+
+        Parameters:
+            event (int, optional): One of the `telemetry.EVENT_*` codes.
+            grams (float, optional): Mass of the event.
+            steps (int, optional): Steps of the event.
+            time_us (int, optional): Microseconds since the epoch (default: now).
+        """
+        record = TelemetryRecord(timeUs=time_us, grams=grams, steps=steps, event=event)
+        self._lib.bus_writer_publish(self._handle, ctypes.byref(record))
+
+    def close(self):
+        """Stops publishing. Attached readers keep the bus and follow the next writer of the same name."""
+        if self._handle:
+            self._lib.bus_writer_close(self._handle)
+            self._handle = None
+
+    def __enter__(self):
+        return self
+
+    def __exit__(self, *exc):
+        self.close()
+
+    def __del__(self):
+        self.close()
+
+
+class BusReader:
+    """
+    Attaches to a telemetry bus.
+
+    Parameters:
+        name (str): Bus name given to the publisher.
+        from_oldest (bool, optional): Start with the oldest record still in the ring instead of
+            the next one published (default: False).
+        max_records (int, optional): Most records returned by one `read()` (default: 65536).
+
+    Raises:
+        OSError: ENOENT if nothing was ever published under `name`.
+    """
+
+    def __init__(self, name, from_oldest=False, max_records=1 << 16):
+        self._handle = None
+        self._lib = _bind(native.load())
+        self._handle = native.check(self._lib.bus_reader_open(name.encode('utf-8'), int(from_oldest)))
+        self._buffer = np.empty(max_records, dtype=RECORD_DTYPE)
+        self.name = name
+
+    def read(self):
+        """
+        Returns the records published since the last call, oldest first.
+
+        Returns:
+            numpy.ndarray: Structured array with 'time_us' (microseconds since the epoch), 'grams',
+            'steps' and 'event' fields. It is a view of a buffer reused by the next `read()`; copy
+            it to keep it longer.
+        """
+        count = self._lib.bus_reader_read(self._handle, self._buffer.ctypes.data, len(self._buffer))
+        return self._buffer[:count]
+
+    def follow(self, poll_s=0.01, timeout=None):
+        """
+        Yields batches from `read()` as they are published.
+
+        Parameters:
+            poll_s (float, optional): Sleep between empty reads (default: 0.01).
+            timeout (float, optional): Stop after this many seconds without records (default: never).
+        """
+        idle_since = time.monotonic()
+        while True:
+            records = self.read()
+            if len(records):
+                idle_since = time.monotonic()
+                yield records
+            elif timeout is not None and time.monotonic() - idle_since > timeout:
+                return
+            else:
+                time.sleep(poll_s)
+
+    @property
+    def lost(self):
+        """Records overwritten before this reader got to them."""
+        return self._lib.bus_reader_lost(self._handle)
+
+    @property
+    def available(self):
+        """Records waiting to be read."""
+        return self._lib.bus_reader_available(self._handle)
+
+    def writer_alive(self):
+        """Returns True if a running process publishes on the bus."""
+        return self._lib.bus_reader_writer_alive(self._handle) != 0
+
+    def close(self):
+        if self._handle:
+            self._lib.bus_reader_close(self._handle)
+            self._handle = None
+
+    def __enter__(self):
+        return self
+
+    def __exit__(self, *exc):
+        self.close()
+
+    def __del__(self):
+        self.close()
@@ -13,13 +13,19 @@ Functions:
     save_config(config_file, powder_config) - Saves configuration settings to a JSON file.
     read_logfile(logfile) - Reads dispensing operation logs into a pandas DataFrame.
     write_to_logfile(logfile, **kwargs) - Appends dispensing operation details into a logfile.
+
+Log files ending in `.pdlog` are binary dose logs (see `doselog`); any other name is a CSV file.
 """
 
 import json
+import re
 import serial
 import serial.tools.list_ports
 import pandas as pd
 import ast
+from . import doselog
+
+BINARY_LOG_SUFFIX = '.pdlog'
 
 def list_serial_ports():
     """
@@ -54,9 +60,13 @@ def get_serial_port():
         "ERROR: No USB Serial Port Found. Please try again or define the port manually using list_serial_ports()."
     )
 
+def _strip_comments(text):
+    """Removes `//` line comments outside of strings, so commented JSON can be parsed."""
+    return re.sub(r'("(?:\\.|[^"\\])*")|//[^\n]*', lambda match: match.group(1) or '', text)
+
 def get_config(config_file):
     """
-    Loads configuration settings from a JSON file.
+    Loads configuration settings from a JSON file; `//` comments are allowed.
 
     Parameters:
         config_file (str): The path to the configuration file.
@@ -69,7 +79,7 @@ def get_config(config_file):
     """
     try:
         with open(config_file, "r") as file:  # Open the configuration file in read mode.
-            powder_config = json.load(file)  # Parse the JSON content into a dictionary.
+            powder_config = json.loads(_strip_comments(file.read()))  # Parse the JSON content into a dictionary.
     except FileNotFoundError:
         raise FileNotFoundError(
             f"Error: '{config_file}' file not found. Please make sure the file exists in the current directory."
@@ -102,8 +112,12 @@ def read_logfile(logfile):
 
     Behavior:
         - Parses string representations of lists in specific columns (e.g., 'desired_amount', 'measured_amount').
+        - Binary `.pdlog` logs are mapped and converted without parsing.
         - If the log file does not exist, raises a FileNotFoundError.
     """
+    if logfile.endswith(BINARY_LOG_SUFFIX):
+        return doselog.read(logfile)
+
     df = pd.read_csv(logfile)  # Load the CSV file into a DataFrame.
     
     # Columns that may contain string representations of lists (to be converted to actual lists).
@@ -115,7 +129,8 @@ def read_logfile(logfile):
             df[column] = df[column].apply(ast.literal_eval)
     return df  # Return the parsed DataFrame.
 
-def write_to_logfile(logfile, desired_amount=None, measured_amount=None, steps=None, augerType=None, powderType=None, filterType=None):
+def write_to_logfile(logfile, desired_amount=None, measured_amount=None, steps=None, augerType=None, powderType=None, filterType=None,
+                     repetition=None, sample=None):
     """
     Appends dispensing operation details into a logfile.
 
@@ -127,12 +142,22 @@ def write_to_logfile(logfile, desired_amount=None, measured_amount=None, steps=N
         augerType (str, optional): The type of auger used for dispensing.
         powderType (str, optional): The type of powder dispensed.
         filterType (str, optional): The type of filter applied to the weight measurement.
+        repetition (int, optional): Repetition of a repeated test.
+        sample (int, optional): Sample within the repetition.
 
     Behavior:
-        - Reads the existing log file into a DataFrame.
-        - Appends the new row of data to the DataFrame.
-        - Saves the updated DataFrame back to the log file.
+        - Binary `.pdlog` logs get one fixed-size record appended, independent of the log size.
+        - CSV logs are rewritten: the existing log is read into a DataFrame, the new row is appended and
+          the DataFrame is saved back to the log file.
     """
+    if logfile.endswith(BINARY_LOG_SUFFIX):
+        kind = doselog.KIND_DOSE if desired_amount is not None else (
+            doselog.KIND_CALIBRATION if steps is not None else doselog.KIND_MEASUREMENT)
+        doselog.append(logfile, kind=kind, desired=desired_amount, measured=measured_amount, steps=steps,
+                       repetition=repetition, sample=sample, auger_type=augerType, powder_type=powderType,
+                       text=filterType)
+        return
+
     # Create a new row with the provided data.
     new_row = {
         'desired_amount': [desired_amount] if desired_amount is not None else None,
@@ -142,6 +167,10 @@ def write_to_logfile(logfile, desired_amount=None, measured_amount=None, steps=N
         'powder_type': [powderType] if powderType is not None else None,
         'filter_type': [filterType] if filterType is not None else None
     }
+    if repetition is not None:
+        new_row['repetition'] = [repetition]
+    if sample is not None:
+        new_row['sample'] = [sample]
 
     try:
         log_df = read_logfile(logfile)  # Load the existing log file into a DataFrame.